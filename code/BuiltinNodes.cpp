@@ -11,6 +11,10 @@
 #include "Core/Log.h"
 #include "Core/System.h"
 #include "Core/Settings.h"
+#include "Core/Atomic.h"
+#include "Core/Jobs.h"
+#include "Core/Hash.h"
+#include "Core/JsonParser.h"
 
 #include "ImGui/ImGuiAll.h"
 #include "GuiUtil.h"
@@ -54,119 +58,235 @@ void RegisterBuiltinNodes()
     #endif
 }
 
-static bool ParseFormatText(Blob* bufferOut, const char* text, NodeGraph* graph, const Array<PinHandle>& pins, 
-                            char* errorStr, uint32 errorStrSize,
-                            const char* prependStr = nullptr)
+// Format texts: `${Var}` is replaced by the text of the input pin named `Var`, `?{Var:text}` includes `text` only if the 
+// pin has a non-empty value other than "0" (the text can also have variables)
+// Texts are compiled into segments with pre-resolved pin indices, and compiled again only if the text or pin names change
+struct FormatSegment
 {
-    auto FindVar = [graph, pins](const char* name)->const char* {
-        for (uint32 i = 0; i < pins.Count(); i++) {
-            PinHandle pinHandle = pins[i];
-            Pin& pin = ngGetPinData(graph, pinHandle);
-            const char* pinName = pin.dynName ? GetString(pin.dynName) : pin.desc.name;
-            if (strIsEqualNoCase(name, pinName))
-                return pin.ready ? pin.data.str : nullptr;
+    enum class Type : uint32
+    {
+        Text = 0,
+        Var,
+        Optional    // Followed by `numChildren` segments of the section
+    };
+
+    Type type;
+    uint32 numChildren;
+    uint32 pinIndex;        // Var/Optional: Index in inPins. UINT32_MAX if there is no pin with that name
+    uint32 offset;          // Range in the source text. Var/Optional: The variable name
+    uint32 len;
+};
+
+struct FormatTemplate
+{
+    Array<FormatSegment> segments;
+    uint32 textHash;
+    uint32 pinsHash;
+    uint32 textLen;         // Sum of the text segments
+    bool isValid;
+};
+
+static const char* FindNextCloseBracket(const char* str)
+{
+    int bracketDepth = 0;
+    while (*str != 0) {
+        if (*str == '}') {
+            if (bracketDepth == 0) 
+                return str;
+            else 
+                bracketDepth--;
+        }
+        else if (*str == '{') {
+            bracketDepth++;
         }
+        str++;
+    }
+    return nullptr;
+}
 
-        return nullptr;
-    };
+// Dynamic pin names are interned, so comparing the name pointers is enough to detect renames
+static uint32 GetFormatPinsHash(NodeGraph* graph, const Array<PinHandle>& pins)
+{
+    HashMurmur32Incremental hasher(0);
+    for (PinHandle pinHandle : pins) {
+        const Pin& pin = ngGetPinData(graph, pinHandle);
+        const char* pinName = pin.dynName ? GetString(pin.dynName) : pin.desc.name;
+        hasher.Add<const char*>(&pinName);
+    }
+    return hasher.Hash();
+}
 
-    auto FindNextCloseBracket = [](const char* str)->const char* {
-        int bracketDepth = 0;
-        while (*str != 0) {
-            if (*str == '}') {
-                if (bracketDepth == 0) 
-                    return str;
-                else 
-                    bracketDepth--;
-            }
-            else if (*str == '{') {
-                bracketDepth++;
-            }
-            str++;
+static uint32 FindFormatPin(NodeGraph* graph, const Array<PinHandle>& pins, const char* name, uint32 len)
+{
+    for (uint32 i = 0; i < pins.Count(); i++) {
+        const Pin& pin = ngGetPinData(graph, pins[i]);
+        const char* pinName = pin.dynName ? GetString(pin.dynName) : pin.desc.name;
+        if (strIsEqualNoCaseCount(name, pinName, len) && pinName[len] == 0)
+            return i;
+    }
+    return UINT32_MAX;
+}
+
+static void AddFormatText(FormatTemplate* tmpl, uint32 offset, uint32 len)
+{
+    if (len == 0)
+        return;
+
+    tmpl->textLen += len;
+    if (!tmpl->segments.IsEmpty()) {
+        FormatSegment& last = tmpl->segments.Last();
+        if (last.type == FormatSegment::Type::Text && last.offset + last.len == offset) {
+            last.len += len;
+            return;
         }
-        return nullptr;
-    };
+    }
 
+    tmpl->segments.Push(FormatSegment { .type = FormatSegment::Type::Text, .offset = offset, .len = len });
+}
 
-    Blob& blob = *bufferOut;
-    const char* str = text;
-    const char* c = str;
+// Compiles the `${Var}` variables in [start, end) of the text. Top level also takes care of the optional sections
+static bool CompileFormatVars(FormatTemplate* tmpl, const char* text, const char* start, const char* end, bool topLevel,
+                              NodeGraph* graph, const Array<PinHandle>& pins, char* errorStr, uint32 errorStrSize)
+{
+    const char* c = start;
     const char* cropStart = c;
-    char varName[64];
-    size_t dummySize;
+    while (c < end) {
+        bool isVar = c[0] == '$' && c[1] == '{';
+        bool isOptional = topLevel && c[0] == '?' && c[1] == '{';
+        if (!isVar && !isOptional) {
+            c++;
+            continue;
+        }
 
-    if (prependStr) 
-        blob.Write(prependStr, strLen(prependStr));
+        const char* closeBracket = FindNextCloseBracket(c + 2);
+        if (!closeBracket || closeBracket == (c + 2) || closeBracket >= end) {
+            strPrintFmt(errorStr, errorStrSize, "Parsing command failed at: %s", c);
+            return false;
+        }
 
-    // Preprocess pass #1: Include or get rid of ?{} sections (optional)
-    while (*c != 0) {
-        if (*c == '?' && *(c + 1) && *(c + 1) == '{') {
-            const char* closeBracket = FindNextCloseBracket(c + 2);
-            if (!closeBracket || closeBracket == (c + 2)) {
+        const char* nameEnd = closeBracket;
+        if (isOptional) {
+            nameEnd = strFindChar(c + 2, ':');
+            if (nameEnd == nullptr || nameEnd > closeBracket) {
                 strPrintFmt(errorStr, errorStrSize, "Parsing command failed at: %s", c);
                 return false;
             }
+        }
 
-            const char* colon = strFindChar(c + 2, ':');
-            if (colon == nullptr || colon > closeBracket) {
-                strPrintFmt(errorStr, errorStrSize, "Parsing command failed at: %s", c);
+        AddFormatText(tmpl, uint32(cropStart - text), uint32(c - cropStart));
+
+        uint32 nameLen = uint32(nameEnd - c - 2);
+        uint32 index = tmpl->segments.Count();
+        tmpl->segments.Push(FormatSegment {
+            .type = isOptional ? FormatSegment::Type::Optional : FormatSegment::Type::Var,
+            .pinIndex = FindFormatPin(graph, pins, c + 2, nameLen),
+            .offset = uint32(c + 2 - text),
+            .len = nameLen
+        });
+
+        if (isOptional) {
+            if (!CompileFormatVars(tmpl, text, nameEnd + 1, closeBracket, false, graph, pins, errorStr, errorStrSize))
                 return false;
-            }
+            tmpl->segments[index].numChildren = tmpl->segments.Count() - index - 1;
+        }
 
-            strCopyCount(varName, sizeof(varName), c + 2, PtrToInt<uint32>((void*)(colon - c - 2)));
-            if (c > cropStart)
-                blob.Write(cropStart, PtrToInt<uint32>((void*)(c - cropStart)));
+        c = closeBracket + 1;
+        cropStart = c;
+    }
 
-            const char* var = FindVar(varName);
-            if (var != nullptr && var[0] && !strIsEqual(var, "0")) {
-                if (closeBracket > colon + 1)
-                    blob.Write(colon + 1, PtrToInt<uint32>((void*)(closeBracket - colon - 1)));
-            }
+    AddFormatText(tmpl, uint32(cropStart - text), uint32(end - cropStart));
+    return true;
+}
 
-            c = closeBracket;
-            cropStart = c + 1;
-        }
-        c++;
+static const char* GetFormatVar(NodeGraph* graph, const Array<PinHandle>& pins, uint32 pinIndex)
+{
+    if (pinIndex == UINT32_MAX)
+        return nullptr;
+    const Pin& pin = ngGetPinData(graph, pins[pinIndex]);
+    return pin.ready ? pin.data.str : nullptr;
+}
+
+static bool ParseFormatText(FormatTemplate** pTemplate, Blob* bufferOut, const char* text, NodeGraph* graph, const Array<PinHandle>& pins, 
+                            char* errorStr, uint32 errorStrSize,
+                            const char* prependStr = nullptr)
+{
+    if (!*pTemplate)
+        *pTemplate = NEW(memDefaultAlloc(), FormatTemplate);
+    FormatTemplate* tmpl = *pTemplate;
+
+    uint32 textLen = strLen(text);
+    uint32 textHash = hashMurmur32(text, textLen, 0);
+    uint32 pinsHash = GetFormatPinsHash(graph, pins);
+    if (!tmpl->isValid || tmpl->textHash != textHash || tmpl->pinsHash != pinsHash) {
+        tmpl->segments.Clear();
+        tmpl->textLen = 0;
+        tmpl->textHash = textHash;
+        tmpl->pinsHash = pinsHash;
+        tmpl->isValid = CompileFormatVars(tmpl, text, text, text + textLen, true, graph, pins, errorStr, errorStrSize);
+        if (!tmpl->isValid)
+            return false;
     }
-    if (c > cropStart)
-        blob.Write(cropStart, strLen(cropStart));
-    blob.Write<char>('\0');
-    blob.Detach((void**)const_cast<char**>(&c), &dummySize);
-    cropStart = c;
-
-    // Preprocess pass #2: Replace variables 
-    while (*c != 0) {
-        if (*c == '$' && *(c + 1) && *(c + 1) == '{') {
-            const char* closeBracket = FindNextCloseBracket(c + 2);
-            if (!closeBracket || closeBracket == (c + 2)) {
-                strPrintFmt(errorStr, errorStrSize, "Parsing command failed at: %s", c);
-                return false;
-            }
 
-            if (c > cropStart)
-                blob.Write(cropStart, PtrToInt<uint32>((void*)(c - cropStart)));
-            
-            strCopyCount(varName, sizeof(varName), c + 2, PtrToInt<uint32>((void*)(closeBracket - c - 2)));
-            const char* var = FindVar(varName);
+    // Reserve for the worst case (all the sections included), so it's written in one go without growing
+    size_t prependLen = prependStr ? strLen(prependStr) : 0;
+    size_t maxSize = prependLen + tmpl->textLen + 1;
+    for (const FormatSegment& seg : tmpl->segments) {
+        if (seg.type == FormatSegment::Type::Var && seg.pinIndex != UINT32_MAX)
+            maxSize += ngGetPinData(graph, pins[seg.pinIndex]).data.size;
+    }
+
+    Blob& blob = *bufferOut;
+    blob.Reserve(maxSize);
+    if (prependStr)
+        blob.Write(prependStr, prependLen);
+
+    const FormatSegment* segs = tmpl->segments.Ptr();
+    for (uint32 i = 0; i < tmpl->segments.Count(); i++) {
+        const FormatSegment& seg = segs[i];
+        switch (seg.type) {
+        case FormatSegment::Type::Text:
+            blob.Write(text + seg.offset, seg.len);
+            break;
+        case FormatSegment::Type::Var: {
+            const char* var = GetFormatVar(graph, pins, seg.pinIndex);
             if (!var) {
-                strPrintFmt(errorStr, errorStrSize, "Parsing command failed. Variable not found or invalid: %s", varName);
+                strPrintFmt(errorStr, errorStrSize, "Parsing command failed. Variable not found or invalid: %.*s", seg.len, text + seg.offset);
                 return false;
             }
             blob.Write(var, strLen(var));
-
-            c = closeBracket;
-            cropStart = c + 1;
+            break;
+        }
+        case FormatSegment::Type::Optional: {
+            const char* var = GetFormatVar(graph, pins, seg.pinIndex);
+            if (var == nullptr || var[0] == 0 || strIsEqual(var, "0"))
+                i += seg.numChildren;
+            break;
+        }
         }
-
-        c++;
     }
-    if (c > cropStart)
-        blob.Write(cropStart, strLen(cropStart));
     blob.Write<char>('\0');
 
     return true;
 }
 
+static void DestroyFormatTemplate(FormatTemplate* tmpl)
+{
+    if (tmpl) {
+        tmpl->segments.Free();
+        memFree(tmpl);
+    }
+}
+
+// Copies the null-terminated output text that is written since `startOffset` to the pin
+static void SetOutputTextPin(Pin& pin, TextContent* output, uint64 startOffset)
+{
+    AtomicLockScope lock(output->mLock);
+    uint64 endOffset = output->GetSize();
+    ASSERT(endOffset > startOffset);
+    const char* text = output->GetText(startOffset, endOffset);
+    pin.data.SetString(text ? text : "", text ? uint32(endOffset - startOffset - 1) : 0);
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 // Node_DebugMessage
 bool Node_DebugMessage::Execute(NodeGraph* graph, NodeHandle nodeHandle, const Array<PinHandle>& inPins, const Array<PinHandle>& outPins)
@@ -253,6 +373,7 @@ bool Node_CreateProcess::InitializeDuplicate(NodeGraph* graph, NodeHandle nodeHa
     Data* copyData = (Data*)srcData;
     strCopy(data->title, sizeof(data->title), copyData->title);
     strCopy(data->executeCmd, sizeof(data->executeCmd), copyData->executeCmd);
+    strCopy(data->phaseMarker, sizeof(data->phaseMarker), copyData->phaseMarker);
     data->fatalErrorOnFail = copyData->fatalErrorOnFail;
     data->checkRetCode = copyData->checkRetCode;
     data->successRetCode = copyData->successRetCode;
@@ -265,9 +386,52 @@ bool Node_CreateProcess::InitializeDuplicate(NodeGraph* graph, NodeHandle nodeHa
 void Node_CreateProcess::Release(NodeGraph* graph, NodeHandle nodeHandle)
 {
     Node& node = ngGetNodeData(graph, nodeHandle);
+    DestroyFormatTemplate(((Data*)node.data)->cmdTemplate);
     memFree(node.data);
 }
 
+// Free space that stdout is read into, see Node_CreateProcess::Execute
+static constexpr uint32 kCreateProcessMinReadSize = 4*kKB;
+static constexpr uint32 kCreateProcessMaxReadSize = 16*kKB;
+
+// Each phase of the process output is a sub event of the node's event. It lasts until the next marker or the process exit
+// Phases are named after the part of the line that the marker matched, not the whole line. So the marker decides what is 
+// stable across runs (e.g. `^\[\w+\]` for "[Compile] foo.cpp") and the phase stats group by it
+struct CreateProcessPhases
+{
+    TskGraphHandle graphHandle;
+    TskEventHandle nodeEventHandle;
+    TskEventHandle eventHandle;
+    uint32 nextLine;
+};
+
+static void CreateProcessUpdatePhases(CreateProcessPhases* phases, TextContent* output, const char* phaseMarker, const char* title)
+{
+    MemTempAllocator tmpAlloc;
+    Array<String<256>> names(&tmpAlloc);
+
+    // Event calls lock the tasks, so only collect the marker lines while holding the content lock
+    {
+        AtomicLockScope lock(output->mLock);
+        for (; phases->nextLine < output->mLines.Count(); phases->nextLine++) {
+            TextSegment line = output->mLines[phases->nextLine];
+            const char* text = output->GetText(line.begin, line.end);
+            uint32 len = uint32(line.end - line.begin);
+            uint32 matchOffset, matchLen;
+            if (text && len && textRegexMatch(phaseMarker, text, len, true, &matchOffset, &matchLen) && matchLen) {
+                String<256>* name = names.Push();
+                name->FormatSelf("%s: %.*s", title, int(Min<uint32>(matchLen, 200)), text + matchOffset);
+            }
+        }
+    }
+
+    for (const String<256>& name : names) {
+        if (phases->eventHandle.IsValid())
+            tskEndEvent(phases->graphHandle, phases->eventHandle);
+        phases->eventHandle = tskBeginSubEvent(phases->graphHandle, phases->nodeEventHandle, name.CStr());
+    }
+}
+
 bool Node_CreateProcess::Execute(NodeGraph* graph, NodeHandle nodeHandle, const Array<PinHandle>& inPins, const Array<PinHandle>& outPins)
 {
     Node& node = ngGetNodeData(graph, nodeHandle);
@@ -284,7 +448,7 @@ bool Node_CreateProcess::Execute(NodeGraph* graph, NodeHandle nodeHandle, const
         prependCmd = "cmd /c ";
     #endif
 
-    if (!ParseFormatText(&blob, data->executeCmd, graph, inPins, data->errorStr, sizeof(data->errorStr), prependCmd))
+    if (!ParseFormatText(&data->cmdTemplate, &blob, data->executeCmd, graph, inPins, data->errorStr, sizeof(data->errorStr), prependCmd))
         return false;
 
     TskEventScope event(graph, GetTitleUI(graph, nodeHandle));
@@ -293,37 +457,49 @@ bool Node_CreateProcess::Execute(NodeGraph* graph, NodeHandle nodeHandle, const
     Pin& cwdPin = ngGetPinData(graph, inPins[2]);
     const char* cwd = cwdPin.ready ? cwdPin.data.str : nullptr;
 
-    size_t startOffset;
     TextContent* output = node.outputText;
-    if (node.IsFirstTimeRun())
-        output->Reset();
-    else if (output->mBlob.Size())
-        output->mBlob.SetSize(output->mBlob.Size() - 1);    // Remove the last null-terminator
-    startOffset = output->mBlob.Size();
+    uint64 startOffset = output->BeginWrite(node.IsFirstTimeRun());
+
+    CreateProcessPhases phases { .graphHandle = event.mGraphHandle, .nodeEventHandle = event.mHandle };
+    if (data->phaseMarker[0]) {
+        AtomicLockScope lock(output->mLock);
+        phases.nextLine = output->mLines.Count();
+    }
     
     SysProcess proc;
     event.Info(cmd);
     if (proc.Run(cmd, SysProcessFlags::CaptureOutput|SysProcessFlags::InheritHandles|SysProcessFlags::DontCreateConsole, cwd)) {
         data->runningProc = &proc;
-        char buffer[4096];
-        uint32 bytesRead;
 
-        while (proc.IsRunning()) {
-            bytesRead = proc.ReadStdOut(buffer, sizeof(buffer));
-            if (bytesRead == 0)
-                break;
-
-            output->WriteData(buffer, bytesRead);
-            output->ParseLines();
+        {
+            // The worker sits on the pipe until the process exits, let the job system run other nodes meanwhile
+            JobsBlockingScope blocking;
+
+            // Read straight into the output storage until the pipe is closed. When the reads keep filling the whole space, 
+            // the process is writing faster than we read, so ask for more free space to not end up with small reads
+            uint32 minReadSize = kCreateProcessMinReadSize;
+            while (true) {
+                uint32 readSize;
+                char* dst = output->ReserveWrite(minReadSize, &readSize);
+                uint32 bytesRead = proc.ReadStdOut(dst, readSize);
+                output->CommitWrite(bytesRead);
+                if (bytesRead == 0)
+                    break;
+                output->ParseLines();
+                if (data->phaseMarker[0])
+                    CreateProcessUpdatePhases(&phases, output, data->phaseMarker, GetTitleUI(graph, nodeHandle));
+
+                if (bytesRead == readSize)
+                    minReadSize = Min(minReadSize << 1, kCreateProcessMaxReadSize);
+                else if (bytesRead < (minReadSize >> 2))
+                    minReadSize = Max(minReadSize >> 1, kCreateProcessMinReadSize);
+            }
         }
 
-        // Read remaining pipe data if the process is exited
-        while ((bytesRead = proc.ReadStdOut(buffer, sizeof(buffer))) > 0)
-            output->WriteData(buffer, bytesRead);
-
-        output->WriteData<char>('\0');
-        output->ParseLines();
+        output->EndWrite();
         data->runningProc = nullptr;
+        if (phases.eventHandle.IsValid())
+            tskEndEvent(phases.graphHandle, phases.eventHandle);
 
         Pin& execPin = ngGetPinData(graph, outPins[0]);
         Pin& outPin = ngGetPinData(graph, outPins[1]);
@@ -334,7 +510,7 @@ bool Node_CreateProcess::Execute(NodeGraph* graph, NodeHandle nodeHandle, const
                 execPin.ready = true;
 
                 // Output Text
-                outPin.data.SetString((const char*)output->mBlob.Data() + startOffset);
+                SetOutputTextPin(outPin, output, startOffset);
                 outPin.ready = true;
                 event.Success();
             }
@@ -358,7 +534,7 @@ bool Node_CreateProcess::Execute(NodeGraph* graph, NodeHandle nodeHandle, const
             execPin.ready = true;
 
             // Output Text
-            outPin.data.SetString((const char*)output->mBlob.Data() + startOffset);
+            SetOutputTextPin(outPin, output, startOffset);
             outPin.ready = true;
             event.Success();
         }
@@ -396,6 +572,9 @@ bool Node_CreateProcess::ShowEditUI(NodeGraph* graph, NodeHandle nodeHandle)
     
     ImGui::InputText("Title", data->title, sizeof(data->title), ImGuiInputTextFlags_CharsNoBlank);
     ImGui::Checkbox("RunInCmd", &data->runInCmd);
+    ImGui::InputText("PhaseMarker", data->phaseMarker, sizeof(data->phaseMarker));
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Regex for the output lines that start a new phase. Phases are timed as sub events of the node,\nnamed after the part of the line that the regex matched");
     ImGui::Checkbox("CheckReturnCode", &data->checkRetCode);
     if (data->checkRetCode) {
         ImGui::Checkbox("FatalErrorOnFail", &data->fatalErrorOnFail);
@@ -480,6 +659,7 @@ void Node_CreateProcess::SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle,
 
     sjson_put_string(jctx, jparent, "Title", data->title);
     sjson_put_string(jctx, jparent, "ExecuteCmd", data->executeCmd);
+    sjson_put_string(jctx, jparent, "PhaseMarker", data->phaseMarker);
     sjson_put_int(jctx, jparent, "SuccessRetCode", data->successRetCode);
     sjson_put_int(jctx, jparent, "CmdTextInputWidth", data->cmdTextInputWidth);
     sjson_put_bool(jctx, jparent, "CheckRetCode", data->checkRetCode);
@@ -487,18 +667,19 @@ void Node_CreateProcess::SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle,
     sjson_put_bool(jctx, jparent, "RunInCmd", data->runInCmd);
 }
 
-bool Node_CreateProcess::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent)
+bool Node_CreateProcess::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent)
 {
     Node& node = ngGetNodeData(graph, nodeHandle);
     Data* data = (Data*)node.data;
 
-    strCopy(data->title, sizeof(data->title), sjson_get_string(jparent, "Title", node.desc.name));
-    strCopy(data->executeCmd, sizeof(data->executeCmd), sjson_get_string(jparent, "ExecuteCmd", ""));
-    data->successRetCode = sjson_get_int(jparent, "SuccessRetCode", 0);
-    data->cmdTextInputWidth = sjson_get_int(jparent, "CmdTextInputWidth", 550);
-    data->checkRetCode = sjson_get_bool(jparent, "CheckRetCode", true);
-    data->fatalErrorOnFail = sjson_get_bool(jparent, "FatalErrorOnFail", true);
-    data->runInCmd = sjson_get_bool (jparent, "RunInCmd", false);
+    jparent.GetChildValue("Title", data->title, sizeof(data->title), node.desc.name);
+    jparent.GetChildValue("ExecuteCmd", data->executeCmd, sizeof(data->executeCmd));
+    jparent.GetChildValue("PhaseMarker", data->phaseMarker, sizeof(data->phaseMarker));
+    data->successRetCode = jparent.GetChildValue<int>("SuccessRetCode", 0);
+    data->cmdTextInputWidth = jparent.GetChildValue<int>("CmdTextInputWidth", 550);
+    data->checkRetCode = jparent.GetChildValue<bool>("CheckRetCode", true);
+    data->fatalErrorOnFail = jparent.GetChildValue<bool>("FatalErrorOnFail", true);
+    data->runInCmd = jparent.GetChildValue<bool>("RunInCmd", false);
 
     return true;
 }
@@ -565,6 +746,7 @@ bool Node_ShellExecute::InitializeDuplicate(NodeGraph* graph, NodeHandle nodeHan
 void Node_ShellExecute::Release(NodeGraph* graph, NodeHandle nodeHandle)
 {
     Node& node = ngGetNodeData(graph, nodeHandle);
+    DestroyFormatTemplate(((Data*)node.data)->argsTemplate);
     memFree(node.data);
 }
 
@@ -578,7 +760,7 @@ bool Node_ShellExecute::Execute(NodeGraph* graph, NodeHandle nodeHandle, const A
     Blob blob(&tmpAlloc);
     blob.SetGrowPolicy(Blob::GrowPolicy::Linear);
 
-    if (!ParseFormatText(&blob, data->executeArgs, graph, inPins, data->errorStr, sizeof(data->errorStr)))
+    if (!ParseFormatText(&data->argsTemplate, &blob, data->executeArgs, graph, inPins, data->errorStr, sizeof(data->errorStr)))
         return false;
 
     TskEventScope event(graph, GetTitleUI(graph, nodeHandle));
@@ -739,16 +921,16 @@ void Node_ShellExecute::SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle,
     sjson_put_bool(jctx, jparent, "RunAsAdmin", data->runAsAdmin);
 }
 
-bool Node_ShellExecute::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent)
+bool Node_ShellExecute::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent)
 {
     Node& node = ngGetNodeData(graph, nodeHandle);
     Data* data = (Data*)node.data;
 
-    strCopy(data->title, sizeof(data->title), sjson_get_string(jparent, "Title", node.desc.name));
-    strCopy(data->executeArgs, sizeof(data->executeArgs), sjson_get_string(jparent, "ExecuteArgs", ""));
-    strCopy(data->operation, sizeof(data->operation), sjson_get_string(jparent, "Operation", ""));
-    data->fatalErrorOnFail = sjson_get_bool(jparent, "FatalErrorOnFail", true);
-    data->runAsAdmin = sjson_get_bool (jparent, "RunAsAdmin", false);
+    jparent.GetChildValue("Title", data->title, sizeof(data->title), node.desc.name);
+    jparent.GetChildValue("ExecuteArgs", data->executeArgs, sizeof(data->executeArgs));
+    jparent.GetChildValue("Operation", data->operation, sizeof(data->operation));
+    data->fatalErrorOnFail = jparent.GetChildValue<bool>("FatalErrorOnFail", true);
+    data->runAsAdmin = jparent.GetChildValue<bool>("RunAsAdmin", false);
 
     static const char* ops[] = {
         "default",
@@ -914,7 +1096,7 @@ void Node_JoinStringArray::SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandl
     sjson_put_string(jctx, jparent, "JoinStr", data->joinStr);
 }
 
-bool Node_JoinStringArray::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent)
+bool Node_JoinStringArray::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent)
 {
     Node& node = ngGetNodeData(graph, nodeHandle);
     Node_JoinStringArray::Data* data = (Node_JoinStringArray::Data*)node.data;
@@ -924,11 +1106,11 @@ bool Node_JoinStringArray::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHan
     else
         data->isUnixPath = true;
 
-    data->isDirectory = sjson_get_bool(jparent, "IsDirectory", false);
-    data->isUnixPath = sjson_get_bool(jparent, "IsUnixPath", data->isUnixPath);
-    data->prepend = sjson_get_bool(jparent, "Prepend", false);
-    data->append = sjson_get_bool(jparent, "Append", false);
-    strCopy(data->joinStr, sizeof(data->joinStr), sjson_get_string(jparent, "JoinStr", ""));
+    data->isDirectory = jparent.GetChildValue<bool>("IsDirectory", false);
+    data->isUnixPath = jparent.GetChildValue<bool>("IsUnixPath", data->isUnixPath);
+    data->prepend = jparent.GetChildValue<bool>("Prepend", false);
+    data->append = jparent.GetChildValue<bool>("Append", false);
+    jparent.GetChildValue("JoinStr", data->joinStr, sizeof(data->joinStr));
 
     return true;
 }
@@ -1070,7 +1252,7 @@ void Node_JoinString::SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sj
     sjson_put_string(jctx, jparent, "JoinStr", data->joinStr);
 }
 
-bool Node_JoinString::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent)
+bool Node_JoinString::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent)
 {
     Node& node = ngGetNodeData(graph, nodeHandle);
     Data* data = (Node_JoinString::Data*)node.data;
@@ -1080,9 +1262,9 @@ bool Node_JoinString::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle,
     else
         data->isUnixPath = true;
 
-    data->isDirectory = sjson_get_bool(jparent, "IsDirectory", false);
-    data->isUnixPath = sjson_get_bool(jparent, "IsUnixPath", data->isUnixPath);
-    strCopy(data->joinStr, sizeof(data->joinStr), sjson_get_string(jparent, "JoinStr", ""));
+    data->isDirectory = jparent.GetChildValue<bool>("IsDirectory", false);
+    data->isUnixPath = jparent.GetChildValue<bool>("IsUnixPath", data->isUnixPath);
+    jparent.GetChildValue("JoinStr", data->joinStr, sizeof(data->joinStr));
 
     return true;
 }
@@ -1245,16 +1427,17 @@ void Node_SplitString::SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, s
     sjson_put_bool(jctx, jparent, "IgnoreWhitespace", data->ignoreWhitespace);
 }
 
-bool Node_SplitString::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent)
+bool Node_SplitString::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent)
 {
     Node& node = ngGetNodeData(graph, nodeHandle);
     Node_SplitString::Data* data = (Node_SplitString::Data*)node.data;
 
-    const char* text = sjson_get_string(jparent, "SplitChar", "");
+    char text[8];
+    jparent.GetChildValue("SplitChar", text, sizeof(text));
     data->splitChar = text[0];
 
-    data->splitNewLines = sjson_get_bool(jparent, "SplitNewLines", true);
-    data->ignoreWhitespace = sjson_get_bool(jparent, "IgnoreWhitespace", false);
+    data->splitNewLines = jparent.GetChildValue<bool>("SplitNewLines", true);
+    data->ignoreWhitespace = jparent.GetChildValue<bool>("IgnoreWhitespace", false);
 
     return true;
 }
@@ -1467,13 +1650,13 @@ void Node_CompareString::SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle,
     sjson_put_bool(jctx, jparent, "IgnoreCase", data->ignoreCase);
 }
 
-bool Node_CompareString::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent)
+bool Node_CompareString::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent)
 {
     Node& node = ngGetNodeData(graph, nodeHandle);
     Data* data = (Data*)node.data;
 
-    data->mode = Mode(sjson_get_int(jparent, "Mode", 0));
-    data->ignoreCase = sjson_get_bool(jparent, "IgnoreCase", false);
+    data->mode = Mode(jparent.GetChildValue<int>("Mode", 0));
+    data->ignoreCase = jparent.GetChildValue<bool>("IgnoreCase", false);
     return true;
 }
 
@@ -1550,13 +1733,13 @@ void Node_StringConstant::SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle
     sjson_put_string(jctx, jparent, "Value", data->value);
 }
 
-bool Node_StringConstant::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent)
+bool Node_StringConstant::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent)
 {
     Node& node = ngGetNodeData(graph, nodeHandle);
     Data* data = (Data*)node.data;
 
-    strCopy(data->varName, sizeof(data->varName), sjson_get_string(jparent, "VarName", node.desc.name));
-    strCopy(data->value, sizeof(data->value), sjson_get_string(jparent, "Value", ""));
+    jparent.GetChildValue("VarName", data->varName, sizeof(data->varName), node.desc.name);
+    jparent.GetChildValue("Value", data->value, sizeof(data->value));
 
     return true;
 }
@@ -1714,22 +1897,19 @@ void Node_Constants::SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjs
     }
 }
 
-bool Node_Constants::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent)
+bool Node_Constants::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent)
 {
     Node& node = ngGetNodeData(graph, nodeHandle);
     Data* data = (Data*)node.data;
 
-    strCopy(data->title, sizeof(data->title), sjson_get_string(jparent, "Title", node.desc.name));
-    sjson_node* jitems = sjson_find_member(jparent, "Items");
-    if (jitems) {
-        sjson_node* jitem = sjson_first_child(jitems);
-        while (jitem) {
+    jparent.GetChildValue("Title", data->title, sizeof(data->title), node.desc.name);
+    JsonNode jitems = jparent.GetChild("Items");
+    if (jitems.IsValid()) {
+        for (JsonNode jitem = jitems.GetArrayItem(); jitem.IsValid(); jitem = jitems.GetNextArrayItem(jitem)) {
             Item item {};
-            strCopy(item.value, sizeof(item.value), sjson_get_string(jitem, "Value", ""));
-            item.outputPinIndex = uint32(sjson_get_int(jitem, "OutputPinIndex", 0));
+            jitem.GetChildValue("Value", item.value, sizeof(item.value));
+            item.outputPinIndex = uint32(jitem.GetChildValue<int>("OutputPinIndex", 0));
             data->items.Push(item);
-
-            jitem = jitem->next;
         }
     }
 
@@ -1808,12 +1988,12 @@ void Node_IntConstant::SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, s
     sjson_put_int(jctx, jparent, "Value", data->value);
 }
 
-bool Node_IntConstant::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent)
+bool Node_IntConstant::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent)
 {
     Node& node = ngGetNodeData(graph, nodeHandle);
     Data* data = (Data*)node.data;
-    strCopy(data->varName, sizeof(data->varName), sjson_get_string(jparent, "VarName", node.desc.name));
-    data->value = sjson_get_int(jparent, "Value", 0);
+    jparent.GetChildValue("VarName", data->varName, sizeof(data->varName), node.desc.name);
+    data->value = jparent.GetChildValue<int>("Value", 0);
     return true;
 }
 
@@ -2060,23 +2240,21 @@ void Node_Selector::SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjso
     }
 }
 
-bool Node_Selector::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent)
+bool Node_Selector::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent)
 {
     Node& node = ngGetNodeData(graph, nodeHandle);
     Data* data = (Data*)node.data;
 
-    strCopy(data->title, sizeof(data->title), sjson_get_string(jparent, "Title", node.desc.name));
-    sjson_node* jitems = sjson_find_member(jparent, "SelectorItems");
-    if (jitems) {
-        sjson_node* jitem = sjson_first_child(jitems);
-        while (jitem) {
+    jparent.GetChildValue("Title", data->title, sizeof(data->title), node.desc.name);
+    JsonNode jitems = jparent.GetChild("SelectorItems");
+    if (jitems.IsValid()) {
+        for (JsonNode jitem = jitems.GetArrayItem(); jitem.IsValid(); jitem = jitems.GetNextArrayItem(jitem)) {
             SelectorItem item {};
-            item.value = sjson_get_string(jitem, "Value", "");
-            item.cond = Condition(sjson_get_int(jitem, "Condition", 0));
-            item.outputPinIndex = uint32(sjson_get_int(jitem, "OutputPinIndex", 0));
+            jitem.GetChildValue("Value", item.value.Ptr(), item.value.Capacity());
+            item.value.CalcLength();
+            item.cond = Condition(jitem.GetChildValue<int>("Condition", 0));
+            item.outputPinIndex = uint32(jitem.GetChildValue<int>("OutputPinIndex", 0));
             data->items.Push(item);
-
-            jitem = jitem->next;
         }
     }
     return true;
@@ -2156,12 +2334,12 @@ void Node_MathCounter::SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, s
     sjson_put_int(jctx, jparent, "StartFrom", data->start);
 }
 
-bool Node_MathCounter::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent)
+bool Node_MathCounter::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent)
 {
     Node& node = ngGetNodeData(graph, nodeHandle);
     Data* data = (Data*)node.data;
     
-    data->start = sjson_get_int(jparent, "StartFrom", 0);
+    data->start = jparent.GetChildValue<int>("StartFrom", 0);
     return true;
 }
 
@@ -2230,7 +2408,11 @@ bool Node_EmbedGraph::Execute(NodeGraph* graph, NodeHandle nodeHandle, const Arr
     if (data->loadError || !data->graph)
         return false;
 
-    data->graphMutex.Enter();
+    // Another instance of the embedded graph can hold the mutex for its whole run
+    if (!data->graphMutex.TryEnter()) {
+        JobsBlockingScope blocking;
+        data->graphMutex.Enter();
+    }
     
     TskEventScope taskEvent(graph, GetTitleUI(graph, nodeHandle));
     
@@ -2254,10 +2436,7 @@ bool Node_EmbedGraph::Execute(NodeGraph* graph, NodeHandle nodeHandle, const Arr
     }
 
     TextContent* output = node.outputText;
-    if (node.IsFirstTimeRun())
-        output->Reset();
-    else if (output->mBlob.Size())
-        output->mBlob.SetSize(output->mBlob.Size() - 1);    // Remove the last null-terminator
+    output->BeginWrite(node.IsFirstTimeRun());
 
     bool r = ngExecute(data->graph, false, nullptr, output, taskEvent.mHandle);
 
@@ -2296,14 +2475,16 @@ void Node_EmbedGraph::SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sj
     sjson_put_string(jctx, jparent, "Filepath", wksGetWorkspaceFilePath(GetWorkspace(), data->fileHandle).CStr());
 }
 
-bool Node_EmbedGraph::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent)
+bool Node_EmbedGraph::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent)
 {
     Node& node = ngGetNodeData(graph, nodeHandle);
     Data* data = (Data*)node.data;
     char errMsg[512];
 
-    strCopy(data->title, sizeof(data->title), sjson_get_string(jparent, "Title", node.desc.name));
-    Path filepath = sjson_get_string(jparent, "Filepath", "");
+    jparent.GetChildValue("Title", data->title, sizeof(data->title), node.desc.name);
+    Path filepath;
+    jparent.GetChildValue("Filepath", filepath.Ptr(), filepath.Capacity());
+    filepath.CalcLength();
     if (filepath.IsEmpty()) {
         SetLoadError(graph, nodeHandle, WksFileHandle(), "No file to load");
         return false;
@@ -2419,6 +2600,7 @@ void Node_FormatString::Release(NodeGraph* graph, NodeHandle nodeHandle)
 {
     Node& node = ngGetNodeData(graph, nodeHandle);
     Data* data = (Data*)node.data;
+    DestroyFormatTemplate(data->textTemplate);
     memFree(data);
 }
 
@@ -2489,7 +2671,7 @@ bool Node_FormatString::Execute(NodeGraph* graph, NodeHandle nodeHandle, const A
     Blob blob(&tmpAlloc);
     blob.SetGrowPolicy(Blob::GrowPolicy::Linear);
 
-    if (!ParseFormatText(&blob, data->text, graph, inPins, data->errorStr, sizeof(data->errorStr)))
+    if (!ParseFormatText(&data->textTemplate, &blob, data->text, graph, inPins, data->errorStr, sizeof(data->errorStr)))
         return false;
 
     Pin& outPin = ngGetPinData(graph, outPins[0]);
@@ -2507,12 +2689,12 @@ void Node_FormatString::SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle,
     sjson_put_string(jctx, jparent, "Text", data->text);
 }
 
-bool Node_FormatString::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent)
+bool Node_FormatString::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent)
 {
     Node& node = ngGetNodeData(graph, nodeHandle);
     Data* data = (Data*)node.data;
 
-    strCopy(data->text, sizeof(data->text), sjson_get_string(jparent, "Text", ""));
+    jparent.GetChildValue("Text", data->text, sizeof(data->text));
     return true;
 }
 
@@ -2727,24 +2909,21 @@ bool Node_ListDir::Execute(NodeGraph* graph, NodeHandle nodeHandle, const Array<
         return false;
     }
 
-    size_t startOffset;
     TextContent* output = node.outputText;
-    if (node.IsFirstTimeRun())
-        output->Reset();
-    else if (output->mBlob.Size())
-        output->mBlob.SetSize(output->mBlob.Size() - 1);    // Remove the last null-terminator
-    startOffset = output->mBlob.Size();
+    uint64 startOffset = output->BeginWrite(node.IsFirstTimeRun());
 
-    ListDir_GetListing(Path(dirPin.data.str), data, output, extensions, excludeExtensions, d);
+    {
+        JobsBlockingScope blocking;
+        ListDir_GetListing(Path(dirPin.data.str), data, output, extensions, excludeExtensions, d);
+    }
     closedir(d);
 
-    output->WriteData<char>('\0');
-    output->ParseLines();
+    output->EndWrite();
 
     Pin& outListingPin = ngGetPinData(graph, outPins[0]);
     Pin& outDirPin = ngGetPinData(graph, outPins[1]);
 
-    outListingPin.data.SetString((const char*)output->mBlob.Data() + startOffset);
+    SetOutputTextPin(outListingPin, output, startOffset);
     outListingPin.ready = true;
 
     outDirPin.data.CopyFrom(dirPin.data);
@@ -2766,16 +2945,16 @@ void Node_ListDir::SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson
     sjson_put_bool(jctx, jparent, "OnlyDirectories", data->onlyDirectories);
 }
 
-bool Node_ListDir::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent)
+bool Node_ListDir::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent)
 {
     Node& node = ngGetNodeData(graph, nodeHandle);
     Data* data = (Data*)node.data;
 
-    strCopy(data->extensions, sizeof(data->extensions), sjson_get_string(jparent, "Extensions", ""));
-    strCopy(data->excludeExtensions, sizeof(data->excludeExtensions), sjson_get_string(jparent, "ExcludeExtensions", ""));
-    data->recursive = sjson_get_bool(jparent, "Recursive", false);
-    data->ignoreDirectories = sjson_get_bool(jparent, "IgnoreDirectories", false);
-    data->onlyDirectories = sjson_get_bool(jparent, "OnlyDirectories", false);
+    jparent.GetChildValue("Extensions", data->extensions, sizeof(data->extensions));
+    jparent.GetChildValue("ExcludeExtensions", data->excludeExtensions, sizeof(data->excludeExtensions));
+    data->recursive = jparent.GetChildValue<bool>("Recursive", false);
+    data->ignoreDirectories = jparent.GetChildValue<bool>("IgnoreDirectories", false);
+    data->onlyDirectories = jparent.GetChildValue<bool>("OnlyDirectories", false);
 
     return true;
 }
@@ -2969,23 +3148,22 @@ void Node_TranslateString::SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandl
     }
 }
 
-bool Node_TranslateString::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent)
+bool Node_TranslateString::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent)
 {
     Node& node = ngGetNodeData(graph, nodeHandle);
     Data* data = (Data*)node.data;
 
-    strCopy(data->title, sizeof(data->title), sjson_get_string(jparent, "Title", node.desc.name));
-    sjson_node* jitems = sjson_find_member(jparent, "Items");
-    if (jitems) {
-        sjson_node* jitem = sjson_first_child(jitems);
-        while (jitem) {
+    jparent.GetChildValue("Title", data->title, sizeof(data->title), node.desc.name);
+    JsonNode jitems = jparent.GetChild("Items");
+    if (jitems.IsValid()) {
+        for (JsonNode jitem = jitems.GetArrayItem(); jitem.IsValid(); jitem = jitems.GetNextArrayItem(jitem)) {
             Item item {};
-            item.value = sjson_get_string(jitem, "Value", "");
-            item.cond = Condition(sjson_get_int(jitem, "Condition", 0));
-            item.output = sjson_get_string(jitem, "Output", "");
+            jitem.GetChildValue("Value", item.value.Ptr(), item.value.Capacity());
+            item.value.CalcLength();
+            item.cond = Condition(jitem.GetChildValue<int>("Condition", 0));
+            jitem.GetChildValue("Output", item.output.Ptr(), item.output.Capacity());
+            item.output.CalcLength();
             data->items.Push(item);
-
-            jitem = jitem->next;
         }
     }
     return true;
@@ -3086,11 +3264,11 @@ void Node_GetEnvVar::SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjs
     sjson_put_string(jctx, jparent, "VarName", data->name);
 }
 
-bool Node_GetEnvVar::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent)
+bool Node_GetEnvVar::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent)
 {
     Node& node = ngGetNodeData(graph, nodeHandle);
     Data* data = (Data*)node.data;
-    strCopy(data->name, sizeof(data->name), sjson_get_string(jparent, "VarName", ""));
+    jparent.GetChildValue("VarName", data->name, sizeof(data->name));
     return true;
 }
 
@@ -3182,11 +3360,11 @@ void Node_GetSettingsVar::SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle
     sjson_put_string(jctx, jparent, "SettingName", data->name);
 }
 
-bool Node_GetSettingsVar::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent)
+bool Node_GetSettingsVar::LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent)
 {
     Node& node = ngGetNodeData(graph, nodeHandle);
     Data* data = (Data*)node.data;
-    strCopy(data->name, sizeof(data->name), sjson_get_string(jparent, "SettingName", ""));
+    jparent.GetChildValue("SettingName", data->name, sizeof(data->name));
     return true;
 }
 
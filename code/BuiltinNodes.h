@@ -4,6 +4,7 @@
 #include "NodeGraph.h"
 
 struct ImGuiInputTextCallbackData;
+struct FormatTemplate;
 
 API void RegisterBuiltinNodes();
 
@@ -37,7 +38,7 @@ struct Node_DebugMessage final : NodeImpl
     const PinDesc& GetInputPin(uint32 index) override { return InPins[index]; }
     const PinDesc& GetOutputPin(uint32 index) override { return kEmptyPin; }
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override {}
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override { return true; }
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override { return true; }
     void DrawData(NodeGraph* graph, NodeHandle nodeHandle, bool isDebugMode) override {}
 };
 
@@ -78,7 +79,7 @@ struct Node_UpperCase final : NodeImpl
     const PinDesc& GetInputPin(uint32 index) override { return InPins[index]; }
     const PinDesc& GetOutputPin(uint32 index) override { return OutPins[index]; }
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override {}
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override { return true; }
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override { return true; }
     void DrawData(NodeGraph* graph, NodeHandle nodeHandle, bool isDebugMode) override {}
 };
 
@@ -119,7 +120,7 @@ struct Node_LowerCase : NodeImpl
     const PinDesc& GetInputPin(uint32 index) override { return InPins[index]; }
     const PinDesc& GetOutputPin(uint32 index) override { return OutPins[index]; }
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override {}
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override { return true; }
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override { return true; }
     void DrawData(NodeGraph* graph, NodeHandle nodeHandle, bool isDebugMode) override {}
 };
 
@@ -179,6 +180,7 @@ struct Node_CreateProcess final : NodeImpl
         // props
         char executeCmd[2048];
         char title[64];
+        char phaseMarker[256];  // Regex, output lines that match it start a new phase (sub-event) in the task
         int  successRetCode;
         bool checkRetCode;
         bool fatalErrorOnFail;
@@ -187,6 +189,7 @@ struct Node_CreateProcess final : NodeImpl
         // runtime
         int  cmdTextInputWidth;
         char errorStr[2048];
+        FormatTemplate* cmdTemplate;
         SysProcess* runningProc;
         int textSelectionStart;
         int textSelectionEnd;
@@ -205,7 +208,7 @@ struct Node_CreateProcess final : NodeImpl
     const PinDesc& GetInputPin(uint32 index) override { return InPins[index]; }
     const PinDesc& GetOutputPin(uint32 index) override { return OutPins[index]; }
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override;
     void DrawData(NodeGraph* graph, NodeHandle nodeHandle, bool isDebugMode) override {}
 
     static int CmdEditCallback(ImGuiInputTextCallbackData* data);
@@ -264,6 +267,7 @@ struct Node_ShellExecute final : NodeImpl
 
         // runtime
         char errorStr[1024];
+        FormatTemplate* argsTemplate;
         SysProcess* runningProc;
         int selectedOp;
         int textSelectionStart;
@@ -283,7 +287,7 @@ struct Node_ShellExecute final : NodeImpl
     const PinDesc& GetInputPin(uint32 index) override { return InPins[index]; }
     const PinDesc& GetOutputPin(uint32 index) override { return OutPins[index]; }
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override;
     void DrawData(NodeGraph* graph, NodeHandle nodeHandle, bool isDebugMode) override {}
 
     static int CmdEditCallback(ImGuiInputTextCallbackData* data);
@@ -345,7 +349,7 @@ struct Node_JoinString final : NodeImpl
     const PinDesc& GetInputPin(uint32 index) override { return InPins[index]; }
     const PinDesc& GetOutputPin(uint32 index) override { return OutPins[index]; }
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override;
     void DrawData(NodeGraph* graph, NodeHandle nodeHandle, bool isDebugMode) override {}
     static void Register();
 };
@@ -400,7 +404,7 @@ struct Node_JoinStringArray final : NodeImpl
     const PinDesc& GetInputPin(uint32 index) override { return InPins[index]; }
     const PinDesc& GetOutputPin(uint32 index) override { return OutPins[index]; }
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override;
     void DrawData(NodeGraph* graph, NodeHandle nodeHandle, bool isDebugMode) override {}
     static void Register();
 };
@@ -455,7 +459,7 @@ struct Node_SplitString final : NodeImpl
     const PinDesc& GetInputPin(uint32 index) override { return InPins[index]; }
     const PinDesc& GetOutputPin(uint32 index) override { return OutPins[index]; }
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override;
     void DrawData(NodeGraph* graph, NodeHandle nodeHandle, bool isDebugMode) override {}
 
     static void Register();
@@ -508,7 +512,7 @@ struct Node_SplitPath final : NodeImpl
     const PinDesc& GetInputPin(uint32 index) override { return InPins[index]; }
     const PinDesc& GetOutputPin(uint32 index) override { return OutPins[index]; }
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override {}
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override { return true; }
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override { return true; }
     void DrawData(NodeGraph* graph, NodeHandle nodeHandle, bool isDebugMode) override {}
 
     static void Register(); 
@@ -565,7 +569,7 @@ struct Node_IsFile final : NodeImpl
     const PinDesc& GetInputPin(uint32 index) override { return InPins[index]; }
     const PinDesc& GetOutputPin(uint32 index) override { return OutPins[index]; }
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override {}
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override { return true; }
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override { return true; }
     void DrawData(NodeGraph* graph, NodeHandle nodeHandle, bool isDebugMode) override {}
     static void Register(); 
 };
@@ -613,7 +617,7 @@ struct Node_IsDir : NodeImpl
     const PinDesc& GetInputPin(uint32 index) override { return InPins[index]; }
     const PinDesc& GetOutputPin(uint32 index) override { return OutPins[index]; }
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override {}
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override { return true; }
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override { return true; }
     void DrawData(NodeGraph* graph, NodeHandle nodeHandle, bool isDebugMode) override {}
     static void Register(); 
 };
@@ -663,7 +667,7 @@ struct Node_BoolIf final : NodeImpl
     const PinDesc& GetInputPin(uint32 index) override { return InPins[index]; }
     const PinDesc& GetOutputPin(uint32 index) override { return OutPins[index]; }
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override {}
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override { return true; }
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override { return true; }
     void DrawData(NodeGraph* graph, NodeHandle nodeHandle, bool isDebugMode) override {}
     static void Register(); 
 };
@@ -703,7 +707,7 @@ struct Node_BoolNegate : NodeImpl
     const PinDesc& GetInputPin(uint32 index) override { return InPins[index]; }
     const PinDesc& GetOutputPin(uint32 index) override { return OutPins[index]; }
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override {}
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override { return true; }
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override { return true; }
     void DrawData(NodeGraph* graph, NodeHandle nodeHandle, bool isDebugMode) override {}
     static void Register(); 
 };
@@ -754,7 +758,7 @@ struct Node_MathCounter final : NodeImpl
     const PinDesc& GetInputPin(uint32 index) override { return InPins[index]; }
     const PinDesc& GetOutputPin(uint32 index) override { return OutPins[index]; }
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override;
     void DrawData(NodeGraph* graph, NodeHandle nodeHandle, bool isDebugMode) override {}
     static void Register(); 
 };
@@ -823,7 +827,7 @@ struct Node_CompareString final : NodeImpl
     void Abort(NodeGraph* graph, NodeHandle nodeHandle) override {}
     bool ShowEditUI(NodeGraph* graph, NodeHandle nodeHandle) override;
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override;
     const PinDesc& GetInputPin(uint32 index) override { return InPins[index]; }
     const PinDesc& GetOutputPin(uint32 index) override { return OutPins[index]; }
     const char* GetTitleUI(NodeGraph* graph, NodeHandle handle) override { return nullptr; }
@@ -866,7 +870,7 @@ struct Node_StringConstant final : NodeImpl
     bool Execute(NodeGraph* graph, NodeHandle nodeHandle, const Array<PinHandle>& inPins, const Array<PinHandle>& outPins) override;
     void Abort(NodeGraph* graph, NodeHandle nodeHandle) override {}
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override;
     const PinDesc& GetInputPin(uint32 index) override { return kEmptyPin; }
     const PinDesc& GetOutputPin(uint32 index) override { return OutPins[index]; }
     const char* GetLastError(NodeGraph* graph, NodeHandle nodeHandle) override { return nullptr; }
@@ -915,7 +919,7 @@ struct Node_Constants final : NodeImpl
     bool Execute(NodeGraph* graph, NodeHandle nodeHandle, const Array<PinHandle>& inPins, const Array<PinHandle>& outPins) override;
     void Abort(NodeGraph* graph, NodeHandle nodeHandle) override {}
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override;
     const PinDesc& GetInputPin(uint32 index) override { return kEmptyPin; }
     const PinDesc& GetOutputPin(uint32 index) override { return OutPins[index]; }
     const char* GetLastError(NodeGraph* graph, NodeHandle nodeHandle) override { return nullptr; }
@@ -958,7 +962,7 @@ struct Node_IntConstant final : NodeImpl
     bool Execute(NodeGraph* graph, NodeHandle nodeHandle, const Array<PinHandle>& inPins, const Array<PinHandle>& outPins) override;
     void Abort(NodeGraph* graph, NodeHandle nodeHandle) override {}
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override;
     const PinDesc& GetInputPin(uint32 index) override { return kEmptyPin; }
     const PinDesc& GetOutputPin(uint32 index) override { return OutPins[index]; }
     const char* GetLastError(NodeGraph* graph, NodeHandle nodeHandle) override { return nullptr; }
@@ -1028,7 +1032,7 @@ struct Node_Selector final : NodeImpl
     bool ShowEditUI(NodeGraph* graph, NodeHandle nodeHandle) override;
     bool Execute(NodeGraph* graph, NodeHandle nodeHandle, const Array<PinHandle>& inPins, const Array<PinHandle>& outPins) override;
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override;
     void Abort(NodeGraph* graph, NodeHandle nodeHandle) override {}
     const PinDesc& GetInputPin(uint32 index) override { return InPins[index]; }
     const PinDesc& GetOutputPin(uint32 index) override { return OutPins[index]; }
@@ -1090,7 +1094,7 @@ struct Node_EmbedGraph final : NodeImpl
     bool ShowEditUI(NodeGraph* graph, NodeHandle nodeHandle) override;
     bool Execute(NodeGraph* graph, NodeHandle nodeHandle, const Array<PinHandle>& inPins, const Array<PinHandle>& outPins) override;
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override;
     void Abort(NodeGraph* graph, NodeHandle nodeHandle) override;
     const PinDesc& GetInputPin(uint32 index) override { return InPins[index]; }
     const PinDesc& GetOutputPin(uint32 index) override { return OutPins[index]; }
@@ -1140,6 +1144,7 @@ struct Node_FormatString : NodeImpl
 
         // runtime
         char errorStr[1024];
+        FormatTemplate* textTemplate;
         int textSelectionStart;
         int textSelectionEnd;
         int textCursor;
@@ -1153,7 +1158,7 @@ struct Node_FormatString : NodeImpl
     bool ShowEditUI(NodeGraph* graph, NodeHandle nodeHandle) override;
     bool Execute(NodeGraph* graph, NodeHandle nodeHandle, const Array<PinHandle>& inPins, const Array<PinHandle>& outPins) override;
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override;
     void Abort(NodeGraph* graph, NodeHandle nodeHandle) override {}
     const PinDesc& GetInputPin(uint32 index) override { return InPins[index]; }
     const PinDesc& GetOutputPin(uint32 index) override { return OutPins[index]; }
@@ -1188,7 +1193,7 @@ struct Node_GraphOutput : NodeImpl
     bool ShowEditUI(NodeGraph* graph, NodeHandle nodeHandle) override { return true; }
     bool Execute(NodeGraph* graph, NodeHandle nodeHandle, const Array<PinHandle>& inPins, const Array<PinHandle>& outPins) override;
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override { }
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override { return true; } 
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override { return true; } 
     void Abort(NodeGraph* graph, NodeHandle nodeHandle) override {}
     const PinDesc& GetInputPin(uint32 index) override { return InPins[index]; }
     const PinDesc& GetOutputPin(uint32 index) override { return kEmptyPin; }
@@ -1222,7 +1227,7 @@ struct Node_GraphMetaData : NodeImpl
     bool ShowEditUI(NodeGraph* graph, NodeHandle nodeHandle) override { return true; }
     bool Execute(NodeGraph* graph, NodeHandle nodeHandle, const Array<PinHandle>& inPins, const Array<PinHandle>& outPins) override;
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override { }
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override { return true; } 
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override { return true; } 
     void Abort(NodeGraph* graph, NodeHandle nodeHandle) override {}
     const PinDesc& GetInputPin(uint32 index) override { return InPins[index]; }
     const PinDesc& GetOutputPin(uint32 index) override { return kEmptyPin; }
@@ -1280,7 +1285,7 @@ struct Node_ListDir final : NodeImpl
     bool ShowEditUI(NodeGraph* graph, NodeHandle nodeHandle) override;
     bool Execute(NodeGraph* graph, NodeHandle nodeHandle, const Array<PinHandle>& inPins, const Array<PinHandle>& outPins) override;
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override;
     void Abort(NodeGraph* graph, NodeHandle nodeHandle) override {}
     const PinDesc& GetInputPin(uint32 index) override { return InPins[index]; }
     const PinDesc& GetOutputPin(uint32 index) override { return OutPins[index]; }
@@ -1351,7 +1356,7 @@ struct Node_TranslateString final : NodeImpl
     bool ShowEditUI(NodeGraph* graph, NodeHandle nodeHandle) override;
     bool Execute(NodeGraph* graph, NodeHandle nodeHandle, const Array<PinHandle>& inPins, const Array<PinHandle>& outPins) override;
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override;
     void Abort(NodeGraph* graph, NodeHandle nodeHandle) override {}
     const PinDesc& GetInputPin(uint32 index) override { return InPins[index]; }
     const PinDesc& GetOutputPin(uint32 index) override { return OutPins[index]; }
@@ -1395,7 +1400,7 @@ struct Node_SetEnvVar final : NodeImpl
     bool ShowEditUI(NodeGraph* graph, NodeHandle nodeHandle) override { return true; }
     bool Execute(NodeGraph* graph, NodeHandle nodeHandle, const Array<PinHandle>& inPins, const Array<PinHandle>& outPins) override;
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override {}
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override { return true; }
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override { return true; }
     void Abort(NodeGraph* graph, NodeHandle nodeHandle) override {}
     const PinDesc& GetInputPin(uint32 index) override { return InPins[index]; }
     const PinDesc& GetOutputPin(uint32 index) override { return OutPins[index]; }
@@ -1436,7 +1441,7 @@ struct Node_GetEnvVar final : NodeImpl
     bool ShowEditUI(NodeGraph* graph, NodeHandle nodeHandle) override;
     bool Execute(NodeGraph* graph, NodeHandle nodeHandle, const Array<PinHandle>& inPins, const Array<PinHandle>& outPins) override;
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override;
     void Abort(NodeGraph* graph, NodeHandle nodeHandle) override {}
     const PinDesc& GetInputPin(uint32 index) override { return kEmptyPin; }
     const PinDesc& GetOutputPin(uint32 index) override { return OutPins[index]; }
@@ -1477,7 +1482,7 @@ struct Node_GetSettingsVar final : NodeImpl
     bool ShowEditUI(NodeGraph* graph, NodeHandle nodeHandle) override;
     bool Execute(NodeGraph* graph, NodeHandle nodeHandle, const Array<PinHandle>& inPins, const Array<PinHandle>& outPins) override;
     void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
-    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) override;
+    bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) override;
     void Abort(NodeGraph* graph, NodeHandle nodeHandle) override {}
     const PinDesc& GetInputPin(uint32 index) override { return kEmptyPin; }
     const PinDesc& GetOutputPin(uint32 index) override { return OutPins[index]; }
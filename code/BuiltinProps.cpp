@@ -2,6 +2,7 @@
 
 #include "External/sjson/sjson.h"
 #include "Core/Blobs.h"
+#include "Core/JsonParser.h"
 
 #include "Main.h"
 #include "NodeGraph.h"
@@ -27,7 +28,7 @@ struct NodeGraphVoidProp final : PropertyImpl
     bool ShowCreateUI(NodeGraph* graph, PropertyHandle propHandle, PinData& initialDataInOut) override { return true; }
     void InitializeDataFromPin(NodeGraph* graph, PropertyHandle propHandle) override {}
     void SaveDataToJson(NodeGraph* graph, PropertyHandle propHandle, sjson_context* jctx, sjson_node* jparent) override {}
-    bool LoadDataFromJson(NodeGraph* graph, PropertyHandle propHandle, sjson_context* jctx, sjson_node* jparent) override { return true; }
+    bool LoadDataFromJson(NodeGraph* graph, PropertyHandle propHandle, const JsonNode& jparent) override { return true; }
     void CopyInternalData(NodeGraph* graph, PropertyHandle propHandle, const void* srcData) override {}
 };
 
@@ -50,7 +51,7 @@ struct NodeGraphBooleanProp final : PropertyImpl
     void Release(NodeGraph* graph, PropertyHandle) override {}
     void InitializeDataFromPin(NodeGraph* graph, PropertyHandle propHandle) override {}
     void SaveDataToJson(NodeGraph* graph, PropertyHandle propHandle, sjson_context* jctx, sjson_node* jparent) override {}
-    bool LoadDataFromJson(NodeGraph* graph, PropertyHandle propHandle, sjson_context* jctx, sjson_node* jparent) override { return true; }
+    bool LoadDataFromJson(NodeGraph* graph, PropertyHandle propHandle, const JsonNode& jparent) override { return true; }
     void CopyInternalData(NodeGraph* graph, PropertyHandle propHandle, const void* data) override {}
 };
 
@@ -73,7 +74,7 @@ struct NodeGraphIntProp final : PropertyImpl
     bool Initialize(NodeGraph* graph, PropertyHandle) override   {  return true; };
     void Release(NodeGraph* graph, PropertyHandle) override       {}
     void SaveDataToJson(NodeGraph* graph, PropertyHandle propHandle, sjson_context* jctx, sjson_node* jparent) override {}
-    bool LoadDataFromJson(NodeGraph* graph, PropertyHandle propHandle, sjson_context* jctx, sjson_node* jparent) override { return true; }
+    bool LoadDataFromJson(NodeGraph* graph, PropertyHandle propHandle, const JsonNode& jparent) override { return true; }
     void CopyInternalData(NodeGraph* graph, PropertyHandle propHandle, const void* data) override {}
 };
 
@@ -137,7 +138,7 @@ struct NodeGraphStringProp final : PropertyImpl
     }
 
     void SaveDataToJson(NodeGraph* graph, PropertyHandle propHandle, sjson_context* jctx, sjson_node* jparent) override {}
-    bool LoadDataFromJson(NodeGraph* graph, PropertyHandle propHandle, sjson_context* jctx, sjson_node* jparent) override { return true; }
+    bool LoadDataFromJson(NodeGraph* graph, PropertyHandle propHandle, const JsonNode& jparent) override { return true; }
     void CopyInternalData(NodeGraph* graph, PropertyHandle propHandle, const void* data) override {}
 };
 
@@ -273,25 +274,23 @@ struct NodeGraphEnumProp final : PropertyImpl
         }
     }
 
-    bool LoadDataFromJson(NodeGraph* graph, PropertyHandle propHandle, sjson_context* jctx, sjson_node* jparent) override
+    bool LoadDataFromJson(NodeGraph* graph, PropertyHandle propHandle, const JsonNode& jparent) override
     {
         Property& prop = ngGetPropertyData(graph, propHandle);
         Data* data = (Data*)prop.data;
         data->items.Clear();
 
-        sjson_node* jitems = sjson_find_member(jparent, "Items");
-        if (jitems) {
-            sjson_node* jitem = sjson_first_child(jitems);
-
-            while (jitem) {
+        JsonNode jitems = jparent.GetChild("Items");
+        if (jitems.IsValid()) {
+            for (JsonNode jitem = jitems.GetArrayItem(); jitem.IsValid(); jitem = jitems.GetNextArrayItem(jitem)) {
                 EnumItem item;
-                item.name = sjson_get_string(jitem, "Name", "");
+                jitem.GetChildValue("Name", item.name.Ptr(), item.name.Capacity());
+                item.name.CalcLength();
                 ASSERT_MSG(!item.name.IsEmpty(), "Something went wrong! 'Name' cannot be empty");
-                item.alias = sjson_get_string(jitem, "Alias", "");
+                jitem.GetChildValue("Alias", item.alias.Ptr(), item.alias.Capacity());
+                item.alias.CalcLength();
 
                 data->items.Push(item);
-
-                jitem = jitem->next;
             }
         }
 
@@ -473,22 +472,20 @@ struct NodeGraphMultiSelectProp final : PropertyImpl
         }
     }
 
-    bool LoadDataFromJson(NodeGraph* graph, PropertyHandle propHandle, sjson_context* jctx, sjson_node* jparent) override
+    bool LoadDataFromJson(NodeGraph* graph, PropertyHandle propHandle, const JsonNode& jparent) override
     {
         Property& prop = ngGetPropertyData(graph, propHandle);
         Data* data = (Data*)prop.data;
         data->items.Clear();
 
-        sjson_node* jitems = sjson_find_member(jparent, "Items");
-        if (jitems) {
-            sjson_node* jitem = sjson_first_child(jitems);
-
-            while (jitem) {
+        JsonNode jitems = jparent.GetChild("Items");
+        if (jitems.IsValid()) {
+            for (JsonNode jitem = jitems.GetArrayItem(); jitem.IsValid(); jitem = jitems.GetNextArrayItem(jitem)) {
                 Item item;
-                item.name = sjson_get_string(jitem, "Name", "");
+                jitem.GetChildValue("Name", item.name.Ptr(), item.name.Capacity());
+                item.name.CalcLength();
                 ASSERT_MSG(!item.name.IsEmpty(), "Something went wrong! 'Name' cannot be empty");
                 data->items.Push(item);
-                jitem = jitem->next;
             }
         }
 
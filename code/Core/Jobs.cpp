@@ -15,6 +15,7 @@
 #include "Debug.h"
 #include "Arrays.h"
 #include "Allocators.h"
+#include "BlitSort.h"
 
 // set this to 1 to spam output with tracy zones debugging
 #define JOBS_DEBUG_TRACY_ZONES 0
@@ -24,6 +25,15 @@ namespace _limits
     static constexpr uint32 kJobsMaxFibers = 128;
     static constexpr uint32 kJobsMaxInstances = 512;
     static constexpr uint32 kJobsMaxPending = 4096;
+    static constexpr uint32 kJobsDequeSize = 512;   // Per worker/priority. Must be power of two. Overflows go to the shared list
+    static constexpr uint32 kJobsIdleSpinCount = 64;    // Times a worker (or external waiter) polls before blocking in the OS
+    static constexpr uint32 kJobsExtraThreadIdleTimeout = 2000;    // msecs. Compensating LongTask threads retire after being idle this long
+    static constexpr uint32 kJobsMinStackSize = 64*kKB;
+    static constexpr uint32 kJobsNumStackBuckets = 8;  // Power of two stack sizes, starting from kJobsMinStackSize (64KB .. 8MB)
+    static constexpr uint32 kJobsDefaultShortTaskStackSize = 256*kKB;
+    static constexpr uint32 kJobsDefaultLongTaskStackSize = 512*kKB;
+    // Inline jobs (jobsParallelFor helpers) run the callbacks on the worker's own stack, which must be as big as the fiber stacks they would get
+    static constexpr uint32 kJobsWorkerStackSize = kJobsDefaultLongTaskStackSize;
 
 #ifdef TRACY_ENABLE
     static constexpr uint32 kJobsMaxTracyStackDepth = 8;
@@ -52,12 +62,18 @@ struct JobsFiberProperties
     JobsFiberProperties* prev;
     uint32 index;
     uint32 stackSize;
+    uint64 dispatchTick;    // When the item was scheduled, for the start latency telemetry
+    bool runInline;         // Runs on the worker thread's own stack without a fiber. The callback must not wait (see jobsParallelFor)
+    bool isDependency;      // Not a job item: Sits in the waiters list of a dependency and releases `instance` when the dependency closes
 };
 
 struct JobsSignalInternal
 {
     atomicUint32 signaled;
-    uint8 reserved[CACHE_LINE_SIZE-4];
+    atomicUint32 waitersLock;
+    JobsFiberProperties* waiters;       // Fibers parked on the signal, each Raise wakes one of them
+    atomicUint32 numExternalWaiters;    // Non-worker threads blocked on `value`
+    uint8 reserved[CACHE_LINE_SIZE - sizeof(atomicUint32)*3 - sizeof(void*)];
     atomicUint32 value;
 };
 static_assert(sizeof(JobsSignalInternal) <= sizeof(JobsSignal), "Mismatch sizes between JobsSignal and JobsSignalInternal");
@@ -79,9 +95,9 @@ struct JobsTracyZone
 struct JobsFiber
 {
     uint32 ownerTid;
+    uint32 stackBucket;
     mco_coro* co;
     mco_desc coDesc;
-    atomicUint32* childCounter;
     JobsFiberProperties* props;
     JobsSignalInternal* signal;
     #ifdef TRACY_ENABLE
@@ -89,28 +105,88 @@ struct JobsFiber
     #endif
 };
 
+// Chase-Lev work-stealing deque (bounded): https://www.dre.vanderbilt.edu/~schmidt/PDF/work-stealing-dequeue.pdf
+// Only the owner worker pushes and pops from the bottom, other workers of the same type steal from the top
+struct JobsDeque
+{
+    bool Push(JobsFiberProperties* props);
+    JobsFiberProperties* Pop();
+    JobsFiberProperties* Steal();
+
+    atomicUint64 mTop;
+    uint8 _padding1[CACHE_LINE_SIZE - sizeof(atomicUint64)];
+    atomicUint64 mBottom;
+    uint8 _padding2[CACHE_LINE_SIZE - sizeof(atomicUint64)];
+    atomicPtr mItems[_limits::kJobsDequeSize];
+};
+
+enum class JobsWorkerState : uint32
+{
+    Search = 0,
+    Busy,
+    Idle,
+    _Count
+};
+
+struct alignas(CACHE_LINE_SIZE) JobsWorker
+{
+    JobsDeque deques[uint32(JobsPriority::_Count)];
+    uint32 cpuIndex;        // UINT32_MAX if not pinned
+    uint32 cacheDomain;     // UINT32_MAX if not pinned
+
+    // Telemetry: Only the thread that owns the slot writes these, jobsGetTelemetry reads them without syncing
+    uint64 times[uint32(JobsWorkerState::_Count)];
+    uint64 stateTick;       // When the current state started, zero if the thread is not running
+    JobsWorkerState state;
+    uint64 numItemsRun;
+    uint64 numSteals;
+    uint64 numStarted;
+    uint64 latencyTotal;
+    uint64 latencyHistogram[kJobsLatencyBuckets];
+};
+
 struct JobsThreadData
 {
     JobsFiber* curFiber;
     JobsInstance* waitInstance;
+    JobsWorker* worker;
     JobsType type;
     uint32 threadIndex;
     uint32 threadId;
+    uint32 stealIndex;
+};
+
+enum class JobsThreadState : uint32
+{
+    Idle = 0,   // Slot is free, thread was never started
+    Running,
+    Exited      // Retired compensating thread, needs to be joined before the slot is used again
 };
 
+// Waiters list of the instance is closed when all the fibers are done. Waiting fibers are parked on the list and get re-scheduled on close
+static inline constexpr atomicPtr kJobsWaitersClosed = 1;
+
 struct alignas(CACHE_LINE_SIZE) JobsInstance
 {
     atomicUint32 counter;                       // Atomic counter of sub items within a job 
     uint8 _padding1[CACHE_LINE_SIZE - 4];        // padding for the atomic var to fit inside a cache line
+    atomicPtr waiters;                          // JobsFiberProperties list of waiting fibers, or kJobsWaitersClosed when finished
+    atomicUint32 closed;                        // Non-worker threads block on this one. Set right before `waiters` is closed
+    atomicUint32 numExternalWaiters;
+    _private::JobsDestroyUserDataCallback destroyUserDataFn;   // Called on close, for userData owned by the job (lambda dispatches)
+    void* userData;
+    JobsFiberProperties* pendingItem;           // Items of jobsDispatchAfter are held here (index=groupSize) until all dependencies finish
+    atomicUint32 numPendingDeps;
     JobsType type;
     bool isAutoDelete;
-    uint8 _padding2[CACHE_LINE_SIZE - sizeof(JobsType) - sizeof(bool)];
+    uint8 _padding2[CACHE_LINE_SIZE - sizeof(atomicPtr) - sizeof(atomicUint32)*3 - sizeof(void*)*3 - sizeof(JobsType) - sizeof(bool)];
 };
 
 struct JobsWaitingList
 {
     JobsFiberProperties* waitingList[static_cast<uint32>(JobsPriority::_Count)];
     JobsFiberProperties* waitingListLast[static_cast<uint32>(JobsPriority::_Count)];
+    uint32 counts[static_cast<uint32>(JobsPriority::_Count)];
 };
 
 template <typename _T, uint32 _MaxCount> 
@@ -129,26 +205,50 @@ struct alignas(CACHE_LINE_SIZE) JobsAtomicPool
     uint8 _reserved2[CACHE_LINE_SIZE - sizeof(void*) * 2];
 };
 
+// Pooled fiber stacks of the same size. Each one is a separate virtual memory reservation laid out as:
+//  [mco_coro + context + storage][padding to page][guard page][stack]
+// minicoro places the stack right after the coroutine objects (see `_mco_create_context`). We hand it a stack that spans
+// the padding and the guard page too, so the guard sits directly below the usable stack and overflows fault before 
+// they can reach the coroutine state
+struct JobsStackBucket
+{
+    AtomicLock lock;
+    void** freeStacks;
+    uint32 numFree;
+    uint32 maxFree;
+    size_t headerSize;      // mco_coro + context + storage, where minicoro's stack begins
+    size_t blockSize;       // Reserved size, including the guard page
+};
+
 struct JobsContext
 {
     JobsInitParams initParams;
     Thread* threads[uint32(JobsType::_Count)];
     uint32 numThreads[uint32(JobsType::_Count)];
-    uint8 _padding1[8];
+    uint32 maxThreads[uint32(JobsType::_Count)];                // numThreads + compensating threads (see jobsBeginBlockingSection)
 
-    MemTlsfAllocator tlsfAlloc;
-    uint8 _padding2[alignof(MemThreadSafeAllocator) - sizeof(MemTlsfAllocator)];
-    MemThreadSafeAllocator runtimeAlloc;
-    JobsWaitingList waitingLists[uint32(JobsType::_Count)];
+    JobsStackBucket stackBuckets[_limits::kJobsNumStackBuckets];
+    JobsWaitingList waitingLists[uint32(JobsType::_Count)];     // Shared lists for dispatches from non-worker threads (and deque overflows)
     uint8 _padding3[sizeof(JobsWaitingList) * 2 - alignof(JobsLock)];
     JobsLock waitingListLock;
     Semaphore semaphores[uint32(JobsType::_Count)];
+    JobsWorker* workers[uint32(JobsType::_Count)];
+    atomicUint32 numWaiting[uint32(JobsType::_Count)];          // Items in the shared waiting lists
+    atomicUint32 numSleeping[uint32(JobsType::_Count)];         // Workers that are blocked on the semaphore
+    atomicUint32 numSpinning[uint32(JobsType::_Count)];
+    atomicUint32 numBlocked[uint32(JobsType::_Count)];          // Workers inside blocking sections
+    atomicUint32 numExtraThreads[uint32(JobsType::_Count)];     // Running compensating threads
+    atomicUint32* threadStates[uint32(JobsType::_Count)];       // Per thread slot: JobsThreadState
+    uint32 idleSpinCount;
     JobsAtomicPool<JobsInstance, _limits::kJobsMaxInstances>* instancePool;
     JobsAtomicPool<JobsFiberProperties, _limits::kJobsMaxPending>* fiberPropsPool;
-    StaticArray<Pair<void*, uint32>, 7> pointers;    // Storing memory pointers, For garbage collection at release
+    StaticArray<Pair<void*, uint32>, 8> pointers;    // Storing memory pointers, For garbage collection at release
 
     // Stats
-    size_t runtimeHeapTotal;
+    atomicUint64 stackReservedSize;
+    atomicUint64 stackInUseSize;
+    atomicUint32 numStacksCreated;
+    atomicUint32 numStacksReused;
     size_t initHeapStart;
     size_t initHeapSize;
 
@@ -156,6 +256,7 @@ struct JobsContext
     atomicUint32 numBusyLongThreads;
     atomicUint32 numFibers;
     atomicUint32 numInstances;
+    atomicUint32 numExtraThreadSpawns;
 
     struct MaxValues
     {
@@ -163,10 +264,11 @@ struct JobsContext
         uint32 numBusyLongThreadsMax;
         uint32 numFibersMax;
         uint32 numInstancesMax;
-        uint32 maxFiberHeap;
+        size_t maxFiberHeap;
+        uint32 numBlockedLongThreadsMax;
+        uint32 numExtraLongThreadsMax;
     };
 
-    uint32 fiberHeapAllocSize;
     MaxValues maxValues[2];     // Index: 0 = Write, 1 = Present
 
     bool quit;
@@ -179,16 +281,65 @@ static thread_local JobsThreadData* gJobsThreadData = nullptr;      // Only work
 // Use no_inline function to return our TL var. To avoid compiler confusion with thread-locals when switching fibers
 NO_INLINE static JobsThreadData* jobsGetThreadData() { return gJobsThreadData; }
 
-static void* jobsMcoMallocFn(size_t size, void* allocData)
+static uint32 jobsGetStackBucket(uint32 stackSize)
 {
-    Allocator* alloc = reinterpret_cast<Allocator*>(allocData);
-    return memAllocAligned(size, 16, alloc);
+    uint32 bucket = 0;
+    while ((_limits::kJobsMinStackSize << bucket) < stackSize && bucket < _limits::kJobsNumStackBuckets - 1)
+        bucket++;
+    ASSERT_MSG((_limits::kJobsMinStackSize << bucket) >= stackSize, "Fiber stack size is too big: %u", stackSize);
+    return bucket;
 }
-    
-static void jobsMcoFreeFn(void* ptr, void* allocData)
+
+// Pops a stack from the pool, or reserves a new one. Only the coroutine objects are prefaulted, stack pages are 
+// backed on first touch. So big stacks only cost as much as the deepest call chain that ran on them
+static void* jobsAcquireFiberStack(uint32 bucketIndex)
 {
-    Allocator* alloc = reinterpret_cast<Allocator*>(allocData);
-    memFreeAligned(ptr, 16, alloc);
+    JobsStackBucket& bucket = gJobs.stackBuckets[bucketIndex];
+    atomicFetchAdd64Explicit(&gJobs.stackInUseSize, bucket.blockSize, AtomicMemoryOrder::Relaxed);
+    {
+        AtomicLockScope lock(bucket.lock);
+        if (bucket.numFree) {
+            atomicFetchAdd32Explicit(&gJobs.numStacksReused, 1, AtomicMemoryOrder::Relaxed);
+            return bucket.freeStacks[--bucket.numFree];
+        }
+    }
+
+    // The guard page right after the header stays reserved with no access. Stacks grow down towards it, so overflows
+    // fault right away 
+    size_t pageSize = sysGetPageSize();
+    size_t headerCommitSize = AlignValue<size_t>(bucket.headerSize, pageSize);
+    size_t stackOffset = headerCommitSize + pageSize;
+    uint8* mem = reinterpret_cast<uint8*>(memVirtualReserve(bucket.blockSize));
+    if (!mem)
+        return nullptr;
+    memVirtualCommit(mem, headerCommitSize);
+    memVirtualCommit(mem + stackOffset, bucket.blockSize - stackOffset, MemVirtualFlags::NoPrefault);
+
+    atomicFetchAdd32Explicit(&gJobs.numStacksCreated, 1, AtomicMemoryOrder::Relaxed);
+    atomicFetchAdd64Explicit(&gJobs.stackReservedSize, bucket.blockSize, AtomicMemoryOrder::Relaxed);
+    return mem;
+}
+
+static void jobsFreeFiberStack(uint32 bucketIndex, void* ptr)
+{
+    JobsStackBucket& bucket = gJobs.stackBuckets[bucketIndex];
+    memVirtualRelease(ptr, bucket.blockSize);
+    atomicFetchSub64Explicit(&gJobs.stackReservedSize, bucket.blockSize, AtomicMemoryOrder::Relaxed);
+}
+
+static void jobsReleaseFiberStack(uint32 bucketIndex, void* ptr)
+{
+    JobsStackBucket& bucket = gJobs.stackBuckets[bucketIndex];
+    atomicFetchSub64Explicit(&gJobs.stackInUseSize, bucket.blockSize, AtomicMemoryOrder::Relaxed);
+    {
+        AtomicLockScope lock(bucket.lock);
+        if (bucket.numFree < bucket.maxFree) {
+            bucket.freeStacks[bucket.numFree++] = ptr;
+            return;
+        }
+    }
+
+    jobsFreeFiberStack(bucketIndex, ptr);
 }
 
 static void jobsJumpIn(mco_coro* co)
@@ -249,6 +400,7 @@ INLINE void jobsAddToList(JobsWaitingList* list, JobsFiberProperties* props)
     *plast = props;
     if (*pfirst == NULL)
         *pfirst = props;
+    list->counts[index]++;
 }
 
 INLINE void jobsRemoveFromList(JobsWaitingList* list, JobsFiberProperties* props)
@@ -266,6 +418,270 @@ INLINE void jobsRemoveFromList(JobsWaitingList* list, JobsFiberProperties* props
     if (*plast == props)
         *plast = props->prev;
     props->prev = props->next = nullptr;
+    list->counts[index]--;
+}
+
+bool JobsDeque::Push(JobsFiberProperties* props)
+{
+    uint64 b = atomicLoad64Explicit(&mBottom, AtomicMemoryOrder::Relaxed);
+    uint64 t = atomicLoad64Explicit(&mTop, AtomicMemoryOrder::Acquire);
+    if (int64(b - t) >= int64(_limits::kJobsDequeSize))
+        return false;
+
+    atomicStorePtrExplicit(&mItems[b & (_limits::kJobsDequeSize - 1)], atomicPtr((uintptr_t)props), AtomicMemoryOrder::Relaxed);
+    atomicStore64Explicit(&mBottom, b + 1, AtomicMemoryOrder::Release);
+    return true;
+}
+
+JobsFiberProperties* JobsDeque::Pop()
+{
+    uint64 b = atomicLoad64Explicit(&mBottom, AtomicMemoryOrder::Relaxed) - 1;
+    atomicStore64Explicit(&mBottom, b, AtomicMemoryOrder::Relaxed);
+    atomicThreadFence(AtomicMemoryOrder::Seqcst);
+    uint64 t = atomicLoad64Explicit(&mTop, AtomicMemoryOrder::Relaxed);
+
+    JobsFiberProperties* props = nullptr;
+    if (int64(t) <= int64(b)) {
+        props = reinterpret_cast<JobsFiberProperties*>((uintptr_t)atomicLoadPtrExplicit(&mItems[b & (_limits::kJobsDequeSize - 1)], AtomicMemoryOrder::Relaxed));
+        if (t == b) {
+            // Last item, race against the thieves
+            unsigned long long expected = t;
+            if (!atomicCompareExchange64StrongExplicit(&mTop, &expected, t + 1, AtomicMemoryOrder::Seqcst, AtomicMemoryOrder::Relaxed))
+                props = nullptr;
+            atomicStore64Explicit(&mBottom, b + 1, AtomicMemoryOrder::Relaxed);
+        }
+    }
+    else {
+        atomicStore64Explicit(&mBottom, b + 1, AtomicMemoryOrder::Relaxed);
+    }
+    return props;
+}
+
+JobsFiberProperties* JobsDeque::Steal()
+{
+    uint64 t = atomicLoad64Explicit(&mTop, AtomicMemoryOrder::Acquire);
+    atomicThreadFence(AtomicMemoryOrder::Seqcst);
+    uint64 b = atomicLoad64Explicit(&mBottom, AtomicMemoryOrder::Acquire);
+
+    if (int64(t) < int64(b)) {
+        JobsFiberProperties* props = reinterpret_cast<JobsFiberProperties*>((uintptr_t)atomicLoadPtrExplicit(&mItems[t & (_limits::kJobsDequeSize - 1)], AtomicMemoryOrder::Relaxed));
+        unsigned long long expected = t;
+        if (atomicCompareExchange64StrongExplicit(&mTop, &expected, t + 1, AtomicMemoryOrder::Seqcst, AtomicMemoryOrder::Relaxed))
+            return props;
+    }
+    return nullptr;
+}
+
+// Wakes up sleeping workers. Pairs with the `numSleeping` increment + re-check in jobsThreadFn, so wake-ups are never lost
+static void jobsWakeWorkers(JobsType type, uint32 count)
+{
+    uint32 typeIndex = uint32(type);
+    atomicThreadFence(AtomicMemoryOrder::Seqcst);
+    uint32 numSleeping = atomicLoad32Explicit(&gJobs.numSleeping[typeIndex], AtomicMemoryOrder::Relaxed);
+    if (numSleeping)
+        gJobs.semaphores[typeIndex].Post(Min(numSleeping, count));
+}
+
+// Puts the fiber in the local deque if we are on a worker of the same type, otherwise in the shared waiting list
+static void jobsSchedule(JobsFiberProperties* props, JobsType type)
+{
+    ASSERT(props->next == nullptr && props->prev == nullptr);
+    
+    JobsThreadData* tdata = jobsGetThreadData();
+    if (!tdata || tdata->type != type || !tdata->worker->deques[uint32(props->prio)].Push(props)) {
+        JobsLockScope lock(gJobs.waitingListLock);
+        jobsAddToList(&gJobs.waitingLists[uint32(type)], props);
+        atomicFetchAdd32Explicit(&gJobs.numWaiting[uint32(type)], 1, AtomicMemoryOrder::Release);
+    }
+}
+
+static JobsFiberProperties* jobsFindWork(JobsThreadData* tdata)
+{
+    uint32 typeIndex = uint32(tdata->type);
+    uint32 numWorkers = gJobs.maxThreads[typeIndex];    // Slots of retired (or not yet started) threads have empty deques
+    JobsWorker* workers = gJobs.workers[typeIndex];
+
+    // Higher priorities first, for each priority: local deque -> shared list -> steal from other workers
+    for (uint32 prioIdx = 0; prioIdx < static_cast<uint32>(JobsPriority::_Count); prioIdx++) {
+        JobsFiberProperties* props = tdata->worker->deques[prioIdx].Pop();
+        if (props)
+            return props;
+
+        if (atomicLoad32Explicit(&gJobs.numWaiting[typeIndex], AtomicMemoryOrder::Acquire)) {
+            JobsLockScope lock(gJobs.waitingListLock);
+            JobsWaitingList* list = &gJobs.waitingLists[typeIndex];
+            props = list->waitingList[prioIdx];
+            if (props) {
+                jobsRemoveFromList(list, props);
+                atomicFetchSub32Explicit(&gJobs.numWaiting[typeIndex], 1, AtomicMemoryOrder::Relaxed);
+                return props;
+            }
+        }
+
+        // Pinned workers try the victims that share the last level cache with them first, so the stolen job's data is likely warm
+        uint32 cacheDomain = tdata->worker->cacheDomain;
+        for (uint32 pass = cacheDomain != UINT32_MAX ? 0 : 1; pass < 2; pass++) {
+            for (uint32 i = 0; i < numWorkers; i++) {
+                JobsWorker* victim = &workers[(tdata->stealIndex + i) % numWorkers];
+                if (victim == tdata->worker || (cacheDomain != UINT32_MAX && (victim->cacheDomain == cacheDomain) != (pass == 0)))
+                    continue;
+                props = victim->deques[prioIdx].Steal();
+                if (props) {
+                    tdata->stealIndex = uint32(victim - workers);    // Keep stealing from the same victim while it has work
+                    tdata->worker->numSteals++;
+                    return props;
+                }
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+static void jobsParkOnInstance(JobsInstance* inst, JobsFiberProperties* props)
+{
+    atomicPtr head = atomicLoadPtrExplicit(&inst->waiters, AtomicMemoryOrder::Acquire);
+    while (true) {
+        if (head == kJobsWaitersClosed) {
+            // Finished before we could park, continue right away
+            props->next = nullptr;
+            jobsSchedule(props, props->instance->type);
+            jobsWakeWorkers(props->instance->type, 1);
+            return;
+        }
+
+        props->next = reinterpret_cast<JobsFiberProperties*>((uintptr_t)head);
+        if (atomicCompareExchangePtrWeak(&inst->waiters, &head, atomicPtr((uintptr_t)props)))
+            return;
+    }
+}
+
+// Pushes all the group items of a job to the queues. `item` is the template for the items, only the index differs
+static void jobsScheduleItems(const JobsFiberProperties& item, uint32 numItems)
+{
+    JobsType type = item.instance->type;
+    uint64 dispatchTick = timerGetTicks();
+
+    // Push to the local deque of the current worker (others steal from it), or to the shared list if we are not a worker of this type
+    // Reverse order, so the local worker pops them in order
+    for (uint32 i = numItems; i-- > 0;) {
+        JobsFiberProperties* props = gJobs.fiberPropsPool->New();
+        *props = item;
+        props->index = i;
+        props->dispatchTick = dispatchTick;
+        jobsSchedule(props, type);
+    }
+
+    // Fire up the worker threads
+    jobsWakeWorkers(type, numItems);
+}
+
+// One of the dependencies of the instance is finished. The last one schedules the items that were held back
+static void jobsReleaseDependency(JobsInstance* inst)
+{
+    if (atomicFetchSub32(&inst->numPendingDeps, 1) == 1) {
+        JobsFiberProperties* pending = inst->pendingItem;
+        inst->pendingItem = nullptr;
+
+        uint32 numItems = pending->index;
+        pending->index = 0;
+        jobsScheduleItems(*pending, numItems);
+        gJobs.fiberPropsPool->Delete(pending);
+    }
+}
+
+// Same protocol as jobsParkOnInstance, but with a dependency token instead of a fiber
+static void jobsAddDependency(JobsInstance* dep, JobsFiberProperties* token)
+{
+    ASSERT_MSG(!dep->isAutoDelete, "Cannot depend on AutoDelete jobs, they may be gone already");
+
+    atomicPtr head = atomicLoadPtrExplicit(&dep->waiters, AtomicMemoryOrder::Acquire);
+    while (true) {
+        if (head == kJobsWaitersClosed) {
+            JobsInstance* dependent = token->instance;
+            gJobs.fiberPropsPool->Delete(token);
+            jobsReleaseDependency(dependent);
+            return;
+        }
+
+        token->next = reinterpret_cast<JobsFiberProperties*>((uintptr_t)head);
+        if (atomicCompareExchangePtrWeak(&dep->waiters, &head, atomicPtr((uintptr_t)token)))
+            return;
+    }
+}
+
+static void jobsCloseInstance(JobsInstance* inst)
+{
+    // All the sub-items are done, so nothing references the owned userData anymore
+    if (inst->destroyUserDataFn)
+        inst->destroyUserDataFn(inst->userData);
+
+    bool isAutoDelete = inst->isAutoDelete;
+
+    // Wake up the non-worker threads (see jobsWaitForCompletion). Like the fibers, they only return after `waiters` is closed,
+    // so closing it below is the last thing we do with the instance
+    if (!isAutoDelete) {
+        atomicStore32Explicit(&inst->closed, 1, AtomicMemoryOrder::Seqcst);
+        if (atomicLoad32Explicit(&inst->numExternalWaiters, AtomicMemoryOrder::Seqcst))
+            threadWakeAllOnAddress(&inst->closed);
+    }
+
+    atomicPtr head = atomicExchangePtr(&inst->waiters, kJobsWaitersClosed);
+    
+    // The instance can be deleted by the waiter from now on, don't touch it
+    if (isAutoDelete) {
+        ASSERT_MSG(head == 0, "Cannot wait on AutoDelete jobs");
+        gJobs.instancePool->Delete(inst);
+        atomicFetchSub32Explicit(&gJobs.numInstances, 1, AtomicMemoryOrder::Relaxed);
+        return;
+    }
+
+    JobsFiberProperties* props = reinterpret_cast<JobsFiberProperties*>((uintptr_t)head);
+    while (props) {
+        JobsFiberProperties* next = props->next;
+        props->next = nullptr;
+        if (props->isDependency) {
+            JobsInstance* dependent = props->instance;
+            gJobs.fiberPropsPool->Delete(props);
+            jobsReleaseDependency(dependent);
+            props = next;
+            continue;
+        }
+
+        JobsType type = props->instance->type;
+        jobsSchedule(props, type);
+        jobsWakeWorkers(type, 1);
+        props = next;
+    }
+}
+
+static void jobsParkOnSignal(JobsSignalInternal* signal, JobsFiberProperties* props)
+{
+    bool resume = false;
+    {
+        atomicUint32 expected = 0;
+        while (!atomicCompareExchange32Weak(&signal->waitersLock, &expected, 1)) {
+            expected = 0;
+            atomicPauseCpu();
+        }
+
+        if (atomicLoad32Explicit(&signal->signaled, AtomicMemoryOrder::Acquire)) {
+            atomicStore32Explicit(&signal->signaled, 0, AtomicMemoryOrder::Relaxed);
+            resume = true;
+        }
+        else {
+            props->next = signal->waiters;
+            signal->waiters = props;
+        }
+
+        atomicStore32Explicit(&signal->waitersLock, 0, AtomicMemoryOrder::Release);
+    }
+
+    if (resume) {
+        props->next = nullptr;
+        jobsSchedule(props, props->instance->type);
+        jobsWakeWorkers(props->instance->type, 1);
+    }
 }
 
 NO_INLINE static void jobsEntryFn(mco_coro* co)
@@ -281,20 +697,30 @@ NO_INLINE static void jobsEntryFn(mco_coro* co)
 
 NO_INLINE static JobsFiber* jobsCreateFiber(JobsFiberProperties* props)
 {
-    mco_desc desc = mco_desc_init(jobsEntryFn, props->stackSize);
-    desc.malloc_cb = jobsMcoMallocFn;
-    desc.free_cb = jobsMcoFreeFn;
-    desc.allocator_data = &gJobs.runtimeAlloc;
+    // minicoro's stack covers everything after the header, including the guard page (see JobsStackBucket)
+    // All the blocks in the bucket have the same layout
+    uint32 bucketIndex = jobsGetStackBucket(props->stackSize);
+    const JobsStackBucket& bucket = gJobs.stackBuckets[bucketIndex];
+    mco_desc desc = mco_desc_init(jobsEntryFn, _limits::kJobsMinStackSize << bucketIndex);
+    desc.stack_size = bucket.blockSize - bucket.headerSize;
+    desc.coro_size = bucket.blockSize;
+
+    mco_coro* co = reinterpret_cast<mco_coro*>(jobsAcquireFiberStack(bucketIndex));
+    if (!co) {
+        MEMORY_FAIL();
+        return nullptr;
+    }
 
-    mco_coro* co;
-    mco_result r = mco_create(&co, &desc);
+    mco_result r = mco_init(co, &desc);
     if (r != MCO_SUCCESS) {
+        jobsReleaseFiberStack(bucketIndex, co);
         MEMORY_FAIL();
         return nullptr;
     }
 
     JobsFiber fiber {
         .ownerTid = 0,
+        .stackBucket = bucketIndex,
         .co = co,
         .coDesc = desc,
         .props = props
@@ -304,7 +730,7 @@ NO_INLINE static JobsFiber* jobsCreateFiber(JobsFiberProperties* props)
 
     atomicFetchAdd32Explicit(&gJobs.numFibers, 1, AtomicMemoryOrder::Relaxed);
     gJobs.maxValues[0].numFibersMax = Max(gJobs.numFibers, gJobs.maxValues[0].numFibersMax);
-    gJobs.maxValues[0].maxFiberHeap = Max<uint32>(uint32(gJobs.tlsfAlloc.GetAllocatedSize()), gJobs.maxValues[0].maxFiberHeap);
+    gJobs.maxValues[0].maxFiberHeap = Max<size_t>(gJobs.stackInUseSize, gJobs.maxValues[0].maxFiberHeap);
 
     return reinterpret_cast<JobsFiber*>(co->storage);
 }
@@ -317,7 +743,10 @@ NO_INLINE static void jobsDestroyFiber(JobsFiber* fiber)
     gJobs.fiberPropsPool->Delete(fiber->props);
 
     ASSERT(fiber->co);
-    mco_destroy(fiber->co);
+    mco_coro* co = fiber->co;
+    uint32 bucketIndex = fiber->stackBucket;    // fiber lives in the coroutine storage
+    mco_uninit(co);
+    jobsReleaseFiberStack(bucketIndex, co);
 
     atomicFetchSub32Explicit(&gJobs.numFibers, 1, AtomicMemoryOrder::Relaxed);
 }
@@ -327,8 +756,7 @@ static void jobsTracyEnterZone(TracyCZoneCtx* ctx, const ___tracy_source_locatio
 {
     ASSERT(ctx);
     JobsThreadData* tdata = jobsGetThreadData();
-    if (tdata) {
-        ASSERT(tdata->curFiber);
+    if (tdata && tdata->curFiber) {     // Inline jobs run without a fiber, their zones don't need to be carried around
         logDebugTracy("Enter: fiber=%p, ctx=%u", tdata->curFiber, ctx->id);
 
         ASSERT_MSG(!tdata->curFiber->tracyZonesStack.IsFull(), "Profile sampling stack is too deep. Either remove samples or increase the kJobsMaxTracyStackDepth");
@@ -339,8 +767,7 @@ static void jobsTracyEnterZone(TracyCZoneCtx* ctx, const ___tracy_source_locatio
 static bool jobsTracyExitZone(TracyCZoneCtx* ctx)
 {
     JobsThreadData* tdata = jobsGetThreadData();
-    if (tdata) {
-        ASSERT(tdata->curFiber);
+    if (tdata && tdata->curFiber) {
         JobsFiber* fiber = tdata->curFiber;
         if (fiber->tracyZonesStack.Count()) {
             if (fiber->tracyZonesStack.Last().ctx.id != ctx->id) {
@@ -411,30 +838,132 @@ static void jobsSetFiberToCurrentThread(JobsFiber* fiber)
         ASSERT_MSG(fiber->tracyZonesStack.IsEmpty(), "Tracy zones stack currently have %u remaining items", fiber->tracyZonesStack.Count());
         #endif
 
-        if (atomicFetchSub32(&inst->counter, 1) == 1) {     // Job is finished with all the fibers
-            // Delete the job instance automatically if only indicated by the API
-            if (inst->isAutoDelete) {
-                gJobs.instancePool->Delete(inst);
-                atomicFetchSub32Explicit(&gJobs.numInstances, 1, AtomicMemoryOrder::Relaxed);
-            }
-        }
-
         jobsDestroyFiber(fiber);
+
+        // Job is finished with all the fibers. Wake up the waiters (or delete the instance if it's AutoDelete)
+        if (atomicFetchSub32(&inst->counter, 1) == 1)
+            jobsCloseInstance(inst);
     }
     else {
-        // Yielding, Coming back from WaitForCompletion
+        // Yielding, Coming back from WaitForCompletion or JobsSignal::Wait
+        // Park the fiber on whatever it's waiting for. It may resume on another worker immediately, so don't touch it after this
         ASSERT(fiber->co->state == MCO_SUSPENDED);
-        fiber->childCounter = &jobsGetThreadData()->waitInstance->counter;
-        jobsGetThreadData()->waitInstance = nullptr;
-        uint32 typeIndex = uint32(inst->type);
+        JobsThreadData* tdata = jobsGetThreadData();
+        if (tdata->waitInstance) {
+            JobsInstance* waitInstance = tdata->waitInstance;
+            tdata->waitInstance = nullptr;
+            jobsParkOnInstance(waitInstance, fiber->props);
+        }
+        else {
+            ASSERT(fiber->signal);
+            jobsParkOnSignal(fiber->signal, fiber->props);
+        }
+    }
+}
+
+// Inline jobs don't get a fiber, so they can't be parked. They run to completion directly on the worker's stack
+static void jobsRunInline(JobsFiberProperties* props)
+{
+    ASSERT(jobsGetThreadData()->curFiber == nullptr);
 
+    JobsType type = jobsGetThreadData()->type;
+    atomicUint32* numBusy = type == JobsType::ShortTask ? &gJobs.numBusyShortThreads : &gJobs.numBusyLongThreads;
+    atomicFetchAdd32Explicit(numBusy, 1, AtomicMemoryOrder::Relaxed);
+
+    props->callback(props->index, props->userData);
+
+    atomicFetchSub32Explicit(numBusy, 1, AtomicMemoryOrder::Relaxed);
+
+    JobsInstance* inst = props->instance;
+    gJobs.fiberPropsPool->Delete(props);
+    if (atomicFetchSub32(&inst->counter, 1) == 1)
+        jobsCloseInstance(inst);
+}
+
+static int jobsThreadFn(void* userData);
+
+static void jobsStartThread(JobsType type, uint32 slotIndex)
+{
+    uint32 typeIndex = uint32(type);
+    char name[32];
+    strPrintFmt(name, sizeof(name), "%s_%u", type == JobsType::ShortTask ? "ShortTask" : "LongTask", slotIndex+1);
+
+    Thread& thread = gJobs.threads[typeIndex][slotIndex];
+    thread.Start(ThreadDesc {
+        .entryFn = jobsThreadFn, 
+        .userData = IntToPtr<uint64>((static_cast<uint64>(slotIndex+1) << 32) | typeIndex), 
+        .name = name, 
+        .stackSize = _limits::kJobsWorkerStackSize,
+        .flags = ThreadCreateFlags::None
+    });
+    ASSERT(thread.IsRunning());
+    thread.SetPriority(type == JobsType::ShortTask ? ThreadPriority::High : ThreadPriority::Normal);
+}
+
+// Compensating threads keep `numThreads` workers runnable while some of them are blocked
+static void jobsSpawnExtraThread(JobsType type)
+{
+    uint32 typeIndex = uint32(type);
+    uint32 maxExtra = gJobs.maxThreads[typeIndex] - gJobs.numThreads[typeIndex];
+
+    atomicUint32 numExtra = atomicLoad32Explicit(&gJobs.numExtraThreads[typeIndex], AtomicMemoryOrder::Acquire);
+    do {
+        if (numExtra >= maxExtra)
+            return;
+    } while (!atomicCompareExchange32Weak(&gJobs.numExtraThreads[typeIndex], &numExtra, numExtra + 1));
+
+    for (uint32 i = gJobs.numThreads[typeIndex]; i < gJobs.maxThreads[typeIndex]; i++) {
+        atomicUint32* state = &gJobs.threadStates[typeIndex][i];
+        atomicUint32 prevState = atomicLoad32Explicit(state, AtomicMemoryOrder::Acquire);
+        if (prevState != uint32(JobsThreadState::Running) && 
+            atomicCompareExchange32Strong(state, &prevState, uint32(JobsThreadState::Running))) 
         {
-            JobsLockScope lk(gJobs.waitingListLock);
-            jobsAddToList(&gJobs.waitingLists[typeIndex], fiber->props);
-        }
+            if (prevState == uint32(JobsThreadState::Exited))
+                gJobs.threads[typeIndex][i].Stop();
+            jobsStartThread(type, i);
 
-        gJobs.semaphores[typeIndex].Post();
+            atomicFetchAdd32Explicit(&gJobs.numExtraThreadSpawns, 1, AtomicMemoryOrder::Relaxed);
+            gJobs.maxValues[0].numExtraLongThreadsMax = Max(gJobs.maxValues[0].numExtraLongThreadsMax, numExtra + 1);
+            return;
+        }
     }
+
+    // All the slots are still taken by threads that are about to exit
+    atomicFetchSub32(&gJobs.numExtraThreads[typeIndex], 1);
+}
+
+// Called by idle compensating threads. Retires the thread if there are more compensating threads than blocked workers
+static bool jobsTryRetireExtraThread(JobsThreadData* tdata)
+{
+    uint32 typeIndex = uint32(tdata->type);
+    atomicUint32 numExtra = atomicLoad32Explicit(&gJobs.numExtraThreads[typeIndex], AtomicMemoryOrder::Acquire);
+    do {
+        if (numExtra <= atomicLoad32(&gJobs.numBlocked[typeIndex]))
+            return false;
+    } while (!atomicCompareExchange32Weak(&gJobs.numExtraThreads[typeIndex], &numExtra, numExtra - 1));
+
+    return true;
+}
+
+// Time spent in the previous state goes to its counter. jobsGetTelemetry adds the time of the current state on its own, 
+// so a worker that sleeps or runs a single long job for the whole sampling period still shows up
+static void jobsSwitchWorkerState(JobsWorker* worker, JobsWorkerState state, uint64 tick)
+{
+    if (worker->stateTick)
+        worker->times[uint32(worker->state)] += tick - worker->stateTick;
+    worker->state = state;
+    worker->stateTick = tick;
+}
+
+static void jobsRecordStartLatency(JobsWorker* worker, uint64 latency)
+{
+    uint32 bucket = 0;
+    for (uint64 us = latency / 1000; us && bucket < kJobsLatencyBuckets - 1; us >>= 1)
+        bucket++;
+
+    worker->numStarted++;
+    worker->latencyTotal += latency;
+    worker->latencyHistogram[bucket]++;
 }
 
 static int jobsThreadFn(void* userData)
@@ -447,74 +976,83 @@ static int jobsThreadFn(void* userData)
         jobsGetThreadData()->threadIndex = (param >> 32) & 0xffffffff;
         jobsGetThreadData()->type = static_cast<JobsType>(uint32(param & 0xffffffff));
         jobsGetThreadData()->threadId = threadGetCurrentId();
+        jobsGetThreadData()->worker = &gJobs.workers[uint32(jobsGetThreadData()->type)][jobsGetThreadData()->threadIndex - 1];
+        jobsGetThreadData()->stealIndex = jobsGetThreadData()->threadIndex;
+
+        uint32 cpuIndex = jobsGetThreadData()->worker->cpuIndex;
+        if (cpuIndex != UINT32_MAX && !threadSetCurrentThreadAffinity(cpuIndex))
+            logWarning("Jobs: Failed to pin worker thread to cpu %u", cpuIndex);
     }
 
-    uint32 spinCount = !PLATFORM_MOBILE;
-    uint32 typeIndex = uint32(jobsGetThreadData()->type);
+    JobsThreadData* tdata = jobsGetThreadData();
+    JobsWorker* worker = tdata->worker;
+    uint32 typeIndex = uint32(tdata->type);
+    bool isExtra = tdata->threadIndex > gJobs.numThreads[typeIndex];
+    jobsSwitchWorkerState(worker, JobsWorkerState::Search, timerGetTicks());
     while (!gJobs.quit) {
-        gJobs.semaphores[typeIndex].Wait();
-
-        bool waitingListIsLive = false;
-        JobsFiber* fiber = nullptr;
+        JobsFiberProperties* props = jobsFindWork(tdata);
 
-        // Select and fetch the job from the waiting list
-        {
-            JobsLockScope lock(gJobs.waitingListLock);
-            for (uint32 prioIdx = 0; prioIdx < static_cast<uint32>(JobsPriority::_Count); prioIdx++) {
-                JobsWaitingList* list = &gJobs.waitingLists[typeIndex];
-                JobsFiberProperties* props = list->waitingList[prioIdx];
-    
-                while (props) {
-                    waitingListIsLive = true;
-
-                    // Choose the fiber to continue based on these 3 conditions:
-                    //  1) There is no fiber assigned to props. so it's the first run
-                    //  2) Fiber is not waiting on any children jobs
-                    //  3) Fiber is not waiting on a signal (if so, check if the signal is fired and reset it)
-                    JobsFiber* tmpFiber = props->fiber;
-                    atomicUint32 one = 1;
-                    if (tmpFiber == nullptr || 
-                        ((tmpFiber->childCounter == nullptr || atomicLoad32Explicit(tmpFiber->childCounter, AtomicMemoryOrder::Acquire) == 0) &&
-                        (tmpFiber->signal == nullptr || atomicCompareExchange32Strong(&tmpFiber->signal->signaled, &one, 0))))
-                    {
-                        if (tmpFiber == nullptr)
-                            props->fiber = jobsCreateFiber(props);
-
-                        fiber = props->fiber;
-                        fiber->childCounter = nullptr;
-                        jobsRemoveFromList(list, props);
-                        prioIdx = static_cast<uint32>(JobsPriority::_Count);    // break out of outer loop
-                        break;
-                    }
-    
-    
-                    props = props->next;
-                }
+        // Poll for a short while before going to sleep, new work usually arrives in bursts
+        // Only one worker per type spins at a time, so idle workers don't eat up the cpu from the busy ones
+        atomicUint32 notSpinning = 0;
+        if (!props && atomicCompareExchange32Strong(&gJobs.numSpinning[typeIndex], &notSpinning, 1)) {
+            for (uint32 spin = 0; !props && spin < gJobs.idleSpinCount && !gJobs.quit; spin++) {
+                atomicPauseCpu();
+                props = jobsFindWork(tdata);
             }
+            atomicStore32Explicit(&gJobs.numSpinning[typeIndex], 0, AtomicMemoryOrder::Release);
         }
 
-        if (fiber) {
-            jobsSetFiberToCurrentThread(fiber);
+        if (!props) {
+            // Announce that we are going to sleep, then check again. Dispatchers post the semaphore only if there are sleepers
+            atomicFetchAdd32(&gJobs.numSleeping[typeIndex], 1);
+            props = jobsFindWork(tdata);
+            if (!props) {
+                jobsSwitchWorkerState(worker, JobsWorkerState::Idle, timerGetTicks());
+                bool signaled = gJobs.semaphores[typeIndex].Wait(isExtra ? _limits::kJobsExtraThreadIdleTimeout : UINT32_MAX);
+                jobsSwitchWorkerState(worker, JobsWorkerState::Search, timerGetTicks());
+                atomicFetchSub32(&gJobs.numSleeping[typeIndex], 1);
+                if (!signaled && isExtra && jobsTryRetireExtraThread(tdata))
+                    break;
+                continue;
+            }
+            atomicFetchSub32(&gJobs.numSleeping[typeIndex], 1);
         }
-        else if (waitingListIsLive) {
-            // Try picking another fiber cuz there are still workers in the waiting list but we couldn't pick them up
-            // TODO: we probably need to modify something here to not spin the threads with waiting signals
-            gJobs.semaphores[typeIndex].Post();
 
-            if (spinCount & 1023) 
-                atomicPauseCpu();
-            else
-                threadYield();
+        uint64 startTick = timerGetTicks();
+        jobsSwitchWorkerState(worker, JobsWorkerState::Busy, startTick);
+        worker->numItemsRun++;
+        if (props->fiber == nullptr)    // Not a resumed fiber
+            jobsRecordStartLatency(worker, startTick - props->dispatchTick);
+
+        if (props->runInline) {
+            jobsRunInline(props);
+        }
+        else {
+            if (props->fiber == nullptr)
+                props->fiber = jobsCreateFiber(props);
+            jobsSetFiberToCurrentThread(props->fiber);
         }
+
+        jobsSwitchWorkerState(worker, JobsWorkerState::Search, timerGetTicks());
     }
 
+    // Stop the clock, slots of the retired compensating threads can stay empty for a while
+    jobsSwitchWorkerState(worker, worker->state, timerGetTicks());
+    worker->stateTick = 0;
+
+    uint32 slotIndex = tdata->threadIndex - 1;
     memFree(jobsGetThreadData());
     gJobsThreadData = nullptr;
+    if (isExtra)
+        atomicStore32Explicit(&gJobs.threadStates[typeIndex][slotIndex], uint32(JobsThreadState::Exited), AtomicMemoryOrder::Release);
     return 0;
 }
 
 static JobsInstance* jobsDispatchInternal(bool isAutoDelete, JobsType type, JobsCallback callback, void* userData, 
-                                          uint32 groupSize, JobsPriority prio, uint32 stackSize)
+                                          uint32 groupSize, JobsPriority prio, uint32 stackSize,
+                                          _private::JobsDestroyUserDataCallback destroyUserDataFn = nullptr, bool runInline = false,
+                                          const JobsHandle* deps = nullptr, uint32 numDeps = 0)
 {
     ASSERT(groupSize);
 
@@ -531,6 +1069,8 @@ static JobsInstance* jobsDispatchInternal(bool isAutoDelete, JobsType type, Jobs
     atomicExchange32Explicit(&instance->counter, numFibers, AtomicMemoryOrder::Release);
     instance->type = type;
     instance->isAutoDelete = isAutoDelete;
+    instance->destroyUserDataFn = destroyUserDataFn;
+    instance->userData = userData;
 
     // Another fiber is running on this worker thread
     // Set the running fiber as a parent to the new ones, unless we are using AutoDelete fibers, which don't have any dependencies
@@ -540,28 +1080,42 @@ static JobsInstance* jobsDispatchInternal(bool isAutoDelete, JobsType type, Jobs
     }
 
     if (stackSize == 0)
-        stackSize = type == JobsType::ShortTask ? 256*kKB : 512*kKB;
+        stackSize = type == JobsType::ShortTask ? _limits::kJobsDefaultShortTaskStackSize : _limits::kJobsDefaultLongTaskStackSize;
+
+    JobsFiberProperties item {
+        .callback = callback,
+        .userData = userData,
+        .instance = instance,
+        .prio = prio,
+        .stackSize = stackSize,
+        .runInline = runInline
+    };
 
-    // Push workers to the end of the list, will be collected by fiber threads
-    {
-        JobsLockScope lock(gJobs.waitingListLock);
-        for (uint32 i = 0; i < numFibers; i++) {
-            JobsFiberProperties* props = gJobs.fiberPropsPool->New();
-            *props = JobsFiberProperties {
-                .callback = callback,
-                .userData = userData,
-                .instance = instance,
-                .prio = prio,
-                .index = i,
-                .stackSize = stackSize
-            };
-    
-            jobsAddToList(&gJobs.waitingLists[uint32(type)], props);
-        }
+    if (numDeps == 0) {
+        jobsScheduleItems(item, numFibers);
+        return instance;
     }
 
-    // Fire up the worker threads
-    gJobs.semaphores[uint32(type)].Post(numFibers);
+    // Hold the items back until all the dependencies are closed. Nobody waits for them, the last one to finish schedules the items
+    // The extra pending count keeps the dependencies that are already finished from releasing the job while we are still registering
+    ASSERT(deps);
+    JobsFiberProperties* pending = gJobs.fiberPropsPool->New();
+    *pending = item;
+    pending->index = numFibers;
+    instance->pendingItem = pending;
+    atomicStore32Explicit(&instance->numPendingDeps, numDeps + 1, AtomicMemoryOrder::Release);
+
+    for (uint32 i = 0; i < numDeps; i++) {
+        ASSERT(deps[i]);
+        JobsFiberProperties* token = gJobs.fiberPropsPool->New();
+        *token = JobsFiberProperties {
+            .instance = instance,
+            .isDependency = true
+        };
+        jobsAddDependency(deps[i], token);
+    }
+
+    jobsReleaseDependency(instance);
     return instance;
 }
 
@@ -570,11 +1124,10 @@ void jobsWaitForCompletion(JobsHandle instance)
     // PROFILE_ZONE(jobsGetThreadData() == nullptr);
     ASSERT(!instance->isAutoDelete);
 
-    uint32 spinCount = !PLATFORM_MOBILE;    // On mobile hardware, we start from yielding then proceed with Pause
-    while (atomicLoad32Explicit(&instance->counter, AtomicMemoryOrder::Acquire)) {
-        // If current thread has a fiber assigned and running, put it in waiting list and jump out of it 
-        // so one of the threads can continue picking up more workers
-        if (jobsGetThreadData()) {
+    if (jobsGetThreadData()) {
+        // Current thread has a fiber assigned and running, park it on the instance and jump out of it 
+        // so the thread can continue picking up more work. The fiber gets re-scheduled when the instance is closed
+        while (atomicLoadPtrExplicit(&instance->waiters, AtomicMemoryOrder::Acquire) != kJobsWaitersClosed) {
             ASSERT_MSG(jobsGetThreadData()->curFiber, "Worker threads should always have a fiber assigned when 'Wait' is called");
 
             JobsFiber* curFiber = jobsGetThreadData()->curFiber;
@@ -583,11 +1136,20 @@ void jobsWaitForCompletion(JobsHandle instance)
 
             jobsJumpOut(curFiber->co);  // Back to `jobsThreadFn::jobsSetFiberToCurrentThread`
         }
-        else {
-            if (spinCount++ & 1023)
-                atomicPauseCpu();   // Main thread just loops 
-            else
-                threadYield();
+    }
+    else {
+        // Non-worker threads: Poll for short jobs, then block in the OS until the instance is closed
+        // `closed` is only for sleeping, `waiters` is the last store of jobsCloseInstance and the only one that allows deleting the instance.
+        // Between the two, the wait below returns right away, so we spin for a few instructions at most
+        auto IsClosed = [instance]() { return atomicLoadPtrExplicit(&instance->waiters, AtomicMemoryOrder::Acquire) == kJobsWaitersClosed; };
+        for (uint32 spin = 0; spin < gJobs.idleSpinCount && !IsClosed(); spin++)
+            atomicPauseCpu();
+
+        while (!IsClosed()) {
+            atomicFetchAdd32(&instance->numExternalWaiters, 1);
+            if (!atomicLoad32(&instance->closed))
+                threadWaitOnAddress(&instance->closed, 0);
+            atomicFetchSub32(&instance->numExternalWaiters, 1);
         }
     }
 
@@ -611,6 +1173,371 @@ void jobsDispatchAuto(JobsType type, JobsCallback callback, void* userData, uint
     jobsDispatchInternal(true, type, callback, userData, groupSize, prio, stackSize);
 }
 
+void jobsBeginBlockingSection()
+{
+    // Only LongTask workers are compensated, ShortTasks are not supposed to block
+    JobsThreadData* tdata = jobsGetThreadData();
+    if (!tdata || tdata->type != JobsType::LongTask)
+        return;
+
+    uint32 typeIndex = uint32(tdata->type);
+    uint32 numBlocked = atomicFetchAdd32(&gJobs.numBlocked[typeIndex], 1) + 1;
+    gJobs.maxValues[0].numBlockedLongThreadsMax = Max(gJobs.maxValues[0].numBlockedLongThreadsMax, numBlocked);
+
+    if (atomicLoad32(&gJobs.numExtraThreads[typeIndex]) < numBlocked)
+        jobsSpawnExtraThread(tdata->type);
+}
+
+void jobsEndBlockingSection()
+{
+    // The fiber may have moved to another worker in between, but it's always the same type
+    JobsThreadData* tdata = jobsGetThreadData();
+    if (!tdata || tdata->type != JobsType::LongTask)
+        return;
+
+    [[maybe_unused]] uint32 prevCount = atomicFetchSub32(&gJobs.numBlocked[uint32(tdata->type)], 1);
+    ASSERT(prevCount > 0);
+}
+
+JobsHandle jobsDispatchAfter(const JobsHandle* deps, uint32 numDeps, JobsType type, JobsCallback callback, void* userData, 
+                             uint32 groupSize, JobsPriority prio, uint32 stackSize)
+{
+    return jobsDispatchInternal(false, type, callback, userData, groupSize, prio, stackSize, nullptr, false, deps, numDeps);
+}
+
+void jobsDispatchAutoAfter(const JobsHandle* deps, uint32 numDeps, JobsType type, JobsCallback callback, void* userData, 
+                           uint32 groupSize, JobsPriority prio, uint32 stackSize)
+{
+    jobsDispatchInternal(true, type, callback, userData, groupSize, prio, stackSize, nullptr, false, deps, numDeps);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Graph
+struct JobsGraphNode
+{
+    JobsType type;
+    JobsCallback callback;
+    void* userData;
+    uint32 groupSize;
+    JobsPriority prio;
+    uint32 stackSize;
+    uint32 numDeps;         // Incoming edges
+    JobsHandle handle;
+};
+
+struct JobsGraphEdge
+{
+    uint32 node;
+    uint32 dependsOn;
+};
+
+struct JobsGraph
+{
+    Allocator* alloc;
+    Array<JobsGraphNode> nodes;
+    Array<JobsGraphEdge> edges;
+    Array<uint32> order;        // Topological order of the last dispatch
+    bool dispatched;
+};
+
+JobsGraph* jobsCreateGraph(Allocator* alloc)
+{
+    JobsGraph* graph = NEW(alloc, JobsGraph) { .alloc = alloc };
+    graph->nodes.SetAllocator(alloc);
+    graph->edges.SetAllocator(alloc);
+    graph->order.SetAllocator(alloc);
+    return graph;
+}
+
+void jobsDestroyGraph(JobsGraph* graph)
+{
+    if (!graph)
+        return;
+    ASSERT_MSG(!graph->dispatched, "Graph must be waited on before destroying it");
+
+    graph->nodes.Free();
+    graph->edges.Free();
+    graph->order.Free();
+    memFree(graph, graph->alloc);
+}
+
+uint32 jobsGraphAddNode(JobsGraph* graph, JobsType type, JobsCallback callback, void* userData, uint32 groupSize, 
+                        JobsPriority prio, uint32 stackSize)
+{
+    ASSERT(!graph->dispatched);
+    ASSERT(callback);
+
+    graph->nodes.Push(JobsGraphNode {
+        .type = type,
+        .callback = callback,
+        .userData = userData,
+        .groupSize = groupSize,
+        .prio = prio,
+        .stackSize = stackSize
+    });
+    return graph->nodes.Count() - 1;
+}
+
+void jobsGraphAddDependency(JobsGraph* graph, uint32 node, uint32 dependsOn)
+{
+    ASSERT(!graph->dispatched);
+    ASSERT(node < graph->nodes.Count() && dependsOn < graph->nodes.Count());
+    ASSERT(node != dependsOn);
+
+    graph->edges.Push(JobsGraphEdge { .node = node, .dependsOn = dependsOn });
+}
+
+bool jobsGraphDispatch(JobsGraph* graph)
+{
+    ASSERT_MSG(!graph->dispatched, "Graph is already dispatched, wait on it first");
+    
+    // Topological sort (Kahn). Every job is dispatched after its dependencies, because it needs their handles
+    MemTempAllocator tmpAlloc;
+    uint32 numNodes = graph->nodes.Count();
+    uint32* numRemaining = tmpAlloc.MallocZeroTyped<uint32>(Max(numNodes, 1u));
+    for (JobsGraphNode& node : graph->nodes)
+        node.numDeps = 0;
+    for (const JobsGraphEdge& edge : graph->edges) {
+        graph->nodes[edge.node].numDeps++;
+        numRemaining[edge.node]++;
+    }
+
+    graph->order.Clear();
+    for (uint32 i = 0; i < numNodes; i++) {
+        if (numRemaining[i] == 0)
+            graph->order.Push(i);
+    }
+
+    for (uint32 i = 0; i < graph->order.Count(); i++) {
+        uint32 index = graph->order[i];
+        for (const JobsGraphEdge& edge : graph->edges) {
+            if (edge.dependsOn == index && --numRemaining[edge.node] == 0)
+                graph->order.Push(edge.node);
+        }
+    }
+
+    if (graph->order.Count() != numNodes) {
+        logError("Jobs: Graph has cyclic dependencies");
+        graph->order.Clear();
+        return false;
+    }
+
+    JobsHandle* deps = tmpAlloc.MallocTyped<JobsHandle>(Max(graph->edges.Count(), 1u));
+    for (uint32 index : graph->order) {
+        JobsGraphNode& node = graph->nodes[index];
+        
+        uint32 numDeps = 0;
+        for (const JobsGraphEdge& edge : graph->edges) {
+            if (edge.node == index)
+                deps[numDeps++] = graph->nodes[edge.dependsOn].handle;
+        }
+        ASSERT(numDeps == node.numDeps);
+
+        node.handle = jobsDispatchAfter(deps, numDeps, node.type, node.callback, node.userData, node.groupSize, node.prio, node.stackSize);
+    }
+
+    graph->dispatched = true;
+    return true;
+}
+
+void jobsGraphWaitForCompletion(JobsGraph* graph)
+{
+    if (!graph->dispatched)
+        return;
+
+    for (uint32 index : graph->order) {
+        JobsGraphNode& node = graph->nodes[index];
+        jobsWaitForCompletion(node.handle);
+        node.handle = nullptr;
+    }
+    graph->dispatched = false;
+}
+
+bool jobsGraphIsRunning(JobsGraph* graph)
+{
+    if (!graph->dispatched)
+        return false;
+
+    for (const JobsGraphNode& node : graph->nodes) {
+        if (jobsIsRunning(node.handle))
+            return true;
+    }
+    return false;
+}
+
+JobsHandle _private::jobsDispatchOwned(bool isAutoDelete, JobsType type, JobsCallback callback, void* userData, 
+                                       JobsDestroyUserDataCallback destroyFn, uint32 groupSize, JobsPriority prio, uint32 stackSize)
+{
+    return jobsDispatchInternal(isAutoDelete, type, callback, userData, groupSize, prio, stackSize, destroyFn);
+}
+
+struct JobsParallelForData
+{
+    JobsRangeCallback callback;
+    void* userData;
+    uint32 end;
+    uint32 grainSize;
+    uint32 numSplits;
+    uint8 _padding[CACHE_LINE_SIZE - sizeof(void*)*2 - sizeof(uint32)*3];
+    atomicUint32 next;
+};
+
+// Guided self-scheduling: Every claim takes a 1/numSplits portion of what's left (but no less than grainSize)
+// So chunks start big, to keep the overhead low, and get smaller towards the end, to balance the load between the threads
+static bool jobsParallelForRunChunk(JobsParallelForData* data)
+{
+    uint32 first = atomicLoad32Explicit(&data->next, AtomicMemoryOrder::Relaxed);
+    while (first < data->end) {
+        uint32 remaining = data->end - first;
+        uint32 count = Min(remaining, Max(data->grainSize, remaining / data->numSplits));
+        if (atomicCompareExchange32Weak(&data->next, &first, first + count)) {
+            data->callback(first, first + count, data->userData);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void jobsParallelForTask(uint32, void* userData)
+{
+    JobsParallelForData* data = reinterpret_cast<JobsParallelForData*>(userData);
+    while (jobsParallelForRunChunk(data)) {}
+}
+
+void jobsParallelFor(uint32 begin, uint32 end, uint32 grainSize, JobsRangeCallback callback, void* userData, JobsType type, JobsPriority prio)
+{
+    ASSERT(callback);
+    ASSERT(end >= begin);
+    ASSERT(type != JobsType::_Count);
+
+    if (begin == end)
+        return;
+
+    grainSize = Max(grainSize, 1u);
+    uint32 count = end - begin;
+    uint32 numWorkers = gJobs.numThreads[uint32(type)];
+    uint32 numChunks = DivCeil(count, grainSize);
+
+    // Small ranges are not worth the dispatch. Nested loops inside inline chunks also run serially, because there is no fiber to park
+    JobsThreadData* tdata = jobsGetThreadData();
+    if (numChunks <= 1 || numWorkers == 0 || (tdata && !tdata->curFiber)) {
+        callback(begin, end, userData);
+        return;
+    }
+
+    JobsParallelForData data {
+        .callback = callback,
+        .userData = userData,
+        .end = end,
+        .grainSize = grainSize,
+        .numSplits = (numWorkers + 1) * 2,
+        .next = begin
+    };
+
+    // The calling thread takes part as well, so we need at most numChunks-1 helpers. Helpers run inline (no fibers)
+    uint32 numHelpers = Min(numChunks - 1, numWorkers);
+    JobsHandle handle = jobsDispatchInternal(false, type, jobsParallelForTask, &data, numHelpers, prio, 0, nullptr, true);
+    while (jobsParallelForRunChunk(&data)) {}
+    jobsWaitForCompletion(handle);
+}
+
+// Orders the cpus for the affinity policy and assigns them to workers. Worker N of each type gets the N'th cpu in the order
+static void jobsAssignWorkerCpus(JobsAffinity affinity)
+{
+    for (uint32 i = 0; i < uint32(JobsType::_Count); i++) {
+        for (uint32 k = 0; k < gJobs.maxThreads[i]; k++) {
+            gJobs.workers[i][k].cpuIndex = UINT32_MAX;
+            gJobs.workers[i][k].cacheDomain = UINT32_MAX;
+        }
+    }
+
+    if (affinity == JobsAffinity::None)
+        return;
+
+    SysCpuTopology topo;
+    if (!sysGetCpuTopology(&topo)) {
+        logWarning("Jobs: Cpu topology is not available on this platform. Worker threads will not be pinned");
+        return;
+    }
+
+    logInfo("(init) Cpu topology: %u cpus, %u cores, %u cache domains, %u packages, %u numa nodes", 
+            topo.numCpus, topo.numCores, topo.numCacheDomains, topo.numPackages, topo.numNumaNodes);
+
+    struct CpuSlot
+    {
+        const SysCpuInfo* cpu;
+        uint64 key;
+    };
+
+    auto MakeKey = [](uint32 a, uint32 b, uint32 c, uint32 d)->uint64 { 
+        return (uint64(a & 0xffff) << 48) | (uint64(b & 0xffff) << 32) | (uint64(c & 0xffff) << 16) | uint64(d & 0xffff); 
+    };
+    auto SortSlots = [](CpuSlot* slots, uint32 count) {
+        BlitSort<CpuSlot>(slots, count, [](const CpuSlot& a, const CpuSlot& b)->int { return a.key < b.key ? -1 : (a.key > b.key ? 1 : 0); });
+    };
+
+    // Compact order first, then figure out the rank of each cpu within its core, domain and package
+    MemTempAllocator tmpAlloc;
+    CpuSlot* slots = tmpAlloc.MallocTyped<CpuSlot>(topo.numCpus);
+    for (uint32 i = 0; i < topo.numCpus; i++) {
+        const SysCpuInfo& cpu = topo.cpus[i];
+        slots[i] = CpuSlot { .cpu = &cpu, .key = MakeKey(cpu.packageIndex, cpu.cacheDomainIndex, cpu.coreIndex, cpu.cpuIndex) };
+    }
+    SortSlots(slots, topo.numCpus);
+
+    uint32 numSlots = 0;
+    uint32 smtRank = 0, coreRank = 0, domainRank = 0;
+    for (uint32 i = 0; i < topo.numCpus; i++) {
+        const SysCpuInfo* cpu = slots[i].cpu;
+        const SysCpuInfo* prev = i > 0 ? slots[i-1].cpu : nullptr;
+        if (prev && prev->packageIndex == cpu->packageIndex) {
+            if (prev->cacheDomainIndex == cpu->cacheDomainIndex) {
+                if (prev->coreIndex == cpu->coreIndex) {
+                    smtRank++;
+                }
+                else {
+                    smtRank = 0;
+                    coreRank++;
+                }
+            }
+            else {
+                smtRank = coreRank = 0;
+                domainRank++;
+            }
+        }
+        else {
+            smtRank = coreRank = domainRank = 0;
+        }
+
+        switch (affinity) {
+        case JobsAffinity::Compact:
+            slots[numSlots++] = CpuSlot { .cpu = cpu, .key = MakeKey(cpu->packageIndex, cpu->cacheDomainIndex, cpu->coreIndex, smtRank) };
+            break;
+        case JobsAffinity::Scatter:
+            slots[numSlots++] = CpuSlot { .cpu = cpu, .key = MakeKey(smtRank, coreRank, domainRank, cpu->packageIndex) };
+            break;
+        case JobsAffinity::PhysicalCores:
+            if (smtRank == 0)
+                slots[numSlots++] = CpuSlot { .cpu = cpu, .key = MakeKey(cpu->packageIndex, cpu->cacheDomainIndex, cpu->coreIndex, 0) };
+            break;
+        default:
+            break;
+        }
+    }
+    SortSlots(slots, numSlots);
+    ASSERT(numSlots);
+
+    for (uint32 i = 0; i < uint32(JobsType::_Count); i++) {
+        for (uint32 k = 0; k < gJobs.numThreads[i]; k++) {
+            const SysCpuInfo* cpu = slots[k % numSlots].cpu;
+            gJobs.workers[i][k].cpuIndex = cpu->cpuIndex;
+            gJobs.workers[i][k].cacheDomain = cpu->cacheDomainIndex;
+        }
+    }
+
+    memFree(topo.cpus);
+}
+
 void jobsInitialize(const JobsInitParams& initParams)
 {
     ASSERT(initParams.alloc);
@@ -626,6 +1553,12 @@ void jobsInitialize(const JobsInitParams& initParams)
 
     gJobs.numThreads[uint32(JobsType::ShortTask)] = initParams.numShortTaskThreads == 0 ? Max<uint32>(1, numCores - 1) : initParams.numShortTaskThreads;
     gJobs.numThreads[uint32(JobsType::LongTask)] =  initParams.numLongTaskThreads == 0 ? Max<uint32>(1, numCores - 1) : initParams.numLongTaskThreads;
+    gJobs.maxThreads[uint32(JobsType::ShortTask)] = gJobs.numThreads[uint32(JobsType::ShortTask)];
+    gJobs.maxThreads[uint32(JobsType::LongTask)] = Max(gJobs.numThreads[uint32(JobsType::LongTask)], 
+        initParams.maxLongTaskThreads == 0 ? gJobs.numThreads[uint32(JobsType::LongTask)]*4 : initParams.maxLongTaskThreads);
+
+    // Spinning before sleep only pays off when the spinner doesn't take the cpu from the thread that is about to give it work
+    gJobs.idleSpinCount = numCores > 2 ? _limits::kJobsIdleSpinCount : 0;
 
     // TODO: On android platforms, we have different core types, performance and efficiency
     //       We can't exactly figure that out yet, but current we are following the qualcomm pattern
@@ -637,7 +1570,7 @@ void jobsInitialize(const JobsInitParams& initParams)
         debugStacktraceSaveStopPoint((void*)jobsEntryFn);   // workaround for stacktrace crash bug. see `debugStacktraceSaveStopPoint`
 
     #ifdef JOBS_USE_ANDERSON_LOCK
-    uint32 numTotalThreads = gJobs.numThreads[0] + gJobs.numThreads[1] + 1;
+    uint32 numTotalThreads = gJobs.maxThreads[0] + gJobs.maxThreads[1] + 1;
     atomicALockInitialize(&gJobs.waitingListLock, numTotalThreads, memAllocAlignedTyped<AtomicALockThread>(numTotalThreads, alignof(AtomicALockThread), initParams.alloc));
     if (initParams.alloc->GetType() != AllocatorType::Bump)
         gJobs.pointers.Add(Pair<void*, uint32>(gJobs.waitingListLock.slots, alignof(AtomicALockThread)));
@@ -646,61 +1579,55 @@ void jobsInitialize(const JobsInitParams& initParams)
     gJobs.semaphores[uint32(JobsType::ShortTask)].Initialize();
     gJobs.semaphores[uint32(JobsType::LongTask)].Initialize();
     
-    // Fibers stack memory pool. 
-    // Reserve 1MB for each fiber stack. Be careful with maxFibers value, because the memory pool can get huge if high number is used
+    // Fiber stack pools. Every bucket keeps up to maxFibers stacks around for reuse, stacks are reserved on demand
     {
         uint32 maxFibers = initParams.maxFibers ? initParams.maxFibers : _limits::kJobsMaxFibers;
-        size_t allocSize = 2*maxFibers*kMB;
-        size_t poolSize = MemTlsfAllocator::GetMemoryRequirement(allocSize);
-        void* buffer = memAlloc(poolSize, initParams.alloc);
+        void** freeStacks = memAllocTyped<void*>(maxFibers*_limits::kJobsNumStackBuckets, initParams.alloc);
+        if (initParams.alloc->GetType() != AllocatorType::Bump)
+            gJobs.pointers.Add(Pair<void*, uint32>(freeStacks, 0));
+
+        size_t pageSize = sysGetPageSize();
+        for (uint32 i = 0; i < _limits::kJobsNumStackBuckets; i++) {
+            JobsStackBucket& bucket = gJobs.stackBuckets[i];
+            bucket.freeStacks = freeStacks + i*maxFibers;
+            bucket.maxFree = maxFibers;
+            mco_desc desc = mco_desc_init(jobsEntryFn, _limits::kJobsMinStackSize << i);
+            bucket.headerSize = desc.coro_size - desc.stack_size - 16;  // See minicoro's `_mco_init_desc_sizes`
+            bucket.blockSize = AlignValue<size_t>(bucket.headerSize, pageSize) + pageSize + desc.stack_size;
+        }
+    }
+
+    for (uint32 i = 0; i < uint32(JobsType::_Count); i++) {
+        gJobs.workers[i] = memAllocAlignedTyped<JobsWorker>(gJobs.maxThreads[i], alignof(JobsWorker), initParams.alloc);
+        memset(gJobs.workers[i], 0x0, sizeof(JobsWorker)*gJobs.maxThreads[i]);
         if (initParams.alloc->GetType() != AllocatorType::Bump)
-            gJobs.pointers.Add(Pair<void*, uint32>(buffer, 0));
+            gJobs.pointers.Add(Pair<void*, uint32>(gJobs.workers[i], alignof(JobsWorker)));
 
-        gJobs.tlsfAlloc.Initialize(allocSize, buffer, poolSize, initParams.debugAllocations);
-        gJobs.runtimeAlloc.SetAllocator(&gJobs.tlsfAlloc);
-        gJobs.runtimeHeapTotal = allocSize;
+        gJobs.threadStates[i] = memAllocZeroTyped<atomicUint32>(gJobs.maxThreads[i], initParams.alloc);
+        if (initParams.alloc->GetType() != AllocatorType::Bump)
+            gJobs.pointers.Add(Pair<void*, uint32>(gJobs.threadStates[i], 0));
     }
 
+    jobsAssignWorkerCpus(initParams.affinity);
+
     gJobs.instancePool = JobsAtomicPool<JobsInstance, _limits::kJobsMaxInstances>::Create(initParams.alloc);
     gJobs.fiberPropsPool = JobsAtomicPool<JobsFiberProperties, _limits::kJobsMaxPending>::Create(initParams.alloc);
 
-    // Initialize and start the threads
-    // LongTasks
-    gJobs.threads[uint32(JobsType::LongTask)] = NEW_ARRAY(initParams.alloc, Thread, gJobs.numThreads[uint32(JobsType::LongTask)]);
-    if (initParams.alloc->GetType() != AllocatorType::Bump)
-        gJobs.pointers.Add(Pair<void*, uint32>(gJobs.threads[uint32(JobsType::LongTask)], 0));
+    // Initialize and start the threads. LongTasks have extra slots for the compensating threads, which are started on demand
+    for (uint32 i = 0; i < uint32(JobsType::_Count); i++) {
+        gJobs.threads[i] = NEW_ARRAY(initParams.alloc, Thread, gJobs.maxThreads[i]);
+        if (initParams.alloc->GetType() != AllocatorType::Bump)
+            gJobs.pointers.Add(Pair<void*, uint32>(gJobs.threads[i], 0));
+    }
 
     for (uint32 i = 0; i < gJobs.numThreads[uint32(JobsType::LongTask)]; i++) {
-        char name[32];
-        strPrintFmt(name, sizeof(name), "LongTask_%u", i+1);
-        gJobs.threads[uint32(JobsType::LongTask)][i].Start(ThreadDesc {
-            .entryFn = jobsThreadFn, 
-            .userData = IntToPtr<uint64>((static_cast<uint64>(i+1) << 32) | uint32(JobsType::LongTask)), 
-            .name = name, 
-            .stackSize = 64*kKB,
-            .flags = ThreadCreateFlags::None
-        });
-        ASSERT(gJobs.threads[uint32(JobsType::LongTask)][i].IsRunning());
-        gJobs.threads[uint32(JobsType::LongTask)][i].SetPriority(ThreadPriority::Normal);
+        gJobs.threadStates[uint32(JobsType::LongTask)][i] = uint32(JobsThreadState::Running);
+        jobsStartThread(JobsType::LongTask, i);
     }
     
-    // ShortTasks
-    gJobs.threads[uint32(JobsType::ShortTask)] = NEW_ARRAY(initParams.alloc, Thread, gJobs.numThreads[uint32(JobsType::ShortTask)]);
-    if (initParams.alloc->GetType() != AllocatorType::Bump)
-        gJobs.pointers.Add(Pair<void*, uint32>(gJobs.threads[uint32(JobsType::ShortTask)], 0));
-
     for (uint32 i = 0; i < gJobs.numThreads[uint32(JobsType::ShortTask)]; i++) {
-        char name[32];
-        strPrintFmt(name, sizeof(name), "ShortTask_%u", i+1);
-        gJobs.threads[uint32(JobsType::ShortTask)][i].Start(ThreadDesc {
-            .entryFn = jobsThreadFn, 
-            .userData = IntToPtr<uint64>((static_cast<uint64>(i+1) << 32) | uint32(JobsType::ShortTask)), 
-            .name = name, 
-            .stackSize = 64*kKB,
-            .flags = ThreadCreateFlags::None
-        });
-        ASSERT(gJobs.threads[uint32(JobsType::ShortTask)][i].IsRunning());
-        gJobs.threads[uint32(JobsType::ShortTask)][i].SetPriority(ThreadPriority::High);
+        gJobs.threadStates[uint32(JobsType::ShortTask)][i] = uint32(JobsThreadState::Running);
+        jobsStartThread(JobsType::ShortTask, i);
     }
 
     debugFiberScopeProtector_RegisterCallback([](void*)->bool { return jobsGetThreadData() && jobsGetThreadData()->curFiber != nullptr; });
@@ -712,26 +1639,26 @@ void jobsInitialize(const JobsInitParams& initParams)
     tracySetZoneCallbacks(jobsTracyEnterZone, jobsTracyExitZone);
     #endif
 
-    logInfo("(init) Job dispatcher: %u short task threads, %u long task threads", 
+    logInfo("(init) Job dispatcher: %u short task threads, %u long task threads (max: %u)", 
             gJobs.numThreads[uint32(JobsType::ShortTask)],
-            gJobs.numThreads[uint32(JobsType::LongTask)]);
+            gJobs.numThreads[uint32(JobsType::LongTask)],
+            gJobs.maxThreads[uint32(JobsType::LongTask)]);
 }
 
 void jobsRelease()
 {
     gJobs.quit = true;
 
-    gJobs.semaphores[uint32(JobsType::ShortTask)].Post(gJobs.numThreads[uint32(JobsType::ShortTask)]);
-    gJobs.semaphores[uint32(JobsType::LongTask)].Post(gJobs.numThreads[uint32(JobsType::LongTask)]);
-
-    if (gJobs.threads[uint32(JobsType::ShortTask)]) {
-        for (uint32 i = 0; i < gJobs.numThreads[uint32(JobsType::ShortTask)]; i++)
-            gJobs.threads[uint32(JobsType::ShortTask)][i].Stop();
-    }
+    gJobs.semaphores[uint32(JobsType::ShortTask)].Post(gJobs.maxThreads[uint32(JobsType::ShortTask)]);
+    gJobs.semaphores[uint32(JobsType::LongTask)].Post(gJobs.maxThreads[uint32(JobsType::LongTask)]);
 
-    if (gJobs.threads[uint32(JobsType::LongTask)]) {
-        for (uint32 i = 0; i < gJobs.numThreads[uint32(JobsType::LongTask)]; i++)
-            gJobs.threads[uint32(JobsType::LongTask)][i].Stop();
+    for (uint32 i = 0; i < uint32(JobsType::_Count); i++) {
+        if (!gJobs.threads[i])
+            continue;
+        for (uint32 k = 0; k < gJobs.maxThreads[i]; k++) {
+            if (gJobs.threadStates[i][k] != uint32(JobsThreadState::Idle))
+                gJobs.threads[i][k].Stop();
+        }
     }
 
     if (gJobs.instancePool)
@@ -739,6 +1666,13 @@ void jobsRelease()
     if (gJobs.fiberPropsPool)
         JobsAtomicPool<JobsFiberProperties, _limits::kJobsMaxPending>::Destroy(gJobs.fiberPropsPool, gJobs.initParams.alloc);
 
+    for (uint32 i = 0; i < _limits::kJobsNumStackBuckets; i++) {
+        JobsStackBucket& bucket = gJobs.stackBuckets[i];
+        for (uint32 k = 0; k < bucket.numFree; k++)
+            jobsFreeFiberStack(i, bucket.freeStacks[k]);
+        bucket.numFree = 0;
+    }
+
     memFree(jobsGetThreadData());
     gJobsThreadData = nullptr;
 
@@ -757,6 +1691,10 @@ void jobsGetBudgetStats(JobsBudgetStats* stats)
     stats->maxLongTaskThreads = gJobs.numThreads[uint32(JobsType::LongTask)];
     stats->numBusyShortThreads = m.numBusyShortThreadsMax;
     stats->numBusyLongThreads = m.numBusyLongThreadsMax;
+    stats->numBlockedLongThreads = m.numBlockedLongThreadsMax;
+    stats->numExtraLongThreads = m.numExtraLongThreadsMax;
+    stats->maxExtraLongThreads = gJobs.maxThreads[uint32(JobsType::LongTask)] - gJobs.numThreads[uint32(JobsType::LongTask)];
+    stats->numExtraThreadSpawns = gJobs.numExtraThreadSpawns;
 
     stats->maxFibers = gJobs.initParams.maxFibers ? gJobs.initParams.maxFibers : _limits::kJobsMaxFibers;
     stats->numFibers = m.numFibersMax;
@@ -765,7 +1703,9 @@ void jobsGetBudgetStats(JobsBudgetStats* stats)
     stats->numJobs = m.numInstancesMax;
 
     stats->fiberHeapSize = m.maxFiberHeap;
-    stats->fiberHeapMax = gJobs.runtimeHeapTotal;
+    stats->fiberHeapMax = gJobs.stackReservedSize;
+    stats->numFiberStacksCreated = gJobs.numStacksCreated;
+    stats->numFiberStacksReused = gJobs.numStacksReused;
 
     stats->initHeapStart = gJobs.initHeapStart;
     stats->initHeapSize = gJobs.initHeapSize;
@@ -776,6 +1716,69 @@ void jobsResetBudgetStats()
     JobsContext::MaxValues* m = &gJobs.maxValues[0];
     gJobs.maxValues[1] = *m;
     memset(m, 0x0, sizeof(*m));    
+
+    // These only get updated on change, so carry the current values over to the new period
+    m->numBlockedLongThreadsMax = gJobs.numBlocked[uint32(JobsType::LongTask)];
+    m->numExtraLongThreadsMax = gJobs.numExtraThreads[uint32(JobsType::LongTask)];
+}
+
+// The values are read while the workers are updating them, so the sample is not an exact snapshot. Good enough for the graphs
+void jobsGetTelemetry(JobsTelemetry* telemetry, Allocator* alloc)
+{
+    ASSERT(telemetry);
+    memset(telemetry, 0x0, sizeof(*telemetry));
+
+    telemetry->timestamp = timerGetTicks();
+    telemetry->numWorkers = gJobs.maxThreads[uint32(JobsType::ShortTask)] + gJobs.maxThreads[uint32(JobsType::LongTask)];
+    telemetry->workers = memAllocZeroTyped<JobsWorkerTelemetry>(telemetry->numWorkers, alloc);
+
+    uint32 workerIndex = 0;
+    for (uint32 typeIndex = 0; typeIndex < uint32(JobsType::_Count); typeIndex++) {
+        JobsTypeTelemetry& t = telemetry->types[typeIndex];
+        t.firstWorker = workerIndex;
+        t.numWorkers = gJobs.maxThreads[typeIndex];
+        t.numBusy = typeIndex == uint32(JobsType::ShortTask) ? gJobs.numBusyShortThreads : gJobs.numBusyLongThreads;
+        t.numBlocked = gJobs.numBlocked[typeIndex];
+
+        for (uint32 i = 0; i < gJobs.maxThreads[typeIndex]; i++) {
+            JobsWorker& worker = gJobs.workers[typeIndex][i];
+            JobsWorkerTelemetry& w = telemetry->workers[workerIndex++];
+            uint64 times[uint32(JobsWorkerState::_Count)];
+            memcpy(times, worker.times, sizeof(times));
+            uint64 stateTick = worker.stateTick;
+            if (stateTick && telemetry->timestamp > stateTick)
+                times[uint32(worker.state)] += telemetry->timestamp - stateTick;
+
+            w.busyTime = times[uint32(JobsWorkerState::Busy)];
+            w.searchTime = times[uint32(JobsWorkerState::Search)];
+            w.idleTime = times[uint32(JobsWorkerState::Idle)];
+            w.numItemsRun = worker.numItemsRun;
+            w.numSteals = worker.numSteals;
+            w.isRunning = gJobs.threadStates[typeIndex][i] == uint32(JobsThreadState::Running);
+
+            t.numStarted += worker.numStarted;
+            t.latencyTotal += worker.latencyTotal;
+            for (uint32 b = 0; b < kJobsLatencyBuckets; b++)
+                t.latencyHistogram[b] += worker.latencyHistogram[b];
+
+            for (uint32 prioIdx = 0; prioIdx < uint32(JobsPriority::_Count); prioIdx++) {
+                JobsDeque& deque = worker.deques[prioIdx];
+                uint64 top = atomicLoad64Explicit(&deque.mTop, AtomicMemoryOrder::Relaxed);
+                uint64 bottom = atomicLoad64Explicit(&deque.mBottom, AtomicMemoryOrder::Relaxed);
+                int64 count = int64(bottom - top);   // Can be off by one while the owner is popping
+                t.queueDepth[prioIdx] += uint32(Max<int64>(count, 0));
+            }
+        }
+
+        for (uint32 prioIdx = 0; prioIdx < uint32(JobsPriority::_Count); prioIdx++)
+            t.queueDepth[prioIdx] += gJobs.waitingLists[typeIndex].counts[prioIdx];
+    }
+
+    telemetry->numFibers = gJobs.numFibers;
+    telemetry->maxFibers = gJobs.initParams.maxFibers ? gJobs.initParams.maxFibers : _limits::kJobsMaxFibers;
+    telemetry->numJobs = gJobs.numInstances;
+    for (uint32 i = 0; i < _limits::kJobsNumStackBuckets; i++)
+        telemetry->numPooledStacks += gJobs.stackBuckets[i].numFree;
 }
 
 uint32 jobsGetWorkerThreadsCount(JobsType type)
@@ -784,17 +1787,49 @@ uint32 jobsGetWorkerThreadsCount(JobsType type)
     return gJobs.numThreads[uint32(type)];
 }
 
+static void jobsSignalWakeExternal(JobsSignalInternal* self)
+{
+    if (atomicLoad32Explicit(&self->numExternalWaiters, AtomicMemoryOrder::Seqcst))
+        threadWakeAllOnAddress(&self->value);
+}
+
 JobsSignal::JobsSignal()
 {
     JobsSignalInternal* self = reinterpret_cast<JobsSignalInternal*>(data);
     self->signaled = 0;
+    self->waitersLock = 0;
+    self->waiters = nullptr;
+    self->numExternalWaiters = 0;
     self->value = 0;
 }
 
 void JobsSignal::Raise()
 {
     JobsSignalInternal* self = reinterpret_cast<JobsSignalInternal*>(data);
-    atomicExchange32Explicit(&self->signaled, 1, AtomicMemoryOrder::Release);
+    
+    // Wake up one of the parked fibers, or keep the signaled state for the next waiter
+    JobsFiberProperties* props = nullptr;
+    {
+        atomicUint32 expected = 0;
+        while (!atomicCompareExchange32Weak(&self->waitersLock, &expected, 1)) {
+            expected = 0;
+            atomicPauseCpu();
+        }
+
+        props = self->waiters;
+        if (props)
+            self->waiters = props->next;
+        else
+            atomicExchange32Explicit(&self->signaled, 1, AtomicMemoryOrder::Release);
+
+        atomicStore32Explicit(&self->waitersLock, 0, AtomicMemoryOrder::Release);
+    }
+
+    if (props) {
+        props->next = nullptr;
+        jobsSchedule(props, props->instance->type);
+        jobsWakeWorkers(props->instance->type, 1);
+    }
 }
 
 void JobsSignal::Wait()
@@ -806,8 +1841,9 @@ void JobsSignal::WaitOnCondition(bool(*condFn)(int value, int reference), int re
 {
     JobsSignalInternal* self = reinterpret_cast<JobsSignalInternal*>(data);
 
-    uint32 spinCount = !PLATFORM_MOBILE;
-    while (condFn(atomicLoad32Explicit(&self->value, AtomicMemoryOrder::Acquire), reference)) {
+    uint32 spinCount = 0;
+    uint32 value;
+    while (condFn(int(value = atomicLoad32Explicit(&self->value, AtomicMemoryOrder::Acquire)), reference)) {
         if (jobsGetThreadData()) {
             ASSERT_MSG(jobsGetThreadData()->curFiber, "'Wait' should only be called during running job tasks");
 
@@ -819,11 +1855,15 @@ void JobsSignal::WaitOnCondition(bool(*condFn)(int value, int reference), int re
 
             curFiber->signal = nullptr;
         }
+        else if (spinCount++ < gJobs.idleSpinCount) {
+            atomicPauseCpu();
+        }
         else {
-            if (spinCount++ & 1023)
-                atomicPauseCpu();   // Main thread just loops 
-            else
-                threadYield();
+            // Block until the value changes. Every modification of `value` wakes us up
+            atomicFetchAdd32(&self->numExternalWaiters, 1);
+            if (atomicLoad32(&self->value) == value)
+                threadWaitOnAddress(&self->value, value);
+            atomicFetchSub32(&self->numExternalWaiters, 1);
         }
     }
 }
@@ -831,19 +1871,22 @@ void JobsSignal::WaitOnCondition(bool(*condFn)(int value, int reference), int re
 void JobsSignal::Set(int value)
 {
     JobsSignalInternal* self = reinterpret_cast<JobsSignalInternal*>(data);
-    atomicExchange32Explicit(&self->value, uint32(value), AtomicMemoryOrder::Release);
+    atomicExchange32Explicit(&self->value, uint32(value), AtomicMemoryOrder::Seqcst);
+    jobsSignalWakeExternal(self);
 }
 
 void JobsSignal::Decrement()
 {
     JobsSignalInternal* self = reinterpret_cast<JobsSignalInternal*>(data);
-    atomicFetchAdd32Explicit(&self->value, 1, AtomicMemoryOrder::Release);
+    atomicFetchAdd32Explicit(&self->value, 1, AtomicMemoryOrder::Seqcst);
+    jobsSignalWakeExternal(self);
 }
 
 void JobsSignal::Increment()
 {
     JobsSignalInternal* self = reinterpret_cast<JobsSignalInternal*>(data);
-    atomicFetchSub32Explicit(&self->value, 1, AtomicMemoryOrder::Release);
+    atomicFetchSub32Explicit(&self->value, 1, AtomicMemoryOrder::Seqcst);
+    jobsSignalWakeExternal(self);
 }
 
 template <typename _T, uint32 _MaxCount> 
@@ -21,6 +21,14 @@
 //      LongTask: Long tasks are expected to do IO or longer jobs. They can span across several threads as well.
 //                There are numCores-1 threads of this type in the thread pool by default
 //                They also run on the lower priority threads as opposed to ShortTask types. So by nature ShortTasks have higher priority for cpu execution
+//                LongTask workers that block (process wait, file IO, mutexes) should wrap it with `JobsBlockingScope`. The pool then spawns
+//                compensating threads (up to maxLongTaskThreads) so there are always numLongTaskThreads workers runnable. Those retire when idle
+//
+// Scheduling:
+//      Every worker has a work-stealing deque per priority. Jobs dispatched from a worker go to its own deque and idle workers of the same type
+//      steal from others. Jobs dispatched from other threads go to a shared list. Fibers that wait on a job or a signal are parked on it
+//      and get re-scheduled when the job finishes or the signal is raised, so workers never scan or spin over waiting fibers
+//      When the workers are pinned (JobsAffinity), stealing tries the workers in the same cache domain first
 //
 #include "Base.h"
 
@@ -43,12 +51,26 @@ enum class JobsType : uint32
     _Count
 };
 
+// Pinning the worker threads to cpus. Needs cpu topology info (see sysGetCpuTopology), otherwise it falls back to None
+// Workers of both types with the same index are pinned to the same cpu. Compensating LongTask threads are never pinned
+enum class JobsAffinity : uint32
+{
+    None = 0,       // Let the OS move the workers around
+    Compact,        // Fill cache domains one after another (SMT siblings next to each other), so workers share caches
+    Scatter,        // Spread across packages and cache domains first, then SMT siblings. More cache and memory bandwidth per worker
+    PhysicalCores   // Like Compact, but only one logical cpu per physical core
+};
+
 struct JobsBudgetStats
 {
     uint32 maxShortTaskThreads;
     uint32 maxLongTaskThreads;
     uint32 numBusyShortThreads;
     uint32 numBusyLongThreads;
+    uint32 numBlockedLongThreads;       // Inside JobsBlockingScope
+    uint32 numExtraLongThreads;         // Compensating threads
+    uint32 maxExtraLongThreads;
+    uint32 numExtraThreadSpawns;        // Total since initialize
 
     uint32 numFibers;
     uint32 maxFibers;
@@ -56,13 +78,53 @@ struct JobsBudgetStats
     uint32 numJobs;
     uint32 maxJobs;
     
-    size_t fiberHeapSize;
-    size_t fiberHeapMax;
+    size_t fiberHeapSize;               // Stack memory used by the running fibers (peak)
+    size_t fiberHeapMax;                // Reserved stack memory, including the pooled stacks
+    uint32 numFiberStacksCreated;       // Total since initialize
+    uint32 numFiberStacksReused;
 
     size_t initHeapStart;
     size_t initHeapSize;
 };
 
+// Telemetry: All the counters and times are cumulative since jobsInitialize, times are in nanosecs (timer ticks)
+// Take samples periodically and diff them to get rates, utilization and latencies for the period (see GuiJobsView)
+static inline constexpr uint32 kJobsLatencyBuckets = 16;
+
+struct JobsWorkerTelemetry
+{
+    uint64 busyTime;        // Running job items
+    uint64 searchTime;      // Polling the queues and stealing from other workers, including the idle spin
+    uint64 idleTime;        // Sleeping in the OS, waiting for work
+    uint64 numItemsRun;     // Started and resumed items
+    uint64 numSteals;
+    bool isRunning;         // Compensating LongTask slots only have a thread while other workers are blocked
+};
+
+struct JobsTypeTelemetry
+{
+    uint32 firstWorker;     // Index into JobsTelemetry::workers
+    uint32 numWorkers;      // Thread slots, including the ones for the compensating threads
+    uint32 numBusy;
+    uint32 numBlocked;
+    uint32 queueDepth[uint32(JobsPriority::_Count)];   // Items waiting to start or resume: worker deques + shared list
+    uint64 numStarted;
+    uint64 latencyTotal;                                // Dispatch (or dependencies finished) to start
+    uint64 latencyHistogram[kJobsLatencyBuckets];       // Bucket 0: <1us, Bucket N: <2^N us. Last one gets everything above
+};
+
+struct JobsTelemetry
+{
+    uint64 timestamp;
+    JobsTypeTelemetry types[uint32(JobsType::_Count)];
+    JobsWorkerTelemetry* workers;   // Allocated by jobsGetTelemetry, free it with memFree
+    uint32 numWorkers;
+    uint32 numFibers;               // Running and parked fibers
+    uint32 maxFibers;
+    uint32 numJobs;
+    uint32 numPooledStacks;
+};
+
 struct alignas(CACHE_LINE_SIZE) JobsSignal
 {
     JobsSignal();
@@ -83,10 +145,11 @@ struct JobsInitParams
     Allocator* alloc = memDefaultAlloc();
     uint32 numShortTaskThreads = 0; // Default: total number of cores - 1
     uint32 numLongTaskThreads = 0;  // Default: total number of cores - 1
+    uint32 maxLongTaskThreads = 0;  // Including the compensating threads for blocked workers. Default: numLongTaskThreads*4
     uint32 defaultShortTaskStackSize = kMB;
     uint32 defaultLongTaskStackSize = kMB;
-    uint32 maxFibers = 0;       // Maximum fibers in execution. Default=_limits::kJobsMaxFibers
-    bool debugAllocations = false;
+    JobsAffinity affinity = JobsAffinity::None;
+    uint32 maxFibers = 0;       // Maximum fibers in execution. Default=_limits::kJobsMaxFibers. Also the number of pooled stacks per size
 };
 
 API void jobsInitialize(const JobsInitParams& initParams);
@@ -103,32 +166,105 @@ API bool jobsIsRunning(JobsHandle handle);
 API void jobsDispatchAuto(JobsType type, JobsCallback callback, void* userData = nullptr, 
                           uint32 groupSize = 1, JobsPriority prio = JobsPriority::Normal, uint32 stackSize = 0);
 
+// Continuations: The job is queued right away, but its items only start after all the `deps` jobs are finished
+// No thread is blocked in between, the last finishing dependency schedules the items. Dependencies cannot be AutoDelete jobs, 
+// and their handles still have to be released with jobsWaitForCompletion, which returns right away once they are finished
+API [[nodiscard]] JobsHandle jobsDispatchAfter(const JobsHandle* deps, uint32 numDeps, JobsType type, JobsCallback callback, void* userData = nullptr, 
+                                               uint32 groupSize = 1, JobsPriority prio = JobsPriority::Normal, uint32 stackSize = 0);
+API void jobsDispatchAutoAfter(const JobsHandle* deps, uint32 numDeps, JobsType type, JobsCallback callback, void* userData = nullptr, 
+                               uint32 groupSize = 1, JobsPriority prio = JobsPriority::Normal, uint32 stackSize = 0);
+
+// Graph: Builds a DAG of jobs and dispatches all of them at once with jobsDispatchAfter
+//      JobsGraph* graph = jobsCreateGraph();
+//      uint32 a = jobsGraphAddNode(graph, JobsType::ShortTask, FnA);
+//      uint32 b = jobsGraphAddNode(graph, JobsType::LongTask, FnB, userData, 4);
+//      jobsGraphAddDependency(graph, b, a);   // b runs after a
+//      jobsGraphDispatch(graph);
+//      ...
+//      jobsGraphWaitForCompletion(graph);     // Graph can be dispatched again after this
+//      jobsDestroyGraph(graph);
+struct JobsGraph;
+API JobsGraph* jobsCreateGraph(Allocator* alloc = memDefaultAlloc());
+API void jobsDestroyGraph(JobsGraph* graph);
+API uint32 jobsGraphAddNode(JobsGraph* graph, JobsType type, JobsCallback callback, void* userData = nullptr, 
+                            uint32 groupSize = 1, JobsPriority prio = JobsPriority::Normal, uint32 stackSize = 0);
+API void jobsGraphAddDependency(JobsGraph* graph, uint32 node, uint32 dependsOn);
+API bool jobsGraphDispatch(JobsGraph* graph);   // Returns false if the graph has cycles
+API void jobsGraphWaitForCompletion(JobsGraph* graph);
+API bool jobsGraphIsRunning(JobsGraph* graph);
+
+// Blocking sections: Announce that the current LongTask job is going to block the thread for a while (see Thread Model)
+// No-op on other threads. Do not wait on jobs or signals inside the section: Parked fibers do not block the thread
+API void jobsBeginBlockingSection();
+API void jobsEndBlockingSection();
+
+struct JobsBlockingScope
+{
+    JobsBlockingScope() { jobsBeginBlockingSection(); }
+    ~JobsBlockingScope() { jobsEndBlockingSection(); }
+};
+
 API void jobsGetBudgetStats(JobsBudgetStats* stats);
 API void jobsResetBudgetStats();
+API void jobsGetTelemetry(JobsTelemetry* telemetry, Allocator* alloc = memDefaultAlloc());
 API uint32 jobsGetWorkerThreadsCount(JobsType type);
 
-#if 0
+// Parallel-for: Splits [begin, end) into chunks of at least `grainSize` items and runs `callback(rangeBegin, rangeEnd, userData)` on them
+// Chunks are claimed dynamically (big first, smaller towards the end), and the calling thread processes chunks too until the range is done
+// Ranges that fit in a single grain run inline on the caller. Helper jobs run directly on the worker threads without fibers, 
+// so the callback must not wait on jobs or signals. Blocks the caller (or yields the current job) until the whole range is processed
+using JobsRangeCallback = void(*)(uint32 rangeBegin, uint32 rangeEnd, void* userData);
+API void jobsParallelFor(uint32 begin, uint32 end, uint32 grainSize, JobsRangeCallback callback, void* userData, 
+                         JobsType type = JobsType::ShortTask, JobsPriority prio = JobsPriority::Normal);
+
+namespace _private
+{
+    using JobsDestroyUserDataCallback = void(*)(void* userData);
+
+    // userData is owned by the job and gets destroyed with `destroyFn` after all the group items are finished
+    API JobsHandle jobsDispatchOwned(bool isAutoDelete, JobsType type, JobsCallback callback, void* userData, 
+                                     JobsDestroyUserDataCallback destroyFn, uint32 groupSize, JobsPriority prio, uint32 stackSize);
+
+    template <typename _Func>
+    struct JobsLambda
+    {
+        static void Run(uint32 groupIndex, void* userData) { (*reinterpret_cast<_Func*>(userData))(groupIndex); }
+        static void Destroy(void* userData) 
+        { 
+            reinterpret_cast<_Func*>(userData)->~_Func(); 
+            memFree(userData);
+        }
+    };
+}
+
 // Templated lambda functions (no need for userData)
 // Callback: [](uint32 groupIndex)
-// The Caveat here is that we need to keep the passing _Func alive as long as the task exists
-// So I'm not sure if I'm going to keep this
+// The lambda is copied along with its captures and the copy lives until the job is finished, so it's safe to capture locals by value
 template <typename _Func>
-inline JobsHandle jobsDispatch(JobsType type, _Func* fn, uint32 groupSize = 1, JobsPriority prio = JobsPriority::Normal, uint32 stackSize = 0)
+inline JobsHandle jobsDispatch(JobsType type, _Func fn, uint32 groupSize = 1, JobsPriority prio = JobsPriority::Normal, uint32 stackSize = 0)
 {
-    auto wrapperFn = [](uint32 groupIndex, void* userData) {
-        (*(_Func*)userData)(groupIndex);
-    };
+    _Func* userData = NEW(memDefaultAlloc(), _Func)(static_cast<_Func&&>(fn));
+    return _private::jobsDispatchOwned(false, type, _private::JobsLambda<_Func>::Run, userData, _private::JobsLambda<_Func>::Destroy, 
+                                       groupSize, prio, stackSize);
+}
 
-    return jobsDispatch(type, wrapperFn, fn, groupSize, prio, stackSize);
+template <typename _Func>
+inline void jobsDispatchAuto(JobsType type, _Func fn, uint32 groupSize = 1, JobsPriority prio = JobsPriority::Normal, uint32 stackSize = 0)
+{
+    _Func* userData = NEW(memDefaultAlloc(), _Func)(static_cast<_Func&&>(fn));
+    _private::jobsDispatchOwned(true, type, _private::JobsLambda<_Func>::Run, userData, _private::JobsLambda<_Func>::Destroy, 
+                                groupSize, prio, stackSize);
 }
 
+// Callback: [](uint32 rangeBegin, uint32 rangeEnd)
+// Since the call blocks until the range is processed, `fn` stays on the caller's stack and is shared between the threads
 template <typename _Func>
-inline void jobsDispatchAuto(JobsType type, _Func* fn, uint32 groupSize = 1, JobsPriority prio = JobsPriority::Normal, uint32 stackSize = 0)
+inline void jobsParallelFor(uint32 begin, uint32 end, uint32 grainSize, _Func fn, 
+                            JobsType type = JobsType::ShortTask, JobsPriority prio = JobsPriority::Normal)
 {
-    auto wrapperFn = [](uint32 groupIndex, void* userData) {
-        (*(_Func*)userData)(groupIndex);
+    auto wrapperFn = [](uint32 rangeBegin, uint32 rangeEnd, void* userData) {
+        (*reinterpret_cast<_Func*>(userData))(rangeBegin, rangeEnd);
     };
 
-    jobsDispatchAuto(type, wrapperFn, fn, groupSize, prio, stackSize);
+    jobsParallelFor(begin, end, grainSize, wrapperFn, &fn, type, prio);
 }
-#endif
\ No newline at end of file
@@ -38,7 +38,7 @@ JsonContext* jsonParse(const char* json5, uint32 json5Len, JsonErrorLocation* ou
         .user_data = &tokens
     };
 
-    json5Len = json5Len == 0 ? json5Len : strLen(json5);
+    json5Len = json5Len != 0 ? json5Len : strLen(json5);
     cj5_result r = cj5_parse_with_factory(json5, (int)json5Len, factory);
 
     if (r.error == CJ5_ERROR_NONE) {
@@ -50,10 +50,10 @@ JsonContext* jsonParse(const char* json5, uint32 json5Len, JsonErrorLocation* ou
         JsonContext* ctx = mallocator.Calloc(alloc);
 
         ctx->numTokens = tokens.Count();
-        memcpy(ctx->tokens, r.tokens, tokens.Count());
-        ctx->r.tokens = ctx->tokens;
+        memcpy(ctx->tokens, r.tokens, sizeof(cj5_token)*tokens.Count());
 
         ctx->r = r;
+        ctx->r.tokens = ctx->tokens;
         ctx->alloc = alloc;
 
         if (!mainAllocIsTemp)
@@ -79,6 +79,74 @@ void jsonDestroy(JsonContext* ctx)
         MemSingleShotMalloc<JsonContext>::Free(ctx, ctx->alloc);
 }
 
+uint32 jsonGetTokenCount(JsonContext* ctx)
+{
+    ASSERT(ctx);
+    return ctx->numTokens;
+}
+
+// Resolves JSON5 escape sequences of a string token. Output is truncated to dstSize and always null-terminated
+static const char* jsonUnescapeString(char* dst, uint32 dstSize, const char* src, uint32 srcLen)
+{
+    ASSERT(dstSize);
+    uint32 len = 0;
+    uint32 maxLen = dstSize - 1;
+
+    auto Put = [dst, maxLen, &len](char ch) { if (len < maxLen) dst[len++] = ch; };
+
+    for (uint32 i = 0; i < srcLen && len < maxLen; i++) {
+        char ch = src[i];
+        if (ch != '\\' || i + 1 == srcLen) {
+            Put(ch);
+            continue;
+        }
+
+        ch = src[++i];
+        switch (ch) {
+        case 'n':   Put('\n'); break;
+        case 'r':   Put('\r'); break;
+        case 't':   Put('\t'); break;
+        case 'b':   Put('\b'); break;
+        case 'f':   Put('\f'); break;
+        case 'v':   Put('\v'); break;
+        case '0':   Put('\0'); break;
+        case '\r': if (i + 1 < srcLen && src[i + 1] == '\n') i++; break;  // Line continuation
+        case '\n': break;
+        case 'u':
+            if (i + 4 < srcLen) {
+                uint32 code = 0;
+                for (uint32 k = 1; k <= 4; k++) {
+                    char h = src[i + k];
+                    code <<= 4;
+                    if (h >= '0' && h <= '9')       code |= uint32(h - '0');
+                    else if (h >= 'a' && h <= 'f')  code |= uint32(h - 'a' + 10);
+                    else if (h >= 'A' && h <= 'F')  code |= uint32(h - 'A' + 10);
+                }
+                i += 4;
+
+                // UTF-8, surrogate pairs are not combined
+                if (code < 0x80) {
+                    Put(char(code));
+                }
+                else if (code < 0x800) {
+                    Put(char(0xC0 | (code >> 6)));
+                    Put(char(0x80 | (code & 0x3F)));
+                }
+                else {
+                    Put(char(0xE0 | (code >> 12)));
+                    Put(char(0x80 | ((code >> 6) & 0x3F)));
+                    Put(char(0x80 | (code & 0x3F)));
+                }
+            }
+            break;
+        default:    Put(ch); break;     // \" \' \\ \/ and the rest map to themselves
+        }
+    }
+
+    dst[len] = '\0';
+    return dst;
+}
+
 uint32 JsonNode::GetChildCount() const
 {
     cj5_result* r = reinterpret_cast<cj5_result*>(mCtx);
@@ -140,8 +208,38 @@ const char* JsonNode::GetValue(char* outValue, uint32 valueSize) const
     cj5_result* r = reinterpret_cast<cj5_result*>(mCtx);
     CJ5_ASSERT(mTokenId >= 0 && mTokenId < r->num_tokens);
     const cj5_token* tok = &r->tokens[mTokenId];
-    return cj5__strcpy(outValue, valueSize, &r->json5[tok->start], tok->end - tok->start);
+    if (tok->type == CJ5_TOKEN_STRING)
+        return jsonUnescapeString(outValue, valueSize, &r->json5[tok->start], uint32(tok->end - tok->start));
+    else
+        return cj5__strcpy(outValue, valueSize, &r->json5[tok->start], tok->end - tok->start);
+}
+
+const char* JsonNode::GetChildValue(const char* _childNode, char* outValue, uint32 valueSize, const char* _defaultValue) const
+{
+    JsonNode jchild = GetChild(_childNode);
+    if (jchild.IsValid() && mCtx->r.tokens[jchild.mTokenId].type == CJ5_TOKEN_STRING)
+        return jchild.GetValue(outValue, valueSize);
 
+    strCopy(outValue, valueSize, _defaultValue);
+    return outValue;
+}
+
+const char* JsonNode::GetChildString(const char* _childNode, Allocator* alloc, const char* _defaultValue) const
+{
+    JsonNode jchild = GetChild(_childNode);
+    if (!jchild.IsValid() || mCtx->r.tokens[jchild.mTokenId].type != CJ5_TOKEN_STRING)
+        return _defaultValue;
+
+    uint32 size = jchild.GetValueLength() + 1;
+    char* str = (char*)memAlloc(size, alloc);
+    return jchild.GetValue(str, size);
+}
+
+uint32 JsonNode::GetValueLength() const
+{
+    ASSERT(IsValid());
+    const cj5_token* tok = &mCtx->r.tokens[mTokenId];
+    return uint32(tok->end - tok->start);
 }
 
 JsonNode JsonNode::GetChildItem(uint32 _index) const
@@ -189,7 +287,8 @@ JsonNode JsonNode::GetArrayItem(uint32 _index) const
     const cj5_token* tok = &r->tokens[mTokenId];
     int index = (int)_index;
     ASSERT(tok->type == CJ5_TOKEN_ARRAY);
-    ASSERT(index < tok->size);
+    if (index >= tok->size)
+        return JsonNode(mCtx, -1);
     for (int i = mTokenId + 1, count = 0, ic = r->num_tokens; i < ic && count < tok->size; i++) {
         if (r->tokens[i].parent_id == mTokenId) {
             if (count == index)
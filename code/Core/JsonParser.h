@@ -11,8 +11,11 @@ struct JsonErrorLocation
     uint32 col;
 };
 
+// The context keeps referencing the json5 text, it should stay valid until jsonDestroy
+// json5Len = 0: json5 is null-terminated
 API JsonContext* jsonParse(const char* json5, uint32 json5Len, JsonErrorLocation* outErrLoc, Allocator* alloc = memDefaultAlloc());
 API void jsonDestroy(JsonContext* ctx);
+API uint32 jsonGetTokenCount(JsonContext* ctx);
 
 struct JsonNode
 {
@@ -27,7 +30,7 @@ struct JsonNode
     JsonNode GetNextChildItem(const JsonNode& curChildItem) const;
     uint32 GetChildCount() const;
 
-    JsonNode GetArrayItem(uint32 _index = 0) const;
+    JsonNode GetArrayItem(uint32 _index = 0) const;     // Returns invalid node if the array is empty
     JsonNode GetNextArrayItem(const JsonNode& curItem) const;
     uint32 GetArrayCount() const;
 
@@ -35,14 +38,18 @@ struct JsonNode
     bool IsObject() const;
     bool IsArray() const;
 
+    // Strings are unescaped and truncated to the buffer size
     const char* GetKey(char* outKey, uint32 keySize) const;
     const char* GetValue(char* outValue, uint32 valueSize) const;
+    const char* GetChildValue(const char* _childNode, char* outValue, uint32 valueSize, const char* _defaultValue = "") const;
+    uint32 GetValueLength() const;  // Upper bound of the string length, for allocating the buffer for GetValue
+    const char* GetChildString(const char* _childNode, Allocator* alloc, const char* _defaultValue = "") const;  // For strings without a size limit
 
     template <typename _T> _T GetValue() const;
     template <typename _T> uint32 GetArrayValues(_T* _values, uint32 _maxValues) const;
 
-    template <typename _T> _T GetChildValue(const char* _childNode, _T _defaultValue);
-    template <typename _T> uint32 GetChildArrayValues(const char* _childNode, _T* _values, uint32 _maxValues);
+    template <typename _T> _T GetChildValue(const char* _childNode, _T _defaultValue) const;
+    template <typename _T> uint32 GetChildArrayValues(const char* _childNode, _T* _values, uint32 _maxValues) const;
 
 private:
     JsonContext* mCtx = nullptr;
@@ -100,11 +107,13 @@ inline JsonNode::JsonNode(JsonContext* _ctx, int _tokenId, int _itemIndex) : mCt
 
 inline bool JsonNode::HasChild(const char* _childNode) const
 {
-    return cj5_seek(reinterpret_cast<cj5_result*>(mCtx), mTokenId, _childNode) != -1;
+    return IsValid() && cj5_seek(reinterpret_cast<cj5_result*>(mCtx), mTokenId, _childNode) != -1;
 }
 
 inline JsonNode JsonNode::GetChild(const char* _childNode) const
 {
+    if (!IsValid())
+        return JsonNode();
     int id = cj5_seek(reinterpret_cast<cj5_result*>(mCtx), mTokenId, _childNode);
     return JsonNode(mCtx, id);
 }
@@ -169,6 +178,11 @@ template <> inline uint32 JsonNode::GetValue() const
     return cj5_get_uint(reinterpret_cast<cj5_result*>(mCtx), mTokenId);
 }
 
+template <> inline int64 JsonNode::GetValue() const
+{
+    return cj5_get_int64(reinterpret_cast<cj5_result*>(mCtx), mTokenId);
+}
+
 template <> inline uint64 JsonNode::GetValue() const
 {
     return cj5_get_uint64(reinterpret_cast<cj5_result*>(mCtx), mTokenId);
@@ -206,86 +220,91 @@ template <> inline Int2 JsonNode::GetValue() const
     return v;
 }
 
-template <> inline uint32 JsonNode::GetChildValue(const char* _childNode, uint32 _defaultValue)
+template <> inline uint32 JsonNode::GetChildValue(const char* _childNode, uint32 _defaultValue) const
 {
     return cj5_seekget_uint(reinterpret_cast<cj5_result*>(mCtx), mTokenId, _childNode, _defaultValue);
 }
 
-template <> inline uint64 JsonNode::GetChildValue(const char* _childNode, uint64 _defaultValue)
+template <> inline uint64 JsonNode::GetChildValue(const char* _childNode, uint64 _defaultValue) const
 {
     return cj5_seekget_uint64(reinterpret_cast<cj5_result*>(mCtx), mTokenId, _childNode, _defaultValue);
 }
 
-template <> inline int JsonNode::GetChildValue(const char* _childNode, int _defaultValue)
+template <> inline int64 JsonNode::GetChildValue(const char* _childNode, int64 _defaultValue) const
+{
+    return cj5_seekget_int64(reinterpret_cast<cj5_result*>(mCtx), mTokenId, _childNode, _defaultValue);
+}
+
+template <> inline int JsonNode::GetChildValue(const char* _childNode, int _defaultValue) const
 {
     return cj5_seekget_int(reinterpret_cast<cj5_result*>(mCtx), mTokenId, _childNode, _defaultValue);
 }
 
-template <> inline float JsonNode::GetChildValue(const char* _childNode, float _defaultValue)
+template <> inline float JsonNode::GetChildValue(const char* _childNode, float _defaultValue) const
 {
     return cj5_seekget_float(reinterpret_cast<cj5_result*>(mCtx), mTokenId, _childNode, _defaultValue);
 }
 
-template <> inline double JsonNode::GetChildValue(const char* _childNode, double _defaultValue)
+template <> inline double JsonNode::GetChildValue(const char* _childNode, double _defaultValue) const
 {
     return cj5_seekget_double(reinterpret_cast<cj5_result*>(mCtx), mTokenId, _childNode, _defaultValue);
 }
 
-template <> inline bool JsonNode::GetChildValue(const char* _childNode, bool _defaultValue)
+template <> inline bool JsonNode::GetChildValue(const char* _childNode, bool _defaultValue) const
 {
     return cj5_seekget_bool(reinterpret_cast<cj5_result*>(mCtx), mTokenId, _childNode, _defaultValue);
 }
 
-template <> inline Float4 JsonNode::GetChildValue(const char* _childNode, Float4 _defaultValue)
+template <> inline Float4 JsonNode::GetChildValue(const char* _childNode, Float4 _defaultValue) const
 {
     JsonNode jArr = GetChild(_childNode);
     return jArr.IsValid() && jArr.IsArray() ? jArr.GetValue<Float4>() : _defaultValue;
 }
 
-template <> inline Float3 JsonNode::GetChildValue(const char* _childNode, Float3 _defaultValue)
+template <> inline Float3 JsonNode::GetChildValue(const char* _childNode, Float3 _defaultValue) const
 {
     JsonNode jArr = GetChild(_childNode);
     return jArr.IsValid() && jArr.IsArray() ? jArr.GetValue<Float3>() : _defaultValue;
 }
 
-template <> inline Float2 JsonNode::GetChildValue(const char* _childNode, Float2 _defaultValue)
+template <> inline Float2 JsonNode::GetChildValue(const char* _childNode, Float2 _defaultValue) const
 {
     JsonNode jArr = GetChild(_childNode);
     return jArr.IsValid() && jArr.IsArray() ? jArr.GetValue<Float2>() : _defaultValue;
 }
 
-template <> inline Int2 JsonNode::GetChildValue(const char* _childNode, Int2 _defaultValue)
+template <> inline Int2 JsonNode::GetChildValue(const char* _childNode, Int2 _defaultValue) const
 {
     JsonNode jArr = GetChild(_childNode);
     return jArr.IsValid() && jArr.IsArray() ? jArr.GetValue<Int2>() : _defaultValue;
 }
 
-template <> inline uint32 JsonNode::GetChildArrayValues(const char* _childNode, uint32* _values, uint32 _maxValues)
+template <> inline uint32 JsonNode::GetChildArrayValues(const char* _childNode, uint32* _values, uint32 _maxValues) const
 {
     return (uint32)cj5_seekget_array_uint(reinterpret_cast<cj5_result*>(mCtx), mTokenId, _childNode, _values, _maxValues);
 }
 
-template <> inline uint32 JsonNode::GetChildArrayValues(const char* _childNode, int* _values, uint32 _maxValues)
+template <> inline uint32 JsonNode::GetChildArrayValues(const char* _childNode, int* _values, uint32 _maxValues) const
 {
     return (uint32)cj5_seekget_array_int(reinterpret_cast<cj5_result*>(mCtx), mTokenId, _childNode, _values, _maxValues);
 }
 
-template <> inline uint32 JsonNode::GetChildArrayValues(const char* _childNode, uint64* _values, uint32 _maxValues)
+template <> inline uint32 JsonNode::GetChildArrayValues(const char* _childNode, uint64* _values, uint32 _maxValues) const
 {
     return (uint32)cj5_seekget_array_uint64(reinterpret_cast<cj5_result*>(mCtx), mTokenId, _childNode, _values, _maxValues);
 }
 
-template <> inline uint32 JsonNode::GetChildArrayValues(const char* _childNode, bool* _values, uint32 _maxValues)
+template <> inline uint32 JsonNode::GetChildArrayValues(const char* _childNode, bool* _values, uint32 _maxValues) const
 {
     return (uint32)cj5_seekget_array_bool(reinterpret_cast<cj5_result*>(mCtx), mTokenId, _childNode, _values, _maxValues);
 }
 
-template <> inline uint32 JsonNode::GetChildArrayValues(const char* _childNode, double* _values, uint32 _maxValues)
+template <> inline uint32 JsonNode::GetChildArrayValues(const char* _childNode, double* _values, uint32 _maxValues) const
 {
     return (uint32)cj5_seekget_array_double(reinterpret_cast<cj5_result*>(mCtx), mTokenId, _childNode, _values, _maxValues);
 }
 
-template <> inline uint32 JsonNode::GetChildArrayValues(const char* _childNode, float* _values, uint32 _maxValues)
+template <> inline uint32 JsonNode::GetChildArrayValues(const char* _childNode, float* _values, uint32 _maxValues) const
 {
     return (uint32)cj5_seekget_array_float(reinterpret_cast<cj5_result*>(mCtx), mTokenId, _childNode, _values, _maxValues);
 }
@@ -8,6 +8,12 @@
 #include "Debug.h"
 #include "Arrays.h"
 #include "Allocators.h"
+#include "Atomic.h"
+#include "BlitSort.h"
+#include "Blobs.h"
+#include "Hash.h"
+
+#include <time.h>   // timespec_get, localtime
 
 #if PLATFORM_MOBILE || PLATFORM_OSX
     #define TERM_COLOR_RESET     ""
@@ -33,12 +39,143 @@
     #endif
 #endif
 
+static inline constexpr uint32 kLogMinRingSize = 4*kKB;
+static inline constexpr uint32 kLogFlushTimeout = 1000;     // msecs
+
+// Entries in the ring buffers. Text comes right after the header and is null-terminated
+struct LogRecord
+{
+    uint32 size;                // Header + text, 8 byte aligned
+    LogLevel type;              // LogLevel::_Count marks the padding at the end of the buffer
+    uint32 channels;
+    uint32 line;
+    uint32 textLen;
+    uint32 sourceFileLen;
+    uint32 threadId;
+    uint64 timestamp;
+    uint64 seq;
+    const char* sourceFile;     // Always comes from __FILE__, so we keep the pointer
+};
+
+// Single producer (owner thread), single consumer (sink thread) ring buffer
+// head/tail are the total written/read bytes, so they never wrap
+struct alignas(CACHE_LINE_SIZE) LogRing
+{
+    atomicUint64 head;
+    uint8 _padding1[CACHE_LINE_SIZE - sizeof(atomicUint64)];
+    atomicUint64 tail;
+    uint8 _padding2[CACHE_LINE_SIZE - sizeof(atomicUint64)];
+
+    uint8* buffer;
+    uint32 size;
+    atomicUint32 isOrphaned;    // Owner thread has exited, sink frees the ring after draining it
+    uint64 drainTail;           // Sink thread only
+    LogRing* next;
+};
+
+struct LogThreadContext
+{
+    LogRing* ring;
+    uint32 generation;          // Rings from previous logInitializeAsync calls are already freed
+    uint32 threadId;            // Cached, it's a syscall on some platforms
+    bool isSinkThread;
+
+    ~LogThreadContext();
+};
+
+struct LogAsyncContext
+{
+    LogAsyncParams params;
+    Thread thread;
+    Semaphore semaphore;
+    atomicPtr rings;            // LogRing linked-list. Producers push to the front, only the sink removes
+    atomicUint64 seq;
+    atomicUint64 numSync;
+    atomicUint64 numDropped;
+    atomicUint64 numBlocked;
+    atomicUint32 numRings;
+    atomicUint32 numPasses;     // Finished drain passes, logFlush waits on this
+    atomicUint32 generation;
+    atomicUint32 isRunning;
+    atomicUint32 quit;
+    uint64 numDroppedReported;  // Sink thread only
+    uint32 numBatches;
+    uint32 maxBatchSize;
+    bool initialized;
+};
+
+// Binary log file layout:
+//  LogBinaryHeader
+//  LogBinaryRecord + payload, ... (8 byte aligned). Zero record type marks the end of a file that is not truncated (crash)
+//      Entry:  uint32 level, uint32 channels, uint64 time, uint32 threadId, uint32 sourceFileId, uint32 line, uint32 textLen, text
+//      String: uint32 id, uint32 len, chars. Written before the first entry that references it
+static inline constexpr uint32 kLogBinaryMagic = MakeFourCC('A', 'P', 'L', 'G');
+static inline constexpr uint32 kLogBinaryVersion = 1;
+
+enum class LogBinaryRecordType : uint32
+{
+    End = 0,
+    Entry,
+    String
+};
+
+struct LogBinaryHeader
+{
+    uint32 magic;
+    uint32 version;
+    int64 startTime;        // Unix time when the file was created, in microsecs
+    uint32 fileIndex;       // Increases with every rotation
+    uint32 reserved;
+};
+
+struct LogBinaryRecord
+{
+    LogBinaryRecordType type;
+    uint32 size;            // Including this header and the padding
+};
+
+struct LogBinaryEntry
+{
+    LogBinaryRecord record;
+    uint32 level;
+    uint32 channels;
+    uint64 time;            // Nanosecs since startTime
+    uint32 threadId;
+    uint32 sourceFileId;    // 0 = None
+    uint32 line;
+    uint32 textLen;
+};
+
+struct LogBinaryString
+{
+    LogBinaryRecord record;
+    uint32 id;
+    uint32 len;
+};
+
+struct LogBinaryWriter
+{
+    AtomicLock lock;
+    LogBinaryFileParams params;
+    Path filepath;
+    FileMapping file;
+    HashTable<uint32> sourceFileIds;    // Key: hash of the __FILE__ pointer
+    uint8* data;
+    size_t offset;
+    uint64 startTick;
+    uint32 numStrings;
+    uint32 fileIndex;
+    bool isOpen;
+};
+
 struct LogContext
 {
     StaticArray<Pair<LogCallback, void*>, 8> callbacks;
     LogLevel logLevel = DEFAULT_LOG_LEVEL;
     bool breakOnErrors;
     bool treatWarningsAsErrors;
+    LogAsyncContext async;
+    LogBinaryWriter binary;
 };
 
 static LogContext gLog;
@@ -62,6 +199,27 @@ void logSetSettings(LogLevel logLevel, bool breakOnErrors, bool treatWarningsAsE
     gLog.treatWarningsAsErrors = treatWarningsAsErrors;
 }
 
+static uint32 logFormatTerminalText(const LogEntry& entry, char* text, uint32 textSize)
+{
+    const char* openFmt = "";
+    const char* closeFmt = "";
+
+    // terminal coloring
+    switch (entry.type) {
+    case LogLevel::Info:    openFmt = TERM_COLOR_WHITE; closeFmt = TERM_COLOR_WHITE; break;
+    case LogLevel::Debug:	openFmt = TERM_COLOR_CYAN; closeFmt = TERM_COLOR_RESET; break;
+    case LogLevel::Verbose:	openFmt = TERM_COLOR_RESET; closeFmt = TERM_COLOR_RESET; break;
+    case LogLevel::Warning:	openFmt = TERM_COLOR_YELLOW; closeFmt = TERM_COLOR_RESET; break;
+    case LogLevel::Error:	openFmt = TERM_COLOR_RED; closeFmt = TERM_COLOR_RESET; break;
+    default:			    break;
+    }
+
+    return strPrintFmt(text, textSize, "%s%s%s%s", 
+                       openFmt, 
+                       kLogEntryTypes[static_cast<uint32>(entry.type)], 
+                       entry.text, closeFmt);
+}
+
 static void logPrintToTerminal(const LogEntry& entry)
 {
     uint32 newSize = entry.textLen + 128;
@@ -70,24 +228,7 @@ static void logPrintToTerminal(const LogEntry& entry)
     char* text = tmp.MallocTyped<char>(newSize);
 
     if (text) {
-        const char* openFmt = "";
-        const char* closeFmt = "";
-
-        // terminal coloring
-        switch (entry.type) {
-        case LogLevel::Info:    openFmt = TERM_COLOR_WHITE; closeFmt = TERM_COLOR_WHITE; break;
-        case LogLevel::Debug:	openFmt = TERM_COLOR_CYAN; closeFmt = TERM_COLOR_RESET; break;
-        case LogLevel::Verbose:	openFmt = TERM_COLOR_RESET; closeFmt = TERM_COLOR_RESET; break;
-        case LogLevel::Warning:	openFmt = TERM_COLOR_YELLOW; closeFmt = TERM_COLOR_RESET; break;
-        case LogLevel::Error:	openFmt = TERM_COLOR_RED; closeFmt = TERM_COLOR_RESET; break;
-        default:			    break;
-        }
-
-        strPrintFmt(text, newSize, "%s%s%s%s", 
-            openFmt, 
-            kLogEntryTypes[static_cast<uint32>(entry.type)], 
-            entry.text, closeFmt);
-        
+        logFormatTerminalText(entry, text, newSize);
         puts(text);
     }
     else {
@@ -154,9 +295,261 @@ static void logPrintToTracy(const LogEntry& entry)
 }
 #endif
 
-static void engineDispatchLogEntry(const LogEntry& entry)
+//------------------------------------------------------------------------
+// Binary file
+static Path logGetRotatedBinaryFilepath(const Path& filepath, uint32 index)
+{
+    if (index == 0)
+        return filepath;
+    Path rotated;
+    strPrintFmt(rotated.Ptr(), sizeof(rotated), "%s.%u", filepath.CStr(), index);
+    return rotated;
+}
+
+// NOTE: Runs with the writer lock held, so no logging in here
+static bool logCreateBinaryFile(LogBinaryWriter& w)
+{
+    if (w.file.IsOpen())
+        w.file.CloseAndTruncate(w.offset);
+
+    // 'path.<N-2>' -> 'path.<N-1>', ..., 'path' -> 'path.1'. The oldest one is replaced
+    for (uint32 i = w.params.maxFiles - 1; i > 0; i--) {
+        Path src = logGetRotatedBinaryFilepath(w.filepath, i - 1);
+        if (src.IsFile())
+            pathReplace(src.CStr(), logGetRotatedBinaryFilepath(w.filepath, i).CStr());
+    }
+
+    if (!w.file.Create(w.filepath.CStr(), w.params.maxFileSize)) {
+        w.isOpen = false;
+        return false;
+    }
+
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+
+    w.data = (uint8*)w.file.WritableData();
+    w.startTick = timerGetTicks();
+    *((LogBinaryHeader*)w.data) = {
+        .magic = kLogBinaryMagic,
+        .version = kLogBinaryVersion,
+        .startTime = int64(now.tv_sec)*1000000 + int64(now.tv_nsec/1000),
+        .fileIndex = w.fileIndex++
+    };
+    w.offset = sizeof(LogBinaryHeader);
+    w.numStrings = 0;
+    w.sourceFileIds.Clear();
+    return true;
+}
+
+static void logWriteToBinaryFile(const LogEntry& entry)
+{
+    LogBinaryWriter& w = gLog.binary;
+    AtomicLockScope lock(w.lock);
+    if (!w.isOpen)
+        return;
+
+    uint32 textLen = Min(entry.textLen, w.params.maxFileSize/4);
+    uint32 entrySize = AlignValue<uint32>(uint32(sizeof(LogBinaryEntry)) + textLen, 8u);
+    uint32 stringSize = AlignValue<uint32>(uint32(sizeof(LogBinaryString)) + entry.sourceFileLen, 8u);
+    uint32 key = entry.sourceFile ? hashFnv32(&entry.sourceFile, sizeof(entry.sourceFile)) : 0;
+    uint32 stringIndex = entry.sourceFile ? w.sourceFileIds.Find(key) : UINT32_MAX;
+
+    size_t requiredSize = entrySize + (entry.sourceFile && stringIndex == UINT32_MAX ? stringSize : 0);
+    if (w.offset + requiredSize > w.file.Size()) {
+        if (!logCreateBinaryFile(w))
+            return;
+        stringIndex = UINT32_MAX;
+    }
+
+    uint32 sourceFileId = 0;
+    if (entry.sourceFile) {
+        if (stringIndex == UINT32_MAX) {
+            sourceFileId = ++w.numStrings;
+            LogBinaryString* str = (LogBinaryString*)(w.data + w.offset);
+            *str = {
+                .record = { .type = LogBinaryRecordType::String, .size = stringSize },
+                .id = sourceFileId,
+                .len = entry.sourceFileLen
+            };
+            memcpy(str + 1, entry.sourceFile, entry.sourceFileLen);
+            w.offset += stringSize;
+            w.sourceFileIds.Add(key, sourceFileId);
+        }
+        else {
+            sourceFileId = w.sourceFileIds.Get(stringIndex);
+        }
+    }
+
+    LogBinaryEntry* e = (LogBinaryEntry*)(w.data + w.offset);
+    *e = {
+        .record = { .type = LogBinaryRecordType::Entry, .size = entrySize },
+        .level = uint32(entry.type),
+        .channels = entry.channels,
+        .time = entry.timestamp > w.startTick ? entry.timestamp - w.startTick : 0,
+        .threadId = entry.threadId,
+        .sourceFileId = sourceFileId,
+        .line = entry.line,
+        .textLen = textLen
+    };
+    memcpy(e + 1, entry.text, textLen);
+    w.offset += entrySize;
+}
+
+bool logOpenBinaryFile(const char* filepath, const LogBinaryFileParams& params)
+{
+    ASSERT(params.maxFiles > 0);
+    ASSERT(params.maxFileSize > sizeof(LogBinaryHeader));
+
+    LogBinaryWriter& w = gLog.binary;
+    bool r;
+    {
+        AtomicLockScope lock(w.lock);
+        ASSERT_MSG(!w.isOpen, "Binary log file is already open");
+        w.params = params;
+        w.filepath = filepath;
+        w.fileIndex = 0;
+        w.sourceFileIds.Reserve(128);
+        w.isOpen = true;
+        r = logCreateBinaryFile(w);
+    }
+
+    if (!r)
+        logError("Log: Creating binary log file failed: %s", filepath);
+    return r;
+}
+
+void logCloseBinaryFile()
+{
+    // Entries that are still in the rings belong to the file
+    logFlush();
+
+    LogBinaryWriter& w = gLog.binary;
+    AtomicLockScope lock(w.lock);
+    if (w.file.IsOpen())
+        w.file.CloseAndTruncate(w.offset);
+    w.sourceFileIds.Free();
+    w.data = nullptr;
+    w.isOpen = false;
+}
+
+static void logDecodeBinaryEntry(const LogBinaryHeader& header, const LogBinaryEntry& e, const char* sourceFile, 
+                                 LogBinaryDecodeFormat format, Blob* outText)
+{
+    static const char* kLevelNames[uint32(LogLevel::_Count)] = { "Default", "Error", "Warning", "Info", "Verbose", "Debug" };
+    uint32 level = e.level < uint32(LogLevel::_Count) ? e.level : 0;
+    const char* text = (const char*)(&e + 1);
+
+    int64 usecs = header.startTime + int64(e.time/1000);
+    time_t tm = time_t(usecs/1000000);
+    char timeStr[32];
+    strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", localtime(&tm));
+
+    char line[kMaxPath + 128];
+    if (format == LogBinaryDecodeFormat::Text) {
+        strPrintFmt(line, sizeof(line), "%s.%06u %6u %s", timeStr, uint32(usecs%1000000), e.threadId, kLogEntryTypes[level]);
+        outText->Write(line, strLen(line));
+        outText->Write(text, e.textLen);
+        if (sourceFile) {
+            strPrintFmt(line, sizeof(line), " (%s:%u)", sourceFile, e.line);
+            outText->Write(line, strLen(line));
+        }
+        outText->Write<char>('\n');
+    }
+    else {
+        strPrintFmt(line, sizeof(line), "{\"time\":\"%s.%06u\",\"level\":\"%s\",\"channels\":%u,\"thread\":%u,\"file\":\"", 
+                    timeStr, uint32(usecs%1000000), kLevelNames[level], e.channels, e.threadId);
+        outText->Write(line, strLen(line));
+
+        // Escape both the file path (windows backslashes) and the text
+        auto WriteEscaped = [outText](const char* str, uint32 len) {
+            for (uint32 i = 0; i < len; i++) {
+                char ch = str[i];
+                switch (ch) {
+                case '"':   outText->Write("\\\"", 2);  break;
+                case '\\':  outText->Write("\\\\", 2); break;
+                case '\n':  outText->Write("\\n", 2);   break;
+                case '\r':  outText->Write("\\r", 2);   break;
+                case '\t':  outText->Write("\\t", 2);   break;
+                default:
+                    if (uint8(ch) < 0x20) {
+                        char code[8];
+                        strPrintFmt(code, sizeof(code), "\\u%04x", uint32(uint8(ch)));
+                        outText->Write(code, 6);
+                    }
+                    else {
+                        outText->Write<char>(ch);
+                    }
+                    break;
+                }
+            }
+        };
+
+        if (sourceFile)
+            WriteEscaped(sourceFile, strLen(sourceFile));
+        strPrintFmt(line, sizeof(line), "\",\"line\":%u,\"text\":\"", e.line);
+        outText->Write(line, strLen(line));
+        WriteEscaped(text, e.textLen);
+        outText->Write("\"}\n", 3);
+    }
+}
+
+bool logDecodeBinaryFile(const char* filepath, Blob* outText, LogBinaryDecodeFormat format)
+{
+    ASSERT(outText);
+
+    FileMapping file;
+    if (!file.Open(filepath))
+        return false;
+
+    const uint8* data = (const uint8*)file.Data();
+    size_t size = file.Size();
+    const LogBinaryHeader* header = (const LogBinaryHeader*)data;
+    if (size < sizeof(LogBinaryHeader) || header->magic != kLogBinaryMagic || header->version != kLogBinaryVersion) {
+        file.Close();
+        return false;
+    }
+
+    // Text is usually a bit bigger than the records, json about twice
+    outText->SetGrowPolicy(Blob::GrowPolicy::Multiply);
+    outText->Reserve(outText->Size() + (format == LogBinaryDecodeFormat::Text ? size : size*2));
+
+    MemTempAllocator tmp;
+    Array<char*> strings(&tmp);     // Index = id - 1, null-terminated copies
+
+    size_t offset = sizeof(LogBinaryHeader);
+    while (offset + sizeof(LogBinaryRecord) <= size) {
+        const LogBinaryRecord* record = (const LogBinaryRecord*)(data + offset);
+        if (record->type == LogBinaryRecordType::End || record->size < sizeof(LogBinaryRecord) || offset + record->size > size)
+            break;
+
+        if (record->type == LogBinaryRecordType::String && record->size >= sizeof(LogBinaryString)) {
+            const LogBinaryString* str = (const LogBinaryString*)record;
+            if (str->id == strings.Count() + 1 && sizeof(LogBinaryString) + str->len <= record->size) {
+                char* s = tmp.MallocTyped<char>(str->len + 1);
+                memcpy(s, str + 1, str->len);
+                s[str->len] = '\0';
+                strings.Push(s);
+            }
+        }
+        else if (record->type == LogBinaryRecordType::Entry && record->size >= sizeof(LogBinaryEntry)) {
+            const LogBinaryEntry* e = (const LogBinaryEntry*)record;
+            if (sizeof(LogBinaryEntry) + e->textLen <= record->size) {
+                const char* sourceFile = (e->sourceFileId && e->sourceFileId <= strings.Count()) ? strings[e->sourceFileId - 1] : nullptr;
+                logDecodeBinaryEntry(*header, *e, sourceFile, format, outText);
+            }
+        }
+
+        offset += record->size;
+    }
+
+    file.Close();
+    return true;
+}
+
+// Everything except the terminal, which the sink thread writes for the whole batch at once
+static void logDispatchToOutputs(const LogEntry& entry)
 {
-    logPrintToTerminal(entry); 
+    logWriteToBinaryFile(entry);
     logPrintToDebugger(entry);
     #ifdef TRACY_ENABLE
         logPrintToTracy(entry);
@@ -167,8 +560,359 @@ static void engineDispatchLogEntry(const LogEntry& entry)
 
     for (Pair<LogCallback, void*> c : gLog.callbacks)
         c.first(entry, c.second);
+}
+
+//------------------------------------------------------------------------
+// Async
+LogThreadContext::~LogThreadContext()
+{
+    if (ring && generation == atomicLoad32Explicit(&gLog.async.generation, AtomicMemoryOrder::Acquire))
+        atomicStore32Explicit(&ring->isOrphaned, 1, AtomicMemoryOrder::Release);
+}
+
+NO_INLINE static LogThreadContext& logGetThreadContext()
+{
+    static thread_local LogThreadContext threadCtx;
+    return threadCtx;
+}
+
+static LogRing* logGetThreadRing(LogThreadContext& ctx)
+{
+    uint32 generation = atomicLoad32Explicit(&gLog.async.generation, AtomicMemoryOrder::Acquire);
+    if (ctx.ring && ctx.generation == generation)
+        return ctx.ring;
+
+    uint32 ringSize = gLog.async.params.ringSize;
+    MemSingleShotMalloc<LogRing> mallocator;
+    mallocator.AddMemberField<uint8>(offsetof(LogRing, buffer), ringSize);
+    LogRing* ring = mallocator.Calloc();
+    ring->size = ringSize;
+
+    atomicPtr first = atomicLoadPtrExplicit(&gLog.async.rings, AtomicMemoryOrder::Relaxed);
+    do {
+        ring->next = (LogRing*)first;
+    } while (!atomicCompareExchangePtrWeakExplicit(&gLog.async.rings, &first, atomicPtr(ring), 
+                                                   AtomicMemoryOrder::Release, AtomicMemoryOrder::Relaxed));
+    atomicFetchAdd32Explicit(&gLog.async.numRings, 1, AtomicMemoryOrder::Relaxed);
+
+    ctx.ring = ring;
+    ctx.generation = generation;
+    return ring;
+}
+
+// Returns false if the entry should be dispatched on the calling thread instead
+static bool logPushEntry(const LogEntry& entry)
+{
+    LogThreadContext& ctx = logGetThreadContext();
+    if (ctx.isSinkThread)
+        return false;
+
+    LogRing* ring = logGetThreadRing(ctx);
+    uint32 recordSize = AlignValue<uint32>(uint32(sizeof(LogRecord)) + entry.textLen + 1, 8u);
+    if (recordSize > ring->size/2) {
+        atomicFetchAdd64Explicit(&gLog.async.numSync, 1, AtomicMemoryOrder::Relaxed);
+        return false;
+    }
+
+    uint64 head = atomicLoad64Explicit(&ring->head, AtomicMemoryOrder::Relaxed);
+    uint32 offset = uint32(head) & (ring->size - 1);
+    uint32 contiguous = ring->size - offset;
+    uint32 required = recordSize + (contiguous < recordSize ? contiguous : 0);
+
+    uint64 tail = atomicLoad64Explicit(&ring->tail, AtomicMemoryOrder::Acquire);
+    if (head + required - tail > ring->size) {
+        // Losing errors and warnings is worse than stalling the thread 
+        bool mustBlock = entry.type == LogLevel::Error || entry.type == LogLevel::Warning || 
+                         gLog.async.params.backpressure == LogBackpressure::Block;
+        if (!mustBlock) {
+            if (gLog.async.params.backpressure == LogBackpressure::Sync) {
+                atomicFetchAdd64Explicit(&gLog.async.numSync, 1, AtomicMemoryOrder::Relaxed);
+                return false;
+            }
+            atomicFetchAdd64Explicit(&gLog.async.numDropped, 1, AtomicMemoryOrder::Relaxed);
+            return true;
+        }
+
+        atomicFetchAdd64Explicit(&gLog.async.numBlocked, 1, AtomicMemoryOrder::Relaxed);
+        gLog.async.semaphore.Post();
+        do {
+            if (!atomicLoad32Explicit(&gLog.async.isRunning, AtomicMemoryOrder::Acquire))
+                return false;
+            threadYield();
+            tail = atomicLoad64Explicit(&ring->tail, AtomicMemoryOrder::Acquire);
+        } while (head + required - tail > ring->size);
+    }
+
+    if (contiguous < recordSize) {
+        // Padding that is smaller than the header is skipped implicitly by the sink
+        if (contiguous >= sizeof(LogRecord)) {
+            LogRecord* padding = (LogRecord*)(ring->buffer + offset);
+            padding->size = contiguous;
+            padding->type = LogLevel::_Count;
+        }
+        offset = 0;
+    }
+
+    LogRecord* record = (LogRecord*)(ring->buffer + offset);
+    *record = {
+        .size = recordSize,
+        .type = entry.type,
+        .channels = entry.channels,
+        .line = entry.line,
+        .textLen = entry.textLen,
+        .sourceFileLen = entry.sourceFileLen,
+        .threadId = entry.threadId,
+        .timestamp = entry.timestamp,
+        .seq = atomicFetchAdd64Explicit(&gLog.async.seq, 1, AtomicMemoryOrder::Relaxed),
+        .sourceFile = entry.sourceFile
+    };
+    char* text = (char*)(record + 1);
+    memcpy(text, entry.text, entry.textLen);
+    text[entry.textLen] = '\0';
+
+    uint64 newHead = head + required;
+    atomicStore64Explicit(&ring->head, newHead, AtomicMemoryOrder::Release);
+
+    // Wake up the sink early when the ring gets crowded, and for errors so they show up right away
+    uint32 halfSize = ring->size/2;
+    if ((newHead - tail > halfSize && head - tail <= halfSize) || entry.type == LogLevel::Error)
+        gLog.async.semaphore.Post();
+
+    return true;
+}
+
+static void logDrainRings()
+{
+    LogAsyncContext& async = gLog.async;
+    MemTempAllocator tmp;
+    Array<LogRecord*> records(&tmp);
+    uint32 terminalSize = 1;
+
+    LogRing* first = (LogRing*)atomicLoadPtrExplicit(&async.rings, AtomicMemoryOrder::Acquire);
+    for (LogRing* ring = first; ring; ring = ring->next) {
+        uint64 tail = atomicLoad64Explicit(&ring->tail, AtomicMemoryOrder::Relaxed);
+        uint64 head = atomicLoad64Explicit(&ring->head, AtomicMemoryOrder::Acquire);
+        while (tail < head) {
+            uint32 offset = uint32(tail) & (ring->size - 1);
+            uint32 contiguous = ring->size - offset;
+            if (contiguous < sizeof(LogRecord)) {
+                tail += contiguous;
+                continue;
+            }
+
+            LogRecord* record = (LogRecord*)(ring->buffer + offset);
+            if (record->type != LogLevel::_Count) {
+                records.Push(record);
+                terminalSize += record->textLen + 128;
+            }
+            tail += record->size;
+        }
+        ring->drainTail = tail;
+    }
+
+    if (!records.IsEmpty()) {
+        BlitSort<LogRecord*>(records.Ptr(), records.Count(), 
+                             [](LogRecord* const& a, LogRecord* const& b)->int { return a->seq < b->seq ? -1 : (a->seq > b->seq ? 1 : 0); });
+
+        // All the terminal lines go out with a single write
+        char* terminalText = tmp.MallocTyped<char>(terminalSize);
+        uint32 terminalLen = 0;
+        for (LogRecord* record : records) {
+            LogEntry entry {
+                .type = record->type,
+                .channels = record->channels,
+                .textLen = record->textLen,
+                .sourceFileLen = record->sourceFileLen,
+                .line = record->line,
+                .threadId = record->threadId,
+                .timestamp = record->timestamp,
+                .text = (const char*)(record + 1),
+                .sourceFile = record->sourceFile
+            };
+
+            terminalLen += logFormatTerminalText(entry, terminalText + terminalLen, terminalSize - terminalLen - 1);
+            terminalText[terminalLen++] = '\n';
+        }
+        fwrite(terminalText, 1, terminalLen, stdout);
+        fflush(stdout);
+
+        for (LogRecord* record : records) {
+            logDispatchToOutputs({
+                .type = record->type,
+                .channels = record->channels,
+                .textLen = record->textLen,
+                .sourceFileLen = record->sourceFileLen,
+                .line = record->line,
+                .threadId = record->threadId,
+                .timestamp = record->timestamp,
+                .text = (const char*)(record + 1),
+                .sourceFile = record->sourceFile
+            });
+        }
+
+        async.numBatches++;
+        async.maxBatchSize = Max(async.maxBatchSize, records.Count());
+    }
+
+    for (LogRing* ring = first; ring; ring = ring->next)
+        atomicStore64Explicit(&ring->tail, ring->drainTail, AtomicMemoryOrder::Release);
+
+    // Free the rings of exited threads once they are empty 
+    LogRing* prev = nullptr;
+    for (LogRing* ring = first; ring;) {
+        LogRing* next = ring->next;
+        if (atomicLoad32Explicit(&ring->isOrphaned, AtomicMemoryOrder::Acquire) && 
+            atomicLoad64Explicit(&ring->head, AtomicMemoryOrder::Acquire) == ring->drainTail) 
+        {
+            if (prev) {
+                prev->next = next;
+            }
+            else {
+                atomicPtr expected = atomicPtr(ring);
+                if (!atomicCompareExchangePtrStrongExplicit(&async.rings, &expected, atomicPtr(next), 
+                                                            AtomicMemoryOrder::Release, AtomicMemoryOrder::Relaxed)) 
+                {
+                    // New rings were pushed in front of it 
+                    prev = (LogRing*)expected;
+                    while (prev->next != ring)
+                        prev = prev->next;
+                    prev->next = next;
+                }
+            }
+            MemSingleShotMalloc<LogRing>::Free(ring);
+            atomicFetchSub32Explicit(&async.numRings, 1, AtomicMemoryOrder::Relaxed);
+        }
+        else {
+            prev = ring;
+        }
+        ring = next;
+    }
+
+    uint64 numDropped = atomicLoad64Explicit(&async.numDropped, AtomicMemoryOrder::Relaxed);
+    if (numDropped > async.numDroppedReported) {
+        logWarning("Log: %llu entries dropped, logging is faster than the sink thread can write", 
+                   numDropped - async.numDroppedReported);
+        async.numDroppedReported = numDropped;
+    }
+
+    atomicFetchAdd32Explicit(&async.numPasses, 1, AtomicMemoryOrder::Release);
+}
+
+static int logSinkThreadFn(void*)
+{
+    logGetThreadContext().isSinkThread = true;
+
+    while (!atomicLoad32Explicit(&gLog.async.quit, AtomicMemoryOrder::Acquire)) {
+        gLog.async.semaphore.Wait(gLog.async.params.flushIntervalMs);
+        logDrainRings();
+    }
+
+    logDrainRings();
+    return 0;
+}
+
+bool logInitializeAsync(const LogAsyncParams& params)
+{
+    LogAsyncContext& async = gLog.async;
+    ASSERT_MSG(!async.initialized, "Async logging is already initialized");
+
+    async.params = params;
+    uint32 ringSize = kLogMinRingSize;
+    while (ringSize < params.ringSize)
+        ringSize <<= 1;
+    async.params.ringSize = ringSize;
+    async.params.flushIntervalMs = Max(params.flushIntervalMs, 1u);
+
+    async.semaphore.Initialize();
+    atomicStore32Explicit(&async.quit, 0, AtomicMemoryOrder::Relaxed);
+    atomicFetchAdd32Explicit(&async.generation, 1, AtomicMemoryOrder::Release);
+
+    if (!async.thread.Start(ThreadDesc { .entryFn = logSinkThreadFn, .userData = nullptr, .name = "LogSink" })) {
+        async.semaphore.Release();
+        logError("Log: Starting the sink thread failed, logging stays synchronous");
+        return false;
+    }
+
+    async.initialized = true;
+    atomicStore32Explicit(&async.isRunning, 1, AtomicMemoryOrder::Release);
+    return true;
+}
+
+void logReleaseAsync()
+{
+    LogAsyncContext& async = gLog.async;
+    if (!async.initialized)
+        return;
+
+    // New entries go to the terminal directly, the sink thread drains the rest before quitting
+    atomicStore32Explicit(&async.isRunning, 0, AtomicMemoryOrder::Release);
+    atomicStore32Explicit(&async.quit, 1, AtomicMemoryOrder::Release);
+    async.semaphore.Post();
+    async.thread.Stop();
+    async.semaphore.Release();
+
+    LogRing* ring = (LogRing*)atomicExchangePtr(&async.rings, 0);
+    while (ring) {
+        LogRing* next = ring->next;
+        MemSingleShotMalloc<LogRing>::Free(ring);
+        ring = next;
+    }
+    atomicStore32Explicit(&async.numRings, 0, AtomicMemoryOrder::Relaxed);
+    atomicFetchAdd32Explicit(&async.generation, 1, AtomicMemoryOrder::Release);
+    async.initialized = false;
+}
+
+void logFlush()
+{
+    LogAsyncContext& async = gLog.async;
+    if (!atomicLoad32Explicit(&async.isRunning, AtomicMemoryOrder::Acquire) || logGetThreadContext().isSinkThread)
+        return;
+
+    // The pass that is currently running may have already missed our entries, so wait for the next one too
+    uint32 numPasses = atomicLoad32Explicit(&async.numPasses, AtomicMemoryOrder::Acquire);
+    async.semaphore.Post(2);
+
+    uint64 startTick = timerGetTicks();
+    while (atomicLoad32Explicit(&async.numPasses, AtomicMemoryOrder::Acquire) - numPasses < 2) {
+        // No asserts here, the assert handler flushes the log too
+        if (timerToMS(timerDiff(timerGetTicks(), startTick)) > kLogFlushTimeout)
+            break;
+        threadYield();
+    }
+}
+
+void logGetStats(LogStats* stats)
+{
+    LogAsyncContext& async = gLog.async;
+    uint64 numSync = atomicLoad64Explicit(&async.numSync, AtomicMemoryOrder::Relaxed);
+    uint64 numDropped = atomicLoad64Explicit(&async.numDropped, AtomicMemoryOrder::Relaxed);
+
+    *stats = {
+        .numEntries = atomicLoad64Explicit(&async.seq, AtomicMemoryOrder::Relaxed),
+        .numSync = numSync,
+        .numDropped = numDropped,
+        .numBlocked = atomicLoad64Explicit(&async.numBlocked, AtomicMemoryOrder::Relaxed),
+        .numRings = atomicLoad32Explicit(&async.numRings, AtomicMemoryOrder::Relaxed),
+        .numBatches = async.numBatches,
+        .maxBatchSize = async.maxBatchSize
+    };
+}
+
+static void logDispatchEntry(LogEntry entry)
+{
+    LogThreadContext& ctx = logGetThreadContext();
+    if (!ctx.threadId)
+        ctx.threadId = threadGetCurrentId();
+    entry.threadId = ctx.threadId;
+    entry.timestamp = timerGetTicks();
+
+    if (!atomicLoad32Explicit(&gLog.async.isRunning, AtomicMemoryOrder::Acquire) || !logPushEntry(entry)) {
+        logPrintToTerminal(entry);
+        logDispatchToOutputs(entry);
+    }
 
     if (entry.type == LogLevel::Error && gLog.breakOnErrors) {
+        logFlush();
         ASSERT_MSG(0, "Breaking on error");
     }
 }
@@ -187,7 +931,7 @@ void _private::logPrintInfo(uint32 channels, const char* sourceFile, uint32 line
     strPrintFmtArgs(text, fmtLen, fmt, args);
     va_end(args);
 
-    engineDispatchLogEntry({
+    logDispatchEntry({
         .type = LogLevel::Info,
         .channels = channels,
         .textLen = strLen(text),
@@ -214,7 +958,7 @@ void _private::logPrintDebug(uint32 channels, const char* sourceFile, uint32 lin
         strPrintFmtArgs(text, fmtLen, fmt, args);
         va_end(args);
 
-        engineDispatchLogEntry({
+        logDispatchEntry({
             .type = LogLevel::Debug,
             .channels = channels,
             .textLen = strLen(text),
@@ -245,7 +989,7 @@ void _private::logPrintVerbose(uint32 channels, const char* sourceFile, uint32 l
     strPrintFmtArgs(text, fmtLen, fmt, args);
     va_end(args);
 
-    engineDispatchLogEntry({
+    logDispatchEntry({
         .type = LogLevel::Verbose,
         .channels = channels,
         .textLen = strLen(text),
@@ -270,7 +1014,7 @@ void _private::logPrintWarning(uint32 channels, const char* sourceFile, uint32 l
     strPrintFmtArgs(text, fmtLen, fmt, args);
     va_end(args);
 
-    engineDispatchLogEntry({
+    logDispatchEntry({
         .type = !gLog.treatWarningsAsErrors ? LogLevel::Warning : LogLevel::Error,
         .channels = channels,
         .textLen = strLen(text),
@@ -295,7 +1039,7 @@ void _private::logPrintError(uint32 channels, const char* sourceFile, uint32 lin
     strPrintFmtArgs(text, fmtLen, fmt, args);
     va_end(args);
 
-    engineDispatchLogEntry({
+    logDispatchEntry({
         .type = LogLevel::Error,
         .channels = channels,
         .textLen = strLen(text),
@@ -2,6 +2,8 @@
 
 #include "Base.h"
 
+struct Blob;
+
 enum class LogLevel
 {
     Default = 0,
@@ -20,6 +22,8 @@ struct LogEntry
     uint32      textLen;
     uint32      sourceFileLen;
     uint32      line;
+    uint32      threadId;
+    uint64      timestamp;      // timerGetTicks() of the calling thread
     const char* text;
     const char* sourceFile;
 };
@@ -30,6 +34,60 @@ API void logRegisterCallback(LogCallback callback, void* userData);
 API void logUnregisterCallback(LogCallback callback);
 API void logSetSettings(LogLevel logLevel, bool breakOnErrors, bool treatWarningsAsErrors);
 
+// Asynchronous logging: every thread formats its entries into its own lock-free ring buffer and a background sink thread
+// drains all rings in batches, ordered by submission, then writes them to the outputs and callbacks. 
+// Before logInitializeAsync and after logReleaseAsync, entries are dispatched on the calling thread.
+// NOTE: With async logging enabled, callbacks are called from the sink thread
+enum class LogBackpressure
+{
+    Block = 0,  // Wait for the sink thread to make room in the ring
+    Drop,       // Drop the entry and count it. Errors and warnings always block
+    Sync        // Dispatch the entry on the calling thread, out of order with the queued entries
+};
+
+struct LogAsyncParams
+{
+    uint32 ringSize = 64*kKB;       // Per thread, rounded up to power of two. Bigger entries are dispatched on the calling thread
+    uint32 flushIntervalMs = 10;    // The sink thread also wakes up when a ring gets half full or a producer is blocked
+    LogBackpressure backpressure = LogBackpressure::Drop;
+};
+
+struct LogStats
+{
+    uint64 numEntries;      // Went through the rings
+    uint64 numSync;         // Dispatched on the calling thread (oversized or Sync backpressure)
+    uint64 numDropped;
+    uint64 numBlocked;      // Times a producer had to wait for the sink thread
+    uint32 numRings;
+    uint32 numBatches;
+    uint32 maxBatchSize;
+};
+
+API bool logInitializeAsync(const LogAsyncParams& params = {});
+API void logReleaseAsync();         // Flushes the remaining entries. Other threads should have stopped logging by then
+API void logFlush();                // Waits until everything logged before the call is dispatched
+API void logGetStats(LogStats* stats);
+
+// Binary log file: every entry is written as a fixed-layout record (level, channels, thread, timestamp, source location) to a
+// memory-mapped file. Source file paths are written once per file and referenced by id.
+// When the file is full, it's rotated: 'path' -> 'path.1' -> ... -> 'path.<maxFiles-1>' and the oldest one is deleted.
+// Opening also rotates the file of the previous run
+struct LogBinaryFileParams
+{
+    uint32 maxFileSize = 16*kMB;
+    uint32 maxFiles = 4;        // Including the current one
+};
+
+enum class LogBinaryDecodeFormat
+{
+    Text = 0,
+    Json        // One object per line
+};
+
+API bool logOpenBinaryFile(const char* filepath, const LogBinaryFileParams& params = {});
+API void logCloseBinaryFile();
+API bool logDecodeBinaryFile(const char* filepath, Blob* outText, LogBinaryDecodeFormat format = LogBinaryDecodeFormat::Text);
+
 namespace _private
 {
     API void logPrintInfo(uint32 channels, const char* source_file, uint32 line, const char* fmt, ...);
@@ -46,3 +104,10 @@ namespace _private
 #define logWarning(_text, ...)   _private::logPrintWarning(0, __FILE__, __LINE__, _text, ##__VA_ARGS__)
 #define logError(_text, ...)     _private::logPrintError(0, __FILE__, __LINE__, _text, ##__VA_ARGS__)
 
+// Same as above, with channel bits that callbacks can filter on
+#define logInfoCh(_channels, _text, ...)      _private::logPrintInfo(_channels, __FILE__, __LINE__, _text, ##__VA_ARGS__)
+#define logDebugCh(_channels, _text, ...)     _private::logPrintDebug(_channels, __FILE__, __LINE__, _text, ##__VA_ARGS__)
+#define logVerboseCh(_channels, _text, ...)   _private::logPrintVerbose(_channels, __FILE__, __LINE__, _text, ##__VA_ARGS__)
+#define logWarningCh(_channels, _text, ...)   _private::logPrintWarning(_channels, __FILE__, __LINE__, _text, ##__VA_ARGS__)
+#define logErrorCh(_channels, _text, ...)     _private::logPrintError(_channels, __FILE__, __LINE__, _text, ##__VA_ARGS__)
+
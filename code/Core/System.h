@@ -136,6 +136,12 @@ API void    threadSetCurrentThreadPriority(ThreadPriority prio);
 API void    threadSetCurrentThreadName(const char* name);
 API void    threadGetCurrentThreadName(char* nameOut, uint32 nameSize);
 API void    threadSleep(uint32 msecs);
+API bool    threadSetCurrentThreadAffinity(uint32 cpuIndex);    // Pins the thread to a logical cpu. Returns false if not supported (macOS)
+
+// Futex-style waits: Blocks the thread as long as *addr == expectedValue, until it's woken up or timed out
+// Spurious wake-ups can happen, so always re-check the condition after returning. Returns false on time out
+API bool    threadWaitOnAddress(const uint32* addr, uint32 expectedValue, uint32 msecs = UINT32_MAX);
+API void    threadWakeAllOnAddress(const uint32* addr);
 
 //--------------------------------------------------------------------------------------------------
 // Timer
@@ -171,7 +177,8 @@ namespace _private
 enum class MemVirtualFlags : uint32
 {
     None = 0,
-    Watch = 0x1
+    Watch = 0x1,        // Reserve: track writes to the pages
+    NoPrefault = 0x2    // Commit: don't touch the pages up front, they get backed on first access
 };
 ENABLE_BITMASK(MemVirtualFlags);
 
@@ -182,7 +189,7 @@ struct MemVirtualStats
 };
 
 void* memVirtualReserve(size_t size, MemVirtualFlags flags = MemVirtualFlags::None);
-void* memVirtualCommit(void* ptr, size_t size);
+void* memVirtualCommit(void* ptr, size_t size, MemVirtualFlags flags = MemVirtualFlags::None);
 void memVirtualDecommit(void* ptr, size_t size);
 void memVirtualRelease(void* ptr, size_t size);
 MemVirtualStats memVirtualGetStats();
@@ -224,6 +231,8 @@ INLINE bool pathIsFile(const char* path);
 INLINE bool pathIsDir(const char* path);
 API bool pathCreateDir(const char* path);
 API bool pathMove(const char* src, const char* dest);
+API bool pathReplace(const char* src, const char* dest);   // Atomically moves src over an existing dest (rename-over)
+API bool pathDelete(const char* path);
 
 struct Path : String<kMaxPath>
 {
@@ -259,7 +268,7 @@ enum class FileOpenFlags : uint32
     None         = 0,
     Read         = 0x01, // Open for reading
     Write        = 0x02, // Open for writing
-    Append       = 0x03, // Append to the end of the file (write-mode only)
+    Append       = 0x04, // Append to the end of the file, creates it if doesn't exist (write-mode only)
     NoCache      = 0x08, // Disable IO cache, suitable for very large files, remember to align buffers to virtual memory pages
     Writethrough = 0x10, // Write-through writes meta information to disk immediately
     SeqScan      = 0x20, // Optimize cache for sequential read (not to be used with NOCACHE)
@@ -297,6 +306,30 @@ private:
     uint8 mData[64];
 };
 
+// FileMapping: Memory mapped view of a file
+//               Open: Read-only view. Offset doesn't need to be page aligned, the view is aligned internally and Data() points to the requested offset
+//                     Size = 0 maps everything from offset to the end of the file
+//               Create: Creates (or overwrites) the file with the given size and maps all of it for writing
+//                       CloseAndTruncate shrinks the file to the part that is actually written
+struct FileMapping
+{
+    FileMapping();
+
+    bool Open(const char* filepath, size_t offset = 0, size_t size = 0);
+    bool Create(const char* filepath, size_t size);
+    void Close();
+    void CloseAndTruncate(size_t size);     // Writable mappings only
+    bool Flush();                           // Schedules writing the dirty pages to disk. Writable mappings only
+
+    const void* Data() const;
+    void* WritableData();
+    size_t Size() const;
+    bool IsOpen() const;
+
+private:
+    uint8 mData[48];
+};
+
 // Async file
 // TODO: (experimental) Currently, not implemented in platforms other than windows
 struct AsyncFile
@@ -411,6 +444,26 @@ struct SysInfo
     uint32       cpuCapsNeon : 1;
 };
 
+// Logical cpu, as seen by the OS scheduler. All the indices are dense, starting from zero
+struct SysCpuInfo
+{
+    uint32 cpuIndex;            // OS index, pass this to `threadSetCurrentThreadAffinity`
+    uint32 coreIndex;           // Physical core, SMT siblings share the same one
+    uint32 cacheDomainIndex;    // Cpus that share the last level cache (L3 slice, CCX)
+    uint32 packageIndex;        // Socket
+    uint32 numaNode;
+};
+
+struct SysCpuTopology
+{
+    uint32 numCpus;
+    uint32 numCores;
+    uint32 numCacheDomains;
+    uint32 numPackages;
+    uint32 numNumaNodes;
+    SysCpuInfo* cpus;           // Sorted by cpuIndex
+};
+
 struct SysUUID
 {
     uint8 data[16];
@@ -423,7 +476,11 @@ API void sysUnloadDLL(DLLHandle dll);
 API void* sysSymbolAddress(DLLHandle dll, const char* symbolName);
 API size_t sysGetPageSize();
 API void sysGetSysInfo(SysInfo* info);
+// Linux: sysfs (cpu, cache, node). Windows: Only the first processor group. Not supported on macOS
+// `topo->cpus` is allocated with `alloc` and must be freed by the caller
+API bool sysGetCpuTopology(SysCpuTopology* topo, Allocator* alloc = memDefaultAlloc());
 API bool sysIsDebuggerPresent();
+API uint64 sysGetProcessCpuTime();     // User + kernel time of all the threads in the process. Same units as timer ticks (nanosecs)
 API void sysGenerateCmdLineFromArgcArgv(int argc, const char* argv[], char** outString, uint32* outStringLen, 
                                         Allocator* alloc = memDefaultAlloc(), const char* prefixCmd = nullptr);
 
@@ -9,11 +9,14 @@
 #include <sys/socket.h>         // socket funcs
 #if PLATFORM_ANDROID || PLATFORM_LINUX
     #include <sys/prctl.h>          // prctl
+    #include <sys/syscall.h>        // syscall, SYS_futex
+    #include <linux/futex.h>        // FUTEX_WAIT_PRIVATE, FUTEX_WAKE_PRIVATE
 #else
     #include <sched.h>
 #endif
 #include <sys/stat.h>           // stat
 #include <sys/mman.h>           // mmap/munmap/mprotect/..
+#include <sys/resource.h>       // getrusage
 #include <limits.h> 
 #include <stdlib.h>             // realpath
 #include <stdio.h>              // rename
@@ -282,11 +285,56 @@ void threadSleep(uint32 msecs)
     nanosleep(&req, &rem);
 }
 
+#if PLATFORM_APPLE
+// Darwin's private futex-like API, also used by libc++ for atomic waits
+extern "C" int __ulock_wait(uint32_t operation, void* addr, uint64_t value, uint32_t timeoutUs);
+extern "C" int __ulock_wake(uint32_t operation, void* addr, uint64_t wakeValue);
+#define UL_COMPARE_AND_WAIT 1
+#define ULF_WAKE_ALL 0x00000100
+#endif
+
+bool threadWaitOnAddress(const uint32* addr, uint32 expectedValue, uint32 msecs)
+{
+    #if PLATFORM_APPLE
+        uint32 timeoutUs = msecs == UINT32_MAX ? 0 : Max<uint32>(msecs, 1)*1000;
+        int r = __ulock_wait(UL_COMPARE_AND_WAIT, const_cast<uint32*>(addr), expectedValue, timeoutUs);
+        return r >= 0 || errno != ETIMEDOUT;
+    #else
+        struct timespec ts = { (time_t)msecs / 1000, (long)((msecs % 1000) * 1000000) };
+        long r = syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, expectedValue, msecs == UINT32_MAX ? nullptr : &ts, nullptr, 0);
+        return r == 0 || errno != ETIMEDOUT;
+    #endif
+}
+
+void threadWakeAllOnAddress(const uint32* addr)
+{
+    #if PLATFORM_APPLE
+        __ulock_wake(UL_COMPARE_AND_WAIT | ULF_WAKE_ALL, const_cast<uint32*>(addr), 0);
+    #else
+        syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+    #endif
+}
+
 void threadSetCurrentThreadPriority(ThreadPriority prio)
 {
     threadSetPriority(pthread_self(), prio);
 }
 
+bool threadSetCurrentThreadAffinity([[maybe_unused]] uint32 cpuIndex)
+{
+    #if PLATFORM_LINUX || PLATFORM_ANDROID
+        if (cpuIndex >= CPU_SETSIZE)
+            return false;
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(cpuIndex, &cpuSet);
+        return sched_setaffinity(0, sizeof(cpuSet), &cpuSet) == 0;
+    #else
+        // macOS only has affinity tags, which are hints for grouping threads, not pinning
+        return false;
+    #endif
+}
+
 //--------------------------------------------------------------------------------------------------
 // Mutex
 void Mutex::Initialize(uint32 spinCount)
@@ -594,6 +642,156 @@ size_t sysGetPageSize()
     return static_cast<size_t>(sysconf(_SC_PAGESIZE));
 }
 
+uint64 sysGetProcessCpuTime()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+    return (uint64(usage.ru_utime.tv_sec) + uint64(usage.ru_stime.tv_sec))*1000000000ull + 
+           (uint64(usage.ru_utime.tv_usec) + uint64(usage.ru_stime.tv_usec))*1000ull;
+}
+
+#if PLATFORM_LINUX || PLATFORM_ANDROID
+static bool sysReadSysfs(const char* path, char* buff, uint32 buffSize)
+{
+    FILE* f = fopen(path, "rb");
+    if (!f)
+        return false;
+    size_t bytesRead = fread(buff, 1, buffSize - 1, f);
+    fclose(f);
+    buff[bytesRead] = 0;
+    return bytesRead > 0;
+}
+
+static int sysReadSysfsInt(const char* path, int defaultValue)
+{
+    char buff[32];
+    return sysReadSysfs(path, buff, sizeof(buff)) ? strToInt(buff) : defaultValue;
+}
+
+// Cpu list format: "0-3,8,10-11"
+template <typename _Func>
+static void sysForEachInCpuList(const char* list, _Func fn)
+{
+    const char* str = list;
+    while (*str >= '0' && *str <= '9') {
+        uint32 first = 0;
+        while (*str >= '0' && *str <= '9')
+            first = first*10 + uint32(*str++ - '0');
+        uint32 last = first;
+        if (*str == '-') {
+            ++str;
+            last = 0;
+            while (*str >= '0' && *str <= '9')
+                last = last*10 + uint32(*str++ - '0');
+        }
+
+        for (uint32 i = first; i <= last; i++)
+            fn(i);
+
+        if (*str == ',')
+            ++str;
+    }
+}
+
+static uint32 sysGetDenseIndex(uint64* keys, uint32* numKeys, uint64 key)
+{
+    for (uint32 i = 0; i < *numKeys; i++) {
+        if (keys[i] == key)
+            return i;
+    }
+    keys[*numKeys] = key;
+    return (*numKeys)++;
+}
+
+bool sysGetCpuTopology(SysCpuTopology* topo, Allocator* alloc)
+{
+    memset(topo, 0x0, sizeof(*topo));
+
+    long numConfigured = sysconf(_SC_NPROCESSORS_CONF);
+    if (numConfigured <= 0)
+        return false;
+
+    MemTempAllocator tmpAlloc;
+    uint32 maxCpus = uint32(numConfigured);
+    SysCpuInfo* cpus = tmpAlloc.MallocZeroTyped<SysCpuInfo>(maxCpus);
+    uint64* coreKeys = tmpAlloc.MallocTyped<uint64>(maxCpus);
+    uint64* domainKeys = tmpAlloc.MallocTyped<uint64>(maxCpus);
+    uint64* packageKeys = tmpAlloc.MallocTyped<uint64>(maxCpus);
+    uint64* nodeKeys = tmpAlloc.MallocTyped<uint64>(maxCpus);
+    uint32 numCpus = 0;
+
+    char path[128];
+    char buff[512];
+    for (uint32 cpu = 0; cpu < maxCpus; cpu++) {
+        // Offline cpus don't have topology info
+        strPrintFmt(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/core_id", cpu);
+        int coreId = sysReadSysfsInt(path, -1);
+        if (coreId < 0)
+            continue;
+
+        strPrintFmt(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/physical_package_id", cpu);
+        int packageId = Max(sysReadSysfsInt(path, 0), 0);
+
+        // Last level cache domain is identified by the first cpu that shares it
+        int maxLevel = 0;
+        uint64 domainKey = (uint64(1) << 32) | uint32(packageId);   // No cache info: The whole package is one domain
+        for (uint32 index = 0; ; index++) {
+            strPrintFmt(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cache/index%u/level", cpu, index);
+            int level = sysReadSysfsInt(path, -1);
+            if (level < 0)
+                break;
+            if (level < maxLevel)
+                continue;
+
+            strPrintFmt(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cache/index%u/shared_cpu_list", cpu, index);
+            if (sysReadSysfs(path, buff, sizeof(buff))) {
+                maxLevel = level;
+                domainKey = uint32(strToInt(buff));
+            }
+        }
+
+        SysCpuInfo& info = cpus[numCpus++];
+        info.cpuIndex = cpu;
+        info.coreIndex = sysGetDenseIndex(coreKeys, &topo->numCores, (uint64(packageId) << 32) | uint32(coreId));
+        info.cacheDomainIndex = sysGetDenseIndex(domainKeys, &topo->numCacheDomains, domainKey);
+        info.packageIndex = sysGetDenseIndex(packageKeys, &topo->numPackages, uint64(packageId));
+    }
+
+    if (numCpus == 0)
+        return false;
+
+    // NUMA nodes. Without NUMA support in the kernel, everything is in node 0
+    if (sysReadSysfs("/sys/devices/system/node/online", buff, sizeof(buff))) {
+        sysForEachInCpuList(buff, [&](uint32 node) {
+            char nodeCpus[512];
+            strPrintFmt(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", node);
+            if (!sysReadSysfs(path, nodeCpus, sizeof(nodeCpus)))
+                return;
+            uint32 nodeIndex = sysGetDenseIndex(nodeKeys, &topo->numNumaNodes, node);
+            sysForEachInCpuList(nodeCpus, [&](uint32 cpu) {
+                for (uint32 i = 0; i < numCpus; i++) {
+                    if (cpus[i].cpuIndex == cpu)
+                        cpus[i].numaNode = nodeIndex;
+                }
+            });
+        });
+    }
+    topo->numNumaNodes = Max(topo->numNumaNodes, 1u);
+
+    topo->numCpus = numCpus;
+    topo->cpus = memAllocCopy<SysCpuInfo>(cpus, numCpus, alloc);
+    return true;
+}
+#else
+bool sysGetCpuTopology(SysCpuTopology* topo, Allocator*)
+{
+    memset(topo, 0x0, sizeof(*topo));
+    return false;
+}
+#endif // PLATFORM_LINUX || PLATFORM_ANDROID
+
 bool sysSetEnvVar(const char* name, const char* value)
 {
     return value != nullptr ? setenv(name, value, 1) == 0 : unsetenv(name) == 0;
@@ -654,6 +852,16 @@ bool pathMove(const char* src, const char* dest)
     return rename(src, dest) == 0;
 }
 
+bool pathReplace(const char* src, const char* dest)
+{
+    return rename(src, dest) == 0;
+}
+
+bool pathDelete(const char* path)
+{
+    return unlink(path) == 0;
+}
+
 //------------------------------------------------------------------------
 // Virtual memory
 struct MemVirtualStatsAtomic 
@@ -675,10 +883,15 @@ void* memVirtualReserve(size_t size, MemVirtualFlags flags)
     return ptr;
 }
 
-void* memVirtualCommit(void* ptr, size_t size)
+void* memVirtualCommit(void* ptr, size_t size, MemVirtualFlags flags)
 {
     int r = mprotect(ptr, size, PROT_READ | PROT_WRITE);
     ASSERT(r == 0);
+
+    if ((flags & MemVirtualFlags::NoPrefault) == MemVirtualFlags::NoPrefault) {
+        atomicFetchAdd64(&gVMStats.commitedBytes, size);
+        return ptr;
+    }
     
     size_t pageSize = sysGetPageSize();
     r = madvise(ptr, size, MADV_WILLNEED);
@@ -814,11 +1027,11 @@ bool File::Open(const char* filepath, FileOpenFlags flags)
     } else if ((flags & FileOpenFlags::Write) == FileOpenFlags::Write) {
         openFlags |= O_WRONLY;
         if ((flags & FileOpenFlags::Append) == FileOpenFlags::Append) {
-            openFlags |= O_APPEND;
+            openFlags |= (O_APPEND | O_CREAT);
         } else {
             openFlags |= (O_CREAT | O_TRUNC);
-            mode |= (S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH); 
         }
+        mode |= (S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH); 
     }
 
     #if (PLATFORM_LINUX || PLATFORM_ANDROID)
@@ -926,6 +1139,145 @@ bool File::IsOpen() const
     return f->id != -1;
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+// FileMapping
+struct FileMappingPosix
+{
+    void*  view;
+    size_t viewSize;
+    size_t viewOffset;  // offset of the requested data inside the view (page alignment)
+    size_t size;
+    int    fileId;      // Writable mappings keep the descriptor for truncating the file on close
+    bool   writable;
+};
+static_assert(sizeof(FileMappingPosix) <= sizeof(FileMapping));
+
+FileMapping::FileMapping()
+{
+    memset(mData, 0x0, sizeof(mData));
+}
+
+bool FileMapping::Open(const char* filepath, size_t offset, size_t size)
+{
+    FileMappingPosix* m = (FileMappingPosix*)mData;
+    ASSERT_MSG(m->view == nullptr, "FileMapping is already open");
+
+    int fileId = open(filepath, O_RDONLY | __O_LARGEFILE);
+    if (fileId == -1)
+        return false;
+
+    struct stat _stat;
+    if (fstat(fileId, &_stat) != 0 || offset >= static_cast<size_t>(_stat.st_size)) {
+        close(fileId);
+        return false;
+    }
+
+    size_t fileSize = static_cast<size_t>(_stat.st_size);
+    if (size == 0 || offset + size > fileSize)
+        size = fileSize - offset;
+
+    size_t pageSize = sysGetPageSize();
+    size_t alignedOffset = offset - (offset % pageSize);
+    size_t viewSize = size + (offset - alignedOffset);
+
+    void* view = mmap(nullptr, viewSize, PROT_READ, MAP_SHARED, fileId, static_cast<off_t>(alignedOffset));
+    close(fileId);  // Mapping holds a reference to the file, so we don't need the descriptor anymore
+    if (view == MAP_FAILED)
+        return false;
+
+    m->view = view;
+    m->viewSize = viewSize;
+    m->viewOffset = offset - alignedOffset;
+    m->size = size;
+    return true;
+}
+
+bool FileMapping::Create(const char* filepath, size_t size)
+{
+    FileMappingPosix* m = (FileMappingPosix*)mData;
+    ASSERT_MSG(m->view == nullptr, "FileMapping is already open");
+    ASSERT(size);
+
+    int fileId = open(filepath, O_RDWR | O_CREAT | O_TRUNC | __O_LARGEFILE, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fileId == -1)
+        return false;
+
+    if (ftruncate(fileId, static_cast<off_t>(size)) != 0) {
+        close(fileId);
+        return false;
+    }
+
+    void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fileId, 0);
+    if (view == MAP_FAILED) {
+        close(fileId);
+        return false;
+    }
+
+    m->view = view;
+    m->viewSize = size;
+    m->viewOffset = 0;
+    m->size = size;
+    m->fileId = fileId;
+    m->writable = true;
+    return true;
+}
+
+void FileMapping::Close()
+{
+    FileMappingPosix* m = (FileMappingPosix*)mData;
+    if (m->view) {
+        munmap(m->view, m->viewSize);
+        if (m->writable)
+            close(m->fileId);
+        memset(m, 0x0, sizeof(*m));
+    }
+}
+
+void FileMapping::CloseAndTruncate(size_t size)
+{
+    FileMappingPosix* m = (FileMappingPosix*)mData;
+    if (m->view) {
+        ASSERT_MSG(m->writable, "Only writable mappings can be truncated");
+        ASSERT(size <= m->size);
+        munmap(m->view, m->viewSize);
+        [[maybe_unused]] int r = ftruncate(m->fileId, static_cast<off_t>(size));
+        close(m->fileId);
+        memset(m, 0x0, sizeof(*m));
+    }
+}
+
+bool FileMapping::Flush()
+{
+    FileMappingPosix* m = (FileMappingPosix*)mData;
+    ASSERT(m->writable);
+    return m->view ? msync(m->view, m->viewSize, MS_ASYNC) == 0 : false;
+}
+
+void* FileMapping::WritableData()
+{
+    FileMappingPosix* m = (FileMappingPosix*)mData;
+    ASSERT_MSG(m->writable, "FileMapping is opened as read-only");
+    return m->view;
+}
+
+const void* FileMapping::Data() const
+{
+    const FileMappingPosix* m = (const FileMappingPosix*)mData;
+    return m->view ? (const uint8*)m->view + m->viewOffset : nullptr;
+}
+
+size_t FileMapping::Size() const
+{
+    const FileMappingPosix* m = (const FileMappingPosix*)mData;
+    return m->size;
+}
+
+bool FileMapping::IsOpen() const
+{
+    const FileMappingPosix* m = (const FileMappingPosix*)mData;
+    return m->view != nullptr;
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 // Socket
 #define SOCKET_INVALID -1
@@ -19,6 +19,7 @@
 #include <ShlObj.h>     // SH family of functions
 
 #pragma comment(lib, "ws2_32.lib")
+#pragma comment(lib, "Synchronization.lib")     // WaitOnAddress/WakeByAddressAll
 
 namespace _limits 
 {
@@ -334,6 +335,25 @@ void threadSleep(uint32 msecs)
     Sleep((DWORD)msecs);
 }
 
+bool threadWaitOnAddress(const uint32* addr, uint32 expectedValue, uint32 msecs)
+{
+    if (WaitOnAddress((volatile VOID*)addr, &expectedValue, sizeof(uint32), msecs == UINT32_MAX ? INFINITE : msecs))
+        return true;
+    return GetLastError() != ERROR_TIMEOUT;
+}
+
+void threadWakeAllOnAddress(const uint32* addr)
+{
+    WakeByAddressAll((PVOID)addr);
+}
+
+bool threadSetCurrentThreadAffinity(uint32 cpuIndex)
+{
+    if (cpuIndex >= sizeof(KAFFINITY)*8)
+        return false;
+    return SetThreadAffinityMask(GetCurrentThread(), KAFFINITY(1) << cpuIndex) != 0;
+}
+
 void threadSetCurrentThreadPriority(ThreadPriority prio)
 {
     int prioWin = 0;
@@ -438,6 +458,98 @@ size_t sysGetPageSize()
     return (size_t)si.dwPageSize;
 }
 
+uint64 sysGetProcessCpuTime()
+{
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+        return 0;
+
+    // FILETIME is in 100ns units
+    uint64 kernel = (uint64(kernelTime.dwHighDateTime) << 32) | kernelTime.dwLowDateTime;
+    uint64 user = (uint64(userTime.dwHighDateTime) << 32) | userTime.dwLowDateTime;
+    return (kernel + user)*100;
+}
+
+bool sysGetCpuTopology(SysCpuTopology* topo, Allocator* alloc)
+{
+    memset(topo, 0x0, sizeof(*topo));
+
+    DWORD size = 0;
+    GetLogicalProcessorInformationEx(RelationAll, nullptr, &size);
+    if (GetLastError() != ERROR_INSUFFICIENT_BUFFER)
+        return false;
+
+    MemTempAllocator tmpAlloc;
+    uint8* buffer = (uint8*)tmpAlloc.Malloc(size);
+    if (!GetLogicalProcessorInformationEx(RelationAll, (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)buffer, &size))
+        return false;
+
+    // Only processor group 0 (up to 64 cpus), because that's what SetThreadAffinityMask can address
+    constexpr uint32 kMaxCpus = sizeof(KAFFINITY)*8;
+    SysCpuInfo cpus[kMaxCpus] {};
+    bool present[kMaxCpus] {};
+
+    auto ForEachCpu = [](const GROUP_AFFINITY& affinity, auto fn) {
+        if (affinity.Group != 0)
+            return;
+        for (uint32 i = 0; i < kMaxCpus; i++) {
+            if (affinity.Mask & (KAFFINITY(1) << i))
+                fn(i);
+        }
+    };
+
+    BYTE maxCacheLevel = 0;
+    for (uint8* p = buffer; p < buffer + size; p += ((PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)p)->Size) {
+        PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX info = (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)p;
+        if (info->Relationship == RelationCache)
+            maxCacheLevel = Max(maxCacheLevel, info->Cache.Level);
+    }
+
+    for (uint8* p = buffer; p < buffer + size; p += ((PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)p)->Size) {
+        PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX info = (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)p;
+        switch (info->Relationship) {
+        case RelationProcessorCore: {
+            uint32 coreIndex = topo->numCores++;
+            ForEachCpu(info->Processor.GroupMask[0], [&](uint32 cpu) { present[cpu] = true; cpus[cpu].coreIndex = coreIndex; });
+            break;
+        }
+        case RelationProcessorPackage: {
+            uint32 packageIndex = topo->numPackages++;
+            for (WORD g = 0; g < info->Processor.GroupCount; g++)
+                ForEachCpu(info->Processor.GroupMask[g], [&](uint32 cpu) { cpus[cpu].packageIndex = packageIndex; });
+            break;
+        }
+        case RelationCache:
+            if (info->Cache.Level == maxCacheLevel && info->Cache.Type != CacheInstruction) {
+                uint32 domainIndex = topo->numCacheDomains++;
+                ForEachCpu(info->Cache.GroupMask, [&](uint32 cpu) { cpus[cpu].cacheDomainIndex = domainIndex; });
+            }
+            break;
+        case RelationNumaNode: {
+            uint32 nodeIndex = topo->numNumaNodes++;
+            ForEachCpu(info->NumaNode.GroupMask, [&](uint32 cpu) { cpus[cpu].numaNode = nodeIndex; });
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    SysCpuInfo* outCpus = memAllocTyped<SysCpuInfo>(kMaxCpus, alloc);
+    for (uint32 i = 0; i < kMaxCpus; i++) {
+        if (present[i]) {
+            outCpus[topo->numCpus] = cpus[i];
+            outCpus[topo->numCpus++].cpuIndex = i;
+        }
+    }
+
+    topo->numCacheDomains = Max(topo->numCacheDomains, 1u);
+    topo->numPackages = Max(topo->numPackages, 1u);
+    topo->numNumaNodes = Max(topo->numNumaNodes, 1u);
+    topo->cpus = outCpus;
+    return topo->numCpus > 0;
+}
+
 bool sysWin32GetRegisterLocalMachineString(const char* subkey, const char* value, char* dst, size_t dstSize)
 {
     // Only load the DLL and function if it's used 
@@ -644,7 +756,8 @@ bool SysProcess::Run(const char* cmdline, SysProcessFlags flags, const char* cwd
         saAttr.nLength = sizeof(SECURITY_ATTRIBUTES); 
         saAttr.bInheritHandle = inheritHandles; 
 
-        r = CreatePipe(&mStdOutPipeRead, &stdOutPipeWrite, &saAttr, 0);
+        // Default pipe buffer is a few KBs, which makes processes with a lot of output block on every few writes
+        r = CreatePipe(&mStdOutPipeRead, &stdOutPipeWrite, &saAttr, kMB);
         ASSERT_MSG(r, "CreatePipe failed");
 
         r = CreatePipe(&mStdErrPipeRead, &stdErrPipeWrite, &saAttr, 0);
@@ -881,6 +994,16 @@ bool pathMove(const char* src, const char* dest)
     return bool(MoveFileA(src, dest));
 }
 
+bool pathReplace(const char* src, const char* dest)
+{
+    return bool(MoveFileExA(src, dest, MOVEFILE_REPLACE_EXISTING|MOVEFILE_WRITE_THROUGH));
+}
+
+bool pathDelete(const char* path)
+{
+    return bool(DeleteFileA(path));
+}
+
 char* pathGetHomeDir(char* dst, size_t dstSize)
 {
     PWSTR homeDir = nullptr;
@@ -1108,8 +1231,9 @@ void* memVirtualReserve(size_t size, MemVirtualFlags flags)
     return ptr;
 }
 
-void* memVirtualCommit(void* ptr, size_t size)
+void* memVirtualCommit(void* ptr, size_t size, MemVirtualFlags flags)
 {
+    UNUSED(flags);  // Committed pages are only backed on first access anyway
     ASSERT(ptr);
     ptr = VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE);
     if (!ptr) {
@@ -1204,9 +1328,15 @@ bool File::Open(const char* filepath, FileOpenFlags flags)
         createFlags = OPEN_EXISTING;
         shareFlags |= FILE_SHARE_READ;
     } else if ((flags & FileOpenFlags::Write) == FileOpenFlags::Write) {
-        accessFlags |= GENERIC_WRITE;
-        createFlags |= (flags & FileOpenFlags::Append) == FileOpenFlags::Append ? OPEN_EXISTING : CREATE_ALWAYS;
-        shareFlags |= FILE_SHARE_WRITE;
+        if ((flags & FileOpenFlags::Append) == FileOpenFlags::Append) {
+            accessFlags |= FILE_APPEND_DATA;
+            createFlags |= OPEN_ALWAYS;
+        }
+        else {
+            accessFlags |= GENERIC_WRITE;
+            createFlags |= CREATE_ALWAYS;
+        }
+        shareFlags |= FILE_SHARE_WRITE | FILE_SHARE_READ;   // Allow readers (and FileMapping) while the file is being written
     }
 
     if ((flags & FileOpenFlags::NoCache) == FileOpenFlags::NoCache)             attrs |= FILE_FLAG_NO_BUFFERING;
@@ -1315,6 +1445,155 @@ bool File::IsOpen() const
     return f->handle != INVALID_HANDLE_VALUE;
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+// FileMapping
+struct FileMappingWin
+{
+    void*  view;
+    size_t viewOffset;  // offset of the requested data inside the view (allocation granularity alignment)
+    size_t size;
+    HANDLE hfile;       // Writable mappings keep the file open for truncating it on close
+};
+static_assert(sizeof(FileMappingWin) <= sizeof(FileMapping));
+
+FileMapping::FileMapping()
+{
+    memset(mData, 0x0, sizeof(mData));
+}
+
+bool FileMapping::Open(const char* filepath, size_t offset, size_t size)
+{
+    FileMappingWin* m = (FileMappingWin*)mData;
+    ASSERT_MSG(m->view == nullptr, "FileMapping is already open");
+
+    HANDLE hfile = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE, NULL, 
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hfile == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(hfile, &fileSize) || offset >= size_t(fileSize.QuadPart)) {
+        CloseHandle(hfile);
+        return false;
+    }
+
+    if (size == 0 || offset + size > size_t(fileSize.QuadPart))
+        size = size_t(fileSize.QuadPart) - offset;
+
+    HANDLE hmap = CreateFileMappingA(hfile, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(hfile);
+    if (!hmap)
+        return false;
+
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    size_t alignedOffset = offset - (offset % si.dwAllocationGranularity);
+
+    void* view = MapViewOfFile(hmap, FILE_MAP_READ, uint32(uint64(alignedOffset) >> 32), uint32(alignedOffset & 0xffffffff), 
+                               size + (offset - alignedOffset));
+    CloseHandle(hmap);  // View keeps a reference to the mapping object
+    if (!view)
+        return false;
+
+    m->view = view;
+    m->viewOffset = offset - alignedOffset;
+    m->size = size;
+    return true;
+}
+
+bool FileMapping::Create(const char* filepath, size_t size)
+{
+    FileMappingWin* m = (FileMappingWin*)mData;
+    ASSERT_MSG(m->view == nullptr, "FileMapping is already open");
+    ASSERT(size);
+
+    // FILE_SHARE_DELETE: Rotating files renames them while the previous one can still be mapped by a reader 
+    HANDLE hfile = CreateFileA(filepath, GENERIC_READ|GENERIC_WRITE, FILE_SHARE_READ|FILE_SHARE_DELETE, NULL, 
+                               CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hfile == INVALID_HANDLE_VALUE)
+        return false;
+
+    HANDLE hmap = CreateFileMappingA(hfile, NULL, PAGE_READWRITE, uint32(uint64(size) >> 32), uint32(size & 0xffffffff), NULL);
+    if (!hmap) {
+        CloseHandle(hfile);
+        return false;
+    }
+
+    void* view = MapViewOfFile(hmap, FILE_MAP_WRITE, 0, 0, size);
+    CloseHandle(hmap);
+    if (!view) {
+        CloseHandle(hfile);
+        return false;
+    }
+
+    m->view = view;
+    m->viewOffset = 0;
+    m->size = size;
+    m->hfile = hfile;
+    return true;
+}
+
+void FileMapping::Close()
+{
+    FileMappingWin* m = (FileMappingWin*)mData;
+    if (m->view) {
+        UnmapViewOfFile(m->view);
+        if (m->hfile)
+            CloseHandle(m->hfile);
+        memset(m, 0x0, sizeof(*m));
+    }
+}
+
+void FileMapping::CloseAndTruncate(size_t size)
+{
+    FileMappingWin* m = (FileMappingWin*)mData;
+    if (m->view) {
+        ASSERT_MSG(m->hfile, "Only writable mappings can be truncated");
+        ASSERT(size <= m->size);
+
+        // The file cannot be resized while it still has a view
+        UnmapViewOfFile(m->view);
+        LARGE_INTEGER offset;
+        offset.QuadPart = LONGLONG(size);
+        if (SetFilePointerEx(m->hfile, offset, NULL, FILE_BEGIN))
+            SetEndOfFile(m->hfile);
+        CloseHandle(m->hfile);
+        memset(m, 0x0, sizeof(*m));
+    }
+}
+
+bool FileMapping::Flush()
+{
+    FileMappingWin* m = (FileMappingWin*)mData;
+    ASSERT(m->hfile);
+    return m->view ? FlushViewOfFile(m->view, 0) != 0 : false;
+}
+
+void* FileMapping::WritableData()
+{
+    FileMappingWin* m = (FileMappingWin*)mData;
+    ASSERT_MSG(m->hfile, "FileMapping is opened as read-only");
+    return m->view;
+}
+
+const void* FileMapping::Data() const
+{
+    const FileMappingWin* m = (const FileMappingWin*)mData;
+    return m->view ? (const uint8*)m->view + m->viewOffset : nullptr;
+}
+
+size_t FileMapping::Size() const
+{
+    const FileMappingWin* m = (const FileMappingWin*)mData;
+    return m->size;
+}
+
+bool FileMapping::IsOpen() const
+{
+    const FileMappingWin* m = (const FileMappingWin*)mData;
+    return m->view != nullptr;
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 // AsyncFile
 struct AsyncFileWin
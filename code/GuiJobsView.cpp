@@ -0,0 +1,231 @@
+#include "GuiJobsView.h"
+
+#include "ImGui/ImGuiAll.h"
+
+#include "Core/Jobs.h"
+#include "Core/System.h"
+#include "Core/StringUtil.h"
+#include "Core/TracyHelper.h"
+
+#include "Main.h"
+
+static constexpr uint32 kJobsViewNumSamples = 120;
+static constexpr uint64 kJobsViewSampleInterval = 250000000;   // nanosecs
+
+static const char* kJobsViewTypeNames[] = { "ShortTask", "LongTask" };
+static const char* kJobsViewPrioNames[] = { "High", "Normal", "Low" };
+static_assert(CountOf(kJobsViewTypeNames) == uint32(JobsType::_Count));
+static_assert(CountOf(kJobsViewPrioNames) == uint32(JobsPriority::_Count));
+
+// Tracy keeps the plots by name pointer
+static const char* kJobsViewBusyPlots[] = { "Jobs: ShortTask busy %", "Jobs: LongTask busy %" };
+static const char* kJobsViewQueuePlots[] = { "Jobs: ShortTask queue", "Jobs: LongTask queue" };
+static const char* kJobsViewLatencyPlots[] = { "Jobs: ShortTask latency (us)", "Jobs: LongTask latency (us)" };
+static const char* kJobsViewBlockedPlots[] = { "Jobs: ShortTask blocked", "Jobs: LongTask blocked" };
+
+struct GuiJobsViewData
+{
+    struct TypeSamples
+    {
+        float busy[kJobsViewNumSamples];        // Percentage of the running workers' time
+        float search[kJobsViewNumSamples];
+        float queueDepth[kJobsViewNumSamples];
+        float latency[kJobsViewNumSamples];     // Average, in microsecs
+        float latencyHistogram[kJobsLatencyBuckets];    // Last sampling period only
+    };
+
+    JobsTelemetry prev;
+    JobsTelemetry cur;
+    TypeSamples types[uint32(JobsType::_Count)];
+    float numFibers[kJobsViewNumSamples];
+    uint32 sampleIndex;     // Next sample to write, also the oldest one in the ring buffer
+    uint32 numSamples;
+};
+
+// The counters of the current state are estimated on sampling, so a sample can be slightly behind the previous one
+static uint64 GetDelta(uint64 value, uint64 prevValue)
+{
+    return value > prevValue ? value - prevValue : 0;
+}
+
+static float GetPercent(uint64 value, uint64 total)
+{
+    return total ? float(double(value)*100.0/double(total)) : 0;
+}
+
+bool GuiJobsView::Initialize()
+{
+    mData = NEW(memDefaultAlloc(), GuiJobsViewData);
+    memset(mData, 0x0, sizeof(*mData));
+    return true;
+}
+
+void GuiJobsView::Release()
+{
+    if (mData) {
+        memFree(mData->prev.workers);
+        memFree(mData->cur.workers);
+        memFree(mData);
+        mData = nullptr;
+    }
+}
+
+void GuiJobsView::Update()
+{
+    if (!mData)
+        return;
+
+    if (mData->cur.workers && timerDiff(timerGetTicks(), mData->cur.timestamp) < kJobsViewSampleInterval)
+        return;
+
+    memFree(mData->prev.workers);
+    mData->prev = mData->cur;
+    jobsGetTelemetry(&mData->cur);
+    if (!mData->prev.workers)
+        return;
+
+    const JobsTelemetry& prev = mData->prev;
+    const JobsTelemetry& cur = mData->cur;
+    uint32 index = mData->sampleIndex;
+
+    for (uint32 typeIndex = 0; typeIndex < uint32(JobsType::_Count); typeIndex++) {
+        const JobsTypeTelemetry& t = cur.types[typeIndex];
+        const JobsTypeTelemetry& pt = prev.types[typeIndex];
+        GuiJobsViewData::TypeSamples& samples = mData->types[typeIndex];
+
+        uint64 busy = 0, search = 0, idle = 0;
+        for (uint32 i = t.firstWorker; i < t.firstWorker + t.numWorkers; i++) {
+            busy += GetDelta(cur.workers[i].busyTime, prev.workers[i].busyTime);
+            search += GetDelta(cur.workers[i].searchTime, prev.workers[i].searchTime);
+            idle += GetDelta(cur.workers[i].idleTime, prev.workers[i].idleTime);
+        }
+
+        uint32 queueDepth = 0;
+        for (uint32 prioIdx = 0; prioIdx < uint32(JobsPriority::_Count); prioIdx++)
+            queueDepth += t.queueDepth[prioIdx];
+
+        uint64 numStarted = t.numStarted - pt.numStarted;
+        for (uint32 b = 0; b < kJobsLatencyBuckets; b++)
+            samples.latencyHistogram[b] = float(t.latencyHistogram[b] - pt.latencyHistogram[b]);
+
+        samples.busy[index] = GetPercent(busy, busy + search + idle);
+        samples.search[index] = GetPercent(search, busy + search + idle);
+        samples.queueDepth[index] = float(queueDepth);
+        samples.latency[index] = numStarted ? float(timerToUS((t.latencyTotal - pt.latencyTotal) / numStarted)) : 0;
+
+        TracyCPlot(kJobsViewBusyPlots[typeIndex], samples.busy[index]);
+        TracyCPlot(kJobsViewQueuePlots[typeIndex], samples.queueDepth[index]);
+        TracyCPlot(kJobsViewLatencyPlots[typeIndex], samples.latency[index]);
+        TracyCPlot(kJobsViewBlockedPlots[typeIndex], t.numBlocked);
+    }
+
+    mData->numFibers[index] = float(cur.numFibers);
+    TracyCPlot("Jobs: Fibers", mData->numFibers[index]);
+
+    mData->sampleIndex = (index + 1) % kJobsViewNumSamples;
+    mData->numSamples = Min(mData->numSamples + 1, kJobsViewNumSamples);
+}
+
+static void RenderWorkersTable(const JobsTelemetry& cur, const JobsTelemetry& prev, const JobsTypeTelemetry& t)
+{
+    const ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_SizingFixedFit;
+    if (!ImGui::BeginTable("##Workers", 6, flags))
+        return;
+
+    ImGui::TableSetupColumn("Worker", ImGuiTableColumnFlags_WidthStretch);
+    ImGui::TableSetupColumn("Busy");
+    ImGui::TableSetupColumn("Search");
+    ImGui::TableSetupColumn("Idle");
+    ImGui::TableSetupColumn("Items/s");
+    ImGui::TableSetupColumn("Steals/s");
+    ImGui::TableHeadersRow();
+
+    double elapsed = timerToSec(timerDiff(cur.timestamp, prev.timestamp));
+    for (uint32 i = t.firstWorker; i < t.firstWorker + t.numWorkers; i++) {
+        const JobsWorkerTelemetry& w = cur.workers[i];
+        const JobsWorkerTelemetry& pw = prev.workers[i];
+        if (!w.isRunning && !pw.isRunning)
+            continue;
+
+        uint64 busy = GetDelta(w.busyTime, pw.busyTime);
+        uint64 search = GetDelta(w.searchTime, pw.searchTime);
+        uint64 idle = GetDelta(w.idleTime, pw.idleTime);
+        uint64 total = busy + search + idle;
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::Text("#%u", i - t.firstWorker + 1);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.0f%%", GetPercent(busy, total));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.0f%%", GetPercent(search, total));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.0f%%", GetPercent(idle, total));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.0f", elapsed > 0 ? double(w.numItemsRun - pw.numItemsRun)/elapsed : 0);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.0f", elapsed > 0 ? double(w.numSteals - pw.numSteals)/elapsed : 0);
+    }
+
+    ImGui::EndTable();
+}
+
+void GuiJobsView::Render(const char* windowId, bool* pOpen)
+{
+    if (!mData)
+        return;
+
+    // Keep sampling while the window is visible
+    RequestRedrawTimeout(uint32(kJobsViewSampleInterval/1000000));
+
+    ImGui::SetNextWindowSizeConstraints(ImVec2(400, 300), ImVec2(1024, 2048));
+    if (ImGui::Begin(windowId, pOpen)) {
+        const JobsTelemetry& cur = mData->cur;
+        const JobsTelemetry& prev = mData->prev;
+        if (!prev.workers) {
+            ImGui::TextUnformatted("Collecting samples ...");
+            ImGui::End();
+            return;
+        }
+
+        // The ring buffer is not full in the beginning, so the oldest sample is at zero
+        int offset = mData->numSamples == kJobsViewNumSamples ? int(mData->sampleIndex) : 0;
+        int count = int(mData->numSamples);
+        ImVec2 plotSize(-1, 50);
+        char overlay[64];
+
+        ImGui::Text("Fibers: %u/%u  Jobs: %u  Pooled stacks: %u", cur.numFibers, cur.maxFibers, cur.numJobs, cur.numPooledStacks);
+        ImGui::PlotLines("##Fibers", mData->numFibers, count, offset, "Fibers", 0, float(cur.maxFibers), plotSize);
+
+        for (uint32 typeIndex = 0; typeIndex < uint32(JobsType::_Count); typeIndex++) {
+            const JobsTypeTelemetry& t = cur.types[typeIndex];
+            const GuiJobsViewData::TypeSamples& samples = mData->types[typeIndex];
+            uint32 last = (mData->sampleIndex + kJobsViewNumSamples - 1) % kJobsViewNumSamples;
+
+            ImGui::PushID(int(typeIndex));
+            if (ImGui::CollapsingHeader(kJobsViewTypeNames[typeIndex], ImGuiTreeNodeFlags_DefaultOpen)) {
+                ImGui::Text("Busy: %u  Blocked: %u  Queued:", t.numBusy, t.numBlocked);
+                for (uint32 prioIdx = 0; prioIdx < uint32(JobsPriority::_Count); prioIdx++) {
+                    ImGui::SameLine();
+                    ImGui::Text("%s=%u", kJobsViewPrioNames[prioIdx], t.queueDepth[prioIdx]);
+                }
+
+                strPrintFmt(overlay, sizeof(overlay), "Busy: %.0f%%  Search: %.0f%%", samples.busy[last], samples.search[last]);
+                ImGui::PlotLines("##Busy", samples.busy, count, offset, overlay, 0, 100.0f, plotSize);
+
+                strPrintFmt(overlay, sizeof(overlay), "Queue depth: %.0f", samples.queueDepth[last]);
+                ImGui::PlotLines("##Queue", samples.queueDepth, count, offset, overlay, 0, FLT_MAX, plotSize);
+
+                strPrintFmt(overlay, sizeof(overlay), "Start latency: %.1f us", samples.latency[last]);
+                ImGui::PlotLines("##Latency", samples.latency, count, offset, overlay, 0, FLT_MAX, plotSize);
+
+                ImGui::PlotHistogram("##LatencyHistogram", samples.latencyHistogram, int(kJobsLatencyBuckets), 0,
+                                     "Start latency: <1us .. >16ms", 0, FLT_MAX, plotSize);
+
+                RenderWorkersTable(cur, prev, t);
+            }
+            ImGui::PopID();
+        }
+    }
+    ImGui::End();
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Core/Base.h"
+
+struct GuiJobsViewData;
+
+// Job system telemetry: utilization, queue depths and start latencies over time. Helps telling apart a graph that is cpu bound,
+// waiting on processes (blocked LongTask workers) or held back by the scheduler (long queues and latencies with idle workers)
+struct GuiJobsView
+{
+    GuiJobsViewData* mData = nullptr;
+
+    bool Initialize();
+    void Release();
+
+    // Takes the samples and emits the Tracy plots. Call it every frame, even when the window is hidden
+    void Update();
+    void Render(const char* windowId, bool* pOpen);
+};
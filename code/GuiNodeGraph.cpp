@@ -4,12 +4,14 @@
 #include "Core/MathScalar.h"
 #include "Core/BlitSort.h"
 #include "Core/Hash.h"
+#include "Core/JsonParser.h"
 
 #include "GuiUtil.h"
 #include "Main.h"
 #include "BuiltinNodes.h"
 #include "Workspace.h"
 #include "GuiTextView.h"
+#include "SaveQueue.h"
 
 
 #include "ImGui/imnodes.h"
@@ -58,6 +60,9 @@ void GuiNodeGraph::Release()
     mNodes.Free();
     mLinks.Free();
     mSelectedNodes.Free();
+    mGrid.cellStart.Free();
+    mGrid.items.Free();
+    mGrid.nodeIndices.Free();
 
     if (mEditorCtx)
         ImNodes::EditorContextFree(mEditorCtx);
@@ -361,9 +366,246 @@ static uint32 GuiNodeGraph_GetStateColor(GuiNodeGraphNode& node)
     }
 }
 
+static constexpr float kGuiNodeGraphCellSize = 256.0f;
+static constexpr uint32 kGuiNodeGraphMaxCells = 128*128;
+static constexpr float kGuiNodeGraphCullMargin = 32.0f;         // Pins and shadows are slightly outside the node rectangle
+static constexpr uint32 kGuiNodeGraphCullMinNodes = 64;         // Smaller graphs are submitted as a whole
+static constexpr uint32 kGuiNodeGraphLodEnterNodes = 300;
+static constexpr uint32 kGuiNodeGraphLodExitNodes = 200;
+static constexpr float kGuiNodeGraphLodPinHeight = 6.0f;
+
+static void GuiNodeGraph_BuildGrid(GuiNodeGraph* uigraph)
+{
+    GuiNodeGraphGrid& grid = uigraph->mGrid;
+    Array<GuiNodeGraphNode>& nodes = uigraph->mNodes;
+
+    grid.dirty = false;
+    grid.numNodes = nodes.Count();
+    grid.cellStart.Clear();
+    grid.items.Clear();
+    grid.numCols = grid.numRows = 0;
+
+    grid.nodeIndices.Free();
+    grid.nodeIndices.Reserve(Max(nodes.Count()*2, 32u));
+    for (uint32 i = 0; i < nodes.Count(); i++)
+        grid.nodeIndices.Add(uint32(nodes[i].handle), i);
+
+    ImVec2 minPt(FLT_MAX, FLT_MAX);
+    ImVec2 maxPt(-FLT_MAX, -FLT_MAX);
+    for (const GuiNodeGraphNode& uiNode : nodes) {
+        if (uiNode.size.x > 0) {
+            minPt = ImVec2(Min(minPt.x, uiNode.pos.x), Min(minPt.y, uiNode.pos.y));
+            maxPt = ImVec2(Max(maxPt.x, uiNode.pos.x + uiNode.size.x), Max(maxPt.y, uiNode.pos.y + uiNode.size.y));
+        }
+    }
+    if (minPt.x > maxPt.x)
+        return;
+
+    // Sparse graphs spread over a huge area get bigger cells, so the grid stays small
+    float cellSize = kGuiNodeGraphCellSize;
+    while ((uint64((maxPt.x - minPt.x)/cellSize) + 1)*(uint64((maxPt.y - minPt.y)/cellSize) + 1) > kGuiNodeGraphMaxCells)
+        cellSize *= 2.0f;
+
+    grid.origin = minPt;
+    grid.cellSize = cellSize;
+    grid.numCols = uint32((maxPt.x - minPt.x)/cellSize) + 1;
+    grid.numRows = uint32((maxPt.y - minPt.y)/cellSize) + 1;
+
+    auto GetCellRange = [&grid](const GuiNodeGraphNode& uiNode, uint32* x0, uint32* y0, uint32* x1, uint32* y1) {
+        *x0 = Min(uint32((uiNode.pos.x - grid.origin.x)/grid.cellSize), grid.numCols - 1);
+        *y0 = Min(uint32((uiNode.pos.y - grid.origin.y)/grid.cellSize), grid.numRows - 1);
+        *x1 = Min(uint32((uiNode.pos.x + uiNode.size.x - grid.origin.x)/grid.cellSize), grid.numCols - 1);
+        *y1 = Min(uint32((uiNode.pos.y + uiNode.size.y - grid.origin.y)/grid.cellSize), grid.numRows - 1);
+    };
+
+    // Counting sort: Count the nodes of each cell, turn them into offsets, then fill the items
+    uint32 numCells = grid.numCols*grid.numRows;
+    grid.cellStart.Reserve(numCells + 1);
+    for (uint32 i = 0; i <= numCells; i++)
+        grid.cellStart.Push(0);
+
+    uint32 x0, y0, x1, y1;
+    for (const GuiNodeGraphNode& uiNode : nodes) {
+        if (uiNode.size.x > 0) {
+            GetCellRange(uiNode, &x0, &y0, &x1, &y1);
+            for (uint32 y = y0; y <= y1; y++) {
+                for (uint32 x = x0; x <= x1; x++)
+                    ++grid.cellStart[y*grid.numCols + x + 1];
+            }
+        }
+    }
+
+    for (uint32 i = 0; i < numCells; i++)
+        grid.cellStart[i + 1] += grid.cellStart[i];
+
+    grid.items.Reserve(grid.cellStart[numCells]);
+    for (uint32 i = 0; i < grid.cellStart[numCells]; i++)
+        grid.items.Push(0);
+
+    MemTempAllocator tmpAlloc;
+    uint32* cellCount = tmpAlloc.MallocZeroTyped<uint32>(numCells);
+    for (uint32 i = 0; i < nodes.Count(); i++) {
+        if (nodes[i].size.x > 0) {
+            GetCellRange(nodes[i], &x0, &y0, &x1, &y1);
+            for (uint32 y = y0; y <= y1; y++) {
+                for (uint32 x = x0; x <= x1; x++) {
+                    uint32 cell = y*grid.numCols + x;
+                    grid.items[grid.cellStart[cell] + cellCount[cell]++] = i;
+                }
+            }
+        }
+    }
+}
+
+// Progress callbacks come in for many nodes per frame on big graphs, so use the grid's lookup table while it matches mNodes
+static uint32 GuiNodeGraph_FindNode(GuiNodeGraph* uigraph, NodeHandle handle)
+{
+    const GuiNodeGraphGrid& grid = uigraph->mGrid;
+    if (!grid.dirty && grid.numNodes) {
+        uint32 index = grid.nodeIndices.Find(uint32(handle));
+        if (index != INVALID_INDEX) {
+            uint32 nodeIndex = grid.nodeIndices.Get(index);
+            if (uigraph->mNodes[nodeIndex].handle == handle)
+                return nodeIndex;
+        }
+    }
+
+    return uigraph->mNodes.FindIf([handle](const GuiNodeGraphNode& n) { return n.handle == handle; });
+}
+
+static inline bool GuiNodeGraph_Overlaps(const ImVec2& minA, const ImVec2& maxA, const ImVec2& minB, const ImVec2& maxB)
+{
+    return minA.x <= maxB.x && maxA.x >= minB.x && minA.y <= maxB.y && maxA.y >= minB.y;
+}
+
+// Marks the nodes that should be submitted this frame (visibleFrame) and outputs the links that should be submitted
+// Returns the number of nodes that are inside the view
+static uint32 GuiNodeGraph_CullNodes(GuiNodeGraph* uigraph, const ImVec2& viewMin, const ImVec2& viewMax, Array<uint32>* outLinks)
+{
+    GuiNodeGraphGrid& grid = uigraph->mGrid;
+    Array<GuiNodeGraphNode>& nodes = uigraph->mNodes;
+    int frame = ImGui::GetFrameCount();
+
+    if (grid.dirty)
+        GuiNodeGraph_BuildGrid(uigraph);
+
+    uint32 numVisible = 0;
+    if (grid.numCols) {
+        uint32 x0 = uint32(Clamp((viewMin.x - grid.origin.x)/grid.cellSize, 0.0f, float(grid.numCols - 1)));
+        uint32 y0 = uint32(Clamp((viewMin.y - grid.origin.y)/grid.cellSize, 0.0f, float(grid.numRows - 1)));
+        uint32 x1 = uint32(Clamp((viewMax.x - grid.origin.x)/grid.cellSize, 0.0f, float(grid.numCols - 1)));
+        uint32 y1 = uint32(Clamp((viewMax.y - grid.origin.y)/grid.cellSize, 0.0f, float(grid.numRows - 1)));
+
+        for (uint32 y = y0; y <= y1; y++) {
+            for (uint32 x = x0; x <= x1; x++) {
+                uint32 cell = y*grid.numCols + x;
+                for (uint32 i = grid.cellStart[cell]; i < grid.cellStart[cell + 1]; i++) {
+                    GuiNodeGraphNode& uiNode = nodes[grid.items[i]];
+                    // Nodes that span multiple cells are visited more than once
+                    if (uiNode.visibleFrame != frame && GuiNodeGraph_Overlaps(uiNode.pos, uiNode.pos + uiNode.size, viewMin, viewMax)) {
+                        uiNode.visibleFrame = frame;
+                        ++numVisible;
+                    }
+                }
+            }
+        }
+    }
+
+    // Nodes that are not measured yet, and the selected ones. imnodes keeps the selection by node slot, it breaks if they are dropped
+    for (GuiNodeGraphNode& uiNode : nodes) {
+        if (uiNode.size.x <= 0 || uiNode.setPos)
+            uiNode.visibleFrame = frame;
+    }
+    for (NodeHandle handle : uigraph->mSelectedNodes) {
+        uint32 index = grid.nodeIndices.Find(uint32(handle));
+        if (index != INVALID_INDEX)
+            nodes[grid.nodeIndices.Get(index)].visibleFrame = frame;
+    }
+
+    // Links only need their bounds to overlap the view, but then both of the end nodes must be submitted, even if they are outside
+    // Nodes that are not in mNodes are the params node, which is always submitted
+    GuiNodeGraphNode paramsNode {
+        .pos = uigraph->mParamsNodePos,
+        .size = ImVec2(Max(uigraph->mParamsNodeWidth, 1.0f), 1.0f),
+        .visibleFrame = frame
+    };
+    auto GetLinkNode = [&grid, &nodes, &paramsNode](NodeHandle handle)->GuiNodeGraphNode& {
+        uint32 index = grid.nodeIndices.Find(uint32(handle));
+        return index != INVALID_INDEX ? nodes[grid.nodeIndices.Get(index)] : paramsNode;
+    };
+
+    for (uint32 i = 0; i < uigraph->mLinks.Count(); i++) {
+        const Link& link = ngGetLinkData(uigraph->mGraph, uigraph->mLinks[i].handle);
+        GuiNodeGraphNode& nodeA = GetLinkNode(link.nodeA);
+        GuiNodeGraphNode& nodeB = GetLinkNode(link.nodeB);
+
+        bool visible = nodeA.size.x <= 0 || nodeB.size.x <= 0;
+        if (!visible) {
+            ImVec2 linkMin(Min(nodeA.pos.x, nodeB.pos.x), Min(nodeA.pos.y, nodeB.pos.y));
+            ImVec2 linkMax(Max(nodeA.pos.x + nodeA.size.x, nodeB.pos.x + nodeB.size.x), 
+                           Max(nodeA.pos.y + nodeA.size.y, nodeB.pos.y + nodeB.size.y));
+            visible = GuiNodeGraph_Overlaps(linkMin, linkMax, viewMin, viewMax);
+        }
+
+        if (visible) {
+            nodeA.visibleFrame = frame;
+            nodeB.visibleFrame = frame;
+            outLinks->Push(i);
+        }
+    }
+
+    return numVisible;
+}
+
+// Called after ImNodes::EndNode. Nodes that move or resize invalidate the grid
+static void GuiNodeGraph_UpdateNodeRect(GuiNodeGraph* uigraph, GuiNodeGraphNode& uiNode)
+{
+    int id = int(uint32(uiNode.handle));
+    ImNodes::SnapNodeToGrid(id);
+
+    ImVec2 pos = ImNodes::GetNodeGridSpacePos(id);
+    ImVec2 size = ImNodes::GetNodeDimensions(id);
+    if (pos.x != uiNode.pos.x || pos.y != uiNode.pos.y || size.x != uiNode.size.x || size.y != uiNode.size.y)
+        uigraph->mGrid.dirty = true;
+    uiNode.pos = pos;
+    uiNode.size = size;
+    uiNode.culled = false;
+}
+
+// Level of detail: Only the title and the pins (links still need their end points), without any widgets
+static void GuiNodeGraph_RenderNodeLod(GuiNodeGraph* uigraph, GuiNodeGraphNode& uiNode, Node& node)
+{
+    const char* title = node.impl->GetTitleUI(uigraph->mGraph, uiNode.handle);
+    if (title == nullptr || title[0] == 0)
+        title = node.desc.name;
+    float titleWidth = ImGui::CalcTextSize(title).x;
+
+    ImNodes::BeginNode(uint32(uiNode.handle));
+    ImNodes::BeginNodeTitleBar();
+    ImGui::TextUnformatted(title);
+    ImNodes::EndNodeTitleBar();
+
+    for (PinHandle pinHandle : node.inPins) {
+        const Pin& pin = ngGetPinData(uigraph->mGraph, pinHandle);
+        ImNodes::BeginInputAttribute(uint32(pinHandle), !pin.desc.optional ? ImNodesPinShape_CircleFilled : ImNodesPinShape_TriangleFilled);
+        ImGui::Dummy(ImVec2(titleWidth, kGuiNodeGraphLodPinHeight));
+        ImNodes::EndInputAttribute();
+    }
+
+    for (PinHandle pinHandle : node.outPins) {
+        const Pin& pin = ngGetPinData(uigraph->mGraph, pinHandle);
+        ImNodes::BeginOutputAttribute(uint32(pinHandle), !pin.desc.optional ? ImNodesPinShape_CircleFilled : ImNodesPinShape_TriangleFilled);
+        ImGui::Dummy(ImVec2(titleWidth, kGuiNodeGraphLodPinHeight));
+        ImNodes::EndOutputAttribute();
+    }
+
+    ImNodes::EndNode();
+}
+
 void GuiNodeGraph::Render()
 {
     MemTempAllocator tmpAlloc;
+    uint64 startTm = timerGetTicks();
 
     bool debugMode = mDebugMode;
     bool readOnly = debugMode || mDisableEdit;
@@ -452,6 +694,7 @@ void GuiNodeGraph::Render()
                                 uint32 nodeIdx = mNodes.FindIf([handle](const GuiNodeGraphNode& n) { return n.handle == handle; });
                                 ASSERT(nodeIdx != INVALID_INDEX);
                                 mNodes.RemoveAndSwap(nodeIdx);
+                                mGrid.dirty = true;
                                 ngDestroyNode(mGraph, handle);
                             }
                         }
@@ -477,6 +720,7 @@ void GuiNodeGraph::Render()
                     if (ImGui::MenuItem("Duplicate", nullptr, nullptr, !readOnly)) {
                         NodeHandle newHandle = ngDuplicateNode(mGraph, nodeHandle);
                         mNodes.Push(GuiNodeGraphNode { .handle = newHandle });
+                        mGrid.dirty = true;
                         ImNodes::SetNodeScreenSpacePos(int(uint32(newHandle)), ImGui::GetMousePos());
                         mUnsavedChanges = true;
                     }
@@ -489,6 +733,7 @@ void GuiNodeGraph::Render()
                     ImGui::Separator();
                     if (ImGui::MenuItem("Delete", nullptr, nullptr, !readOnly)) {
                         mNodes.RemoveAndSwap(nodeIdx);
+                        mGrid.dirty = true;
                         ngDestroyNode(mGraph, nodeHandle);
                         mUnsavedChanges = true;
                     }
@@ -543,6 +788,7 @@ void GuiNodeGraph::Render()
                                     if (ImGui::MenuItem(nodeNames[i].second)) {
                                         NodeHandle newHandle = ngCreateNode(mGraph, nodeNames[i].second);
                                         mNodes.Push(GuiNodeGraphNode { .handle = newHandle });
+                                        mGrid.dirty = true;
                                         ImNodes::SetNodeScreenSpacePos(int(uint32(newHandle)), mContextMenuPos);
                                         mUnsavedChanges = true;
                                         mContextMenuMousePosSet = false;
@@ -646,11 +892,37 @@ void GuiNodeGraph::Render()
             ImNodes::PopColorStyle();
         }
 
+        // -------------------------------------------------------------------------------------------------------------
+        // Culling: The minimap needs all the nodes
+        Array<uint32> visibleLinks(&tmpAlloc);
+        int frame = ImGui::GetFrameCount();
+        if (!mShowMiniMap && mNodes.Count() >= kGuiNodeGraphCullMinNodes) {
+            // We are inside the editor's child window. Grid space = editor space - panning
+            ImVec2 viewMin = ImVec2(-mPan.x, -mPan.y) - ImVec2(kGuiNodeGraphCullMargin, kGuiNodeGraphCullMargin);
+            ImVec2 viewMax = ImVec2(-mPan.x, -mPan.y) + ImGui::GetWindowSize() + ImVec2(kGuiNodeGraphCullMargin, kGuiNodeGraphCullMargin);
+            uint32 numInView = GuiNodeGraph_CullNodes(this, viewMin, viewMax, &visibleLinks);
+            mLod = mLod ? numInView > kGuiNodeGraphLodExitNodes : numInView > kGuiNodeGraphLodEnterNodes;
+        }
+        else {
+            for (GuiNodeGraphNode& uiNode : mNodes)
+                uiNode.visibleFrame = frame;
+            for (uint32 i = 0; i < mLinks.Count(); i++)
+                visibleLinks.Push(i);
+            mLod = false;
+        }
+
         // -------------------------------------------------------------------------------------------------------------    
         // Nodes
+        mStats.numVisibleNodes = 0;
         for (GuiNodeGraphNode& uiNode : mNodes) {
+            if (uiNode.visibleFrame != frame) {
+                uiNode.culled = true;
+                continue;
+            }
+
             NodeHandle nodeHandle = uiNode.handle;
             Node& node = ngGetNodeData(mGraph, nodeHandle);
+            ++mStats.numVisibleNodes;
 
             if (uiNode.state != GuiNodeGraphNode::State::Idle && !node.desc.constant) {
                 uint32 titleCol = GuiNodeGraph_GetStateColor(uiNode);
@@ -675,6 +947,19 @@ void GuiNodeGraph::Render()
                 ImNodes::SetNodeScreenSpacePos(int(uint32(nodeHandle)), uiNode.pos);
                 uiNode.setPos = false;
             }
+            else if (uiNode.culled) {
+                ImNodes::SetNodeGridSpacePos(int(uint32(nodeHandle)), uiNode.pos);
+            }
+
+            if (mLod) {
+                GuiNodeGraph_RenderNodeLod(this, uiNode, node);
+                GuiNodeGraph_UpdateNodeRect(this, uiNode);
+
+                ImNodes::PopColorStyle();
+                ImNodes::PopColorStyle();
+                ImNodes::PopColorStyle();
+                continue;
+            }
 
             ImNodes::BeginNode(uint32(nodeHandle));
 
@@ -715,13 +1000,17 @@ void GuiNodeGraph::Render()
                     ICON_FA_HOURGLASS_END
                 };
 
-                uiNode.hourglassTime += 1.0f / ImGui::GetIO().Framerate;
+                uiNode.hourglassTime += ImGui::GetIO().DeltaTime;
                 if (uiNode.hourglassTime >= 0.2f) {
                     int numImages = CountOf(hourglass);
                     uiNode.hourglassIndex = (uiNode.hourglassIndex + 1) % numImages;
                     uiNode.hourglassTime = 0;
                 }
                 ImGui::TextUnformatted(hourglass[uiNode.hourglassIndex]);
+                if (ImGui::IsItemHovered() && uiNode.hasProgress) {
+                    ImGui::SetTooltip("Last update: %u started, %u succeeded, %u failed", 
+                                      uiNode.progress.numStarted, uiNode.progress.numSucceeded, uiNode.progress.numFailed);
+                }
                 didSameLine = true;
             }
             else if (uiNode.state == GuiNodeGraphNode::State::Failed) {
@@ -930,11 +1219,10 @@ void GuiNodeGraph::Render()
             }
 
             ImNodes::EndNode();
-            ImNodes::SnapNodeToGrid(uint32(nodeHandle));
+            GuiNodeGraph_UpdateNodeRect(this, uiNode);
             
             if (uiNode.width == 0)
-                uiNode.width = ImNodes::GetNodeDimensions(uint32(nodeHandle)).x;
-            uiNode.pos = ImNodes::GetNodeGridSpacePos(uint32(nodeHandle));
+                uiNode.width = uiNode.size.x;
 
 
             ImNodes::PopColorStyle();
@@ -944,7 +1232,9 @@ void GuiNodeGraph::Render()
 
         // -------------------------------------------------------------------------------------------------------------
         // Links
-        for (GuiNodeGraphLink uiLink : mLinks) {
+        mStats.numVisibleLinks = visibleLinks.Count();
+        for (uint32 linkIndex : visibleLinks) {
+            GuiNodeGraphLink uiLink = mLinks[linkIndex];
             const Link& link = ngGetLinkData(mGraph, uiLink.handle);
 
             // Check if link connects to a selected node, then highlight those
@@ -988,6 +1278,7 @@ void GuiNodeGraph::Render()
                         .pos = ImGui::GetMousePos(),
                         .setPos = true
                     });
+                    mGrid.dirty = true;
                 }
             }
 
@@ -1014,6 +1305,7 @@ void GuiNodeGraph::Render()
                                 .pos = ImGui::GetMousePos(),
                                 .setPos = true
                     });
+                    mGrid.dirty = true;
 
                     {
                         ImportPropertiesData* data = memAllocZeroTyped<ImportPropertiesData>();
@@ -1103,6 +1395,9 @@ void GuiNodeGraph::Render()
             uiNode.textView->Render(node.outputText, windowId);
         }
     }
+
+    float renderTime = float(timerToMS(timerDiff(timerGetTicks(), startTm)));
+    mStats.renderTime = mStats.renderTime > 0 ? mathLerp(mStats.renderTime, renderTime, 0.1f) : renderTime;
 }
 
 void GuiNodeGraph::ResetTextViews()
@@ -1117,6 +1412,7 @@ void GuiNodeGraph::ResetStates()
 {
     for (GuiNodeGraphNode& uiNode : mNodes) {
         uiNode.state = GuiNodeGraphNode::State::Idle;
+        uiNode.hasProgress = false;
     }
 
     for (GuiNodeGraphLink& uiLink : mLinks) {
@@ -1134,14 +1430,16 @@ void GuiNodeGraph::DeleteLink(LinkHandle handle)
 
 void GuiNodeGraph::NodeIdle(NodeHandle handle, bool stranded)
 {
-    uint32 index = mNodes.FindIf([handle](const GuiNodeGraphNode& n) { return n.handle == handle; });
-    if (index != INVALID_INDEX)
+    uint32 index = GuiNodeGraph_FindNode(this, handle);
+    if (index != INVALID_INDEX) {
         mNodes[index].state = stranded ? GuiNodeGraphNode::State::Stranded : GuiNodeGraphNode::State::Idle;
+        mNodes[index].hasProgress = false;
+    }
 }
 
 void GuiNodeGraph::NodeStarted(NodeHandle handle)
 {
-    uint32 index = mNodes.FindIf([handle](const GuiNodeGraphNode& n) { return n.handle == handle; });
+    uint32 index = GuiNodeGraph_FindNode(this, handle);
     if (index != INVALID_INDEX) {
         mNodes[index].hourglassTime = 0;
         mNodes[index].hourglassIndex = 0;
@@ -1151,9 +1449,20 @@ void GuiNodeGraph::NodeStarted(NodeHandle handle)
 
 void GuiNodeGraph::NodeFinished(NodeHandle handle, bool withError)
 {
-    uint32 index = mNodes.FindIf([handle](const GuiNodeGraphNode& n) { return n.handle == handle; });
-    if (index != INVALID_INDEX)
+    uint32 index = GuiNodeGraph_FindNode(this, handle);
+    if (index != INVALID_INDEX) {
         mNodes[index].state = withError ? GuiNodeGraphNode::State::Failed : GuiNodeGraphNode::State::Success;
+        mNodes[index].hasProgress = false;
+    }
+}
+
+void GuiNodeGraph::NodeProgress(NodeHandle handle, const NodeGraphProgressCounters& counters)
+{
+    uint32 index = GuiNodeGraph_FindNode(this, handle);
+    if (index != INVALID_INDEX) {
+        mNodes[index].progress = counters;
+        mNodes[index].hasProgress = true;
+    }
 }
 
 void GuiNodeGraph::LinkFinished(LinkHandle handle)
@@ -1166,6 +1475,7 @@ void GuiNodeGraph::LinkFinished(LinkHandle handle)
 void GuiNodeGraph::CreateNode(NodeHandle handle)
 {
     mNodes.Push(GuiNodeGraphNode { .handle = handle });
+    mGrid.dirty = true;
 }
 
 void GuiNodeGraph::CreateLink(LinkHandle handle) 
@@ -1173,11 +1483,9 @@ void GuiNodeGraph::CreateLink(LinkHandle handle)
     mLinks.Push(GuiNodeGraphLink { .handle = handle });
 }
 
-bool ngSaveLayout(const char* filepath, const GuiNodeGraph& uigraph, bool savePropertyValues)
+void ngSaveLayout(const char* filepath, const GuiNodeGraph& uigraph, bool savePropertyValues)
 {
-    MemTempAllocator tmpAlloc;
-    
-    sjson_context* jctx = sjson_create_context(0, 0, &tmpAlloc);
+    sjson_context* jctx = sjson_create_context(0, 0, memDefaultAlloc());
     ASSERT_ALWAYS(jctx, "Out of memory?");
     sjson_node* jroot = sjson_mkobject(jctx);
     char uuidStr[64];
@@ -1213,19 +1521,7 @@ bool ngSaveLayout(const char* filepath, const GuiNodeGraph& uigraph, bool savePr
         sjson_put_floats(jctx, jsettings, "Pan", &uigraph.mPan.x, 2);
     }
 
-    char* jsonText = sjson_stringify(jctx, jroot, "\t");
-    File f;
-    if (!f.Open(filepath, FileOpenFlags::Write)) {
-        logError("Cannot open file for writing: %s", filepath);
-        return false;
-    }
-
-    f.Write(jsonText, strLen(jsonText));
-    f.Close();
-
-    sjson_free_string(jctx, jsonText);
-    sjson_destroy_context(jctx);    
-    return true;
+    saveSubmitJson(filepath, jctx, jroot);
 }
 
 bool ngLoadLayout(const char* filepath, GuiNodeGraph& uigraph)
@@ -1234,76 +1530,66 @@ bool ngLoadLayout(const char* filepath, GuiNodeGraph& uigraph)
 
     ImNodes::EditorContextSet(uigraph.mEditorCtx);
 
-    File f;
-    if (!f.Open(filepath, FileOpenFlags::Read | FileOpenFlags::SeqScan)) {
+    saveFlush();
+    FileMapping mapping;
+    if (!mapping.Open(filepath)) {
         logError("Opening file failed: %s", filepath);
         return false;
     }
 
-    if (f.GetSize() == 0) {
-        logError("Empty file: %s", filepath);
-        return false;
-    }
-
-    size_t fileSize = f.GetSize();
-    char* jsonText = (char*)tmpAlloc.Malloc(fileSize + 1);
-    f.Read<char>(jsonText, (uint32)fileSize);
-    jsonText[fileSize] = '\0';
-    f.Close();
-
-    sjson_context* jctx = sjson_create_context(0, 0, &tmpAlloc);
-    ASSERT_ALWAYS(jctx, "Out of memory?");
-    sjson_node* jroot = sjson_decode(jctx, jsonText);
-    if (!jroot) {
-        logError("Parsing json failed: %s", filepath);
+    JsonErrorLocation errLoc {};
+    JsonContext* jctx = jsonParse((const char*)mapping.Data(), uint32(mapping.Size()), &errLoc, &tmpAlloc);
+    if (!jctx) {
+        logError("Parsing json failed: %s (Line: %u, Column: %u)", filepath, errLoc.line, errLoc.col);
+        mapping.Close();
         return false;
     }
+    JsonNode jroot(jctx);
 
     {
-        sjson_node* jprop = sjson_find_member(jroot, "Parameters");
-        ASSERT(jprop);
+        JsonNode jprop = jroot.GetChild("Parameters");
+        ASSERT(jprop.IsValid());
         
-        ImVec2 pos;
-        sjson_get_floats(&pos.x, 2, jprop, "Pos");
+        ImVec2 pos {};
+        jprop.GetChildArrayValues<float>("Pos", &pos.x, 2);
         ImNodes::SetNodeGridSpacePos(uigraph.mParamsNode, pos);
-        uigraph.mParamsNodeMaxWidth = sjson_get_float(jprop, "MaxWidth", 150.0f);
+        uigraph.mParamsNodeMaxWidth = jprop.GetChildValue<float>("MaxWidth", 150.0f);
         
         ngLoadPropertiesFromJson(uigraph.mGraph, jprop);
     }
 
     {
         SysUUID uuidNode;
+        char nodeId[64];
 
-        sjson_node* jnodes = sjson_find_member(jroot, "Nodes");
-        ASSERT(jnodes);
+        JsonNode jnodes = jroot.GetChild("Nodes");
+        ASSERT(jnodes.IsValid());
 
-        sjson_node* jnode = sjson_first_child(jnodes);
-        while (jnode) {
-            const char* nodeId = sjson_get_string(jnode, "Id", "");
+        for (JsonNode jnode = jnodes.GetArrayItem(); jnode.IsValid(); jnode = jnodes.GetNextArrayItem(jnode)) {
+            jnode.GetChildValue("Id", nodeId, sizeof(nodeId));
             if (sysUUIDFromString(&uuidNode, nodeId)) {
                 NodeHandle handle = ngFindNodeById(uigraph.mGraph, uuidNode);
                 if (handle.IsValid()) {
-                    ImVec2 pos;
-                    sjson_get_floats(&pos.x, 2, jnode, "Pos");
+                    ImVec2 pos {};
+                    jnode.GetChildArrayValues<float>("Pos", &pos.x, 2);
                     ImNodes::SetNodeGridSpacePos(uint32(handle), pos);
                 }
             }
-
-            jnode = jnode->next;
         }
     }
     
     {
-        sjson_node* jsettings = sjson_find_member(jroot, "Settings");
+        JsonNode jsettings = jroot.GetChild("Settings");
         
-        if (jsettings) {
-            uigraph.mShowMiniMap = sjson_get_bool(jsettings, "Minimap", false);
-            sjson_get_floats(&uigraph.mPan.x, 2, jsettings, "Pan");
+        if (jsettings.IsValid()) {
+            uigraph.mShowMiniMap = jsettings.GetChildValue<bool>("Minimap", false);
+            jsettings.GetChildArrayValues<float>("Pan", &uigraph.mPan.x, 2);
             ImNodes::EditorContextResetPanning(uigraph.mPan);
         }
     }
 
-    sjson_destroy_context(jctx);
+    // The values are read from the mapped text, so close it after we are done with the tokens
+    jsonDestroy(jctx);
+    mapping.Close();
     return true;
-
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "NodeGraph.h"
+#include "Core/Hash.h"
 #include "ImGui/ImGuiAll.h"
 
 struct GuiTextView;
@@ -9,7 +10,8 @@ struct GuiNodeGraph;
 struct GuiNodeGraphNode
 {
     NodeHandle handle;
-    ImVec2 pos;
+    ImVec2 pos;         // Grid space. Except when setPos is set, then it's in screen space
+    ImVec2 size;        // Zero until the node is submitted once
     float width;
     GuiTextView* textView;
     float hourglassTime;
@@ -18,6 +20,10 @@ struct GuiNodeGraphNode
     bool editOutPins;
     bool refocusOutput;
     bool setPos;
+    bool culled;        // imnodes drops the nodes that are not submitted, position is restored when it's visible again
+    int visibleFrame;
+    bool hasProgress;   // Progress counters of the current run are received, they are shown until the next ones come in
+    NodeGraphProgressCounters progress;
 
     enum class State
     {
@@ -37,6 +43,28 @@ struct GuiNodeGraphLink
     bool finished;
 };
 
+// Uniform grid over the node rectangles (grid space), for finding the nodes in the view without going through all of them
+// Cells are stored flat: items of cell N are items[cellStart[N]..cellStart[N+1]). Rebuilt only after nodes move, resize, or are added/removed
+struct GuiNodeGraphGrid
+{
+    ImVec2 origin;
+    float cellSize;
+    uint32 numCols;
+    uint32 numRows;
+    uint32 numNodes;
+    Array<uint32> cellStart;
+    Array<uint32> items;            // Indexes to GuiNodeGraph::mNodes
+    HashTable<uint32> nodeIndices;  // NodeHandle -> Index to GuiNodeGraph::mNodes
+    bool dirty;                     // Set on every add/remove to mNodes, the indexes above are stale until the rebuild
+};
+
+struct GuiNodeGraphStats
+{
+    uint32 numVisibleNodes;
+    uint32 numVisibleLinks;
+    float renderTime;               // Milliseconds, smoothed
+};
+
 enum class GuiNodeGraphContextMenu
 {
     None = 0,
@@ -79,6 +107,9 @@ struct GuiNodeGraph final : NodeGraphEvents
     PinHandle mEditingPinHandle;
     char mEditingPinName[64];
     GuiNodeGraphEvents* mEvents = nullptr;
+    GuiNodeGraphGrid mGrid = {};
+    GuiNodeGraphStats mStats = {};
+    bool mLod = false;              // Too many nodes in the view, only draw boxes with titles and pins
 
     // This is triggered on implicit deletion of links (ngDestroyNode)
     void CreateNode(NodeHandle handle) override;
@@ -88,6 +119,7 @@ struct GuiNodeGraph final : NodeGraphEvents
     void NodeStarted(NodeHandle handle) override;
     void NodeFinished(NodeHandle handle, bool withError) override;
     void LinkFinished(LinkHandle handle) override;
+    void NodeProgress(NodeHandle handle, const NodeGraphProgressCounters& counters) override;
     
     void ResetTextViews();
     void ResetStates();
@@ -97,6 +129,6 @@ struct GuiNodeGraph final : NodeGraphEvents
     void Release();
 };
 
-bool ngSaveLayout(const char* filepath, const GuiNodeGraph& uigraph, bool savePropertyValues = false);
+void ngSaveLayout(const char* filepath, const GuiNodeGraph& uigraph, bool savePropertyValues = false);   // Written on the save thread
 bool ngLoadLayout(const char* filepath, GuiNodeGraph& uigraph);
 
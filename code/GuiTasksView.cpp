@@ -19,6 +19,16 @@ struct GuiTaskViewData
         Failed
     };
 
+    // Analytics of the overview popup. Only recomputed when the stats version of the graph changes
+    struct OverviewStats
+    {
+        TskGraphHandle graphHandle;
+        uint32 version;
+        bool hasGraphStats;
+        TskDurationStats graphStats;
+        Span<TskEventStats> eventStats;
+    };
+
     struct Item
     {
         char* text;
@@ -28,6 +38,7 @@ struct GuiTaskViewData
         TskEventHandle eventHandle;
         Item* firstChild;
         Item* next;
+        bool isSubEvent;    // Listed under the outer event's item instead of the top level
     };
 
     Mutex mutex;
@@ -40,9 +51,110 @@ struct GuiTaskViewData
     Item* hoveredItem = nullptr;
     bool hoveredItemIsChild = false;
     bool showOverview = false;
+    OverviewStats overview = {};
 };
 
-static void RenderGraphOverview(TskGraphHandle graphHandle)
+static void FreeOverviewStats(GuiTaskViewData::OverviewStats* overview)
+{
+    for (TskEventStats& eventStat : overview->eventStats)
+        memFree(eventStat.samples);
+    memFree(overview->eventStats.Ptr());
+    *overview = GuiTaskViewData::OverviewStats {};
+}
+
+static void UpdateOverviewStats(GuiTaskViewData::OverviewStats* overview, TskGraphHandle graphHandle)
+{
+    uint32 version = tskGetStatsVersion(graphHandle);
+    if (overview->graphHandle == graphHandle && overview->version == version)
+        return;
+
+    FreeOverviewStats(overview);
+    overview->graphHandle = graphHandle;
+    overview->version = version;
+    overview->hasGraphStats = tskGetGraphStats(graphHandle, &overview->graphStats);
+    overview->eventStats = tskGetEventStats(graphHandle, memDefaultAlloc());
+}
+
+static void RenderDurationStats(const char* label, const TskDurationStats& stats)
+{
+    char p50[64], p90[64], p99[64];
+    MakeTimeFormat(stats.p50, p50, sizeof(p50));
+    MakeTimeFormat(stats.p90, p90, sizeof(p90));
+    MakeTimeFormat(stats.p99, p99, sizeof(p99));
+    ImGui::Text("%s: %u  p50: %s  p90: %s  p99: %s  trend: %+.2fs/run", label, stats.numSamples, p50, p90, p99, stats.trend);
+
+    if (stats.regressed) {
+        char last[64], baseline[64];
+        MakeTimeFormat(stats.last, last, sizeof(last));
+        MakeTimeFormat(stats.baseline, baseline, sizeof(baseline));
+        ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.9f, 0.5f, 0, 1.0f));
+        ImGui::Text(ICON_FA_EXCLAMATION_TRIANGLE " Last run regressed: %s (baseline %s)", last, baseline);
+        ImGui::PopStyleColor();
+    }
+}
+
+static void RenderEventStats(const Span<TskEventStats>& eventStats)
+{
+    const ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_ScrollY | 
+                                  ImGuiTableFlags_SizingFixedFit;
+    float height = Min(float(eventStats.Count() + 1)*ImGui::GetFrameHeightWithSpacing(), 300.0f);
+    if (!ImGui::BeginTable("##EventStats", 6, flags, ImVec2(-1, height)))
+        return;
+
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Step", ImGuiTableColumnFlags_WidthStretch);
+    ImGui::TableSetupColumn("p50");
+    ImGui::TableSetupColumn("p90");
+    ImGui::TableSetupColumn("p99");
+    ImGui::TableSetupColumn("Trend");
+    ImGui::TableSetupColumn("History", ImGuiTableColumnFlags_WidthFixed, 120.0f);
+    ImGui::TableHeadersRow();
+
+    char durStr[64];
+    for (uint32 i = 0; i < eventStats.Count(); i++) {
+        const TskEventStats& eventStat = eventStats[i];
+        const TskDurationStats& stats = eventStat.stats;
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        if (stats.regressed) {
+            ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.9f, 0.5f, 0, 1.0f));
+            ImGui::Text(ICON_FA_EXCLAMATION_TRIANGLE " %s", eventStat.title.CStr());
+            ImGui::PopStyleColor();
+            if (ImGui::IsItemHovered()) {
+                char baseline[64];
+                MakeTimeFormat(stats.last, durStr, sizeof(durStr));
+                MakeTimeFormat(stats.baseline, baseline, sizeof(baseline));
+                ImGui::SetTooltip("Last: %s, Baseline: %s", durStr, baseline);
+            }
+        }
+        else {
+            ImGui::TextUnformatted(eventStat.title.CStr());
+        }
+
+        ImGui::TableNextColumn();
+        MakeTimeFormat(stats.p50, durStr, sizeof(durStr));
+        ImGui::TextUnformatted(durStr);
+        ImGui::TableNextColumn();
+        MakeTimeFormat(stats.p90, durStr, sizeof(durStr));
+        ImGui::TextUnformatted(durStr);
+        ImGui::TableNextColumn();
+        MakeTimeFormat(stats.p99, durStr, sizeof(durStr));
+        ImGui::TextUnformatted(durStr);
+        ImGui::TableNextColumn();
+        ImGui::Text("%+.2fs", stats.trend);
+
+        ImGui::TableNextColumn();
+        ImGui::PushID(int(i));
+        ImGui::PlotLines("##Spark", eventStat.samples, int(eventStat.numSamples), 0, nullptr, 0, FLT_MAX, 
+                         ImVec2(-1, ImGui::GetTextLineHeight()));
+        ImGui::PopID();
+    }
+
+    ImGui::EndTable();
+}
+
+static void RenderGraphOverview(GuiTaskViewData* data, TskGraphHandle graphHandle)
 {
     auto CloseModal = []() {
         ImGui::CloseCurrentPopup();
@@ -52,6 +164,7 @@ static void RenderGraphOverview(TskGraphHandle graphHandle)
     ImGui::SetNextWindowSizeConstraints(ImVec2(450, 300), ImVec2(1024, 1024));
     if (ImGui::BeginPopupModal("TaskOverview")) {
         Span<TskSummary> history = tskGetHistory(graphHandle, &tmpAlloc);
+        UpdateOverviewStats(&data->overview, graphHandle);
 
         Path graphPath = wksGetWorkspaceFilePath(GetWorkspace(), tskGetFileHandle(graphHandle));
         ImGui::LabelText("##GraphPath", graphPath.CStr());
@@ -68,12 +181,21 @@ static void RenderGraphOverview(TskGraphHandle graphHandle)
         ImGui::Separator();
         if (history.Count()) {
             imguiPlotDateDuration("##TaskTimes", PlotGetter, &history, history.Count(), 0, nullptr, FLT_MAX, FLT_MAX, ImVec2(-1, 120));
+
+            if (data->overview.hasGraphStats)
+                RenderDurationStats("Runs", data->overview.graphStats);
+
             imguiAlignRight([graphHandle]() { if (ImGui::Button("Clear")) { tskClearHistory(graphHandle); }});
         }
         else {
             ImGui::TextUnformatted("[No history available]");
         }
 
+        if (data->overview.eventStats.Count()) {
+            ImGui::Separator();
+            RenderEventStats(data->overview.eventStats);
+        }
+
         ImGui::Separator();
         if (ImGui::Button("OK", ImVec2(120, 0)))
             CloseModal();
@@ -89,8 +211,11 @@ void GuiTaskView::Render(const char* windowId)
 
     if (mData->dataChanged && mData->mutex.TryEnter()) {
         mData->itemsCopy = memReallocTyped<GuiTaskViewData::Item*>(mData->itemsCopy, mData->items.Count());
-        memcpy(mData->itemsCopy, mData->items.Ptr(), mData->items.Count()*sizeof(GuiTaskViewData::Item*));
-        mData->numItems = mData->items.Count();
+        mData->numItems = 0;
+        for (GuiTaskViewData::Item* item : mData->items) {
+            if (!item->isSubEvent)
+                mData->itemsCopy[mData->numItems++] = item;
+        }
         mData->dataChanged = false;
         mData->mutex.Exit();
     }
@@ -101,7 +226,7 @@ void GuiTaskView::Render(const char* windowId)
 
         {
             if (mData->hoveredItem && mData->hoveredItem->graphHandle.IsValid())
-                RenderGraphOverview(mData->hoveredItem->graphHandle);
+                RenderGraphOverview(mData, mData->hoveredItem->graphHandle);
 
             if (mData->showOverview) {
                 ImGui::OpenPopup("TaskOverview");
@@ -216,12 +341,14 @@ void GuiTaskView::Release()
         mData->mutex.Release();
         mData->alloc.Release();
         mData->items.Free();
+        FreeOverviewStats(&mData->overview);
         memFree(mData);
         mData = nullptr;
     }
 }
 
-void GuiTaskView::OnBeginEvent(TskGraphHandle graphHandle, TskEventHandle eventHandle, const char* name, time_t startTm)
+void GuiTaskView::OnBeginEvent(TskGraphHandle graphHandle, TskEventHandle eventHandle, TskEventHandle outerEventHandle, 
+                               const char* name, time_t startTm)
 {
     const char* graphName = tskGetName(graphHandle);
     uint32 textLen = strLen(name) + strLen(graphName) + 2 /* ": " */ + 64 /* duration */;
@@ -229,15 +356,45 @@ void GuiTaskView::OnBeginEvent(TskGraphHandle graphHandle, TskEventHandle eventH
 
     // No need to Free, because we will free the VM allocator itself
     GuiTaskViewData::Item* item = mallocator.AddMemberField<char>(offsetof(GuiTaskViewData::Item, text), textLen + 1).Calloc(&mData->alloc);
-    strPrintFmt(item->text, textLen + 1, "%s: %s", graphName, name);
+    if (outerEventHandle.IsValid())
+        strCopy(item->text, textLen + 1, name);
+    else
+        strPrintFmt(item->text, textLen + 1, "%s: %s", graphName, name);
     item->textLen = textLen + 1;
     item->state = GuiTaskViewData::ItemState::Running;
     item->graphHandle = graphHandle;
     item->eventHandle = eventHandle;
 
     MutexScope mutex(mData->mutex);
+
+    // Sub events are still in the items array, so the end event can find them
+    if (outerEventHandle.IsValid()) {
+        GuiTaskViewData::Item* outerItem = nullptr;
+        for (uint32 i = mData->items.Count(); i-- > 0; ) {
+            GuiTaskViewData::Item* it = mData->items[i];
+            if (it->graphHandle == graphHandle && it->eventHandle == outerEventHandle) {
+                outerItem = it;
+                break;
+            }
+        }
+
+        if (outerItem) {
+            item->isSubEvent = true;
+            if (outerItem->firstChild == nullptr) {
+                outerItem->firstChild = item;
+            }
+            else {
+                GuiTaskViewData::Item* last = outerItem->firstChild;
+                while (last->next)
+                    last = last->next;
+                last->next = item;
+            }
+        }
+    }
+
     mData->items.Push(item);
     mData->dataChanged = true;
+    RequestBackgroundRedraw();
 }
 
 void GuiTaskView::OnEndEvent(TskGraphHandle graphHandle, TskEventHandle eventHandle, float duration)
@@ -259,6 +416,7 @@ void GuiTaskView::OnEndEvent(TskGraphHandle graphHandle, TskEventHandle eventHan
     MakeTimeFormat(duration, durstr, sizeof(durstr));
     strConcat(parentItem->text, parentItem->textLen, " - ");
     strConcat(parentItem->text, parentItem->textLen, durstr);
+    RequestBackgroundRedraw();
 }
 
 void GuiTaskView::OnNewEvent(TskGraphHandle graphHandle, TskEventHandle eventHandle, TskEventType::Enum type, const char* text)
@@ -300,5 +458,7 @@ void GuiTaskView::OnNewEvent(TskGraphHandle graphHandle, TskEventHandle eventHan
             last->next = item;
         }
     }
+
+    RequestBackgroundRedraw();
 }
 
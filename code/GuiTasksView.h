@@ -17,7 +17,8 @@ struct GuiTaskView final : TskCallbacks
     bool Initialize();
     void Release();
 
-    void OnBeginEvent(TskGraphHandle graphHandle, TskEventHandle eventHandle, const char* name, time_t startTm) override;
+    void OnBeginEvent(TskGraphHandle graphHandle, TskEventHandle eventHandle, TskEventHandle outerEventHandle, 
+                      const char* name, time_t startTm) override;
     void OnEndEvent(TskGraphHandle graphHandle, TskEventHandle eventHandle, float duration) override;
     void OnNewEvent(TskGraphHandle graphHandle, TskEventHandle eventHandle, TskEventType::Enum type, const char* text) override;
 };
@@ -1,135 +1,1524 @@
 #include "GuiTextView.h"
 
 #include "Core/Atomic.h"
+#include "Core/Log.h"
 #include "Core/MathScalar.h"
 #include "Core/StringUtil.h"
+#include "Core/Jobs.h"
 
 #include "ImGui/ImGuiAll.h"
 
 #include "Main.h"
 
-bool TextContent::Initialize(size_t reserveSize, size_t pageSize)
+struct TextContentSpill
 {
-    mAlloc.Initialize(reserveSize, pageSize);
-    mBlob.SetAllocator(&mAlloc);
-    mBlob.SetGrowPolicy(Blob::GrowPolicy::Linear, 32*kKB);
+    TextContentSpillParams params;
+    Path filepath;
+    File file;
+    FileMapping mapping;    // Maps the whole spill file. Re-mapped when we need data beyond the mapped size
+    char* head = nullptr;
+    char* tail = nullptr;   // Sliding window over the end of the stream. Capacity is 2x tailSize to amortize the moves
+    size_t tailCapacity = 0;
+    uint64 tailStart = 0;   // Stream offset of the first byte in tail
+    uint64 size = 0;        // Total size of the stream
+    char* staging = nullptr;    // ReserveWrite buffer, spill files are written with a copy anyway
+    bool writeFailed = false;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+// Segment arena
+static constexpr uint32 kTextArenaMaxPooled = 256;     // Number of kTextSegmentSize segments that are kept for reuse
+
+struct TextArenaSegment
+{
+    TextArenaSegment* next;     // Free list
+    TextContent* owner;         // Content that writes to the segment, others only reference it
+    uint32 capacity;
+    uint32 used;                // Only written by the content that acquired the segment
+    atomicUint32 refCount;
+};
+
+struct TextArena
+{
+    AtomicLock lock;
+    TextArenaSegment* freeList;
+    uint32 numFree;
+    atomicUint64 bytesCaptured;
+    atomicUint64 bytesResident;
+};
+
+static TextArena gTextArena;
+
+static inline char* textSegmentData(TextArenaSegment* seg)
+{
+    return (char*)(seg + 1);
+}
+
+static inline const char* textSegmentData(const TextSegmentRef& ref)
+{
+    return textSegmentData(ref.seg) + ref.offset;
+}
+
+static TextArenaSegment* textArenaAcquire(uint32 capacity)
+{
+    TextArenaSegment* seg = nullptr;
+    if (capacity == kTextSegmentSize) {
+        AtomicLockScope lock(gTextArena.lock);
+        seg = gTextArena.freeList;
+        if (seg) {
+            gTextArena.freeList = seg->next;
+            --gTextArena.numFree;
+        }
+    }
+
+    if (!seg) {
+        seg = (TextArenaSegment*)memAlloc(sizeof(TextArenaSegment) + capacity);
+        seg->capacity = capacity;
+    }
+
+    seg->next = nullptr;
+    seg->owner = nullptr;
+    seg->used = 0;
+    seg->refCount = 1;
+    atomicFetchAdd64(&gTextArena.bytesResident, capacity);
+    return seg;
+}
+
+static void textArenaAddRef(TextArenaSegment* seg)
+{
+    atomicFetchAdd32(&seg->refCount, 1);
+}
+
+static void textArenaReleaseRef(TextArenaSegment* seg)
+{
+    if (atomicFetchSub32(&seg->refCount, 1) != 1)
+        return;
+
+    atomicFetchSub64(&gTextArena.bytesResident, seg->capacity);
+    if (seg->capacity == kTextSegmentSize) {
+        AtomicLockScope lock(gTextArena.lock);
+        if (gTextArena.numFree < kTextArenaMaxPooled) {
+            seg->next = gTextArena.freeList;
+            gTextArena.freeList = seg;
+            ++gTextArena.numFree;
+            return;
+        }
+    }
+    memFree(seg);
+}
+
+void textArenaGetStats(TextArenaStats* stats)
+{
+    stats->bytesCaptured = atomicLoad64(&gTextArena.bytesCaptured);
+    stats->bytesResident = atomicLoad64(&gTextArena.bytesResident);
+
+    AtomicLockScope lock(gTextArena.lock);
+    stats->bytesPooled = uint64(gTextArena.numFree)*kTextSegmentSize;
+}
+
+void textArenaRelease()
+{
+    AtomicLockScope lock(gTextArena.lock);
+    while (gTextArena.freeList) {
+        TextArenaSegment* next = gTextArena.freeList->next;
+        memFree(gTextArena.freeList);
+        gTextArena.freeList = next;
+    }
+    gTextArena.numFree = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// TextContent
+bool TextContent::Initialize()
+{
+    mScratch.SetGrowPolicy(Blob::GrowPolicy::Multiply);
+    return true;
+}
+
+bool TextContent::InitializeSpill(const TextContentSpillParams& params)
+{
+    ASSERT(params.tailSize);
+
+    Path spillDir;
+    pathGetCacheDir(spillDir.Ptr(), sizeof(spillDir), CONFIG_APP_NAME);
+    spillDir = Path::Join(spillDir, "Output");
+    if (!spillDir.IsDir() && !pathCreateDir(spillDir.CStr())) {
+        logError("Creating output spill directory failed: %s", spillDir.CStr());
+        return false;
+    }
+
+    SysUUID uuid;
+    char uuidStr[64];
+    if (!sysUUIDGenerate(&uuid) || !sysUUIDToString(uuid, uuidStr, sizeof(uuidStr)))
+        return false;
+
+    TextContentSpill* spill = NEW(memDefaultAlloc(), TextContentSpill);
+    spill->params = params;
+    spill->filepath = Path::Join(spillDir, uuidStr);
+    if (!spill->file.Open(spill->filepath.CStr(), FileOpenFlags::Write)) {
+        logError("Creating output spill file failed: %s", spill->filepath.CStr());
+        memFree(spill);
+        return false;
+    }
+
+    spill->head = (char*)memAlloc(params.headSize);
+    spill->tailCapacity = params.tailSize*2;
+    spill->tail = (char*)memAlloc(spill->tailCapacity);
+    spill->staging = (char*)memAlloc(kTextSegmentSize);
+
+    mSpill = spill;
     return true;
 }
 
 void TextContent::Release()
 {
-    mBlob.Free();
+    // Running searches are cancelled by the generation change, wait for them to exit
+    atomicFetchAdd32(&mGeneration, 1);
+    while (atomicLoad32(&mNumSearches))
+        threadYield();
+
+    if (mSpill) {
+        mSpill->mapping.Close();
+        mSpill->file.Close();
+        pathDelete(mSpill->filepath.CStr());
+        memFree(mSpill->head);
+        memFree(mSpill->tail);
+        memFree(mSpill->staging);
+        memFree(mSpill);
+        mSpill = nullptr;
+    }
+    else {
+        ReleaseSegments();
+        mSegments.Free();
+        mRetiredSegments.Free();
+        mScratch.Free();
+    }
     mLines.Free();
+    mLineTimes.Free();
+    mRuns.Free();
+
+    for (TextSearchChunk* chunk : mSearchChunks)
+        memFree(chunk);
+    mSearchChunks.Free();
 }
-    
-void TextContent::ParseLines()
+
+// Segments can only go back to the arena when no search is reading them. Otherwise they wait for the next Reset or Release
+// Must be called with mLock held, because searches take their copy of the segments under it
+void TextContent::ReleaseSegments()
 {
-    if (!mLastLinePtr)
-        mLastLinePtr = (const char*)mBlob.Data();
-    ASSERT(mLastLinePtr);
-
-    const char* startPtr = (const char*)mBlob.Data();
-    const char* str = mLastLinePtr;
-    const char* line = str;
-    while (uintptr_t(str - startPtr) < mBlob.Size()) {
-        if (*str == '\n' || *str == '\0') {
-            uint32 end = (uint32)uintptr_t(str - startPtr);
-            if (*(str - 1) == '\r')
-                --end;
-            uint32 start = (uint32)uintptr_t(line - startPtr);
+    atomicFetchSub64(&gTextArena.bytesCaptured, mSize);
 
-            AtomicLockScope lock(mLock);
-            mLines.Push({start, end});
+    if (atomicLoad32(&mNumSearches) == 0) {
+        for (TextArenaSegment* seg : mRetiredSegments)
+            textArenaReleaseRef(seg);
+        mRetiredSegments.Clear();
+        for (const TextSegmentRef& ref : mSegments)
+            textArenaReleaseRef(ref.seg);
+    }
+    else {
+        for (const TextSegmentRef& ref : mSegments)
+            mRetiredSegments.Push(ref.seg);
+    }
+
+    mSegments.Clear();
+    mSize = 0;
+}
+
+// Index of the segment that contains the stream offset, INVALID_INDEX if it's out of the stream
+uint32 TextContent::FindSegment(uint64 offset) const
+{
+    if (mSegments.IsEmpty() || offset >= mSize)
+        return INVALID_INDEX;
+
+    uint32 first = 0;
+    uint32 last = mSegments.Count() - 1;
+    while (first < last) {
+        uint32 mid = (first + last + 1) >> 1;
+        if (mSegments[mid].start <= offset)
+            first = mid;
+        else
+            last = mid - 1;
+    }
+    return first;
+}
+
+// Returns the segment that new data is appended to, with at least minSize bytes of free space. Needs mLock
+// When a new segment is needed, the unfinished line at the end of the stream is moved to it, so it stays contiguous
+// Long lines get larger segments, those are not pooled
+TextSegmentRef* TextContent::ReserveSegment(uint32 minSize)
+{
+    uint32 moveSize = 0;
+    if (!mSegments.IsEmpty()) {
+        TextSegmentRef& last = mSegments.Last();
+        TextArenaSegment* seg = last.seg;
+        if (seg->owner == this && seg->capacity - seg->used >= minSize) {
+            if (last.offset + last.size == seg->used)
+                return &last;
+
+            // The null-terminator at the end of the segment is removed from the stream (BeginWrite). Skip it instead of 
+            // overwriting, because redirected contents may still reference it
+            textArenaAddRef(seg);
+            return mSegments.Push(TextSegmentRef { .seg = seg, .start = mSize, .offset = seg->used });
+        }
 
-            if (*str == '\0')
-                break;
+        const char* data = textSegmentData(last);
+        uint32 lineStart = last.size;
+        while (lineStart > 0 && data[lineStart - 1] != '\n')
+            --lineStart;
+        moveSize = last.size - lineStart;
+    }
+
+    uint32 capacity = kTextSegmentSize;
+    while (capacity < moveSize*2 || capacity - moveSize < minSize)
+        capacity <<= 1;
+
+    TextArenaSegment* seg = textArenaAcquire(capacity);
+    seg->owner = this;
+    if (moveSize) {
+        TextSegmentRef& last = mSegments.Last();
+        memcpy(textSegmentData(seg), textSegmentData(last) + last.size - moveSize, moveSize);
+        seg->used = moveSize;
+
+        last.size -= moveSize;
+        if (last.size == 0) {
+            uint64 start = last.start;
+            textArenaReleaseRef(last.seg);
+            last = TextSegmentRef { .seg = seg, .start = start, .size = moveSize };
+            return &last;
+        }
+    }
+
+    return mSegments.Push(TextSegmentRef { .seg = seg, .start = mSize - moveSize, .size = moveSize });
+}
+
+void TextContent::ParseData(const char* data, uint64 dataOffset, size_t size)
+{
+    // Parsing is stalled on a null-terminator that is not removed yet
+    if (mParseOffset < dataOffset || mParseOffset > dataOffset + size)
+        return;
+
+    // Lines are stamped once per write, which is when they arrive from the source
+    uint64 time = timerGetTicks();
+    for (size_t i = size_t(mParseOffset - dataOffset); i < size; i++) {
+        char ch = data[i];
+        if (ch == '\n' || ch == '\0') {
+            uint64 end = dataOffset + i;
+            if (mLastParsedChar == '\r' && end > mLineStart)
+                --end;
+            mLines.Push({mLineStart, end});
+            mLineTimes.Push(time);
+
+            if (ch == '\0') {
+                mParseOffset = dataOffset + i;
+                return;
+            }
 
-            line = str + 1;
-            mLastLinePtr = line;
+            mLineStart = dataOffset + i + 1;
         }
-        ++str;
+        mLastParsedChar = ch;
     }
 
+    mParseOffset = dataOffset + size;
+}
+    
+void TextContent::ParseLines()
+{
+    // Lines are parsed while appending data, because the data is contiguous there
     if (mRedirectContent)
         mRedirectContent->ParseLines();
+    else
+        RequestBackgroundRedraw();
+}
+
+static inline uint8 textToLower(uint8 c)
+{
+    return (c >= 'A' && c <= 'Z') ? uint8(c + 32) : c;
+}
+
+static inline uint32 textTrigramBit(uint32 trigram)
+{
+    static_assert(kSearchChunkBits == (1 << 14));
+    return (trigram * 0x9E3779B1u) >> (32 - 14);
+}
+
+void TextContent::IndexData(const char* data, uint64 dataOffset, size_t size)
+{
+    uint32 trigram = mSearchTrigram;
+    uint32 chunkIndex = INVALID_INDEX;
+    TextSearchChunk* chunk = nullptr;
+
+    for (size_t i = 0; i < size; i++) {
+        uint64 offset = dataOffset + i;
+        trigram = ((trigram << 8) | textToLower(uint8(data[i]))) & 0xffffff;
+        if (offset < 2)
+            continue;
+
+        // Trigrams belong to the chunk that they start in
+        uint32 index = uint32((offset - 2) / kSearchChunkSize);
+        if (index != chunkIndex) {
+            if (index >= mNumSearchChunks) {
+                AtomicLockScope lock(mLock);
+                while (mNumSearchChunks <= index) {
+                    if (mNumSearchChunks == mSearchChunks.Count())
+                        mSearchChunks.Push(memAllocTyped<TextSearchChunk>());
+                    memset(mSearchChunks[mNumSearchChunks++], 0x0, sizeof(TextSearchChunk));
+                }
+            }
+            chunk = mSearchChunks[index];
+            chunkIndex = index;
+        }
+
+        uint32 bit = textTrigramBit(trigram);
+        chunk->bits[bit >> 6] |= (1ull << (bit & 63));
+    }
+
+    mSearchTrigram = trigram;
+}
+
+void TextContent::AppendData(const void* src, size_t size)
+{
+    // Index before the data becomes visible to searches
+    IndexData((const char*)src, GetSize(), size);
+
+    if (!mSpill) {
+        AtomicLockScope lock(mLock);
+        uint64 dataOffset = mSize;
+        const uint8* data = (const uint8*)src;
+        size_t remainSize = size;
+        while (remainSize) {
+            TextSegmentRef* ref = ReserveSegment();
+            TextArenaSegment* seg = ref->seg;
+            uint32 writeSize = uint32(Min<size_t>(remainSize, seg->capacity - seg->used));
+            memcpy(textSegmentData(seg) + seg->used, data, writeSize);
+            seg->used += writeSize;
+            ref->size += writeSize;
+            mSize += writeSize;
+            data += writeSize;
+            remainSize -= writeSize;
+        }
+
+        atomicFetchAdd64(&gTextArena.bytesCaptured, size);
+        ParseData((const char*)src, dataOffset, size);
+        return;
+    }
+
+    TextContentSpill* spill = mSpill;
+    if (spill->file.Write(src, size) != size && !spill->writeFailed) {
+        logError("Writing to output spill file failed: %s", spill->filepath.CStr());
+        spill->writeFailed = true;
+    }
+
+    if (spill->size < spill->params.headSize) {
+        size_t headSize = Min<size_t>(size, spill->params.headSize - spill->size);
+        memcpy(spill->head + spill->size, src, headSize);
+    }
+
+    AtomicLockScope lock(mLock);
+    size_t tailSize = size_t(spill->size - spill->tailStart);
+    if (size >= spill->tailCapacity) {
+        size_t keepSize = spill->params.tailSize;
+        memcpy(spill->tail, (const uint8*)src + size - keepSize, keepSize);
+        spill->tailStart = spill->size + size - keepSize;
+    }
+    else {
+        if (tailSize + size > spill->tailCapacity) {
+            // Slide the window, so at least tailSize bytes remain resident after the write
+            size_t keepSize = Min(tailSize, spill->params.tailSize > size ? spill->params.tailSize - size : 0);
+            memmove(spill->tail, spill->tail + tailSize - keepSize, keepSize);
+            spill->tailStart += tailSize - keepSize;
+            tailSize = keepSize;
+        }
+        memcpy(spill->tail + tailSize, src, size);
+    }
+
+    uint64 dataOffset = spill->size;
+    spill->size += size;
+    ParseData((const char*)src, dataOffset, size);
+}
+
+// Appends the data that is just written to `source` by referencing its segments. Called on the thread that writes to source
+void TextContent::AppendShared(TextContent* source, uint64 sourceOffset, const void* src, size_t size)
+{
+    ASSERT(!mSpill && !source->mSpill);
+    IndexData((const char*)src, GetSize(), size);
+
+    AtomicLockScope lock(mLock);
+    uint64 dataOffset = mSize;
+    uint64 sourceEnd = sourceOffset + size;
+    for (uint32 i = source->FindSegment(sourceOffset); i < source->mSegments.Count(); i++) {
+        const TextSegmentRef& srcRef = source->mSegments[i];
+        if (srcRef.start >= sourceEnd)
+            break;
+
+        uint64 pieceStart = Max(sourceOffset, srcRef.start);
+        uint32 pieceSize = uint32(Min(sourceEnd, srcRef.start + srcRef.size) - pieceStart);
+        uint32 pieceOffset = srcRef.offset + uint32(pieceStart - srcRef.start);
+
+        TextSegmentRef* last = mSegments.IsEmpty() ? nullptr : &mSegments.Last();
+        if (last && last->seg == srcRef.seg && last->offset + last->size == pieceOffset) {
+            last->size += pieceSize;
+            mSize += pieceSize;
+            continue;
+        }
+
+        // When the source starts a new segment, it moves its unfinished line to the beginning of it (ReserveSegment)
+        // If our stream ends with the same bytes, reference the moved copy instead, so the line stays contiguous here as well
+        uint32 movedSize = 0;
+        if (last && srcRef.offset == 0 && pieceOffset > 0 && pieceOffset <= last->size &&
+            memcmp(textSegmentData(srcRef.seg), textSegmentData(*last) + last->size - pieceOffset, pieceOffset) == 0)
+        {
+            movedSize = pieceOffset;
+            last->size -= movedSize;
+            if (last->size == 0) {
+                textArenaReleaseRef(last->seg);
+                mSegments.PopLast();
+            }
+        }
+
+        textArenaAddRef(srcRef.seg);
+        mSegments.Push(TextSegmentRef { 
+            .seg = srcRef.seg, 
+            .start = mSize - movedSize, 
+            .offset = pieceOffset - movedSize, 
+            .size = pieceSize + movedSize 
+        });
+        mSize += pieceSize;
+    }
+
+    ASSERT(mSize == dataOffset + size);
+    atomicFetchAdd64(&gTextArena.bytesCaptured, size);
+    ParseData((const char*)src, dataOffset, size);
 }
 
 void TextContent::WriteData(const void* src, size_t size)
 {
-    mBlob.Write(src, size);
+    uint64 dataOffset = GetSize();
+    AppendData(src, size);
     if (mRedirectContent) {
-        AtomicLockScope redirectLock(mRedirectContent->mLock);
-        mRedirectContent->mBlob.Write(src, size);
+        if (!mSpill && !mRedirectContent->mSpill)
+            mRedirectContent->AppendShared(this, dataOffset, src, size);
+        else
+            mRedirectContent->AppendData(src, size);
     }
 }
 
 void TextContent::Reset()
 {
+    AtomicLockScope lock(mLock);
+    atomicFetchAdd32(&mGeneration, 1);
     mLines.Clear();
-    mBlob.ResetRead();
-    mBlob.SetSize(0);
-    mLastLinePtr = nullptr;
+    mLineTimes.Clear();
+    mRuns.Clear();
+    if (mSpill) {
+        // Searches map the spill file, truncating it under them faults on their reads. The generation change cancels them, 
+        // wait for them to exit. New searches can't start because we hold the lock
+        while (atomicLoad32(&mNumSearches))
+            threadYield();
+
+        mSpill->mapping.Close();
+        mSpill->file.Close();
+        mSpill->file.Open(mSpill->filepath.CStr(), FileOpenFlags::Write);
+        mSpill->tailStart = 0;
+        mSpill->size = 0;
+        mSpill->writeFailed = false;    // The file is reopened, report the next failure again
+    }
+    else {
+        ReleaseSegments();
+    }
+    mLineStart = 0;
+    mParseOffset = 0;
+    mLastParsedChar = 0;
+    mNumSearchChunks = 0;
+    mSearchTrigram = 0;
     atomicExchange32Explicit(&mResetFlag, 1, AtomicMemoryOrder::Release);
 }
 
+uint64 TextContent::BeginWrite(bool reset)
+{
+    if (reset) {
+        Reset();
+    }
+    else if (GetSize()) {
+        // Remove the last null-terminator
+        if (mSpill) {
+            AtomicLockScope lock(mLock);
+            --mSpill->size;
+            mSpill->file.Seek(size_t(mSpill->size));
+        }
+        else {
+            // The byte stays in the segment, new data is written after it (see ReserveSegment)
+            AtomicLockScope lock(mLock);
+            TextSegmentRef& last = mSegments.Last();
+            --mSize;
+            if (--last.size == 0) {
+                textArenaReleaseRef(last.seg);
+                mSegments.PopLast();
+            }
+            atomicFetchSub64(&gTextArena.bytesCaptured, 1);
+        }
+        mSearchTrigram >>= 8;
+    }
+
+    // Runs that didn't produce any lines are replaced, so loops over quiet nodes don't grow mRuns
+    {
+        AtomicLockScope lock(mLock);
+        TextContentRun run { .firstLine = mLines.Count(), .startTime = timerGetTicks() };
+        if (!mRuns.IsEmpty() && mRuns.Last().firstLine == run.firstLine)
+            mRuns.Last() = run;
+        else
+            mRuns.Push(run);
+    }
+
+    return GetSize();
+}
+
+char* TextContent::ReserveWrite(uint32 minSize, uint32* outSize)
+{
+    ASSERT(minSize && minSize <= kTextSegmentSize);
+    if (mSpill) {
+        *outSize = kTextSegmentSize;
+        return mSpill->staging;
+    }
+
+    AtomicLockScope lock(mLock);
+    TextSegmentRef* ref = ReserveSegment(minSize);
+    TextArenaSegment* seg = ref->seg;
+    *outSize = seg->capacity - seg->used;
+    return textSegmentData(seg) + seg->used;
+}
+
+void TextContent::CommitWrite(uint32 size)
+{
+    if (mSpill) {
+        if (size)
+            WriteData(mSpill->staging, size);
+        return;
+    }
+
+    // Segments are only changed by the writing thread, so we can read them without the lock
+    TextSegmentRef& last = mSegments.Last();
+    if (size == 0) {
+        // Nothing is read into a reserved segment that doesn't hold any data yet (see ReserveSegment)
+        if (last.size == 0) {
+            AtomicLockScope lock(mLock);
+            textArenaReleaseRef(last.seg);
+            mSegments.PopLast();
+        }
+        return;
+    }
+
+    TextArenaSegment* seg = last.seg;
+    ASSERT(seg->owner == this && seg->capacity - seg->used >= size);
+    const char* data = textSegmentData(seg) + seg->used;
+    uint64 dataOffset = mSize;
+    IndexData(data, dataOffset, size);
+
+    {
+        AtomicLockScope lock(mLock);
+        seg->used += size;
+        last.size += size;
+        mSize += size;
+        ParseData(data, dataOffset, size);
+    }
+    atomicFetchAdd64(&gTextArena.bytesCaptured, size);
+
+    if (mRedirectContent) {
+        if (!mRedirectContent->mSpill)
+            mRedirectContent->AppendShared(this, dataOffset, data, size);
+        else
+            mRedirectContent->AppendData(data, size);
+    }
+}
+
+void TextContent::EndWrite()
+{
+    WriteData<char>('\0');
+    ParseLines();
+}
+
+uint64 TextContent::GetSize() const
+{
+    return mSpill ? mSpill->size : mSize;
+}
+
+const char* TextContent::GetText(uint64 begin, uint64 end)
+{
+    ASSERT(begin <= end);
+    if (!mSpill) {
+        if (begin == end)
+            return "";
+
+        uint32 index = FindSegment(begin);
+        if (index == INVALID_INDEX || end > mSize)
+            return nullptr;
+
+        const TextSegmentRef& ref = mSegments[index];
+        if (end <= ref.start + ref.size)
+            return textSegmentData(ref) + (begin - ref.start);
+
+        mScratch.SetSize(0);
+        for (uint64 offset = begin; offset < end; ) {
+            const TextSegmentRef& r = mSegments[index++];
+            uint64 copyEnd = Min(end, r.start + r.size);
+            mScratch.Write(textSegmentData(r) + (offset - r.start), size_t(copyEnd - offset));
+            offset = copyEnd;
+        }
+        return (const char*)mScratch.Data();
+    }
+
+    TextContentSpill* spill = mSpill;
+    if (end > spill->size)
+        return nullptr;
+    if (end <= spill->params.headSize)
+        return spill->head + begin;
+    if (begin >= spill->tailStart)
+        return spill->tail + size_t(begin - spill->tailStart);
+
+    if (!spill->mapping.IsOpen() || end > spill->mapping.Size()) {
+        spill->mapping.Close();
+        if (!spill->mapping.Open(spill->filepath.CStr()))
+            return nullptr;
+    }
+    return (const char*)spill->mapping.Data() + begin;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Search
+// Contiguous part of the stream: [start, end). Searches go through the views one by one, matches that cross them are not found
+struct TextSearchView
+{
+    const char* data;
+    uint64 start;
+    uint64 end;
+};
+
+struct TextSearchContext
+{
+    TextContent* content;
+    TextSearchView* views;      // Segments, or the whole spill file mapping
+    uint32 numViews;
+    uint64 size;
+    FileMapping mapping;        // Spill mode: searches map the spill file on their own
+    TextSearchChunk** chunks;   // Copy of the chunk pointers at the time of Begin
+    uint32 numIndexedChunks;
+    uint32 numChunks;
+    uint32 generation;
+    TextSearchFlags flags;
+    char query[256];
+    char literal[256];          // Literal that every match contains. Lower-case if not CaseSensitive
+    uint32 literalLen;
+    uint32 trigramBits[256];
+    uint32 numTrigramBits;
+    uint32 numGroups;
+    uint32 chunksPerGroup;
+    uint32 numGroupsRemaining;
+    uint32 cancel;
+    Array<uint64>* results;     // Per group: Offsets of the matches (or line starts for regex)
+    JobsHandle job;
+};
+
+static const char* textRegexAtomEnd(const char* re)
+{
+    if (re[0] == '\\' && re[1])
+        return re + 2;
+
+    if (re[0] == '[') {
+        const char* p = re + 1;
+        if (*p == '^')
+            ++p;
+        if (*p == ']')
+            ++p;
+        while (*p && *p != ']') {
+            if (p[0] == '\\' && p[1])
+                ++p;
+            ++p;
+        }
+        return *p ? p + 1 : p;
+    }
+
+    return re + 1;
+}
+
+static bool textRegexMatchAtomExact(const char* re, char c)
+{
+    switch (re[0]) {
+    case '.':   
+        return true;
+    case '\\':
+        switch (re[1]) {
+        case 'd':   return c >= '0' && c <= '9';
+        case 'w':   return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+        case 's':   return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+        default:    return c == re[1];
+        }
+    case '[':
+    {
+        const char* p = re + 1;
+        bool negate = *p == '^';
+        if (negate)
+            ++p;
+        bool matched = false;
+        const char* first = p;
+        while (*p && (*p != ']' || p == first)) {
+            char lo = *p;
+            if (lo == '\\' && p[1])
+                lo = *++p;
+            char hi = lo;
+            if (p[1] == '-' && p[2] && p[2] != ']') {
+                hi = p[2];
+                if (hi == '\\' && p[3]) {
+                    hi = p[3];
+                    ++p;
+                }
+                p += 2;
+            }
+            if (c >= lo && c <= hi)
+                matched = true;
+            ++p;
+        }
+        return matched != negate;
+    }
+    default:
+        return c == re[0];
+    }
+}
+
+static bool textRegexMatchAtom(const char* re, char c, bool caseSensitive)
+{
+    if (textRegexMatchAtomExact(re, c))
+        return true;
+    if (!caseSensitive) {
+        if (c >= 'a' && c <= 'z')
+            return textRegexMatchAtomExact(re, char(c - 32));
+        if (c >= 'A' && c <= 'Z')
+            return textRegexMatchAtomExact(re, char(c + 32));
+    }
+    return false;
+}
+
+// matchEnd is optional, receives the end of the matched text
+static bool textRegexMatchHere(const char* re, const char* text, const char* end, bool caseSensitive, const char** matchEnd)
+{
+    if (re[0] == '\0') {
+        if (matchEnd)
+            *matchEnd = text;
+        return true;
+    }
+    if (re[0] == '$' && re[1] == '\0') {
+        if (matchEnd)
+            *matchEnd = text;
+        return text == end;
+    }
+
+    const char* atomEnd = textRegexAtomEnd(re);
+    char q = *atomEnd;
+    if (q == '*' || q == '+' || q == '?') {
+        uint32 minCount = q == '+' ? 1 : 0;
+        uint32 maxCount = q == '?' ? 1 : UINT32_MAX;
+        uint32 count = 0;
+        const char* t = text;
+        while (t < end && count < maxCount && textRegexMatchAtom(re, *t, caseSensitive)) {
+            ++t;
+            ++count;
+        }
+
+        // Greedy: try the longest repetition first
+        while (true) {
+            if (count < minCount)
+                return false;
+            if (textRegexMatchHere(atomEnd + 1, t, end, caseSensitive, matchEnd))
+                return true;
+            if (count == 0)
+                return false;
+            --count;
+            --t;
+        }
+    }
+
+    if (text < end && textRegexMatchAtom(re, *text, caseSensitive))
+        return textRegexMatchHere(atomEnd, text + 1, end, caseSensitive, matchEnd);
+    return false;
+}
+
+static bool textRegexMatchLine(const char* re, const char* begin, const char* end, bool caseSensitive, 
+                               const char** matchBegin = nullptr, const char** matchEnd = nullptr)
+{
+    if (re[0] == '^') {
+        if (matchBegin)
+            *matchBegin = begin;
+        return textRegexMatchHere(re + 1, begin, end, caseSensitive, matchEnd);
+    }
+
+    for (const char* t = begin; t <= end; t++) {
+        if (textRegexMatchHere(re, t, end, caseSensitive, matchEnd)) {
+            if (matchBegin)
+                *matchBegin = t;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool textRegexMatch(const char* regex, const char* text, size_t len, bool caseSensitive, uint32* outMatchOffset, uint32* outMatchLen)
+{
+    const char* matchBegin;
+    const char* matchEnd;
+    if (!textRegexMatchLine(regex, text, text + len, caseSensitive, &matchBegin, &matchEnd))
+        return false;
+
+    if (outMatchOffset)
+        *outMatchOffset = uint32(matchBegin - text);
+    if (outMatchLen)
+        *outMatchLen = uint32(matchEnd - matchBegin);
+    return true;
+}
+
+// Longest sequence of literals that every match of the regex must contain. Used for pre-filtering chunks and lines
+static uint32 textRegexRequiredLiteral(const char* re, char* literal, uint32 literalSize)
+{
+    char run[256];
+    uint32 runLen = 0;
+    uint32 bestLen = 0;
+
+    if (re[0] == '^')
+        ++re;
+
+    while (*re) {
+        const char* atomEnd = textRegexAtomEnd(re);
+        char q = *atomEnd;
+        bool optional = q == '*' || q == '?';
+        bool isLiteral;
+        char ch;
+        if (re[0] == '\\') {
+            ch = re[1];
+            isLiteral = ch && !strchr("dws", ch);
+        }
+        else {
+            ch = re[0];
+            isLiteral = !strchr(".[$", ch);
+        }
+
+        if (isLiteral && !optional && runLen < sizeof(run))
+            run[runLen++] = ch;
+        if (!isLiteral || optional || q == '+' || *atomEnd == '\0') {
+            if (runLen > bestLen && runLen < literalSize) {
+                memcpy(literal, run, runLen);
+                bestLen = runLen;
+            }
+            runLen = 0;
+        }
+
+        re = (q == '*' || q == '+' || q == '?') ? atomEnd + 1 : atomEnd;
+    }
+
+    literal[bestLen] = '\0';
+    return bestLen;
+}
+
+static bool textSearchChunkMayMatch(const TextSearchContext* ctx, uint32 chunkIndex)
+{
+    // Note: The last chunks may be updated after the data becomes visible, so we always scan them
+    if (ctx->numTrigramBits == 0 || chunkIndex + 1 >= ctx->numIndexedChunks)
+        return true;
+
+    // Matches that start in this chunk, can continue in the next one
+    const TextSearchChunk* chunk = ctx->chunks[chunkIndex];
+    const TextSearchChunk* nextChunk = ctx->chunks[chunkIndex + 1];
+    for (uint32 i = 0; i < ctx->numTrigramBits; i++) {
+        uint32 bit = ctx->trigramBits[i];
+        uint64 mask = 1ull << (bit & 63);
+        if (!(chunk->bits[bit >> 6] & mask) && !(nextChunk->bits[bit >> 6] & mask))
+            return false;
+    }
+    return true;
+}
+
+static inline const char* textSearchText(const TextSearchView& view, uint64 offset)
+{
+    return view.data + (offset - view.start);
+}
+
+static inline bool textSearchLiteralAt(const TextSearchContext* ctx, const TextSearchView& view, uint64 offset)
+{
+    const char* str = textSearchText(view, offset);
+    if ((ctx->flags & TextSearchFlags::CaseSensitive) == TextSearchFlags::CaseSensitive)
+        return memcmp(str, ctx->literal, ctx->literalLen) == 0;
+
+    for (uint32 i = 0; i < ctx->literalLen; i++) {
+        if (textToLower(uint8(str[i])) != uint8(ctx->literal[i]))
+            return false;
+    }
+    return true;
+}
+
+static uint64 textSearchLineEnd(const TextSearchView& view, uint64 offset)
+{
+    const char* text = textSearchText(view, offset);
+    const char* lineEnd = (const char*)memchr(text, '\n', size_t(view.end - offset));
+    return lineEnd ? offset + uint64(lineEnd - text) : view.end;
+}
+
+static bool textSearchRegexLine(const TextSearchContext* ctx, const TextSearchView& view, uint64 lineStart, uint64 lineEnd)
+{
+    if (lineEnd > lineStart && *textSearchText(view, lineEnd - 1) == '\r')
+        --lineEnd;
+    return textRegexMatchLine(ctx->query, textSearchText(view, lineStart), textSearchText(view, lineEnd), 
+                              (ctx->flags & TextSearchFlags::CaseSensitive) == TextSearchFlags::CaseSensitive);
+}
+
+static void textSearchChunk(const TextSearchContext* ctx, const TextSearchView& view, uint64 start, uint64 end, 
+                            Array<uint64>* results)
+{
+    bool isRegex = (ctx->flags & TextSearchFlags::Regex) == TextSearchFlags::Regex;
+
+    // Regex without any literals to look for: Test every line that starts in this chunk
+    if (ctx->literalLen == 0) {
+        ASSERT(isRegex);
+        uint64 offset = start;
+        if (offset > view.start && *textSearchText(view, offset - 1) != '\n')
+            offset = textSearchLineEnd(view, offset) + 1;
+        while (offset < end) {
+            uint64 lineEnd = textSearchLineEnd(view, offset);
+            if (textSearchRegexLine(ctx, view, offset, lineEnd))
+                results->Push(offset);
+            offset = lineEnd + 1;
+        }
+        return;
+    }
+
+    // Look for the literal, then test the regex on the line that contains it. Only one match is reported per line
+    uint64 offset = start;
+    while (offset < end && offset + ctx->literalLen <= view.end) {
+        if (!textSearchLiteralAt(ctx, view, offset)) {
+            ++offset;
+            continue;
+        }
+
+        uint64 lineEnd = textSearchLineEnd(view, offset);
+        if (isRegex) {
+            uint64 lineStart = offset;
+            while (lineStart > view.start && *textSearchText(view, lineStart - 1) != '\n')
+                --lineStart;
+            if (textSearchRegexLine(ctx, view, lineStart, lineEnd))
+                results->Push(lineStart);
+        }
+        else {
+            results->Push(offset);
+        }
+        offset = lineEnd + 1;
+    }
+}
+
+static void textSearchTask(uint32 groupIndex, void* userData)
+{
+    TextSearchContext* ctx = (TextSearchContext*)userData;
+    TextContent* content = ctx->content;
+    uint32 firstChunk = groupIndex*ctx->chunksPerGroup;
+    uint32 endChunk = Min(firstChunk + ctx->chunksPerGroup, ctx->numChunks);
+    
+    for (uint32 i = firstChunk; i < endChunk; i++) {
+        if (atomicLoad32Explicit(&ctx->cancel, AtomicMemoryOrder::Relaxed) || 
+            atomicLoad32Explicit(&content->mGeneration, AtomicMemoryOrder::Relaxed) != ctx->generation)
+        {
+            break;
+        }
+
+        if (textSearchChunkMayMatch(ctx, i)) {
+            uint64 start = uint64(i)*kSearchChunkSize;
+            uint64 end = Min<uint64>(start + kSearchChunkSize, ctx->size);
+
+            // Find the first view that contains the chunk start. Views are sorted and have no gaps
+            uint32 first = 0;
+            uint32 last = ctx->numViews - 1;
+            while (first < last) {
+                uint32 mid = (first + last + 1) >> 1;
+                if (ctx->views[mid].start <= start)
+                    first = mid;
+                else
+                    last = mid - 1;
+            }
+
+            for (uint32 v = first; v < ctx->numViews && ctx->views[v].start < end; v++) {
+                const TextSearchView& view = ctx->views[v];
+                textSearchChunk(ctx, view, Max(start, view.start), Min(end, view.end), &ctx->results[groupIndex]);
+            }
+        }
+    }
+
+    // Last group to finish releases the content
+    if (atomicFetchSub32(&ctx->numGroupsRemaining, 1) == 1)
+        atomicFetchSub32(&content->mNumSearches, 1);
+}
+
+static void textSearchDestroyContext(TextSearchContext* ctx)
+{
+    ctx->mapping.Close();
+    if (ctx->results) {
+        for (uint32 i = 0; i < ctx->numGroups; i++)
+            ctx->results[i].Free();
+        memFree(ctx->results);
+    }
+    memFree(ctx->chunks);
+    memFree(ctx->views);
+    memFree(ctx);
+}
+
+bool TextContentSearch::Begin(TextContent* content, const char* query, TextSearchFlags flags)
+{
+    Cancel();
+
+    uint32 queryLen = strLen(query);
+    if (queryLen == 0 || queryLen >= sizeof(TextSearchContext::query))
+        return false;
+
+    TextSearchContext* ctx = NEW(memDefaultAlloc(), TextSearchContext) {
+        .content = content,
+        .flags = flags
+    };
+    strCopy(ctx->query, sizeof(ctx->query), query);
+
+    if ((flags & TextSearchFlags::Regex) == TextSearchFlags::Regex)
+        ctx->literalLen = textRegexRequiredLiteral(query, ctx->literal, sizeof(ctx->literal));
+    else
+        ctx->literalLen = strCopy(ctx->literal, sizeof(ctx->literal), query) ? queryLen : 0;
+
+    // Trigram bits are always lower-case, so we can test case-sensitive queries with the same index
+    for (uint32 i = 0; i < ctx->literalLen; i++) {
+        uint8 c = textToLower(uint8(ctx->literal[i]));
+        if ((flags & TextSearchFlags::CaseSensitive) != TextSearchFlags::CaseSensitive)
+            ctx->literal[i] = char(c);
+        if (i >= 2) {
+            uint32 trigram = (uint32(textToLower(uint8(ctx->literal[i-2]))) << 16) | 
+                             (uint32(textToLower(uint8(ctx->literal[i-1]))) << 8) | c;
+            ctx->trigramBits[ctx->numTrigramBits++] = textTrigramBit(trigram);
+        }
+    }
+    if (ctx->literalLen > kSearchChunkSize)
+        ctx->numTrigramBits = 0;
+
+    {
+        AtomicLockScope lock(content->mLock);
+        ctx->size = content->GetSize();
+        ctx->generation = content->mGeneration;
+        ctx->numIndexedChunks = content->mNumSearchChunks;
+        if (ctx->numIndexedChunks)
+            ctx->chunks = memAllocCopy<TextSearchChunk*>(content->mSearchChunks.Ptr(), ctx->numIndexedChunks);
+
+        // Segments are append-only, so the copies stay valid. They are not given back to the arena until the search is done
+        if (!content->mSpill && ctx->size) {
+            ctx->numViews = content->mSegments.Count();
+            ctx->views = memAllocTyped<TextSearchView>(ctx->numViews);
+            for (uint32 i = 0; i < ctx->numViews; i++) {
+                const TextSegmentRef& ref = content->mSegments[i];
+                ctx->views[i] = TextSearchView { .data = textSegmentData(ref), .start = ref.start, .end = ref.start + ref.size };
+            }
+        }
+
+        if (ctx->size)
+            atomicFetchAdd32(&content->mNumSearches, 1);
+    }
+
+    if (content->mSpill && ctx->size) {
+        if (!ctx->mapping.Open(content->mSpill->filepath.CStr(), 0, size_t(ctx->size))) {
+            logError("Mapping output spill file failed: %s", content->mSpill->filepath.CStr());
+            atomicFetchSub32(&content->mNumSearches, 1);
+            textSearchDestroyContext(ctx);
+            return false;
+        }
+        ctx->size = Min<uint64>(ctx->size, ctx->mapping.Size());
+        if (ctx->size == 0)
+            atomicFetchSub32(&content->mNumSearches, 1);    // No jobs to release it
+        ctx->numViews = 1;
+        ctx->views = memAllocTyped<TextSearchView>(1);
+        ctx->views[0] = TextSearchView { .data = (const char*)ctx->mapping.Data(), .start = 0, .end = ctx->size };
+    }
+
+    mCtx = ctx;
+    if (ctx->size == 0)
+        return true;
+
+    ctx->numChunks = uint32((ctx->size + kSearchChunkSize - 1) / kSearchChunkSize);
+    uint32 maxGroups = Max(jobsGetWorkerThreadsCount(JobsType::LongTask), 1u)*2;
+    ctx->chunksPerGroup = (ctx->numChunks + maxGroups - 1) / maxGroups;
+    ctx->numGroups = (ctx->numChunks + ctx->chunksPerGroup - 1) / ctx->chunksPerGroup;
+    ctx->numGroupsRemaining = ctx->numGroups;
+    ctx->results = NEW_ARRAY(memDefaultAlloc(), Array<uint64>, ctx->numGroups);
+
+    ctx->job = jobsDispatch(JobsType::LongTask, textSearchTask, ctx, ctx->numGroups);
+    return true;
+}
+
+bool TextContentSearch::IsRunning() const
+{
+    return mCtx && mCtx->job && jobsIsRunning(mCtx->job);
+}
+
+void TextContentSearch::Cancel()
+{
+    if (!mCtx)
+        return;
+
+    atomicStore32Explicit(&mCtx->cancel, 1, AtomicMemoryOrder::Release);
+    if (mCtx->job)
+        jobsWaitForCompletion(mCtx->job);
+    textSearchDestroyContext(mCtx);
+    mCtx = nullptr;
+}
+
+bool TextContentSearch::End(Array<uint32>* outLines)
+{
+    if (!mCtx)
+        return false;
+
+    TextSearchContext* ctx = mCtx;
+    if (ctx->job)
+        jobsWaitForCompletion(ctx->job);
+    mCtx = nullptr;
+
+    TextContent* content = ctx->content;
+    outLines->Clear();
+    bool r = ctx->generation == atomicLoad32(&content->mGeneration) && !ctx->cancel;
+    if (r) {
+        // Groups are in chunk order and each group's results are sorted, so offsets are sorted as well
+        // Map them to the line that contains them. Lines are sorted by their start offset
+        AtomicLockScope lock(content->mLock);
+        const Array<TextSegment>& lines = content->mLines;
+        for (uint32 g = 0; g < ctx->numGroups; g++) {
+            for (uint64 offset : ctx->results[g]) {
+                if (lines.IsEmpty() || lines[0].begin > offset)
+                    continue;
+
+                uint32 first = 0;
+                uint32 last = lines.Count() - 1;
+                while (first < last) {
+                    uint32 mid = (first + last + 1) >> 1;
+                    if (lines[mid].begin <= offset)
+                        first = mid;
+                    else
+                        last = mid - 1;
+                }
+
+                if (outLines->IsEmpty() || outLines->Last() != first)
+                    outLines->Push(first);
+            }
+        }
+    }
+
+    textSearchDestroyContext(ctx);
+    return r;
+}
+
 GuiTextView::~GuiTextView()
 {
-    mLines.Free();
+    mSearch.Cancel();
+    mSearchLines.Free();
+    mBlocks.Free();
+    mBlockRowStart.Free();
+    for (BlockRows& b : mBlockRows)
+        b.rows.Free();
     memFree(mEditableText);
 }
 
 void GuiTextView::Reset()
 {
-    mLines.Clear();
+    mBlocks.Clear();
+    mBlockRowStart.Clear();
+    for (BlockRows& b : mBlockRows) {
+        b.rows.Clear();
+        b.blockIndex = INVALID_INDEX;
+    }
     memFree(mEditableText);
     mEditableText = nullptr;
-    mLastUpdateLineCount = 0;
-    mLastUpdateContentWidth = 0;
+    mNumRows = 0;
+    mNumLines = 0;
+    mWrapWidth = 0;
+    mScrollToLine = 0;
     mEditableLine = 0;
     mEditableLineCount = 0;
     mEditableTextSize = 0;
+    mRowStartDirty = false;
+    mSearch.Cancel();
+    mSearchLines.Clear();
+    mSearchIndex = 0;
+    mSearchDone = false;
 }
 
-void GuiTextView::Render(TextContent* content, const char* windowId)
+void GuiTextView::ScrollToLine(uint32 lineNo)
 {
-    auto CreateEditable = [this](const char* str, int lineIndex, uint32 lineNo) {
-        if (mEditableText) {
-            memFree(mEditableText);
-            mEditableText = nullptr;
+    mScrollToLine = lineNo;
+}
+
+uint32 GuiTextView::MeasureBlock(TextContent* content, uint32 blockIndex, Array<Line>* outRows)
+{
+    ImFont* font = imguiGetFonts().monoFont;
+    float fontScale = ImGui::GetIO().FontGlobalScale;
+    uint32 firstLine = blockIndex*kLinesPerBlock;
+    uint32 numRows = 0;
+
+    AtomicLockScope lock(content->mLock);
+    uint32 endLine = Min(firstLine + mBlocks[blockIndex].numLines, content->mLines.Count());
+    for (uint32 i = firstLine; i < endLine; i++) {
+        const TextSegment& line = content->mLines[i];
+        const char* text = content->GetText(line.begin, line.end);
+        if (!text) {
+            if (outRows)
+                outRows->Push(GuiTextView::Line { .lineNo = i + 1, .text = line });
+            ++numRows;
+            continue;
         }
 
-        for (int i = lineIndex; i >= 0; --i) {
-            if (mLines[i].lineNo == lineNo)
-                lineIndex = i;
-            else 
-                break;
+        uint64 beginPos = line.begin;
+        while (true) {
+            const char* wrapped = font->CalcWordWrapPositionA(fontScale, text + (beginPos - line.begin), 
+                                                              text + (line.end - line.begin), mWrapWidth);
+            uint64 wrappedPos = line.begin + uint64(wrapped - text);
+            if (outRows) {
+                outRows->Push(GuiTextView::Line {
+                    .lineNo = i + 1,
+                    .text = {beginPos, wrappedPos}
+                });
+            }
+            ++numRows;
+
+            beginPos = wrappedPos;
+            if (wrappedPos == line.end)
+                break;                
         }
+    }
 
-        uint32 totalTextSize = 0;
-        mEditableLineCount = 0;
-        for (int i = lineIndex; i < int(mLines.Count()); i++) {
-            const GuiTextView::Line& line = mLines[i];
-            if (line.lineNo == lineNo) {
-                uint32 textSize = line.text.end - line.text.begin;
-                mEditableText = memReallocTyped<char>(mEditableText, totalTextSize + textSize + 1);
-                memcpy(mEditableText + totalTextSize, str + line.text.begin, textSize);
-                mEditableText[totalTextSize + textSize] = '\n';
-                totalTextSize += (textSize + 1);
-                ++mEditableLineCount;
+    return numRows;
+}
+
+const GuiTextView::BlockRows& GuiTextView::GetBlockRows(TextContent* content, uint32 blockIndex)
+{
+    Block& block = mBlocks[blockIndex];
+    int frame = ImGui::GetFrameCount();
+
+    BlockRows* target = &mBlockRows[0];
+    for (BlockRows& b : mBlockRows) {
+        if (b.blockIndex == blockIndex && b.numLines == block.numLines) {
+            b.lastUsedFrame = frame;
+            return b;
+        }
+        if (b.lastUsedFrame < target->lastUsedFrame)
+            target = &b;
+    }
+
+    target->rows.Clear();
+    uint32 numRows = MeasureBlock(content, blockIndex, &target->rows);
+    target->blockIndex = blockIndex;
+    target->numLines = block.numLines;
+    target->lastUsedFrame = frame;
+
+    if (block.numRows != numRows || !block.measured) {
+        mNumRows = mNumRows - block.numRows + numRows;
+        block.numRows = numRows;
+        block.measured = true;
+        mRowStartDirty = true;
+    }
+
+    return *target;
+}
+
+uint32 GuiTextView::FindBlockByRow(uint64 row) const
+{
+    ASSERT(mBlocks.Count());
+    uint32 first = 0;
+    uint32 last = mBlocks.Count() - 1;
+    while (first < last) {
+        uint32 mid = (first + last + 1) >> 1;
+        if (mBlockRowStart[mid] <= row)
+            first = mid;
+        else
+            last = mid - 1;
+    }
+    return first;
+}
+
+void GuiTextView::UpdateRowStarts()
+{
+    mBlockRowStart.Reserve(mBlocks.Count());
+    mBlockRowStart.Clear();
+    uint64 numRows = 0;
+    for (const Block& block : mBlocks) {
+        mBlockRowStart.Push(numRows);
+        numRows += block.numRows;
+    }
+    mNumRows = numRows;
+    mRowStartDirty = false;
+}
+
+void GuiTextView::RenderSearchBar(TextContent* content)
+{
+    auto SelectMatch = [this](uint32 index) {
+        mSearchIndex = index;
+        ScrollToLine(mSearchLines[index] + 1);
+    };
+
+    if (mSearchDone && !mSearch.IsRunning() && mSearch.mCtx) {
+        mSearch.End(&mSearchLines);
+        if (!mSearchLines.IsEmpty())
+            SelectMatch(0);
+    }
+
+    bool search = false;
+    ImGui::SetNextItemWidth(Min(250.0f, ImGui::GetContentRegionAvail().x*0.5f));
+    search |= ImGui::InputTextWithHint("##Search", ICON_FA_SEARCH " Search", mSearchText, sizeof(mSearchText), 
+                                       ImGuiInputTextFlags_EnterReturnsTrue);
+    ImGui::SameLine();
+    search |= ImGui::Checkbox("Regex", &mSearchRegex);
+    ImGui::SameLine();
+    search |= ImGui::Checkbox("Case", &mSearchCaseSensitive);
+    ImGui::SameLine();
+    ImGui::Checkbox("Filter", &mFilterLines);
+    ImGui::SameLine();
+    ImGui::Checkbox("Times", &mShowTimes);
+    ImGui::SameLine();
+
+    ImGui::BeginDisabled(mSearchLines.IsEmpty());
+    if (ImGui::ArrowButton("##PrevMatch", ImGuiDir_Up))
+        SelectMatch(mSearchIndex ? mSearchIndex - 1 : mSearchLines.Count() - 1);
+    ImGui::SameLine();
+    if (ImGui::ArrowButton("##NextMatch", ImGuiDir_Down))
+        SelectMatch(mSearchIndex + 1 < mSearchLines.Count() ? mSearchIndex + 1 : 0);
+    ImGui::EndDisabled();
+
+    char status[64] = {};
+    if (mSearch.IsRunning()) {
+        strCopy(status, sizeof(status), "Searching ...");
+        RequestRedrawTimeout(kMainBackgroundRefreshInterval);   // Poll the results
+    }
+    else if (!mSearchLines.IsEmpty())
+        strPrintFmt(status, sizeof(status), "%u/%u", mSearchIndex + 1, mSearchLines.Count());
+    else if (mSearchDone)
+        strCopy(status, sizeof(status), "No matches");
+    if (status[0]) {
+        ImGui::SameLine();
+        ImGui::TextUnformatted(status);
+    }
+
+    if (search) {
+        mSearchLines.Clear();
+        mSearchIndex = 0;
+        TextSearchFlags flags = TextSearchFlags::None;
+        if (mSearchRegex)
+            flags |= TextSearchFlags::Regex;
+        if (mSearchCaseSensitive)
+            flags |= TextSearchFlags::CaseSensitive;
+        mSearchDone = mSearchText[0] ? mSearch.Begin(content, mSearchText, flags) : false;
+        if (!mSearchDone)
+            mSearch.Cancel();
+    }
+}
+
+void GuiTextView::RenderLineTime(TextContent* content, uint32 lineIndex)
+{
+    double secs = 0;
+    {
+        AtomicLockScope lock(content->mLock);
+        if (lineIndex < content->mLineTimes.Count()) {
+            // Runs are sorted by firstLine, find the last one that starts at or before the line
+            const Array<TextContentRun>& runs = content->mRuns;
+            uint32 first = 0;
+            uint32 count = runs.Count();
+            while (count > 0) {
+                uint32 step = count >> 1;
+                if (runs[first + step].firstLine <= lineIndex) {
+                    first += step + 1;
+                    count -= step + 1;
+                }
+                else {
+                    count = step;
+                }
             }
-            else {
-                mEditableText = memReallocTyped<char>(mEditableText, totalTextSize + 1);
-                if (totalTextSize) {
-                    if (mEditableText[totalTextSize-1] == '\n')
-                        mEditableText[totalTextSize-1] = 0;
+
+            uint64 startTime = first ? runs[first - 1].startTime : content->mLineTimes[0];
+            secs = timerToSec(timerDiff(content->mLineTimes[lineIndex], startTime));
+        }
+    }
+
+    // Same width as kLineTimeSample in Render
+    ImGui::TextDisabled("+%9.3fs", secs);
+}
+
+void GuiTextView::RenderFilteredLines(TextContent* content, float lineHeight)
+{
+    if (mScrollToLine) {
+        ImGui::SetScrollY(float(mSearchIndex)*lineHeight);
+        mScrollToLine = 0;
+    }
+
+    char id[32];
+    ImGuiListClipper clipper;
+    clipper.Begin((int)mSearchLines.Count(), lineHeight);
+    while (clipper.Step()) {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+            uint32 lineIndex = mSearchLines[i];
+            strPrintFmt(id, sizeof(id), "##Match_%d", i);
+            if (ImGui::Selectable(id, uint32(i) == mSearchIndex, ImGuiSelectableFlags_AllowDoubleClick)) {
+                mSearchIndex = uint32(i);
+
+                // Double click: Go to the line in the full output
+                if (ImGui::IsMouseDoubleClicked(0)) {
+                    mFilterLines = false;
+                    ScrollToLine(lineIndex + 1);
                 }
-                mEditableText[totalTextSize] = '\0';
-                break;
             }
+            ImGui::SameLine();
+            ImGui::TextDisabled("%u:", lineIndex + 1);
+            ImGui::SameLine();
+            if (mShowTimes) {
+                RenderLineTime(content, lineIndex);
+                ImGui::SameLine();
+            }
+
+            AtomicLockScope lock(content->mLock);
+            const char* text = nullptr;
+            TextSegment line {};
+            if (lineIndex < content->mLines.Count()) {
+                line = content->mLines[lineIndex];
+                text = content->GetText(line.begin, line.end);
+            }
+            if (text)
+                ImGui::TextUnformatted(text, text + (line.end - line.begin));
+            else
+                ImGui::TextUnformatted("");
+        }
+    }
+}
+
+void GuiTextView::Render(TextContent* content, const char* windowId)
+{
+    auto CreateEditable = [this, content](const Array<Line>& rows, uint32 rowIndex, uint32 lineNo) {
+        while (rowIndex > 0 && rows[rowIndex - 1].lineNo == lineNo)
+            --rowIndex;
+
+        uint32 endIndex = rowIndex;
+        uint32 totalTextSize = 0;
+        for (; endIndex < rows.Count() && rows[endIndex].lineNo == lineNo; endIndex++) 
+            totalTextSize += uint32(rows[endIndex].text.end - rows[endIndex].text.begin) + 1;
+
+        memFree(mEditableText);
+        mEditableText = memAllocTyped<char>(totalTextSize + 1);
+
+        AtomicLockScope lock(content->mLock);
+        uint32 offset = 0;
+        for (uint32 i = rowIndex; i < endIndex; i++) {
+            const TextSegment& segment = rows[i].text;
+            const char* text = content->GetText(segment.begin, segment.end);
+            uint32 textSize = text ? uint32(segment.end - segment.begin) : 0;
+            if (textSize)
+                memcpy(mEditableText + offset, text, textSize);
+            offset += textSize;
+            mEditableText[offset++] = '\n';
         }
+        if (offset && mEditableText[offset - 1] == '\n')
+            mEditableText[offset - 1] = 0;
+        mEditableText[offset] = '\0';
 
         mEditableLine = lineNo;        
-        mEditableTextSize = totalTextSize;
+        mEditableLineCount = endIndex - rowIndex;
+        mEditableTextSize = offset;
     };
 
     Docking& dock = imguiGetDocking();
@@ -139,103 +1528,191 @@ void GuiTextView::Render(TextContent* content, const char* windowId)
     }
 
     ImGui::SetNextWindowSize(ImVec2(500, 300), ImGuiCond_FirstUseEver);
-    if (ImGui::Begin(windowId, nullptr, ImGuiWindowFlags_AlwaysVerticalScrollbar)) {
+    if (ImGui::Begin(windowId)) {
+        RenderSearchBar(content);
+        ImGui::BeginChild("##Lines", ImVec2(0, 0), false, ImGuiWindowFlags_AlwaysVerticalScrollbar);
+
         bool updated = false;
-        float contentWidth = ImGui::GetContentRegionAvail().x;        
-        bool widgetResized = mathAbs(contentWidth - mLastUpdateContentWidth) >= 1.0f;
-        bool contentChanged = mLastUpdateLineCount != content->mLines.Count();
-        if ((widgetResized || contentChanged) && atomicLockTryEnter(&content->mLock)) 
-        {
-            uint32 startIndex = mLastUpdateLineCount;
-            mLastUpdateLineCount = content->mLines.Count();
-            mLastUpdateContentWidth = contentWidth;
-
-            MemTempAllocator tempAlloc;
-            Array<TextSegment> tempContentLines(&tempAlloc);
-            content->mLines.CopyTo(&tempContentLines);
-            atomicLockExit(&content->mLock);
-            
-            atomicUint32 kOne = 1;
-            if (atomicCompareExchange32Weak(&content->mResetFlag, &kOne, 0) || widgetResized) {
-                mLines.Clear();
-                startIndex = 0;
-            }
 
-            ImFont* font = imguiGetFonts().monoFont;
-            float fontScale = ImGui::GetIO().FontGlobalScale;
-            const char* strPtr = (const char*)content->mBlob.Data();
-        
-            uint32 lineNo = startIndex + 1;
-            
-            for (uint32 i = startIndex; i < tempContentLines.Count(); i++) {
-                const TextSegment& line = tempContentLines[i];
-                uint32 beginPos = line.begin;
-                while (true) {
-                    const char* wrapped = font->CalcWordWrapPositionA(fontScale, strPtr + beginPos, strPtr + line.end, contentWidth);
-                    uint32 wrappedPos = (uint32)uintptr_t(wrapped - strPtr);
-                    mLines.Push(GuiTextView::Line {
-                        .lineNo = lineNo,
-                        .text = {beginPos, wrappedPos}
-                    });
-
-                    beginPos = wrappedPos;
-                    if (wrappedPos == line.end)
-                        break;                
-                }
+        ImGui::PushFont(imguiGetFonts().monoFont);
+        float lineHeight = ImGui::GetTextLineHeightWithSpacing();
+
+        // Line times take a fixed column on the left, text is wrapped in the rest
+        static const char* kLineTimeSample = "+00000.000s";
+        float timesWidth = mShowTimes ? ImGui::CalcTextSize(kLineTimeSample).x : 0;
+        float contentWidth = ImGui::GetContentRegionAvail().x - (mShowTimes ? timesWidth + ImGui::GetStyle().ItemSpacing.x : 0);
 
-                lineNo++;
+        atomicUint32 kOne = 1;
+        uint32 numLines = content->mLines.Count();
+        if (atomicCompareExchange32Weak(&content->mResetFlag, &kOne, 0) || numLines < mNumLines) {
+            float wrapWidth = mWrapWidth;
+            Reset();
+            mWrapWidth = wrapWidth;
+        }
+
+        // Width changed: Keep the old row counts as estimates and only re-wrap what's visible. The rest is refined below
+        if (mathAbs(contentWidth - mWrapWidth) >= 1.0f) {
+            mWrapWidth = contentWidth;
+            for (Block& block : mBlocks)
+                block.measured = false;
+            for (BlockRows& b : mBlockRows)
+                b.blockIndex = INVALID_INDEX;
+            mAutoScroll = true;
+            updated = true;
+        }
+
+        // New lines: Account one row for each until they are measured
+        if (numLines > mNumLines) {
+            uint32 lineIndex = mNumLines;
+            while (lineIndex < numLines) {
+                if (mBlocks.IsEmpty() || mBlocks.Last().numLines == kLinesPerBlock)
+                    mBlocks.Push(Block {});
+                Block& block = mBlocks.Last();
+                uint32 count = Min(kLinesPerBlock - block.numLines, numLines - lineIndex);
+                block.numLines += count;
+                block.numRows += count;
+                block.measured = false;
+                lineIndex += count;
+                mNumRows += count;
             }
 
+            mNumLines = numLines;
+            mRowStartDirty = true;
             mAutoScroll = true;
             updated = true;
         }
 
-        ImGui::PushFont(imguiGetFonts().monoFont);
+        // Refine row count estimates within a time budget. Compensate the scroll for the blocks that are above the view
+        if (mRowStartDirty)
+            UpdateRowStarts();
+        {
+            uint64 firstVisibleRow = uint64(ImGui::GetScrollY() / lineHeight);
+            int64 scrollRowsDelta = 0;
+            TimerStopWatch stopwatch;
+            for (uint32 i = 0; i < mBlocks.Count() && stopwatch.ElapsedMS() < 2.0; i++) {
+                Block& block = mBlocks[i];
+                if (block.measured)
+                    continue;
 
-        // TEMP: We need to be able to select multiple lines with Shift pressed
-        //       We also can have a max number of lines selected like 64
-        static uint32 selectedLine = 0;
-        static uint32 selectedLine2 = 0;
-        const char* strPtr = (const char*)content->mBlob.Data();
-        char id[32];
-        float lineHeight = ImGui::GetTextLineHeightWithSpacing();
+                uint32 numRows = MeasureBlock(content, i, nullptr);
+                if (numRows != block.numRows) {
+                    if (mBlockRowStart[i] + block.numRows <= firstVisibleRow)
+                        scrollRowsDelta += int64(numRows) - int64(block.numRows);
+                    mNumRows = mNumRows - block.numRows + numRows;
+                    block.numRows = numRows;
+                    mRowStartDirty = true;
+                }
+                block.measured = true;
+            }
+
+            if (mRowStartDirty)
+                UpdateRowStarts();
+            if (scrollRowsDelta && !mAutoScroll)
+                ImGui::SetScrollY(ImGui::GetScrollY() + float(scrollRowsDelta)*lineHeight);
+        }
+
+        if (mFilterLines && mSearchDone) {
+            RenderFilteredLines(content, lineHeight);
+            mAutoScroll = false;
+        }
+        else {
+            if (mScrollToLine && mNumLines) {
+                uint32 lineIndex = Min(mScrollToLine, mNumLines) - 1;
+                uint32 blockIndex = lineIndex / kLinesPerBlock;
+                const BlockRows& blockRows = GetBlockRows(content, blockIndex);
+                if (mRowStartDirty)
+                    UpdateRowStarts();
+
+                uint64 row = mBlockRowStart[blockIndex];
+                for (const Line& line : blockRows.rows) {
+                    if (line.lineNo > lineIndex)
+                        break;
+                    ++row;
+                }
+
+                ImGui::SetScrollY(float(row)*lineHeight);
+                mScrollToLine = 0;
+                mAutoScroll = false;
+                updated = false;
+            }
+
+            // TEMP: We need to be able to select multiple lines with Shift pressed
+            //       We also can have a max number of lines selected like 64
+            static uint32 selectedLine = 0;
+            static uint32 selectedLine2 = 0;
+            char id[32];
 
-        ImGuiListClipper clipper;
-        clipper.Begin((int)mLines.Count());
-        while (clipper.Step()) {
-            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
-                const GuiTextView::Line& line = mLines[i];
-                strPrintFmt(id, sizeof(id), "##Line_%d", i);
-
-                if (mEditableLine != line.lineNo) {
-                    if (ImGui::Selectable(id, line.lineNo == selectedLine || line.lineNo == selectedLine2, ImGuiSelectableFlags_AllowDoubleClick)) {
-                        if (ImGui::GetIO().KeyCtrl) {
-                            if (selectedLine == 0)
-                                selectedLine = line.lineNo;
-                            else if (selectedLine2 == 0)
-                                selectedLine2 = line.lineNo;
+            ImGuiListClipper clipper;
+            clipper.Begin((int)mNumRows, lineHeight);
+            while (clipper.Step()) {
+                if (clipper.DisplayStart >= clipper.DisplayEnd)
+                    continue;
+
+                uint32 blockIndex = FindBlockByRow(uint64(clipper.DisplayStart));
+                for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                    while (blockIndex + 1 < mBlocks.Count() && uint64(i) >= mBlockRowStart[blockIndex + 1])
+                        ++blockIndex;
+
+                    // Note: Measuring a block can change its row count. Row starts are updated in the next frame
+                    const BlockRows& blockRows = GetBlockRows(content, blockIndex);
+                    uint32 rowIndex = uint32(uint64(i) - mBlockRowStart[blockIndex]);
+                    if (rowIndex >= blockRows.rows.Count()) {
+                        ImGui::Dummy(ImVec2(0, ImGui::GetTextLineHeight()));
+                        continue;
+                    }
+
+                    const GuiTextView::Line& line = blockRows.rows[rowIndex];
+                    strPrintFmt(id, sizeof(id), "##Line_%d", i);
+
+                    if (mEditableLine != line.lineNo) {
+                        bool selected = line.lineNo == selectedLine || line.lineNo == selectedLine2 ||
+                                        (!mSearchLines.IsEmpty() && line.lineNo == mSearchLines[mSearchIndex] + 1);
+                        if (ImGui::Selectable(id, selected, ImGuiSelectableFlags_AllowDoubleClick)) {
+                            if (ImGui::GetIO().KeyCtrl) {
+                                if (selectedLine == 0)
+                                    selectedLine = line.lineNo;
+                                else if (selectedLine2 == 0)
+                                    selectedLine2 = line.lineNo;
+                            }
+                            else {
+                                selectedLine = 0;
+                                selectedLine2 = 0;
+                            }
+    
+
+                            if (ImGui::IsMouseDoubleClicked(0))
+                                CreateEditable(blockRows.rows, rowIndex, line.lineNo);
+                            else
+                                mEditableLine = 0;
                         }
-                        else {
-                            selectedLine = 0;
-                            selectedLine2 = 0;
+                        ImGui::SameLine();
+
+                        if (mShowTimes) {
+                            if (rowIndex == 0 || blockRows.rows[rowIndex - 1].lineNo != line.lineNo)
+                                RenderLineTime(content, line.lineNo - 1);
+                            else
+                                ImGui::Dummy(ImVec2(timesWidth, ImGui::GetTextLineHeight()));
+                            ImGui::SameLine();
                         }
-    
 
-                        if (ImGui::IsMouseDoubleClicked(0))
-                            CreateEditable(strPtr, i, line.lineNo);
+                        AtomicLockScope lock(content->mLock);
+                        const char* text = content->GetText(line.text.begin, line.text.end);
+                        if (text)
+                            ImGui::TextUnformatted(text, text + (line.text.end - line.text.begin));
                         else
-                            mEditableLine = 0;
+                            ImGui::TextUnformatted("");
+                    }
+                    else if (rowIndex == 0 || blockRows.rows[rowIndex - 1].lineNo != line.lineNo) {
+                        ASSERT(mEditableText);
+                        ImGui::InputTextMultiline(id, mEditableText, mEditableTextSize,
+                                                  ImVec2(-1, mEditableLineCount*lineHeight + 5), 
+                                                  ImGuiInputTextFlags_ReadOnly|ImGuiInputTextFlags_AutoSelectAll|
+                                                  ImGuiInputTextFlags_NoHorizontalScroll);
+                        i += mEditableLineCount - 1;
+                    }
+                    else {
+                        ImGui::Dummy(ImVec2(0, ImGui::GetTextLineHeight()));
                     }
-                    ImGui::SameLine();
-                    ImGui::TextUnformatted(strPtr + line.text.begin, strPtr + line.text.end);
-                }
-                else {
-                    ASSERT(mEditableText);
-                    ImGui::InputTextMultiline(id, mEditableText, mEditableTextSize,
-                                              ImVec2(-1, mEditableLineCount*lineHeight + 5), 
-                                              ImGuiInputTextFlags_ReadOnly|ImGuiInputTextFlags_AutoSelectAll|
-                                              ImGuiInputTextFlags_NoHorizontalScroll);
-                    i += mEditableLineCount - 1;
                 }
             }
         }
@@ -246,6 +1723,8 @@ void GuiTextView::Render(TextContent* content, const char* windowId)
             ImGui::SetScrollY(ImGui::GetScrollMaxY());
         if (!updated && mAutoScroll)
             mAutoScroll = false;
+
+        ImGui::EndChild();
     }
 
     if (ImGui::IsWindowDocked())
@@ -253,7 +1732,7 @@ void GuiTextView::Render(TextContent* content, const char* windowId)
     else 
         dock.dockIdForOutputs = 0;
 
-    if (ImGui::IsWindowFocused())
+    if (ImGui::IsWindowFocused(ImGuiFocusedFlags_RootAndChildWindows))
         SetFocusedWindow(FocusedWindow { .type = FocusedWindow::Type::Output, .obj = this });
 
     ImGui::End();
@@ -6,47 +6,210 @@
 
 struct TextSegment
 {
-    uint32 begin;
-    uint32 end;
+    uint64 begin;
+    uint64 end;
+};
+
+// Spill mode: Bounded memory capture for very large outputs
+// Keeps the first `headSize` bytes and at least the last `tailSize` bytes of the stream in memory. 
+// Everything is also written to a temp file in the cache directory and the parts that fall out of memory are read back with FileMapping
+struct TextContentSpillParams
+{
+    size_t headSize = 4*kMB;
+    size_t tailSize = 16*kMB;
+};
+
+struct TextContentSpill;
+
+// Start of every BeginWrite in the stream, line times are shown relative to the run that they belong to
+struct TextContentRun
+{
+    uint32 firstLine;
+    uint64 startTime;   // timerGetTicks
+};
+
+// Segment mode (default): Captured text is stored in fixed-size segments that are pooled across all the contents and runs
+// Segments are append-only and reference counted, so redirected contents reference the segments of the source instead of copying
+// Unfinished lines are moved to the next segment when one gets full, so lines don't cross segments (except in rare redirect cases)
+static inline constexpr uint32 kTextSegmentSize = 64*kKB;
+
+struct TextArenaSegment;
+
+struct TextSegmentRef
+{
+    TextArenaSegment* seg;
+    uint64 start;       // Stream offset of the first byte
+    uint32 offset;      // Offset of the first byte in the segment data
+    uint32 size;
+};
+
+struct TextArenaStats
+{
+    uint64 bytesCaptured;   // Total stream size of the contents. Redirected text is counted for both contents
+    uint64 bytesResident;   // Segments that are referenced by the contents
+    uint64 bytesPooled;     // Free segments that are kept for reuse
+};
+
+void textArenaGetStats(TextArenaStats* stats);
+void textArenaRelease();    // Frees the pooled segments
+
+// Search index: For every kSearchChunkSize bytes of the stream, we keep a bitmap of the (lower-case) trigrams in it
+// Searches only scan the chunks that can contain all the trigrams of the query. The overhead is 1/32 of the stream size
+static inline constexpr uint32 kSearchChunkSize = 64*kKB;
+static inline constexpr uint32 kSearchChunkBits = kSearchChunkSize/4;
+
+struct TextSearchChunk
+{
+    uint64 bits[kSearchChunkBits/64];
 };
 
 struct TextContent
 {
-    MemBumpAllocatorVM mAlloc;   // Allocator for the blob. we need to keep all the text persistent and do not invalidate pointers
-    Blob mBlob;
-    Array<TextSegment> mLines; // holds references to blob data
+    Array<TextSegmentRef> mSegments;    // Sorted by stream offset, they cover the whole stream without gaps
+    Array<TextArenaSegment*> mRetiredSegments;  // Released on Reset while searches are still reading them
+    Blob mScratch;             // GetText copies the ranges that cross segments here
+    uint64 mSize = 0;
+    Array<TextSegment> mLines; // holds references to the stream (offsets)
+    Array<uint64> mLineTimes;  // Arrival time of each line (timerGetTicks), parallel to mLines
+    Array<TextContentRun> mRuns;
     AtomicLock mLock;
-    const char* mLastLinePtr = nullptr;
+    uint64 mLineStart = 0;     // Stream offset of the line that is being parsed
+    uint64 mParseOffset = 0;   // Stream offset that parsing continues from
     TextContent* mRedirectContent = nullptr;
+    TextContentSpill* mSpill = nullptr;     // Only valid in spill mode. See InitializeSpill
     uint32 mResetFlag = 0;
+    uint32 mGeneration = 0;    // Incremented on every Reset, so running searches know that their data is invalid
+    uint32 mNumSearches = 0;   // Number of running search jobs. Release waits for them
+    Array<TextSearchChunk*> mSearchChunks;  // Chunks are kept allocated after Reset, because searches may still read them
+    uint32 mNumSearchChunks = 0;
+    uint32 mSearchTrigram = 0;
+    char mLastParsedChar = 0;
 
-    bool Initialize(size_t reserveSize = kMB*256, size_t pageSize = kKB*512);
+    bool Initialize();
+    bool InitializeSpill(const TextContentSpillParams& params = TextContentSpillParams());
     void Release();
     void WriteData(const void* src, size_t size);
     template <typename _T> void WriteData(const _T& v) { WriteData(&v, sizeof(v)); }
     void ParseLines();
     void Reset();
+
+    // Either resets the content or removes the null-terminator of the previous write, so we can continue writing
+    // Returns the stream offset that new data starts from
+    uint64 BeginWrite(bool reset);
+    // Writes the null-terminator and parses the remaining lines
+    void EndWrite();
+
+    // In-place writing: Returns at least `minSize` bytes of free space at the end of the stream (outSize), so the data can be 
+    // read straight into the storage. The data becomes a part of the stream with CommitWrite, which indexes and parses it in place
+    // Only one write can be reserved at a time, and it must be committed before any other write
+    char* ReserveWrite(uint32 minSize, uint32* outSize);
+    void CommitWrite(uint32 size);
+
+    uint64 GetSize() const;
+
+    // Returns pointer to contiguous text for the stream range [begin, end). mLock must be held while using it
+    // In segment mode, ranges that cross segments are copied to a scratch buffer that is overwritten by the next call
+    // In spill mode, the pointer can come from the file mapping or the sliding tail buffer
+    const char* GetText(uint64 begin, uint64 end);
+
+    void AppendData(const void* src, size_t size);
+    void AppendShared(TextContent* source, uint64 sourceOffset, const void* src, size_t size);
+    uint32 FindSegment(uint64 offset) const;
+    TextSegmentRef* ReserveSegment(uint32 minSize = 1);
+    void ReleaseSegments();
+    void ParseData(const char* data, uint64 dataOffset, size_t size);
+    void IndexData(const char* data, uint64 dataOffset, size_t size);
+};
+
+enum class TextSearchFlags : uint32
+{
+    None = 0,
+    CaseSensitive = 0x1,
+    Regex = 0x2     // Supports: . ^ $ * + ? [] and \d \w \s escapes
+};
+ENABLE_BITMASK(TextSearchFlags);
+
+// Matches a single line against a query in the TextSearchFlags::Regex syntax. Optionally returns the part of the line that matched
+bool textRegexMatch(const char* regex, const char* text, size_t len, bool caseSensitive = true, 
+                    uint32* outMatchOffset = nullptr, uint32* outMatchLen = nullptr);
+
+struct TextSearchContext;
+
+// Searches the text that is captured so far in the background. Chunks are scanned in parallel on the job system
+struct TextContentSearch
+{
+    TextSearchContext* mCtx = nullptr;
+
+    bool Begin(TextContent* content, const char* query, TextSearchFlags flags = TextSearchFlags::None);
+    bool IsRunning() const;
+    void Cancel();
+    // Waits for the search to finish and outputs the matching line indexes (sorted, unique)
+    // Returns false if the search is cancelled or the content is reset in the meantime
+    bool End(Array<uint32>* outLines);
 };
 
 struct GuiTextView
 {
+    static constexpr uint32 kLinesPerBlock = 1024;
+
     struct Line
     {
         uint32 lineNo;
         TextSegment text;
     };
 
-    Array<Line> mLines;
-    uint32 mLastUpdateLineCount = 0;
-    float mLastUpdateContentWidth = 0;
+    // Wrapped rows are counted per block of content lines. Blocks that are not measured for the current wrap width
+    // keep their last row count as an estimate, until they are refined in the next frames
+    struct Block
+    {
+        uint32 numRows;
+        uint32 numLines;    // Number of content lines that are accounted for in numRows
+        bool measured;
+    };
+
+    // Wrapped rows of the recently rendered blocks
+    struct BlockRows
+    {
+        Array<Line> rows;
+        uint32 blockIndex = INVALID_INDEX;
+        uint32 numLines = 0;
+        int lastUsedFrame = 0;
+    };
+
+    Array<Block> mBlocks;
+    Array<uint64> mBlockRowStart;   // Prefix sum of block rows, for row to block lookups
+    BlockRows mBlockRows[4];
+    uint64 mNumRows = 0;
+    uint32 mNumLines = 0;
+    float mWrapWidth = 0;
+    uint32 mScrollToLine = 0;
     uint32 mEditableLine = 0;
     uint32 mEditableLineCount = 0;
     uint32 mEditableTextSize = 0;
     char* mEditableText = nullptr;
+    TextContentSearch mSearch;
+    Array<uint32> mSearchLines;     // Line indexes that matched the last search
+    uint32 mSearchIndex = 0;
+    char mSearchText[256] = {};
+    bool mSearchRegex = false;
+    bool mSearchCaseSensitive = false;
+    bool mSearchDone = false;
+    bool mFilterLines = false;      // Only show the lines that matched the search
+    bool mShowTimes = false;        // Show arrival time of the lines, relative to the start of their run
+    bool mRowStartDirty = false;
     bool mAutoScroll = true;
     bool mFirstTimeShow = false;
 
     void Render(TextContent* content, const char* windowId);
+    void ScrollToLine(uint32 lineNo);   // lineNo starts from 1
     ~GuiTextView();
     void Reset();
+
+    uint32 MeasureBlock(TextContent* content, uint32 blockIndex, Array<Line>* outRows);
+    const BlockRows& GetBlockRows(TextContent* content, uint32 blockIndex);
+    uint32 FindBlockByRow(uint64 row) const;
+    void UpdateRowStarts();
+    void RenderSearchBar(TextContent* content);
+    void RenderFilteredLines(TextContent* content, float lineHeight);
+    void RenderLineTime(TextContent* content, uint32 lineIndex);
 };
@@ -475,8 +475,10 @@ void guiUpdate()
         AtomicLockScope lock(status.lock);
         ImDrawList* fgDrawList = ImGui::GetForegroundDrawList();
         float y = displaySize.y - lineSize;
-        status.showTime += 1.0f / ImGui::GetIO().Framerate;
+        status.showTime += ImGui::GetIO().DeltaTime;
         float alpha = mathLinearStep(status.showTime, 0, 5.0f);
+        if (alpha < 1.0f)
+            RequestRedrawTimeout(kMainBackgroundRefreshInterval);   // Keep fading out
         alpha = 1.0f - mathGain(alpha, 0.05f);
         status.color.a = uint8(alpha * 255.0f);
 
@@ -509,6 +511,7 @@ void guiStatus(LogLevel level, const char* fmt, ...)
     }
 
     status.showTime = 0;
+    RequestBackgroundRedraw();  // Can be called from any thread through the log callback
 }
 
 void guiFileDialog(const char* name, const char* cwd, GuiFileDialogFlags flags, GuiFileDialogCallback callback, void* callbackUser)
@@ -540,5 +543,7 @@ void guiFileDialog(const char* name, const char* cwd, GuiFileDialogFlags flags,
 
 void _private::guiLog(const LogEntry& entry, void*)
 {
+    if (entry.channels & kGuiLogChannelNoStatus)
+        return;
     guiStatus(entry.type, entry.text);
 }
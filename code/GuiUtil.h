@@ -44,6 +44,8 @@ void guiUpdate();
 
 void guiStatus(LogLevel level, const char* fmt, ...);
 
+static inline constexpr uint32 kGuiLogChannelNoStatus = 0x1;     // Log entries on this channel don't show up in the status bar
+
 namespace _private
 {
     void guiLog(const LogEntry& entry, void*);
@@ -31,11 +31,28 @@ struct LayoutSettings
     uint16 windowY;    
 };
 
+// Node output capture. When spillToDisk is enabled, only head/tail of each output is kept in memory
+// and the rest is read back from a temp file in the cache directory
+struct OutputSettings
+{
+    bool spillToDisk = false;
+    uint32 spillHeadSizeMB = 4;
+    uint32 spillTailSizeMB = 16;
+};
+
+// Task history journal (<graph>.task). Only the last `retainedRuns` runs are kept, older ones are dropped on compaction
+struct TaskSettings
+{
+    uint32 retainedRuns = 1000;
+};
+
 struct Settings
 {
     BuildSettings build;
     ToolsSettings tools;
     LayoutSettings layout;
+    OutputSettings output;
+    TaskSettings tasks;
 };
 
 struct FocusedWindow
@@ -55,6 +72,16 @@ void Release();
 void Update();
 Settings& GetSettings();
 
+// Redraw on demand: The platform main loop sleeps until there is input, or something asks for a frame
+// Background changes (progress events, output lines, task events) are throttled to kMainBackgroundRefreshInterval
+static inline constexpr uint32 kMainBackgroundRefreshInterval = 100;    // msecs (10hz)
+
+void RequestRedraw();                       // Main thread: Draws the next few frames, imgui needs them to settle after a change
+void RequestRedrawTimeout(uint32 msecs);    // Main thread: Draws a frame after msecs at the latest. Re-request it on every frame for animations
+void RequestBackgroundRedraw();             // Thread-safe: Something visible has changed in the background
+uint32 GetRedrawWaitTime();                 // msecs that the main loop can sleep before the next frame, UINT32_MAX is forever
+void WakeMainLoop();                        // Implemented by the platform main loop. Thread-safe
+
 void* CreateRGBATexture(uint32 width, uint32 height, const void* data);
 void  DestroyTexture(void* handle);
 
@@ -20,6 +20,9 @@
 
 id <MTLDevice> gMetalDevice;
 
+@class AppViewController;
+static AppViewController* gViewController;
+
 @interface AppViewController : NSViewController<NSWindowDelegate>
 @end
 
@@ -27,6 +30,8 @@ id <MTLDevice> gMetalDevice;
 @property (nonatomic, readonly) MTKView *mtkView;
 @property (nonatomic, strong) id <MTLDevice> device;
 @property (nonatomic, strong) id <MTLCommandQueue> commandQueue;
+@property (nonatomic) uint32 redrawGeneration;
+-(void)scheduleRedraw;
 @end
 
 //-----------------------------------------------------------------------------------
@@ -51,6 +56,7 @@ id <MTLDevice> gMetalDevice;
     }
     
     gMetalDevice = _device;
+    gViewController = self;
 
     imguiInitialize();
 
@@ -83,8 +89,20 @@ id <MTLDevice> gMetalDevice;
     self.mtkView.device = self.device;
     self.mtkView.delegate = self;
 
+    // Frames are drawn on demand, see scheduleRedraw
+    self.mtkView.paused = YES;
+    self.mtkView.enableSetNeedsDisplay = NO;
+
     ImGui_ImplOSX_Init(self.view);
 
+    [NSEvent addLocalMonitorForEventsMatchingMask:NSEventMaskAny handler:^NSEvent*(NSEvent* event) {
+        RequestRedraw();
+        [self scheduleRedraw];
+        return event;
+    }];
+    RequestRedraw();
+    [self scheduleRedraw];
+
     [NSApp activateIgnoringOtherApps:YES];
 }
 
@@ -142,10 +160,28 @@ id <MTLDevice> gMetalDevice;
         
         memTempReset(1.0f / io.Framerate);
     }
+
+    [self scheduleRedraw];
+}
+
+// Draws the next frame after GetRedrawWaitTime. Newer calls cancel the pending ones, because they see the latest requests
+-(void)scheduleRedraw
+{
+    uint32 waitTime = GetRedrawWaitTime();
+    uint32 generation = ++self.redrawGeneration;
+    if (waitTime == UINT32_MAX)
+        return;
+
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, int64_t(waitTime)*int64_t(NSEC_PER_MSEC)), dispatch_get_main_queue(), ^{
+        if (generation == self.redrawGeneration)
+            [self.mtkView draw];
+    });
 }
 
 -(void)mtkView:(MTKView*)view drawableSizeWillChange:(CGSize)size
 {
+    RequestRedraw();
+    [self scheduleRedraw];
 }
 
 - (NSSize)windowWillResize:(NSWindow *)sender toSize:(NSSize)frameSize
@@ -232,6 +268,13 @@ void DestroyTexture(void*)
 {
 }
 
+void WakeMainLoop()
+{
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [gViewController scheduleRedraw];
+    });
+}
+
 // TODO:
 bool SetClipboardString(const char* text)
 {
@@ -304,22 +304,35 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int n
 
     // Main loop
     bool done = false;
+    RequestRedraw();
     while (!done && !gWindow.quit)
     {
+        // Sleep until there is input, a background change or a timer (see GetRedrawWaitTime)
+        uint32 waitTime = GetRedrawWaitTime();
+        if (waitTime)
+            ::MsgWaitForMultipleObjectsEx(0, nullptr, waitTime == UINT32_MAX ? INFINITE : waitTime, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+
         // Poll and handle messages (inputs, window resize, etc.)
         // See the WndProc() function below for our to dispatch events to the Win32 backend.
         MSG msg;
         while (::PeekMessage(&msg, nullptr, 0U, 0U, PM_REMOVE))
         {
+            // WM_NULL is posted by WakeMainLoop, everything else is input or window changes
+            if (msg.message != WM_NULL)
+                RequestRedraw();
+            if (msg.message == WM_QUIT)
+                done = true;
             ::TranslateMessage(&msg);
             ::DispatchMessage(&msg);
         }
 
-        if (msg.message == WM_QUIT)
-            done = true;
         if (done)
             break;
 
+        // Woken up by a background change that is still throttled, nothing to draw yet
+        if (GetRedrawWaitTime())
+            continue;
+
         // Handle window resize (we don't resize directly in the WM_SIZE handler)
         if (gWindow.resizeWidth != 0 && gWindow.resizeHeight != 0)
         {
@@ -443,6 +456,12 @@ LRESULT WINAPI WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
     return ::DefWindowProcW(hWnd, msg, wParam, lParam);
 }
 
+void WakeMainLoop()
+{
+    if (gWindow.hwnd)
+        ::PostMessage(gWindow.hwnd, WM_NULL, 0, 0);
+}
+
 void* CreateRGBATexture(uint32 width, uint32 height, const void* data)
 {
     ID3D11Texture2D* texture;
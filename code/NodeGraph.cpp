@@ -4,6 +4,8 @@
 #include "Core/Jobs.h"
 #include "Core/System.h"
 #include "Core/Atomic.h"
+#include "Core/Hash.h"
+#include "Core/JsonParser.h"
 
 #include "Main.h"
 #include "BuiltinProps.h"
@@ -11,6 +13,7 @@
 #include "TaskMan.h"
 #include "Workspace.h"
 #include "GuiTextView.h"
+#include "SaveQueue.h"
 
 #include "ImGui/ImGuiAll.h"
 
@@ -27,6 +30,7 @@ enum class NodeGraphProgressEventType
     LinkComplete
 };
 
+// One entry per node or link that has progress since the last ngUpdateEvents, later events overwrite the type
 struct NodeGraphProgressEvent
 {
     NodeGraphProgressEventType type;
@@ -34,6 +38,7 @@ struct NodeGraphProgressEvent
         NodeHandle nodeHandle;
         LinkHandle linkHandle;
     };
+    NodeGraphProgressCounters counters;
 };
 
 struct NodeGraphDep
@@ -52,6 +57,8 @@ struct NodeGraph
     NodeGraphEvents* events;
     Mutex progressEventsMutex;
     Array<NodeGraphProgressEvent> progressEventsQueue;
+    HashTable<uint32> progressNodeIndices;  // NodeHandle -> Index to progressEventsQueue
+    HashTable<uint32> progressLinkIndices;  // LinkHandle -> Index to progressEventsQueue
     PropertyHandle executePropHandle;
     Array<NodeGraphDep> childGraphs;
     WksFileHandle fileHandle;
@@ -189,6 +196,10 @@ NodeGraph* ngCreate(Allocator* alloc, NodeGraphEvents* events)
     graph->propPool.SetAllocator(alloc);
     graph->childGraphs.SetAllocator(alloc);
     graph->progressEventsQueue.SetAllocator(alloc);
+    graph->progressNodeIndices.SetAllocator(alloc);
+    graph->progressLinkIndices.SetAllocator(alloc);
+    graph->progressNodeIndices.Reserve(32);
+    graph->progressLinkIndices.Reserve(32);
     graph->alloc = alloc;
     graph->events = events;
     graph->progressEventsMutex.Initialize();
@@ -249,11 +260,32 @@ void ngDestroy(NodeGraph* graph)
         graph->childGraphs.Free();
         graph->errorString.Free();
         graph->progressEventsQueue.Free();
+        graph->progressNodeIndices.Free();
+        graph->progressLinkIndices.Free();
         graph->progressEventsMutex.Release();
         memFree(graph, graph->alloc);
     }
 }
 
+static TextContent* ngCreateOutputText()
+{
+    TextContent* content = NEW(memDefaultAlloc(), TextContent);
+    const OutputSettings& settings = GetSettings().output;
+    if (settings.spillToDisk) {
+        TextContentSpillParams params {
+            .headSize = size_t(settings.spillHeadSizeMB)*kMB,
+            .tailSize = size_t(settings.spillTailSizeMB)*kMB
+        };
+
+        if (content->InitializeSpill(params))
+            return content;
+        logWarning("Spilling node output to disk failed, falling back to in-memory capture");
+    }
+
+    content->Initialize();
+    return content;
+}
+
 NodeHandle ngCreateNode(NodeGraph* graph, const char* name, const SysUUID* uuid)
 {
     uint32 index = gNodeGraph.nodeTemplates.FindIf([name](const NodeGraphNodeTemplate& templ)
@@ -284,10 +316,8 @@ NodeHandle ngCreateNode(NodeGraph* graph, const char* name, const SysUUID* uuid)
     node.inPins.SetAllocator(graph->alloc);
     node.outPins.SetAllocator(graph->alloc);
     
-    if (node.desc.captureOutput) {
-        node.outputText = NEW(memDefaultAlloc(), TextContent);
-        node.outputText->Initialize();
-    }
+    if (node.desc.captureOutput)
+        node.outputText = ngCreateOutputText();
     
     const NodeDesc& desc = nodeTempl.desc;
     if (desc.dynamicInPins)
@@ -338,6 +368,7 @@ void ngDestroyNode(NodeGraph* graph, NodeHandle handle)
     
     if (node.desc.captureOutput) {
         node.outputText->Release();
+        memFree(node.outputText);
         node.outputText = nullptr;
     }
     node.impl->Release(graph, handle);
@@ -410,10 +441,8 @@ NodeHandle ngDuplicateNode(NodeGraph* graph, NodeHandle dupHandle)
         return NodeHandle {};
     }
     
-    if (node.desc.captureOutput) {
-        node.outputText = NEW(memDefaultAlloc(), TextContent);
-        node.outputText->Initialize();
-    }
+    if (node.desc.captureOutput)
+        node.outputText = ngCreateOutputText();
     
     for (uint32 i = 0; i < srcNode.inPins.Count(); i++) {
         Pin& srcPin = graph->pinPool.Data(srcNode.inPins[i]);
@@ -712,10 +741,36 @@ static void ngExecuteNodesTask(uint32 index, void* userData)
     }
 }
 
+// Loops can run a node thousands of times between two frames, so events are coalesced per node and link as they come in
+// This keeps the queue and the work in ngUpdateEvents bounded by the graph size instead of the number of iterations
 static inline void ngPushProgressEvent(NodeGraph* graph, const NodeGraphProgressEvent& e)
 {
-    MutexScope mtx(graph->progressEventsMutex);
-    graph->progressEventsQueue.Push(e);
+    bool isLink = e.type == NodeGraphProgressEventType::LinkComplete;
+    uint32 key = isLink ? uint32(e.linkHandle) : uint32(e.nodeHandle);
+
+    {
+        MutexScope mtx(graph->progressEventsMutex);
+        HashTable<uint32>& indices = isLink ? graph->progressLinkIndices : graph->progressNodeIndices;
+        uint32 index = indices.Find(key);
+        NodeGraphProgressEvent* ev;
+        if (index == INVALID_INDEX) {
+            indices.Add(key, graph->progressEventsQueue.Count());
+            ev = graph->progressEventsQueue.Push(e);
+            ev->counters = {};
+        }
+        else {
+            ev = &graph->progressEventsQueue[indices.Get(index)];
+            ev->type = e.type;
+        }
+
+        switch (e.type) {
+        case NodeGraphProgressEventType::NodeExecuteBegin:     ++ev->counters.numStarted;      break;
+        case NodeGraphProgressEventType::NodeExecuteSuccess:   ++ev->counters.numSucceeded;    break;
+        case NodeGraphProgressEventType::NodeExecuteError:     ++ev->counters.numFailed;       break;
+        default:                                                                                break;
+        }
+    }
+    RequestBackgroundRedraw();
 }
 
 bool ngExecute(NodeGraph* graph, bool debugMode, mco_coro* coro, TextContent* redirectContent, TskEventHandle parentEventHandle)
@@ -882,8 +937,7 @@ bool ngExecute(NodeGraph* graph, bool debugMode, mco_coro* coro, TextContent* re
             // Haven't found a way to properly show several content in redirected text viewer
             if (node.desc.captureOutput && !redirectSet && redirectContent) {
                 node.outputText->mRedirectContent = redirectContent;
-                if (redirectContent->mBlob.Size())
-                    redirectContent->mBlob.SetSize(redirectContent->mBlob.Size() - 1);    // Remove the last null-terminator
+                redirectContent->BeginWrite(false);
                 redirectSet = true;
             }
 
@@ -983,6 +1037,7 @@ bool ngExecute(NodeGraph* graph, bool debugMode, mco_coro* coro, TextContent* re
         nodes.Free();
         links.Free();
         tskEndGraphExecute(graph->taskHandle, graph->metaData.str, error);
+        tskSaveGraphTask(graph->taskHandle);    // Only appends this run to the journal
         graph->parentEventHandle = TskEventHandle();
     };
 
@@ -1176,6 +1231,10 @@ void ngUpdateEvents(NodeGraph* graph)
 
     MutexScope mtx(graph->progressEventsMutex);
     for (NodeGraphProgressEvent& ev : graph->progressEventsQueue) {
+        const NodeGraphProgressCounters& c = ev.counters;
+        if (c.numStarted || c.numSucceeded || c.numFailed)
+            graph->events->NodeProgress(ev.nodeHandle, c);
+
         switch (ev.type) {
         case NodeGraphProgressEventType::NodeResetIdle:
             graph->events->NodeIdle(ev.nodeHandle, false);
@@ -1198,9 +1257,12 @@ void ngUpdateEvents(NodeGraph* graph)
         }
     }
     graph->progressEventsQueue.Clear();
+    graph->progressNodeIndices.Clear();
+    graph->progressLinkIndices.Clear();
 
     // Increase running time for each node in execution
-    float dt = 1.0f/ImGui::GetIO().Framerate;
+    // Frames are drawn on demand, so use the actual frame time instead of the average framerate
+    float dt = ImGui::GetIO().DeltaTime;
     for (Node& node : graph->nodePool) {
         if (node.isRunning)
             node.runningTime += dt;
@@ -1319,28 +1381,30 @@ Array<PropertyHandle> ngGetProperties(NodeGraph* graph, Allocator* alloc)
     return props;
 }
 
-static PinData ngLoadPinData(sjson_node* jdata)
+static PinData ngLoadPinData(const JsonNode& jdata)
 {
-    if (!jdata)
+    if (!jdata.IsValid())
         return PinData {};
 
     PinData data {};
-    const char* typeStr = sjson_get_string(jdata, "Type", "");
+    char typeStr[32];
+    jdata.GetChildValue("Type", typeStr, sizeof(typeStr));
     if (strIsEqual(typeStr, "Boolean")) {
         data.type = PinDataType::Boolean;
-        data.b = sjson_get_bool(jdata, "Value", false);
+        data.b = jdata.GetChildValue<bool>("Value", false);
     }
     else if (strIsEqual(typeStr, "Float")) {
         data.type = PinDataType::Float;
-        data.f = sjson_get_float(jdata, "Value", 0);
+        data.f = jdata.GetChildValue<float>("Value", 0);
     }
     else if (strIsEqual(typeStr, "Integer")) {
         data.type = PinDataType::Integer;
-        data.n = sjson_get_int(jdata, "Value", 0);
+        data.n = jdata.GetChildValue<int>("Value", 0);
     }
     else if (strIsEqual(typeStr, "String")) {
+        MemTempAllocator tmpAlloc;
         data.type = PinDataType::String;
-        data.SetString(sjson_get_string(jdata, "Value", ""));
+        data.SetString(jdata.GetChildString("Value", &tmpAlloc));
     }
     else if (strIsEqual(typeStr, "Void")) {
         data.type = PinDataType::Void;
@@ -1353,6 +1417,67 @@ static PinData ngLoadPinData(sjson_node* jdata)
     return data;
 };
 
+// Mapped json file and its tokens. Values are read from the mapped text on demand, so the mapping stays open until the
+// loader returns. Closing it on scope exit also releases the view before the file is saved over again
+struct NgJsonFile
+{
+    FileMapping mapping;
+    JsonContext* jctx = nullptr;
+
+    ~NgJsonFile()
+    {
+        jsonDestroy(jctx);
+        mapping.Close();
+    }
+};
+
+// Maps the file and tokenizes it in one pass
+static JsonContext* ngParseJsonFile(NgJsonFile* file, const char* filepath, const char* displayFilepath, Allocator* alloc, 
+                                    char* errMsg = nullptr, uint32 errMsgSize = 0)
+{
+    FileMapping* mapping = &file->mapping;
+    if (!mapping->Open(filepath)) {
+        logError("Opening file failed: %s", filepath);
+        if (errMsg)
+            strPrintFmt(errMsg, errMsgSize, "Opening file failed: %s", displayFilepath);
+        return nullptr;
+    }
+
+    JsonErrorLocation errLoc {};
+    JsonContext* jctx = jsonParse((const char*)mapping->Data(), uint32(mapping->Size()), &errLoc, alloc);
+    if (!jctx) {
+        logError("Parsing json failed: %s (Line: %u, Column: %u)", filepath, errLoc.line, errLoc.col);
+        if (errMsg) 
+            strPrintFmt(errMsg, errMsgSize, "Parsing json failed: %s (Line: %u, Column: %u)", displayFilepath, errLoc.line, errLoc.col);
+        mapping->Close();
+        return nullptr;
+    }
+
+    file->jctx = jctx;
+    return jctx;
+}
+
+static void ngLoadExtraPins(NodeGraph* graph, NodeHandle handle, const JsonNode& jnode)
+{
+    const Node& node = ngGetNodeData(graph, handle);
+    char pinName[256];
+
+    if (node.desc.dynamicInPins) {
+        JsonNode jpins = jnode.GetChild("ExtraInPins");
+        if (jpins.IsValid()) {
+            for (JsonNode jpin = jpins.GetArrayItem(); jpin.IsValid(); jpin = jpins.GetNextArrayItem(jpin))
+                ngInsertDynamicPinIntoNode(graph, handle, PinType::Input, jpin.GetValue(pinName, sizeof(pinName)));
+        }
+    }
+
+    if (node.desc.dynamicOutPins) {
+        JsonNode jpins = jnode.GetChild("ExtraOutPins");
+        if (jpins.IsValid()) {
+            for (JsonNode jpin = jpins.GetArrayItem(); jpin.IsValid(); jpin = jpins.GetNextArrayItem(jpin))
+                ngInsertDynamicPinIntoNode(graph, handle, PinType::Output, jpin.GetValue(pinName, sizeof(pinName)));
+        }
+    }
+}
 
 bool ngLoad(NodeGraph* graph, WksFileHandle fileHandle, char* errMsg, uint32 errMsgSize)
 {
@@ -1363,68 +1488,49 @@ bool ngLoad(NodeGraph* graph, WksFileHandle fileHandle, char* errMsg, uint32 err
 
     graph->fileHandle = fileHandle;
 
+    // The graph or its task file might still be in the save queue
+    saveFlush();
+
     // Load task file (optional)
     graph->taskHandle = tskLoadGraphTask(graph->fileHandle);
     ASSERT(graph->taskHandle.IsValid());
 
     MemTempAllocator tmpAlloc;
-    File f;
-    if (!f.Open(filepath.CStr(), FileOpenFlags::Read | FileOpenFlags::SeqScan)) {
-        logError("Opening file failed: %s", filepath.CStr());
-        if (errMsg)
-            strPrintFmt(errMsg, errMsgSize, "Opening file failed: %s", wfilepath.CStr());
-        return false;
-    }
-
-    if (f.GetSize() == 0) {
-        logError("Empty file: %s", filepath.CStr());
-        if (errMsg)
-            strPrintFmt(errMsg, errMsgSize, "Empty file: %s", wfilepath.CStr());
-        return false;
-    }
-
-    size_t fileSize = f.GetSize();
-    char* jsonText = (char*)tmpAlloc.Malloc(fileSize + 1);
-    f.Read<char>(jsonText, (uint32)fileSize);
-    jsonText[fileSize] = '\0';
-    f.Close();
-
-    sjson_context* jctx = sjson_create_context(0, 0, &tmpAlloc);
-    ASSERT_ALWAYS(jctx, "Out of memory?");
-    sjson_node* jroot = sjson_decode(jctx, jsonText);
-    if (!jroot) {
-        logError("Parsing json failed: %s", filepath.CStr());
-        if (errMsg) 
-            strPrintFmt(errMsg, errMsgSize, "Parsing json failed: %s", wfilepath.CStr());
+    NgJsonFile jsonFile;
+    JsonContext* jctx = ngParseJsonFile(&jsonFile, filepath.CStr(), wfilepath.CStr(), &tmpAlloc, errMsg, errMsgSize);
+    if (!jctx)
         return false;
-    }
+    JsonNode jroot(jctx);
 
     // Dependencies: For now, it is only there to check for circular dependencies
     //               It's data will be populated by child nodes (ngLoadChild)
     if (gParentFilepath) {
-        sjson_node* jdeps = sjson_find_member(jroot, "Dependencies");
-        sjson_node* jdep = sjson_first_child(jdeps);
-        while (jdep) {
-            if (strIsEqualNoCase(jdep->string_, gParentFilepath)) {
-                logError("Cannot load: %s. circular dependency found: %s", filepath.CStr(), gParentFilepath);
-                if (errMsg) 
-                    strPrintFmt(errMsg, errMsgSize, "Cannot load: %s. circular dependency found: %s", wfilepath.CStr(), gParentFilepath);
-                return false;
+        JsonNode jdeps = jroot.GetChild("Dependencies");
+        if (jdeps.IsValid()) {
+            char depFilepath[kMaxPath];
+            for (JsonNode jdep = jdeps.GetArrayItem(); jdep.IsValid(); jdep = jdeps.GetNextArrayItem(jdep)) {
+                if (strIsEqualNoCase(jdep.GetValue(depFilepath, sizeof(depFilepath)), gParentFilepath)) {
+                    logError("Cannot load: %s. circular dependency found: %s", filepath.CStr(), gParentFilepath);
+                    if (errMsg) 
+                        strPrintFmt(errMsg, errMsgSize, "Cannot load: %s. circular dependency found: %s", wfilepath.CStr(), gParentFilepath);
+                    return false;
+                }
             }
-            jdep = jdep->next;
         }
     }
+
+    char uuidStr[64];
+    char name[128];
     
     // Properties
-    {
-        sjson_node* jprops = sjson_find_member(jroot, "Properties");
-        sjson_node* jprop = sjson_first_child(jprops);
-        while (jprop) {
-            const char* uuidStr = sjson_get_string(jprop, "Id", "");
-            const char* name = sjson_get_string(jprop, "Name", "");
-            const char* pinName = sjson_get_string(jprop, "PinName", "");
-            const char* pinDesc = sjson_get_string(jprop, "PinDescription", "");
-            PinData initialData = ngLoadPinData(sjson_find_member(jprop, "InitialData"));
+    JsonNode jprops = jroot.GetChild("Properties");
+    if (jprops.IsValid()) {
+        for (JsonNode jprop = jprops.GetArrayItem(); jprop.IsValid(); jprop = jprops.GetNextArrayItem(jprop)) {
+            jprop.GetChildValue("Id", uuidStr, sizeof(uuidStr));
+            jprop.GetChildValue("Name", name, sizeof(name));
+            const char* pinName = jprop.GetChildString("PinName", &tmpAlloc);
+            const char* pinDesc = jprop.GetChildString("PinDescription", &tmpAlloc);
+            PinData initialData = ngLoadPinData(jprop.GetChild("InitialData"));
             
             PropertyHandle handle;
             SysUUID uuid;
@@ -1435,8 +1541,8 @@ bool ngLoad(NodeGraph* graph, WksFileHandle fileHandle, char* errMsg, uint32 err
                 ngStartProperty(graph, handle, initialData, CreateString(pinName), CreateString(pinDesc));
 
                 Pin& propPin = ngGetPinData(graph, prop.pin);
-                propPin.data = ngLoadPinData(sjson_find_member(jprop, "Data"));
-                if (!prop.impl->LoadDataFromJson(graph, handle, jctx, jprop)) {
+                propPin.data = ngLoadPinData(jprop.GetChild("Data"));
+                if (!prop.impl->LoadDataFromJson(graph, handle, jprop)) {
                     if (errMsg)
                         strPrintFmt(errMsg, errMsgSize, "Loading property data failed: %s (File: %s)", pinName, wfilepath.CStr());
                     return false;
@@ -1447,43 +1553,27 @@ bool ngLoad(NodeGraph* graph, WksFileHandle fileHandle, char* errMsg, uint32 err
             else {
                 handle = graph->propPool.HandleAt(0);
             }
-
-            jprop = jprop->next;
         }
     }
 
     // Nodes
-    {
-        sjson_node* jnodes = sjson_find_member(jroot, "Nodes");
-        sjson_node* jnode = sjson_first_child(jnodes);
-        while (jnode) {
-            const char* uuidStr = sjson_get_string(jnode, "Id", "");
-            const char* name = sjson_get_string(jnode, "Name", "");
-            sjson_node* jextraInPins = sjson_find_member(jnode, "ExtraInPins");
-            sjson_node* jextraOutPins = sjson_find_member(jnode, "ExtraOutPins");
+    // Links reference the nodes by uuid, so we keep a lookup table instead of searching the whole pool for every link
+    HashTable<NodeHandle> nodeLookup(&tmpAlloc);
+    JsonNode jnodes = jroot.GetChild("Nodes");
+    if (jnodes.IsValid()) {
+        nodeLookup.Reserve(Max(jnodes.GetArrayCount(), 16u));
+        for (JsonNode jnode = jnodes.GetArrayItem(); jnode.IsValid(); jnode = jnodes.GetNextArrayItem(jnode)) {
+            jnode.GetChildValue("Id", uuidStr, sizeof(uuidStr));
+            jnode.GetChildValue("Name", name, sizeof(name));
 
             SysUUID uuid;
             if (sysUUIDFromString(&uuid, uuidStr)) {
                 NodeHandle handle = ngCreateNode(graph, name, &uuid);
 
                 Node& node = ngGetNodeData(graph, handle);
-                if (node.desc.dynamicInPins && jextraInPins) {
-                    sjson_node* jpin = sjson_first_child(jextraInPins);
-                    while (jpin) {
-                        ngInsertDynamicPinIntoNode(graph, handle, PinType::Input, jpin->string_);
-                        jpin = jpin->next;
-                    }
-                }
+                ngLoadExtraPins(graph, handle, jnode);
 
-                if (node.desc.dynamicOutPins && jextraOutPins) {
-                    sjson_node* jpin = sjson_first_child(jextraOutPins);
-                    while (jpin) {
-                        ngInsertDynamicPinIntoNode(graph, handle, PinType::Output, jpin->string_);
-                        jpin = jpin->next;
-                    }
-                }
-
-                if (!node.impl->LoadDataFromJson(graph, handle, jctx, jnode)) {
+                if (!node.impl->LoadDataFromJson(graph, handle, jnode)) {
                     if (errMsg) {
                         strPrintFmt(errMsg, errMsgSize, "Loading graph '%s' failed while loading node data '%s': %s", 
                                     wfilepath.CStr(), name, 
@@ -1492,52 +1582,67 @@ bool ngLoad(NodeGraph* graph, WksFileHandle fileHandle, char* errMsg, uint32 err
                     return false;
                 }
 
+                uint32 uuidHash = hashFnv32(&uuid, sizeof(uuid));
+                if (nodeLookup.Find(uuidHash) == INVALID_INDEX)
+                    nodeLookup.Add(uuidHash, handle);
+
                 if (graph->events)
                     graph->events->CreateNode(handle);
             }
-
-            jnode = jnode->next;
         }
     }
 
+    auto FindNode = [graph, &nodeLookup](const SysUUID& uuid)->NodeHandle {
+        uint32 index = nodeLookup.Find(hashFnv32(&uuid, sizeof(uuid)));
+        if (index != INVALID_INDEX) {
+            NodeHandle handle = nodeLookup.Get(index);
+            if (ngGetNodeData(graph, handle).uuid == uuid)
+                return handle;
+        }
+
+        // Hash collision, or a node that is not in this file
+        return graph->nodePool.FindIf([uuid](const Node& n) { return n.uuid == uuid; });
+    };
+
     // Links
-    {
-        sjson_node* jlinks = sjson_find_member(jroot, "Links");
-        sjson_node* jlink = sjson_first_child(jlinks);
-        while (jlink) {
-            const char* nodeAId = sjson_get_string(jlink, "NodeA", "");
-            const char* nodeBId = sjson_get_string(jlink, "NodeB", "");
+    JsonNode jlinks = jroot.GetChild("Links");
+    if (jlinks.IsValid()) {
+        char nodeAId[64];
+        char nodeBId[64];
+        for (JsonNode jlink = jlinks.GetArrayItem(); jlink.IsValid(); jlink = jlinks.GetNextArrayItem(jlink)) {
+            jlink.GetChildValue("NodeA", nodeAId, sizeof(nodeAId));
+            jlink.GetChildValue("NodeB", nodeBId, sizeof(nodeBId));
             PinHandle pinA {};
             PinHandle pinB {};
             SysUUID uuidNode;
 
             if (nodeAId[0] == 0) {
-                const char* propId = sjson_get_string(jlink, "PropertyId", "");
+                jlink.GetChildValue("PropertyId", uuidStr, sizeof(uuidStr));
 
                 SysUUID uuidProp;
-                if (sysUUIDFromString(&uuidProp, propId)) {
+                if (sysUUIDFromString(&uuidProp, uuidStr)) {
                     PropertyHandle handle = graph->propPool.FindIf([uuidProp](const Property& p) { return p.uuid == uuidProp; });
                     if (handle.IsValid())
                         pinA = ngGetPropertyData(graph, handle).pin;
                 }
             }
             else {
-                int pinId = sjson_get_int(jlink, "PinA", -1);
+                int pinId = jlink.GetChildValue<int>("PinA", -1);
                 ASSERT(pinId != -1);
 
                 if (sysUUIDFromString(&uuidNode, nodeAId)) {
-                    NodeHandle handle = graph->nodePool.FindIf([uuidNode](const Node& n) { return n.uuid == uuidNode; });
+                    NodeHandle handle = FindNode(uuidNode);
                     if (handle.IsValid()) 
                         pinA = ngGetNodeData(graph, handle).outPins[pinId];
                 }
             }
             ASSERT(pinA.IsValid());
 
-            int pinBId = sjson_get_int(jlink, "PinB", -1);
+            int pinBId = jlink.GetChildValue<int>("PinB", -1);
             ASSERT(pinBId != -1);
 
             if (sysUUIDFromString(&uuidNode, nodeBId)) {
-                NodeHandle handle = graph->nodePool.FindIf([uuidNode](const Node& n) { return n.uuid == uuidNode; });
+                NodeHandle handle = FindNode(uuidNode);
                 Node& nodeB = ngGetNodeData(graph, handle);
                 if (pinBId < int(nodeB.inPins.Count()))
                     pinB = nodeB.inPins[pinBId];
@@ -1551,13 +1656,9 @@ bool ngLoad(NodeGraph* graph, WksFileHandle fileHandle, char* errMsg, uint32 err
                 if (graph->events)
                     graph->events->CreateLink(handle);
             }
-
-            jlink = jlink->next;
         }
     }
     
-    sjson_destroy_context(jctx);   
-    
     return true;
 }
 
@@ -1596,37 +1697,16 @@ sjson_node* ngSavePinData(sjson_context* jctx, const PinData& data)
 NodeHandle ngLoadNode(const char* filepath, NodeGraph* graph, bool genId)
 {
     MemTempAllocator tmpAlloc;
-
-    File f;
-    if (!f.Open(filepath, FileOpenFlags::Read | FileOpenFlags::SeqScan)) {
-        logError("Opening file failed: %s", filepath);
-        return NodeHandle();
-    }
-
-    if (f.GetSize() == 0) {
-        logError("Empty file: %s", filepath);
+    NgJsonFile jsonFile;
+    JsonContext* jctx = ngParseJsonFile(&jsonFile, filepath, filepath, &tmpAlloc);
+    if (!jctx)
         return NodeHandle();
-    }
-
-    size_t fileSize = f.GetSize();
-    char* jsonText = (char*)tmpAlloc.Malloc(fileSize + 1);
-    f.Read<char>(jsonText, (uint32)fileSize);
-    jsonText[fileSize] = '\0';
-    f.Close();
 
-    sjson_context* jctx = sjson_create_context(0, 0, &tmpAlloc);
-    ASSERT_ALWAYS(jctx, "Out of memory?");
-    sjson_node* jroot = sjson_decode(jctx, jsonText);
-    if (!jroot) {
-        logError("Parsing json failed: %s", filepath);
-        return NodeHandle();
-    }
-
-    sjson_node* jnode = jroot;
-    const char* uuidStr = sjson_get_string(jnode, "Id", "");
-    const char* name = sjson_get_string(jnode, "Name", "");
-    sjson_node* jextraInPins = sjson_find_member(jnode, "ExtraInPins");
-    sjson_node* jextraOutPins = sjson_find_member(jnode, "ExtraOutPins");
+    JsonNode jnode(jctx);
+    char uuidStr[64];
+    char name[128];
+    jnode.GetChildValue("Id", uuidStr, sizeof(uuidStr));
+    jnode.GetChildValue("Name", name, sizeof(name));
 
     SysUUID uuid;
     bool hasId = genId ? sysUUIDGenerate(&uuid) : sysUUIDFromString(&uuid, uuidStr);
@@ -1637,23 +1717,9 @@ NodeHandle ngLoadNode(const char* filepath, NodeGraph* graph, bool genId)
         // TODO: handle possible errors
 
         Node& node = ngGetNodeData(graph, handle);
-        if (node.desc.dynamicInPins && jextraInPins) {
-            sjson_node* jpin = sjson_first_child(jextraInPins);
-            while (jpin) {
-                ngInsertDynamicPinIntoNode(graph, handle, PinType::Input, jpin->string_);
-                jpin = jpin->next;
-            }
-        }
-
-        if (node.desc.dynamicOutPins && jextraOutPins) {
-            sjson_node* jpin = sjson_first_child(jextraOutPins);
-            while (jpin) {
-                ngInsertDynamicPinIntoNode(graph, handle, PinType::Output, jpin->string_);
-                jpin = jpin->next;
-            }
-        }
+        ngLoadExtraPins(graph, handle, jnode);
 
-        if (!node.impl->LoadDataFromJson(graph, handle, jctx, jnode)) {
+        if (!node.impl->LoadDataFromJson(graph, handle, jnode)) {
             // TODO: handle possible errors
             return NodeHandle();
         }
@@ -1720,7 +1786,7 @@ bool ngSaveNode(const char* filepath, NodeGraph* graph, NodeHandle nodeHandle)
     return true;
 }
 
-bool ngSave(NodeGraph* graph, WksFileHandle fileHandle)
+bool ngSave(NodeGraph* graph, WksFileHandle fileHandle, bool wait)
 {
     if (!fileHandle.IsValid())
         fileHandle = graph->fileHandle;
@@ -1732,7 +1798,8 @@ bool ngSave(NodeGraph* graph, WksFileHandle fileHandle)
 
     MemTempAllocator tmpAlloc;
     
-    sjson_context* jctx = sjson_create_context(0, 0, &tmpAlloc);
+    // The json tree is the snapshot of the graph, it's written to disk on the save thread (see saveSubmitJson)
+    sjson_context* jctx = sjson_create_context(0, 0, memDefaultAlloc());
     ASSERT_ALWAYS(jctx, "Out of memory?");
     sjson_node* jroot = sjson_mkobject(jctx);
 
@@ -1848,19 +1915,10 @@ bool ngSave(NodeGraph* graph, WksFileHandle fileHandle)
         }
     }
 
-    char* jsonText = sjson_stringify(jctx, jroot, "\t");
-    File f;
-    if (!f.Open(filepath.CStr(), FileOpenFlags::Write)) {
-        logError("Cannot open file for writing: %s", wksGetWorkspaceFilePath(GetWorkspace(), fileHandle).CStr());
-        return false;
-    }
-
-    f.Write(jsonText, strLen(jsonText));
-    f.Close();
-
-    sjson_free_string(jctx, jsonText);
-    sjson_destroy_context(jctx);
+    if (wait)
+        return saveWriteJson(filepath.CStr(), jctx, jroot);
 
+    saveSubmitJson(filepath.CStr(), jctx, jroot);
     return true;    
 }
 
@@ -2005,22 +2063,22 @@ bool ngReloadChildNodes(NodeGraph* graph, WksFileHandle childGraphFile)
     return r;
 }
 
-void ngLoadPropertiesFromJson(NodeGraph* graph, sjson_node* jprops)
+void ngLoadPropertiesFromJson(NodeGraph* graph, const JsonNode& jprops)
 {
-    sjson_node* jvalues = sjson_find_member(jprops, "Values");
-    if (jvalues) {
-        sjson_node* jvalue = sjson_first_child(jvalues);
+    JsonNode jvalues = jprops.GetChild("Values");
+    if (jvalues.IsValid()) {
         SysUUID uuid;
-        while (jvalue) {
-            const char* uuidStr = sjson_get_string(jvalue, "Id", "");
+        char uuidStr[64];
+        for (JsonNode jvalue = jvalues.GetArrayItem(); jvalue.IsValid(); jvalue = jvalues.GetNextArrayItem(jvalue)) {
+            jvalue.GetChildValue("Id", uuidStr, sizeof(uuidStr));
             if (sysUUIDFromString(&uuid, uuidStr)) {
                 PropertyHandle propHandle = ngFindPropertyById(graph, uuid);
                 if (propHandle.IsValid()) {
                     Property& prop = ngGetPropertyData(graph, propHandle);
                     if (prop.started && prop.pin.IsValid()) {
                         Pin& pin = ngGetPinData(graph, prop.pin);
-                        sjson_node* jdata = sjson_find_member(jvalue, "Data");
-                        if (jdata) {
+                        JsonNode jdata = jvalue.GetChild("Data");
+                        if (jdata.IsValid()) {
                             pin.data.Free();
                             pin.data = ngLoadPinData(jdata);
                                 
@@ -2029,8 +2087,6 @@ void ngLoadPropertiesFromJson(NodeGraph* graph, sjson_node* jprops)
                     } // If property is initialized
                 } // if property found
             } // if uuid is value
-                
-            jvalue = jvalue->next;
         }
     }
 }
@@ -2038,33 +2094,13 @@ void ngLoadPropertiesFromJson(NodeGraph* graph, sjson_node* jprops)
 bool ngLoadPropertiesFromFile(NodeGraph* graph, const char* jsonFilepath)
 {
     MemTempAllocator tmpAlloc;
-    File f;
-    if (!f.Open(jsonFilepath, FileOpenFlags::Read | FileOpenFlags::SeqScan)) {
-        logError("Opening file failed: %s", jsonFilepath);
-        return false;
-    }
-
-    if (f.GetSize() == 0) {
-        logError("Empty file: %s", jsonFilepath);
+    NgJsonFile jsonFile;
+    JsonContext* jctx = ngParseJsonFile(&jsonFile, jsonFilepath, jsonFilepath, &tmpAlloc);
+    if (!jctx)
         return false;
-    }
-
-    size_t fileSize = f.GetSize();
-    char* jsonText = (char*)tmpAlloc.Malloc(fileSize + 1);
-    f.Read<char>(jsonText, (uint32)fileSize);
-    jsonText[fileSize] = '\0';
-    f.Close();
-
-    sjson_context* jctx = sjson_create_context(0, 0, &tmpAlloc);
-    ASSERT_ALWAYS(jctx, "Out of memory?");
-    sjson_node* jroot = sjson_decode(jctx, jsonText);
-    if (!jroot) {
-        logError("Parsing json failed: %s", jsonFilepath);
-        return false;
-    }
 
-    sjson_node* jprop = sjson_find_member(jroot, "Parameters");
-    if (jprop) {
+    JsonNode jprop = JsonNode(jctx).GetChild("Parameters");
+    if (jprop.IsValid()) {
         ngLoadPropertiesFromJson(graph, jprop);
         return true;
     }
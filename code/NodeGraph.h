@@ -98,6 +98,7 @@ struct NodeDesc
 
 typedef struct sjson_context sjson_context;
 typedef struct sjson_node sjson_node;
+struct JsonNode;
 
 struct NO_VTABLE NodeImpl
 {
@@ -145,7 +146,7 @@ struct NO_VTABLE NodeImpl
     // Save/Load the internal/custom data only to json DOM format. You can do nothing if there is no custom data. built-in node properties will be handles automatically
     // 'jparent' is the root header for the node, you should put/get data only from that scope
     virtual void SaveDataToJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) = 0;
-    virtual bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, sjson_context* jctx, sjson_node* jparent) = 0;
+    virtual bool LoadDataFromJson(NodeGraph* graph, NodeHandle nodeHandle, const JsonNode& jparent) = 0;
 };
 
 struct Node
@@ -174,7 +175,16 @@ struct Link
     NodeHandle nodeB;
 };
 
+// Number of progress events of a node that are coalesced since the last ngUpdateEvents
+struct NodeGraphProgressCounters
+{
+    uint32 numStarted;
+    uint32 numSucceeded;
+    uint32 numFailed;
+};
+
 // Callbacks used for GUI syncing
+// Progress callbacks (NodeIdle .. LinkFinished) are called from ngUpdateEvents, at most once per node and link with the last state
 struct NO_VTABLE NodeGraphEvents
 {
     virtual void CreateNode(NodeHandle handle) = 0;
@@ -184,6 +194,7 @@ struct NO_VTABLE NodeGraphEvents
     virtual void NodeStarted(NodeHandle handle) = 0;
     virtual void NodeFinished(NodeHandle handle, bool withError) = 0;
     virtual void LinkFinished(LinkHandle handle) = 0;
+    virtual void NodeProgress(NodeHandle handle, const NodeGraphProgressCounters& counters) = 0;   // Before the state callback
 };
 
 struct PropertyDesc
@@ -201,7 +212,7 @@ struct NO_VTABLE PropertyImpl
     virtual bool ShowCreateUI(NodeGraph* graph, PropertyHandle propHandle, PinData& initialDataInOut) = 0;
     virtual void InitializeDataFromPin(NodeGraph* graph, PropertyHandle propHandle) = 0;
     virtual void SaveDataToJson(NodeGraph* graph, PropertyHandle propHandle, sjson_context* jctx, sjson_node* jparent) = 0;
-    virtual bool LoadDataFromJson(NodeGraph* graph, PropertyHandle propHandle, sjson_context* jctx, sjson_node* jparent) = 0;
+    virtual bool LoadDataFromJson(NodeGraph* graph, PropertyHandle propHandle, const JsonNode& jparent) = 0;
     virtual void CopyInternalData(NodeGraph* graph, PropertyHandle propHandle, const void* data) = 0;
 };
 
@@ -233,7 +244,9 @@ API Array<const char*> ngGetRegisteredProperties(Allocator* alloc);
 API NodeGraph* ngCreate(Allocator* alloc, NodeGraphEvents* events = nullptr);
 API void ngDestroy(NodeGraph* graph);
 API bool ngLoad(NodeGraph* graph, WksFileHandle fileHandle, char* errMsg = nullptr, uint32 errMsgSize = 0);
-API bool ngSave(NodeGraph* graph, WksFileHandle fileHandle = WksFileHandle());
+// The file is written on the save thread, which logs the failures. With `wait`, it's written before returning and
+// the result is returned (new graphs are saved this way, so a failed write doesn't leave a graph without a file)
+API bool ngSave(NodeGraph* graph, WksFileHandle fileHandle = WksFileHandle(), bool wait = false);
 API const char* ngGetName(NodeGraph* graph);
 API WksFileHandle ngGetFileHandle(NodeGraph* graph);
 
@@ -254,7 +267,7 @@ API bool ngStartProperty(NodeGraph* graph, PropertyHandle handle, const PinData&
 API bool ngEditProperty(NodeGraph* graph, PropertyHandle handle, StringId pinName, StringId pinDescText);
 API void ngDestroyProperty(NodeGraph* graph, PropertyHandle handle);
 
-API void ngLoadPropertiesFromJson(NodeGraph* graph, sjson_node* jprops);
+API void ngLoadPropertiesFromJson(NodeGraph* graph, const JsonNode& jprops);
 API bool ngLoadPropertiesFromFile(NodeGraph* graph, const char* jsonFilepath);
 API void ngSavePropertiesToJson(NodeGraph* graph, sjson_context* jctx, sjson_node* jprops);
 API bool ngSavePropertiesToFile(NodeGraph* graph, const char* jsonFilepath);
@@ -0,0 +1,311 @@
+#include "SaveQueue.h"
+
+#include "Core/System.h"
+#include "Core/Blobs.h"
+#include "Core/Arrays.h"
+#include "Core/Log.h"
+#include "Core/StringUtil.h"
+
+#include "External/sjson/sjson.h"
+
+struct SaveRequest
+{
+    SaveMode mode;
+    void* snapshot;
+    bool (*serializeFn)(Blob* blob, void* snapshot);
+    void (*finishFn)(SaveResult result, void* snapshot);
+};
+
+struct SaveFile
+{
+    Path filepath;
+    Array<SaveRequest> requests;    // Written in order. Only the first one can be a Replace
+};
+
+struct SaveContext
+{
+    Mutex mutex;
+    Semaphore semaphore;
+    Signal finishSignal;
+    Thread thread;
+    Array<SaveFile> queue;          // Files that are not started yet, one entry per file
+    uint64 numSubmitted;
+    uint64 numFinished;
+    bool quit;
+    bool initialized;
+};
+
+struct SaveJsonSnapshot
+{
+    sjson_context* jctx;
+    sjson_node* jroot;
+};
+
+static SaveContext gSave;
+
+static bool saveReplaceFile(const Path& filepath, const Blob& blob)
+{
+    Path tmpFilepath(filepath);
+    tmpFilepath.Append(".tmp");
+
+    File f;
+    if (!f.Open(tmpFilepath.CStr(), FileOpenFlags::Write)) {
+        logError("Cannot open file for writing: %s", tmpFilepath.CStr());
+        return false;
+    }
+    bool written = f.Write(blob.Data(), blob.Size()) == blob.Size();
+    f.Close();
+
+    if (!written || !pathReplace(tmpFilepath.CStr(), filepath.CStr())) {
+        logError("Writing file failed: %s", filepath.CStr());
+        pathDelete(tmpFilepath.CStr());
+        return false;
+    }
+
+    return true;
+}
+
+static bool saveAppendFile(const Path& filepath, const Blob& blob)
+{
+    File f;
+    if (!f.Open(filepath.CStr(), FileOpenFlags::Write | FileOpenFlags::Append)) {
+        logError("Cannot open file for writing: %s", filepath.CStr());
+        return false;
+    }
+    bool written = f.Write(blob.Data(), blob.Size()) == blob.Size();
+    f.Close();
+
+    if (!written)
+        logError("Writing file failed: %s", filepath.CStr());
+    return written;
+}
+
+// Serializes all the chained requests into one blob, so the file is opened and written once
+static bool saveWriteFile(SaveFile& file)
+{
+    ASSERT(!file.requests.IsEmpty());
+
+    Blob blob;
+    blob.SetGrowPolicy(Blob::GrowPolicy::Multiply);
+
+    bool success = true;
+    for (const SaveRequest& req : file.requests) {
+        if (!req.serializeFn(&blob, req.snapshot)) {
+            logError("Serializing file data failed: %s", file.filepath.CStr());
+            success = false;
+            break;
+        }
+    }
+
+    if (success) {
+        if (file.requests[0].mode == SaveMode::Replace)
+            success = saveReplaceFile(file.filepath, blob);
+        else if (blob.Size())
+            success = saveAppendFile(file.filepath, blob);
+    }
+
+    for (const SaveRequest& req : file.requests)
+        req.finishFn(success ? SaveResult::Written : SaveResult::Failed, req.snapshot);
+
+    blob.Free();
+    return success;
+}
+
+static int saveThreadFn(void*)
+{
+    bool quit = false;
+    while (!quit) {
+        gSave.semaphore.Wait();
+
+        while (true) {
+            SaveFile file;
+            {
+                MutexScope mtx(gSave.mutex);
+                if (gSave.queue.IsEmpty()) {
+                    quit = gSave.quit;
+                    break;
+                }
+                file = gSave.queue.PopFirst();
+            }
+
+            saveWriteFile(file);
+
+            {
+                MutexScope mtx(gSave.mutex);
+                gSave.numFinished += file.requests.Count();
+            }
+            file.requests.Free();
+            gSave.finishSignal.RaiseAll();
+        }
+    }
+
+    return 0;
+}
+
+bool saveInitialize()
+{
+    ASSERT_MSG(!gSave.initialized, "Save queue is already initialized");
+
+    gSave.mutex.Initialize();
+    gSave.semaphore.Initialize();
+    gSave.finishSignal.Initialize();
+    gSave.quit = false;
+
+    if (!gSave.thread.Start(ThreadDesc { .entryFn = saveThreadFn, .userData = nullptr, .name = "Save" })) {
+        gSave.finishSignal.Release();
+        gSave.semaphore.Release();
+        gSave.mutex.Release();
+        logError("Save: Starting the save thread failed, files are written synchronously");
+        return false;
+    }
+
+    gSave.initialized = true;
+    return true;
+}
+
+void saveRelease()
+{
+    if (!gSave.initialized)
+        return;
+
+    // The thread writes everything in the queue before quitting
+    {
+        MutexScope mtx(gSave.mutex);
+        gSave.quit = true;
+    }
+    gSave.semaphore.Post();
+    gSave.thread.Stop();
+
+    ASSERT(gSave.queue.IsEmpty());
+    gSave.queue.Free();
+    gSave.finishSignal.Release();
+    gSave.semaphore.Release();
+    gSave.mutex.Release();
+    gSave.initialized = false;
+}
+
+void saveSubmit(const SaveDesc& desc)
+{
+    ASSERT(desc.filepath && desc.filepath[0]);
+    ASSERT(desc.serializeFn && desc.finishFn);
+
+    SaveRequest req {
+        .mode = desc.mode,
+        .snapshot = desc.snapshot,
+        .serializeFn = desc.serializeFn,
+        .finishFn = desc.finishFn
+    };
+
+    if (!gSave.initialized) {
+        SaveFile file { .filepath = desc.filepath };
+        file.requests.Push(req);
+        saveWriteFile(file);
+        file.requests.Free();
+        return;
+    }
+
+    SaveFile superseded;
+    {
+        MutexScope mtx(gSave.mutex);
+        ++gSave.numSubmitted;
+
+        uint32 index = gSave.queue.FindIf([&desc](const SaveFile& f) { return f.filepath.IsEqual(desc.filepath); });
+        if (index != INVALID_INDEX) {
+            SaveFile& file = gSave.queue[index];
+            if (desc.mode == SaveMode::Replace) {
+                superseded.requests = file.requests;
+                file.requests = Array<SaveRequest>();
+                gSave.numFinished += superseded.requests.Count();
+            }
+            file.requests.Push(req);
+        }
+        else {
+            SaveFile* file = gSave.queue.Push(SaveFile { .filepath = desc.filepath });
+            file->requests.Push(req);
+        }
+    }
+
+    gSave.semaphore.Post();
+
+    for (const SaveRequest& r : superseded.requests)
+        r.finishFn(SaveResult::Superseded, r.snapshot);
+    superseded.requests.Free();
+}
+
+bool saveWrite(const SaveDesc& desc)
+{
+    ASSERT(desc.filepath && desc.filepath[0]);
+    ASSERT(desc.serializeFn && desc.finishFn);
+
+    // Pending requests for the file are older than this one, they should not overwrite it afterwards
+    saveFlush();
+
+    SaveFile file { .filepath = desc.filepath };
+    file.requests.Push(SaveRequest {
+        .mode = desc.mode,
+        .snapshot = desc.snapshot,
+        .serializeFn = desc.serializeFn,
+        .finishFn = desc.finishFn
+    });
+    bool success = saveWriteFile(file);
+    file.requests.Free();
+    return success;
+}
+
+static SaveDesc saveMakeJsonDesc(const char* filepath, sjson_context* jctx, sjson_node* jroot)
+{
+    SaveJsonSnapshot* snapshot = memAllocTyped<SaveJsonSnapshot>();
+    snapshot->jctx = jctx;
+    snapshot->jroot = jroot;
+
+    return SaveDesc {
+        .filepath = filepath,
+        .mode = SaveMode::Replace,
+        .snapshot = snapshot,
+        .serializeFn = [](Blob* blob, void* snapshot)->bool {
+            SaveJsonSnapshot* s = (SaveJsonSnapshot*)snapshot;
+            char* jsonText = sjson_stringify(s->jctx, s->jroot, "\t");
+            if (!jsonText)
+                return false;
+            blob->Write(jsonText, strLen(jsonText));
+            sjson_free_string(s->jctx, jsonText);
+            return true;
+        },
+        .finishFn = [](SaveResult, void* snapshot) {
+            SaveJsonSnapshot* s = (SaveJsonSnapshot*)snapshot;
+            sjson_destroy_context(s->jctx);
+            memFree(s);
+        }
+    };
+}
+
+void saveSubmitJson(const char* filepath, sjson_context* jctx, sjson_node* jroot)
+{
+    saveSubmit(saveMakeJsonDesc(filepath, jctx, jroot));
+}
+
+bool saveWriteJson(const char* filepath, sjson_context* jctx, sjson_node* jroot)
+{
+    return saveWrite(saveMakeJsonDesc(filepath, jctx, jroot));
+}
+
+void saveFlush()
+{
+    if (!gSave.initialized)
+        return;
+
+    uint64 target;
+    {
+        MutexScope mtx(gSave.mutex);
+        target = gSave.numSubmitted;
+    }
+
+    while (true) {
+        {
+            MutexScope mtx(gSave.mutex);
+            if (gSave.numFinished >= target)
+                break;
+        }
+        gSave.finishSignal.Wait(10);
+    }
+}
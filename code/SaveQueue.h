@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Core/Base.h"
+
+struct Blob;
+typedef struct sjson_context sjson_context;
+typedef struct sjson_node sjson_node;
+
+// Background file saving
+// The caller takes a snapshot of its data (under its own lock, if it has one) and submits it. The save thread serializes the
+// snapshot and writes the file. Replace writes to a temp file and renames it over the old one, so readers never see a partial file
+// Requests for the same file that are not started yet are coalesced: Replace drops the pending ones, Append is chained after them
+enum class SaveMode
+{
+    Replace,
+    Append
+};
+
+enum class SaveResult
+{
+    Written,
+    Failed,
+    Superseded      // Dropped, because a newer Replace for the same file came in before this one is started
+};
+
+struct SaveDesc
+{
+    const char* filepath;
+    SaveMode mode;
+    void* snapshot;
+
+    // Runs on the save thread, writes the file data of the snapshot to the blob
+    bool (*serializeFn)(Blob* blob, void* snapshot);
+
+    // Called exactly once for every submitted request, frees the snapshot
+    // Runs on the save thread, or on the submitting thread for Superseded requests
+    void (*finishFn)(SaveResult result, void* snapshot);
+};
+
+bool saveInitialize();
+void saveRelease();     // Writes everything that is pending before returning
+
+// Before saveInitialize and after saveRelease, requests are written on the calling thread
+void saveSubmit(const SaveDesc& desc);
+
+// Writes the file on the calling thread and returns false if it fails. Waits for the pending requests first
+// Use it when the caller has to know about the failure, like creating a new file
+bool saveWrite(const SaveDesc& desc);
+
+// Stringifies the json on the save thread and replaces the file with it. Takes the ownership of the sjson context
+// The context should be created with a thread-safe allocator (not temp), because it's destroyed on the save thread
+void saveSubmitJson(const char* filepath, sjson_context* jctx, sjson_node* jroot);
+bool saveWriteJson(const char* filepath, sjson_context* jctx, sjson_node* jroot);
+
+// Waits until all the submitted requests are finished. Call it before reading back a file that might be pending
+void saveFlush();
@@ -3,10 +3,13 @@
 #include "Main.h"
 #include "NodeGraph.h"
 #include "Workspace.h"
+#include "SaveQueue.h"
 
 #include "Core/Log.h"
-
-#include "External/sjson/sjson.h"
+#include "Core/Blobs.h"
+#include "Core/BlitSort.h"
+#include "Core/Hash.h"
+#include "Core/JsonParser.h"
 
 #include <time.h>
 
@@ -25,7 +28,11 @@ struct TskEvent
     TskGraphHandle parentGraphHandle;
     TskEventHandle parentEventHandle;
     TskEventHandle tmpEvent;
+    TskEventHandle outerEventHandle;    // Same graph, see tskBeginSubEvent
     Array<TskEventItem> items;
+    uint32 id;          // Sequential per graph, keeps the journal order after compaction
+    uint32 runIndex;
+    bool ended;
 };
 
 struct TskGraph
@@ -41,6 +48,17 @@ struct TskGraph
     uint64_t startTmHires;
     time_t startTm;
     bool inExecute;
+
+    uint32 runIndex;
+    uint32 nextEventId;
+    uint32 statsVersion;        // Incremented whenever the inputs of the analytics change, see tskGetStatsVersion
+
+    // Journal state: ended events and history entries that are not written to the task file yet
+    Array<TskEventHandle> unsavedEvents;
+    uint32 numSavedHistory;
+    uint32 journalFirstRun;
+    bool journalNeedsCompact;
+    bool journalReadOnly;       // Written by a newer version that we can't read, so we don't overwrite it either
 };
 
 struct TskContext
@@ -49,6 +67,45 @@ struct TskContext
     Mutex graphsMutex;
 };
 
+// Task journal file layout:
+//  TskJournalHeader
+//  TskJournalRecord + payload, ...
+//      Event:   uint32 id, uint32 outerId, float duration, int64 tm, str16 title    (outerId is INVALID_INDEX if it's not a sub event)
+//               Version 1 doesn't have the ids, those journals are loaded without nesting and compacted on next save
+//      Item:    uint32 type, str32 text         (belongs to the last Event record before it)
+//      Summary: float duration, int64 startTm, str16 metaData
+// Records are only appended. Compaction rewrites the retained runs into a new file and renames it over the old one
+static inline constexpr uint32 kTskJournalMagic = MakeFourCC('T', 'S', 'K', 'J');
+static inline constexpr uint32 kTskJournalVersion = 2;
+static inline constexpr uint32 kTskJournalVersionNoEventIds = 1;
+static inline constexpr uint32 kTskJournalCompactFactor = 2;   // Compact when the journal holds this many times the retained runs
+static inline constexpr uint32 kTskJournalEventFixedSize = sizeof(uint32) + sizeof(uint32) + sizeof(float) + sizeof(int64) + sizeof(uint16);
+static inline constexpr uint32 kTskJournalEventFixedSizeNoIds = sizeof(float) + sizeof(int64) + sizeof(uint16);
+static inline constexpr uint32 kTskJournalItemFixedSize = sizeof(uint32) + sizeof(uint32);
+static inline constexpr uint32 kTskJournalSummaryFixedSize = sizeof(float) + sizeof(int64) + sizeof(uint16);
+
+enum class TskJournalRecordType : uint32
+{
+    Event = 0,
+    Item,
+    Summary
+};
+
+struct TskJournalHeader
+{
+    uint32 magic;
+    uint32 version;
+    uint32 firstRun;
+    uint32 reserved;
+};
+
+struct TskJournalRecord
+{
+    TskJournalRecordType type;
+    uint32 runIndex;
+    uint32 size;        // payload size in bytes, following the record
+};
+
 static TskContext gTsk;
 
 TskEventType::Enum TskEventType::FromString(const char* estr)
@@ -77,6 +134,7 @@ void tskRelease()
             ev.items.Free();
         tsk.events.Free();
         tsk.history.Free();
+        tsk.unsavedEvents.Free();
     }
     gTsk.graphs.Free();
 }
@@ -97,9 +155,242 @@ static inline Path tskGetTaskFilePath(WksFileHandle graphFileHandle)
     return taskFilepath;
 }
 
+static inline uint32 tskGetRetainedRuns()
+{
+    return Max<uint32>(GetSettings().tasks.retainedRuns, 1);
+}
+
+static inline uint32 tskGetFirstRetainedRun(uint32 runIndex)
+{
+    uint32 retainedRuns = tskGetRetainedRuns();
+    return runIndex > retainedRuns ? (runIndex - retainedRuns + 1) : 0;
+}
+
+// Old task files were json. Loads everything, and the next save converts it to the journal
+static void tskLoadLegacyTaskFile(TskGraph& taskGraph, const char* jsonData, size_t jsonSize, const char* filepath)
+{
+    MemTempAllocator tmpAlloc;
+    JsonErrorLocation errLoc {};
+    JsonContext* jctx = jsonParse(jsonData, uint32(jsonSize), &errLoc, &tmpAlloc);
+    if (!jctx) {
+        logWarning("Parsing json failed: %s (Line: %u, Column: %u)", filepath, errLoc.line, errLoc.col);
+        return;
+    }
+    JsonNode jroot(jctx);
+
+    // Legacy files don't have run indexes, so every "Run" event (see tskBeginGraphExecute) starts a new run
+    JsonNode jevents = jroot.GetChild("Events");
+    if (jevents.IsValid()) {
+        for (JsonNode jevent = jevents.GetArrayItem(); jevent.IsValid(); jevent = jevents.GetNextArrayItem(jevent)) {
+            char title[256];
+            jevent.GetChildValue("Title", title, sizeof(title));
+            if (strIsEqual(title, "Run") || taskGraph.runIndex == 0)
+                ++taskGraph.runIndex;
+
+            TskEventHandle eventHandle = taskGraph.events.Add(TskEvent {
+                .title = title,
+                .duration = jevent.GetChildValue<float>("Duration", 0),
+                .tm = static_cast<time_t>(jevent.GetChildValue<int64>("Time", 0)),
+                .id = taskGraph.nextEventId++,
+                .runIndex = taskGraph.runIndex,
+                .ended = true
+            });
+            TskEvent& event = taskGraph.events.Data(eventHandle);
+
+            JsonNode jitems = jevent.GetChild("Items");
+            if (jitems.IsValid()) {
+                char typeStr[32];
+                for (JsonNode jitem = jitems.GetArrayItem(); jitem.IsValid(); jitem = jitems.GetNextArrayItem(jitem)) {
+                    event.items.Push(TskEventItem {
+                        .text = CreateString(jitem.GetChildString("Text", &tmpAlloc)),
+                        .type = TskEventType::FromString(jitem.GetChildValue("Type", typeStr, sizeof(typeStr)))
+                    });
+                }
+            }
+        }
+    }
+
+    // History only has the successful runs, assume they are the latest ones
+    JsonNode jhistory = jroot.GetChild("History");
+    if (jhistory.IsValid()) {
+        uint32 numSummaries = jhistory.GetArrayCount();
+        taskGraph.runIndex = Max(taskGraph.runIndex, numSummaries);
+        uint32 runIndex = taskGraph.runIndex - numSummaries;
+
+        char metaData[256];
+        for (JsonNode jsummary = jhistory.GetArrayItem(); jsummary.IsValid(); jsummary = jhistory.GetNextArrayItem(jsummary)) {
+            taskGraph.history.Push(TskSummary {
+                .duration = jsummary.GetChildValue<float>("Duration", 0),
+                .startTm = static_cast<time_t>(jsummary.GetChildValue<int64>("StartTime", 0)),
+                .metaData = jsummary.GetChildValue("MetaData", metaData, sizeof(metaData)),
+                .runIndex = ++runIndex
+            });
+        }
+    }
+
+    taskGraph.journalNeedsCompact = true;
+}
+
+// Returns false if the journal is truncated or corrupt. Everything until the bad record is still loaded
+static bool tskLoadJournal(TskGraph& taskGraph, const uint8* data, size_t size)
+{
+    const TskJournalHeader* header = (const TskJournalHeader*)data;
+    ASSERT(header->version == kTskJournalVersion || header->version == kTskJournalVersionNoEventIds);
+    bool hasEventIds = header->version != kTskJournalVersionNoEventIds;
+    size_t startOffset = sizeof(TskJournalHeader);
+
+    // First pass: only walk the record headers to find out the last run, so we can skip the ones we don't retain
+    uint32 lastRun = header->firstRun;
+    size_t offset = startOffset;
+    while (offset + sizeof(TskJournalRecord) <= size) {
+        const TskJournalRecord* record = (const TskJournalRecord*)(data + offset);
+        if (offset + sizeof(TskJournalRecord) + record->size > size)
+            break;
+        lastRun = Max(lastRun, record->runIndex);
+        offset += sizeof(TskJournalRecord) + record->size;
+    }
+    size_t endOffset = offset;
+
+    uint32 firstRun = tskGetFirstRetainedRun(lastRun);
+    taskGraph.runIndex = lastRun;
+    taskGraph.journalFirstRun = header->firstRun;
+
+    // Sub events are usually written before their outer event (they end first), so the outer handles are resolved at the end
+    struct SubEvent
+    {
+        TskEventHandle handle;
+        uint32 outerId;
+    };
+
+    MemTempAllocator tmpAlloc;
+    Array<SubEvent> subEvents(&tmpAlloc);
+    HashTable<TskEventHandle> eventLookup(&tmpAlloc);    // id -> handle
+    eventLookup.Reserve(64);
+    TskEvent* event = nullptr;
+    bool valid = true;
+    offset = startOffset;
+    while (offset < endOffset) {
+        const TskJournalRecord* record = (const TskJournalRecord*)(data + offset);
+        offset += sizeof(TskJournalRecord);
+        if (record->runIndex < firstRun || record->size == 0) {
+            offset += record->size;
+            continue;
+        }
+
+        Blob payload((void*)(data + offset), record->size);
+        payload.SetSize(record->size);
+        offset += record->size;
+
+        auto ReadString = [&payload, &tmpAlloc](uint32 len)->const char* {
+            char* str = tmpAlloc.MallocTyped<char>(len + 1);
+            if (len)
+                payload.Read(str, len);
+            str[len] = '\0';
+            return str;
+        };
+
+        // Fixed fields are read before the string lengths are checked, so too small records are corrupt
+        uint32 fixedSize = 0;
+        switch (record->type) {
+        case TskJournalRecordType::Event:   fixedSize = hasEventIds ? kTskJournalEventFixedSize : kTskJournalEventFixedSizeNoIds; break;
+        case TskJournalRecordType::Item:    fixedSize = kTskJournalItemFixedSize; break;
+        case TskJournalRecordType::Summary: fixedSize = kTskJournalSummaryFixedSize; break;
+        default:                            break;
+        }
+        if (record->size < fixedSize) {
+            valid = false;
+            break;
+        }
+
+        switch (record->type) {
+        case TskJournalRecordType::Event: {
+            TskEvent ev {
+                .runIndex = record->runIndex,
+                .ended = true
+            };
+            uint32 id = taskGraph.nextEventId;
+            uint32 outerId = INVALID_INDEX;
+            int64 tm = 0;
+            uint16 titleLen = 0;
+            if (hasEventIds) {
+                payload.Read<uint32>(&id);
+                payload.Read<uint32>(&outerId);
+            }
+            payload.Read<float>(&ev.duration);
+            payload.Read<int64>(&tm);
+            payload.Read<uint16>(&titleLen);
+            if (payload.ReadOffset() + titleLen > payload.Size()) {
+                valid = false;
+                break;
+            }
+            // Ids are kept, so the new events of this session come after the loaded ones (see tskCompactJournal)
+            ev.id = id;
+            ev.tm = static_cast<time_t>(tm);
+            ev.title = ReadString(titleLen);
+            taskGraph.nextEventId = Max(taskGraph.nextEventId, id + 1);
+
+            TskEventHandle eventHandle = taskGraph.events.Add(ev);
+            eventLookup.Add(id, eventHandle);
+            if (outerId != INVALID_INDEX)
+                subEvents.Push(SubEvent { .handle = eventHandle, .outerId = outerId });
+            event = &taskGraph.events.Data(eventHandle);
+            break;
+        }
+        case TskJournalRecordType::Item: {
+            uint32 type = 0;
+            uint32 textLen = 0;
+            payload.Read<uint32>(&type);
+            payload.Read<uint32>(&textLen);
+            if (!event || type >= TskEventType::_Count || payload.ReadOffset() + textLen > payload.Size()) {
+                valid = false;
+                break;
+            }
+            event->items.Push(TskEventItem {
+                .text = CreateString(ReadString(textLen)),
+                .type = TskEventType::Enum(type)
+            });
+            break;
+        }
+        case TskJournalRecordType::Summary: {
+            TskSummary summary { .runIndex = record->runIndex };
+            int64 startTm = 0;
+            uint16 metaLen = 0;
+            payload.Read<float>(&summary.duration);
+            payload.Read<int64>(&startTm);
+            payload.Read<uint16>(&metaLen);
+            if (payload.ReadOffset() + metaLen > payload.Size()) {
+                valid = false;
+                break;
+            }
+            summary.startTm = static_cast<time_t>(startTm);
+            summary.metaData = ReadString(metaLen);
+            taskGraph.history.Push(summary);
+            break;
+        }
+        default:
+            // Unknown record types from newer versions are skipped
+            break;
+        }
+
+        if (!valid)
+            break;
+    }
+
+    // Outer events that were dropped with their run or never ended (crash) leave the sub event at the top level
+    for (const SubEvent& subEvent : subEvents) {
+        uint32 index = eventLookup.Find(subEvent.outerId);
+        if (index != INVALID_INDEX)
+            taskGraph.events.Data(subEvent.handle).outerEventHandle = eventLookup.Get(index);
+    }
+
+    taskGraph.numSavedHistory = taskGraph.history.Count();
+    return valid && endOffset == size;
+}
+
 TskGraphHandle tskLoadGraphTask(WksFileHandle graphFileHandle)
 {
     Path filepath = tskGetTaskFilePath(graphFileHandle);
+    saveFlush();    // The journal might still be in the save queue
     MutexScope mtx(gTsk.graphsMutex);
     for (uint32 i = 0; i < gTsk.graphs.Count(); i++) {
         TskGraphHandle handle = gTsk.graphs.HandleAt(i);
@@ -116,123 +407,210 @@ TskGraphHandle tskLoadGraphTask(WksFileHandle graphFileHandle)
         .refCount = 1
     });
     
-    File f;
-    if (!f.Open(filepath.CStr(), FileOpenFlags::Read | FileOpenFlags::SeqScan) || f.GetSize() == 0)
+    FileMapping mapping;
+    if (!mapping.Open(filepath.CStr()) || mapping.Size() == 0)
         return handle;
     
     TskGraph& taskGraph = gTsk.graphs.Data(handle);
-    MemTempAllocator tmpAlloc;
-    size_t fileSize = f.GetSize();
-    char* jsonText = (char*)tmpAlloc.Malloc(fileSize + 1);
-    f.Read<char>(jsonText, (uint32)fileSize);
-    jsonText[fileSize] = '\0';
-    f.Close();
-
-    sjson_context* jctx = sjson_create_context(0, 0, &tmpAlloc);
-    ASSERT_ALWAYS(jctx, "Out of memory?");
-    sjson_node* jroot = sjson_decode(jctx, jsonText);
-    if (!jroot) {
-        logWarning("Parsing json failed: %s", filepath.CStr());
-        return handle;
+    const uint8* data = (const uint8*)mapping.Data();
+    size_t size = mapping.Size();
+
+    if (size >= sizeof(TskJournalHeader) && ((const TskJournalHeader*)data)->magic == kTskJournalMagic) {
+        uint32 version = ((const TskJournalHeader*)data)->version;
+        if (version != kTskJournalVersion && version != kTskJournalVersionNoEventIds) {
+            logWarning("Task journal version %u is not supported, history will not be saved to it: %s", version, filepath.CStr());
+            taskGraph.journalReadOnly = true;
+        }
+        else if (!tskLoadJournal(taskGraph, data, size)) {
+            logWarning("Task journal is truncated or corrupt, it will be rewritten on next save: %s", filepath.CStr());
+            taskGraph.journalNeedsCompact = true;
+        }
+        else if (version != kTskJournalVersion) {
+            // Rewrite with the current version, so we don't append new records to the old layout
+            taskGraph.journalNeedsCompact = true;
+        }
+    }
+    else {
+        tskLoadLegacyTaskFile(taskGraph, (const char*)data, size, filepath.CStr());
     }
 
-    sjson_node* jevents = sjson_find_member(jroot, "Events");
-    if (jevents) {
-        sjson_node* jevent = sjson_first_child(jevents);
-        while (jevent) {
-            TskEventHandle eventHandle = taskGraph.events.Add(TskEvent {
-                .title = sjson_get_string(jevent, "Title", ""),
-                .duration = sjson_get_float(jevent, "Duration", 0),
-                .tm = static_cast<time_t>(sjson_get_int64(jevent, "Time", 0))
-            });
-            TskEvent& event = taskGraph.events.Data(eventHandle);
+    mapping.Close();
+    return handle;
+}
 
-            sjson_node* jitems = sjson_find_member(jevent, "Items");
-            if (jitems) {
-                sjson_node* jitem = sjson_first_child(jitems);
-                while (jitem) {
-                    event.items.Push(TskEventItem {
-                        .text = CreateString(sjson_get_string(jitem, "Text", "")),
-                        .type = TskEventType::FromString(sjson_get_string(jitem, "Type", ""))
-                    });
-                    jitem = jitem->next;
-                }
-            }
+static void tskWriteJournalEvent(Blob* blob, TskGraph& graphTask, const TskEvent& event)
+{
+    uint32 outerId = INVALID_INDEX;
+    if (event.outerEventHandle.IsValid() && graphTask.events.IsValid(event.outerEventHandle))
+        outerId = graphTask.events.Data(event.outerEventHandle).id;
 
-            jevent = jevent->next;
-        }
+    uint32 titleLen = event.title.Length();
+    blob->Write<TskJournalRecord>(TskJournalRecord {
+        .type = TskJournalRecordType::Event,
+        .runIndex = event.runIndex,
+        .size = kTskJournalEventFixedSize + titleLen
+    });
+    blob->Write<uint32>(event.id);
+    blob->Write<uint32>(outerId);
+    blob->Write<float>(event.duration);
+    blob->Write<int64>(static_cast<int64>(event.tm));
+    blob->WriteStringBinary16(event.title.CStr(), titleLen);
+
+    for (const TskEventItem& item : event.items) {
+        const char* text = GetString(item.text);
+        uint32 textLen = strLen(text);
+        blob->Write<TskJournalRecord>(TskJournalRecord {
+            .type = TskJournalRecordType::Item,
+            .runIndex = event.runIndex,
+            .size = kTskJournalItemFixedSize + textLen
+        });
+        blob->Write<uint32>(uint32(item.type));
+        blob->WriteStringBinary(text, textLen);
     }
+}
 
-    sjson_node* jhistory = sjson_find_member(jroot, "History");
-    if (jhistory) {
-        sjson_node* jsummary = sjson_first_child(jhistory);
-        while (jsummary) {
-            taskGraph.history.Push(TskSummary {
-                .duration = sjson_get_float(jsummary, "Duration", 0),
-                .startTm = sjson_get_int64(jsummary, "StartTime", 0),
-                .metaData = sjson_get_string(jsummary, "MetaData", "")
-            });
-            jsummary = jsummary->next;
+static void tskWriteJournalSummary(Blob* blob, const TskSummary& summary)
+{
+    uint32 metaLen = summary.metaData.Length();
+    blob->Write<TskJournalRecord>(TskJournalRecord {
+        .type = TskJournalRecordType::Summary,
+        .runIndex = summary.runIndex,
+        .size = kTskJournalSummaryFixedSize + metaLen
+    });
+    blob->Write<float>(summary.duration);
+    blob->Write<int64>(static_cast<int64>(summary.startTm));
+    blob->WriteStringBinary16(summary.metaData.CStr(), metaLen);
+}
+
+// Journal data is serialized under the lock, which is only memory work. The save thread does the file IO
+struct TskSaveSnapshot
+{
+    TskGraphHandle handle;
+    Blob blob;
+};
+
+static bool tskSerializeSnapshot(Blob* blob, void* snapshot)
+{
+    const Blob& data = ((TskSaveSnapshot*)snapshot)->blob;
+    return blob->Write(data.Data(), data.Size()) == data.Size();
+}
+
+static void tskFinishSnapshot(SaveResult result, void* snapshot)
+{
+    TskSaveSnapshot* s = (TskSaveSnapshot*)snapshot;
+    if (result == SaveResult::Failed) {
+        // Partially written records are detected on load, rewrite the whole thing next time
+        MutexScope mtx(gTsk.graphsMutex);
+        if (gTsk.graphs.IsValid(s->handle))
+            gTsk.graphs.Data(s->handle).journalNeedsCompact = true;
+    }
+
+    s->blob.Free();
+    memFree(s);
+}
+
+static TskSaveSnapshot* tskCreateSnapshot(TskGraphHandle handle)
+{
+    TskSaveSnapshot* snapshot = memAllocTyped<TskSaveSnapshot>();
+    snapshot->handle = handle;
+    snapshot->blob = Blob();
+    snapshot->blob.SetGrowPolicy(Blob::GrowPolicy::Multiply);
+    return snapshot;
+}
+
+// Drops everything before the retained runs and serializes the whole journal, it is then written to a temp file and renamed over the old one
+static TskSaveSnapshot* tskCompactJournal(TskGraphHandle handle, TskGraph& graphTask)
+{
+    uint32 firstRun = tskGetFirstRetainedRun(graphTask.runIndex);
+
+    for (uint32 i = graphTask.events.Count(); i-- > 0;) {
+        TskEventHandle eventHandle = graphTask.events.HandleAt(i);
+        TskEvent& event = graphTask.events.Data(eventHandle);
+        if (event.ended && event.runIndex < firstRun) {
+            event.items.Free();
+            graphTask.events.Remove(eventHandle);
         }
     }
 
-    sjson_destroy_context(jctx);
-    return handle;
+    uint32 numOldSummaries = 0;
+    while (numOldSummaries < graphTask.history.Count() && graphTask.history[numOldSummaries].runIndex < firstRun)
+        ++numOldSummaries;
+    if (numOldSummaries)
+        graphTask.history.RemoveRangeAndShift(0, numOldSummaries);
+    ++graphTask.statsVersion;
+
+    MemTempAllocator tmpAlloc;
+    Array<TskEvent*> events(&tmpAlloc);
+    for (TskEvent& event : graphTask.events) {
+        if (event.ended)
+            events.Push(&event);
+    }
+    BlitSort<TskEvent*>(events.Ptr(), events.Count(), [](TskEvent* const& a, TskEvent* const& b)->int {
+        return a->id < b->id ? -1 : (a->id > b->id ? 1 : 0);
+    });
+
+    TskSaveSnapshot* snapshot = tskCreateSnapshot(handle);
+    snapshot->blob.Write<TskJournalHeader>(TskJournalHeader {
+        .magic = kTskJournalMagic,
+        .version = kTskJournalVersion,
+        .firstRun = firstRun
+    });
+    for (TskEvent* event : events)
+        tskWriteJournalEvent(&snapshot->blob, graphTask, *event);
+    for (const TskSummary& summary : graphTask.history)
+        tskWriteJournalSummary(&snapshot->blob, summary);
+
+    graphTask.journalFirstRun = firstRun;
+    graphTask.journalNeedsCompact = false;
+    return snapshot;
 }
 
 bool tskSaveGraphTask(TskGraphHandle handle)
 {
+    // Submit under the lock, so the requests reach the save queue in the same order as their snapshots. Otherwise a 
+    // compaction (Replace) could get in after a newer Append and overwrite it
+    // Superseded requests call tskFinishSnapshot right away, graphsMutex is recursive
     MutexScope mtx(gTsk.graphsMutex);
     TskGraph& graphTask = gTsk.graphs.Data(handle);
     Path filepath = tskGetTaskFilePath(graphTask.graphFileHandle);
 
-    MemTempAllocator tmpAlloc;
-    sjson_context* jctx = sjson_create_context(0, 0, &tmpAlloc);
-    ASSERT_ALWAYS(jctx, "Out of memory?");
-    sjson_node* jroot = sjson_mkobject(jctx);
-
-    sjson_node* jevents = sjson_put_array(jctx, jroot, "Events");
-    for (TskEvent& event : graphTask.events) {
-        sjson_node* jevent = sjson_mkobject(jctx);
-        sjson_put_string(jctx, jevent, "Title", event.title.CStr());
-        sjson_put_float(jctx, jevent, "Duration", event.duration);
-        sjson_put_int64(jctx, jevent, "Time", static_cast<int64>(event.tm));
-
-        if (event.items.Count()) {
-            sjson_node* jitems = sjson_put_array(jctx, jevent, "Items");
-            for (TskEventItem& item : event.items) {
-                sjson_node* jitem = sjson_mkobject(jctx);
-                sjson_put_string(jctx, jitem, "Text", GetString(item.text));
-                sjson_put_string(jctx, jitem, "Type", TskEventType::ToString(item.type));
-                sjson_append_element(jitems, jitem);
-            }
-        }
-
-        sjson_append_element(jevents, jevent);
+    if (graphTask.journalReadOnly) {
+        graphTask.unsavedEvents.Clear();
+        graphTask.numSavedHistory = graphTask.history.Count();
+        return false;
     }
 
-    sjson_node* jhistory = sjson_put_array(jctx, jroot, "History");
-    for (TskSummary& summary : graphTask.history) {
-        sjson_node* jsummary = sjson_mkobject(jctx);
-        sjson_put_float(jctx, jsummary, "Duration", summary.duration);
-        sjson_put_int64(jctx, jsummary, "StartTime", summary.startTm);
-        sjson_put_string(jctx, jsummary, "MetaData", summary.metaData.CStr());
-
-        sjson_append_element(jhistory, jsummary);
+    // If the first write is still in the save queue, the file doesn't exist and we compact again. That's fine, it supersedes the pending one
+    SaveMode mode;
+    TskSaveSnapshot* snapshot;
+    uint32 journalRuns = graphTask.runIndex >= graphTask.journalFirstRun ? (graphTask.runIndex - graphTask.journalFirstRun + 1) : 0;
+    if (graphTask.journalNeedsCompact || journalRuns > tskGetRetainedRuns()*kTskJournalCompactFactor || !filepath.IsFile()) {
+        mode = SaveMode::Replace;
+        snapshot = tskCompactJournal(handle, graphTask);
     }
+    else {
+        if (graphTask.unsavedEvents.IsEmpty() && graphTask.numSavedHistory == graphTask.history.Count())
+            return true;
 
-    char* jsonText = sjson_stringify(jctx, jroot, "\t");
-    File f;
-    if (!f.Open(filepath.CStr(), FileOpenFlags::Write)) {
-        logError("Cannot open file for writing: %s", filepath.CStr());
-        return false;
+        mode = SaveMode::Append;
+        snapshot = tskCreateSnapshot(handle);
+        for (TskEventHandle eventHandle : graphTask.unsavedEvents)
+            tskWriteJournalEvent(&snapshot->blob, graphTask, graphTask.events.Data(eventHandle));
+        for (uint32 i = graphTask.numSavedHistory; i < graphTask.history.Count(); i++)
+            tskWriteJournalSummary(&snapshot->blob, graphTask.history[i]);
     }
 
-    f.Write(jsonText, strLen(jsonText));
-    f.Close();
+    // Everything is in the snapshot now. Write failures are reported back with journalNeedsCompact (see tskFinishSnapshot)
+    graphTask.unsavedEvents.Clear();
+    graphTask.numSavedHistory = graphTask.history.Count();
 
-    sjson_free_string(jctx, jsonText);
-    sjson_destroy_context(jctx);
+    saveSubmit(SaveDesc {
+        .filepath = filepath.CStr(),
+        .mode = mode,
+        .snapshot = snapshot,
+        .serializeFn = tskSerializeSnapshot,
+        .finishFn = tskFinishSnapshot
+    });
     return true;
 }
 
@@ -242,7 +620,11 @@ void tskDestroyTask(TskGraphHandle handle)
     TskGraph& graphTask = gTsk.graphs.Data(handle);
     --graphTask.refCount;
     if (graphTask.refCount == 0) {
+        for (TskEvent& ev : graphTask.events)
+            ev.items.Free();
         graphTask.events.Free();
+        graphTask.history.Free();
+        graphTask.unsavedEvents.Free();
         gTsk.graphs.Remove(handle);
     }
 }
@@ -257,12 +639,14 @@ TskEventHandle tskBeginEvent(TskGraphHandle graphHandle, const char* name, TskGr
         .startTm = timerGetTicks(),
         .tm = time(nullptr),
         .parentGraphHandle = redirectGraph,
-        .parentEventHandle = redirectEvents
+        .parentEventHandle = redirectEvents,
+        .id = graphTask.nextEventId++,
+        .runIndex = graphTask.runIndex
     });
 
     TskEvent& event = graphTask.events.Data(eventHandle);
     if (graphTask.callbacks) 
-        graphTask.callbacks->OnBeginEvent(graphHandle, eventHandle, event.title.CStr(), event.tm);
+        graphTask.callbacks->OnBeginEvent(graphHandle, eventHandle, TskEventHandle(), event.title.CStr(), event.tm);
         
     if (redirectGraph.IsValid() && redirectEvents.IsValid()) {
         ASSERT(redirectGraph != graphHandle);
@@ -278,6 +662,28 @@ TskEventHandle tskBeginEvent(TskGraphHandle graphHandle, const char* name, TskGr
     return eventHandle;
 }
 
+TskEventHandle tskBeginSubEvent(TskGraphHandle graphHandle, TskEventHandle outerEventHandle, const char* name)
+{
+    MutexScope mtx(gTsk.graphsMutex);
+    TskGraph& graphTask = gTsk.graphs.Data(graphHandle);
+    ASSERT(graphTask.events.IsValid(outerEventHandle));
+    
+    TskEventHandle eventHandle = graphTask.events.Add(TskEvent {
+        .title = name,
+        .startTm = timerGetTicks(),
+        .tm = time(nullptr),
+        .outerEventHandle = outerEventHandle,
+        .id = graphTask.nextEventId++,
+        .runIndex = graphTask.runIndex
+    });
+
+    TskEvent& event = graphTask.events.Data(eventHandle);
+    if (graphTask.callbacks) 
+        graphTask.callbacks->OnBeginEvent(graphHandle, eventHandle, outerEventHandle, event.title.CStr(), event.tm);
+    
+    return eventHandle;
+}
+
 void tskEndEvent(TskGraphHandle graphHandle, TskEventHandle eventHandle)
 {
     MutexScope mtx(gTsk.graphsMutex);
@@ -285,6 +691,9 @@ void tskEndEvent(TskGraphHandle graphHandle, TskEventHandle eventHandle)
         
     TskEvent& event = graphTask.events.Data(eventHandle);
     event.duration = (float)timerToSec(timerDiff(timerGetTicks(), event.startTm));
+    event.ended = true;
+    ++graphTask.statsVersion;
+    graphTask.unsavedEvents.Push(eventHandle);
 
     if (graphTask.callbacks)
         graphTask.callbacks->OnEndEvent(graphHandle, eventHandle, event.duration);
@@ -379,11 +788,57 @@ void tskBeginGraphExecute(TskGraphHandle graphHandle, TskGraphHandle redirectGra
     graphTask.inExecute = true;
     graphTask.startTmHires = timerGetTicks();
     graphTask.startTm = time(nullptr);
+    ++graphTask.runIndex;
 
     ASSERT(!graphTask.mainEvent.IsValid());
     graphTask.mainEvent = tskBeginEvent(graphHandle, "Run");
 }
 
+static bool tskGetGraphStatsNoLock(TskGraph& graphTask, TskDurationStats* outStats, const TskAnalyticsParams& params);
+static Span<TskEventStats> tskGetEventStatsNoLock(TskGraph& graphTask, Allocator* alloc, const TskAnalyticsParams& params);
+
+// Adds info items to the main event of the run for the run itself and the steps that got slower than their baseline
+static void tskReportRegressions(TskGraphHandle graphHandle, TskGraph& graphTask)
+{
+    TskAnalyticsParams params;
+    TskDurationStats stats;
+    char lastStr[64];
+    char baselineStr[64];
+
+    if (tskGetGraphStatsNoLock(graphTask, &stats, params) && stats.regressed) {
+        MakeTimeFormat(stats.last, lastStr, sizeof(lastStr));
+        MakeTimeFormat(stats.baseline, baselineStr, sizeof(baselineStr));
+        String<256> text;
+        text.FormatSelf("Run regressed: %s (baseline %s, +%.0f%%)", lastStr, baselineStr, 100.0f*(stats.last/stats.baseline - 1.0f));
+        tskPushEvent(graphHandle, graphTask.mainEvent, TskEventType::Info, text.CStr());
+    }
+
+    // Only report the steps that are part of this run
+    MemTempAllocator tmpAlloc;
+    Span<TskEventStats> eventStats = tskGetEventStatsNoLock(graphTask, &tmpAlloc, params);
+    for (const TskEventStats& eventStat : eventStats) {
+        if (!eventStat.stats.regressed)
+            continue;
+
+        bool inRun = false;
+        for (TskEvent& event : graphTask.events) {
+            if (event.runIndex == graphTask.runIndex && event.ended && event.title == eventStat.title) {
+                inRun = true;
+                break;
+            }
+        }
+        if (!inRun)
+            continue;
+
+        MakeTimeFormat(eventStat.stats.last, lastStr, sizeof(lastStr));
+        MakeTimeFormat(eventStat.stats.baseline, baselineStr, sizeof(baselineStr));
+        String<512> text;
+        text.FormatSelf("Step '%s' regressed: %s (baseline %s, +%.0f%%)", eventStat.title.CStr(), lastStr, baselineStr, 
+                        100.0f*(eventStat.stats.last/eventStat.stats.baseline - 1.0f));
+        tskPushEvent(graphHandle, graphTask.mainEvent, TskEventType::Info, text.CStr());
+    }
+}
+
 void tskEndGraphExecute(TskGraphHandle graphHandle, const char* metaData, bool withError)
 {
     MutexScope mtx(gTsk.graphsMutex);
@@ -394,11 +849,14 @@ void tskEndGraphExecute(TskGraphHandle graphHandle, const char* metaData, bool w
         graphTask.history.Push(TskSummary {
             .duration = (float)timerToSec(timerDiff(timerGetTicks(), graphTask.startTmHires)),
             .startTm = graphTask.startTm,
-            .metaData = metaData ? metaData : ""
+            .metaData = metaData ? metaData : "",
+            .runIndex = graphTask.runIndex
         });    
     }
 
     ASSERT(graphTask.mainEvent.IsValid());
+    if (!withError)
+        tskReportRegressions(graphHandle, graphTask);
     tskPushEvent(graphHandle, graphTask.mainEvent, withError ? TskEventType::Error : TskEventType::Success, "");
     tskEndEvent(graphHandle, graphTask.mainEvent);
     graphTask.mainEvent = TskEventHandle();
@@ -431,4 +889,156 @@ void tskClearHistory(TskGraphHandle graphHandle)
     MutexScope mtx(gTsk.graphsMutex);
     TskGraph& graphTask = gTsk.graphs.Data(graphHandle);
     graphTask.history.Clear();
-}
\ No newline at end of file
+    graphTask.numSavedHistory = 0;
+    graphTask.journalNeedsCompact = true;   // Clearing can't be appended, rewrite the journal on next save
+    ++graphTask.statsVersion;
+}
+
+uint32 tskGetStatsVersion(TskGraphHandle graphHandle)
+{
+    MutexScope mtx(gTsk.graphsMutex);
+    return gTsk.graphs.Data(graphHandle).statsVersion;
+}
+
+static float tskCalcPercentile(const float* sorted, uint32 count, float p)
+{
+    ASSERT(count);
+    float rank = p*float(count - 1);
+    uint32 index = uint32(rank);
+    if (index + 1 >= count)
+        return sorted[count - 1];
+    float t = rank - float(index);
+    return sorted[index] + (sorted[index + 1] - sorted[index])*t;
+}
+
+static int tskCompareDurations(const float& a, const float& b)
+{
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+static void tskCalcDurationStats(const float* samples, uint32 count, const TskAnalyticsParams& params, TskDurationStats* outStats)
+{
+    *outStats = TskDurationStats { .numSamples = count };
+    if (count == 0)
+        return;
+
+    MemTempAllocator tmpAlloc;
+    float* sorted = memAllocCopy<float>(samples, count, &tmpAlloc);
+    BlitSort<float>(sorted, count, tskCompareDurations);
+    outStats->p50 = tskCalcPercentile(sorted, count, 0.5f);
+    outStats->p90 = tskCalcPercentile(sorted, count, 0.9f);
+    outStats->p99 = tskCalcPercentile(sorted, count, 0.99f);
+    outStats->last = samples[count - 1];
+
+    if (count > 1) {
+        float n = float(count);
+        float sumX = 0, sumY = 0, sumXY = 0, sumXX = 0;
+        for (uint32 i = 0; i < count; i++) {
+            float x = float(i);
+            sumX += x;
+            sumY += samples[i];
+            sumXY += x*samples[i];
+            sumXX += x*x;
+        }
+        float denom = n*sumXX - sumX*sumX;
+        outStats->trend = denom != 0 ? (n*sumXY - sumX*sumY)/denom : 0;
+    }
+
+    uint32 numBaseline = Min(count - 1, params.baselineRuns);
+    if (numBaseline) {
+        float* baseline = memAllocCopy<float>(samples + count - 1 - numBaseline, numBaseline, &tmpAlloc);
+        BlitSort<float>(baseline, numBaseline, tskCompareDurations);
+        outStats->baseline = tskCalcPercentile(baseline, numBaseline, 0.5f);
+        outStats->regressed = numBaseline >= params.minBaselineRuns && outStats->baseline > 0 &&
+                              outStats->last > outStats->baseline*(1.0f + params.regressionThreshold) &&
+                              (outStats->last - outStats->baseline) > params.minRegressionSecs;
+    }
+}
+
+static bool tskGetGraphStatsNoLock(TskGraph& graphTask, TskDurationStats* outStats, const TskAnalyticsParams& params)
+{
+    uint32 count = graphTask.history.Count();
+    if (count == 0) {
+        *outStats = TskDurationStats {};
+        return false;
+    }
+
+    MemTempAllocator tmpAlloc;
+    float* samples = tmpAlloc.MallocTyped<float>(count);
+    for (uint32 i = 0; i < count; i++)
+        samples[i] = graphTask.history[i].duration;
+    tskCalcDurationStats(samples, count, params, outStats);
+    return true;
+}
+
+static Span<TskEventStats> tskGetEventStatsNoLock(TskGraph& graphTask, Allocator* alloc, const TskAnalyticsParams& params)
+{
+    // Note: `alloc` can be a temp allocator, so we cannot open another temp scope on top of it here
+    Array<TskEvent*> events;
+    for (TskEvent& event : graphTask.events) {
+        if (event.ended && !strIsEqual(event.title.CStr(), "Run"))
+            events.Push(&event);
+    }
+    if (events.IsEmpty())
+        return Span<TskEventStats>();
+
+    // Group by title, each group in run order
+    BlitSort<TskEvent*>(events.Ptr(), events.Count(), [](TskEvent* const& a, TskEvent* const& b)->int {
+        int r = strcmp(a->title.CStr(), b->title.CStr());
+        return r != 0 ? r : (a->id < b->id ? -1 : (a->id > b->id ? 1 : 0));
+    });
+
+    Array<TskEventStats> groups;
+    float* samples = memAllocTyped<float>(events.Count());
+    uint32 groupStart = 0;
+    for (uint32 i = 1; i <= events.Count(); i++) {
+        if (i < events.Count() && events[i]->title == events[groupStart]->title)
+            continue;
+
+        uint32 count = i - groupStart;
+        for (uint32 k = 0; k < count; k++)
+            samples[k] = events[groupStart + k]->duration;
+
+        TskEventStats* stat = groups.Push();
+        stat->title = events[groupStart]->title;
+        tskCalcDurationStats(samples, count, params, &stat->stats);
+
+        uint32 numSparkSamples = Min(count, params.maxSamples);
+        stat->samples = numSparkSamples ? memAllocCopy<float>(samples + count - numSparkSamples, numSparkSamples, alloc) : nullptr;
+        stat->numSamples = numSparkSamples;
+
+        groupStart = i;
+    }
+
+    // TskEventStats is not trivially copyable (String), sort pointers to it instead
+    Array<TskEventStats*> order;
+    for (TskEventStats& stat : groups)
+        order.Push(&stat);
+    BlitSort<TskEventStats*>(order.Ptr(), order.Count(), [](TskEventStats* const& a, TskEventStats* const& b)->int {
+        return a->stats.p50 > b->stats.p50 ? -1 : (a->stats.p50 < b->stats.p50 ? 1 : 0);
+    });
+
+    Array<TskEventStats> stats(alloc);
+    stats.Reserve(order.Count());
+    for (TskEventStats* stat : order)
+        stats.Push(*stat);
+
+    order.Free();
+    groups.Free();
+    memFree(samples);
+    events.Free();
+    return stats.Detach();
+}
+
+bool tskGetGraphStats(TskGraphHandle graphHandle, TskDurationStats* outStats, const TskAnalyticsParams& params)
+{
+    ASSERT(outStats);
+    MutexScope mtx(gTsk.graphsMutex);
+    return tskGetGraphStatsNoLock(gTsk.graphs.Data(graphHandle), outStats, params);
+}
+
+Span<TskEventStats> tskGetEventStats(TskGraphHandle graphHandle, Allocator* alloc, const TskAnalyticsParams& params)
+{
+    MutexScope mtx(gTsk.graphsMutex);
+    return tskGetEventStatsNoLock(gTsk.graphs.Data(graphHandle), alloc, params);
+}
@@ -30,11 +30,45 @@ struct TskSummary
     float duration;
     time_t startTm;
     String<256> metaData;
+    uint32 runIndex;
+};
+
+// Duration statistics over a series of runs (graph runs or all runs of a single node event)
+// Regression: the latest sample is compared against the median of the `baselineRuns` samples before it
+struct TskDurationStats
+{
+    uint32 numSamples;
+    float p50;
+    float p90;
+    float p99;
+    float trend;            // Least-squares slope over the samples, in seconds per run
+    float last;             // Latest duration
+    float baseline;         // Median of the rolling baseline window before the latest sample
+    bool regressed;
+};
+
+struct TskEventStats
+{
+    String<256> title;
+    TskDurationStats stats;
+    float* samples;         // Durations in run order, last `maxSamples` of them (for sparklines)
+    uint32 numSamples;
+};
+
+struct TskAnalyticsParams
+{
+    uint32 baselineRuns = 20;
+    uint32 minBaselineRuns = 5;             // No regression flags until there is this many samples in the baseline
+    float regressionThreshold = 0.25f;      // Flag when last > baseline*(1 + threshold)
+    float minRegressionSecs = 0.5f;         // ..and the difference is larger than this, filters out noisy short steps
+    uint32 maxSamples = 64;
 };
 
 struct NO_VTABLE TskCallbacks
 {
-    virtual void OnBeginEvent(TskGraphHandle graphHandle, TskEventHandle eventHandle, const char* name, time_t startTm) = 0;
+    // outerEventHandle is valid for sub events (see tskBeginSubEvent)
+    virtual void OnBeginEvent(TskGraphHandle graphHandle, TskEventHandle eventHandle, TskEventHandle outerEventHandle, 
+                              const char* name, time_t startTm) = 0;
     virtual void OnEndEvent(TskGraphHandle graphHandle, TskEventHandle eventHandle, float duration) = 0;
     virtual void OnNewEvent(TskGraphHandle graphHandle, TskEventHandle eventHandle, TskEventType::Enum type, const char* text) = 0;
 };
@@ -49,13 +83,18 @@ TskEventHandle ngGetParentEventHandle(NodeGraph* graph);
 
 // do not reload task if it's already loaded (refcount > 1)
 // Returns an empty Task object, if the file does not exist
+// Task files are binary append-only journals. Only the last `Settings::tasks.retainedRuns` runs are loaded
 TskGraphHandle tskLoadGraphTask(WksFileHandle graphFileHandle);
+// Appends new events/history to the journal on the save thread. The journal is rewritten (compacted) when it holds too many old runs
 bool tskSaveGraphTask(TskGraphHandle handle);
 
 void tskDestroyTask(TskGraphHandle handle); // TODO: must be refcounted (we might have multiple/embedded graphs opened)
 
 TskEventHandle tskBeginEvent(TskGraphHandle graphHandle, const char* name,
                              TskGraphHandle redirectGraph = TskGraphHandle(), TskEventHandle redirectEvents = TskEventHandle());
+// Event that runs inside another event of the same graph, like the phases of a node. Ended with tskEndEvent as usual
+// Sub events are not redirected to the parent graph, only their outer event is
+TskEventHandle tskBeginSubEvent(TskGraphHandle graphHandle, TskEventHandle outerEventHandle, const char* name);
 void tskEndEvent(TskGraphHandle graphHandle, TskEventHandle eventHandle);
 void tskPushEvent(TskGraphHandle handle, TskEventHandle eventHandle, TskEventType::Enum type, const char* text);
 
@@ -111,4 +150,11 @@ void tskEndGraphExecute(TskGraphHandle graphHandle, const char* metaData, bool w
 
 WksFileHandle tskGetFileHandle(TskGraphHandle graphHandle);
 Span<TskSummary> tskGetHistory(TskGraphHandle graphHandle, Allocator* alloc);
-void tskClearHistory(TskGraphHandle graphHandle);
\ No newline at end of file
+void tskClearHistory(TskGraphHandle graphHandle);
+
+// Analytics over the retained history. Graph stats only include successful runs (see tskEndGraphExecute)
+// Event stats are grouped by event title and sorted by p50, slowest first. "Run" events are excluded, use graph stats instead
+bool tskGetGraphStats(TskGraphHandle graphHandle, TskDurationStats* outStats, const TskAnalyticsParams& params = TskAnalyticsParams());
+Span<TskEventStats> tskGetEventStats(TskGraphHandle graphHandle, Allocator* alloc, const TskAnalyticsParams& params = TskAnalyticsParams());
+// Changes when the history or the ended events change, so the stats can be cached until then
+uint32 tskGetStatsVersion(TskGraphHandle graphHandle);
\ No newline at end of file
@@ -8,22 +8,18 @@
 #include "Core/Settings.h"
 #include "Core/Atomic.h"
 #include "Core/IniParser.h"
+#include "Core/Hash.h"
+#include "Core/MathScalar.h"
 
 #include "GuiTextView.h"
 #include "GuiNodeGraph.h"
 #include "GuiUtil.h"
 #include "GuiWorkspace.h"
 #include "GuiTasksView.h"
+#include "GuiJobsView.h"
+#include "SaveQueue.h"
 #include "ImGui/ImGuiAll.h"
 
-#define STRPOOL_U64 StringId
-#define STRPOOL_MALLOC(ctx, size) memAlloc(size, (Allocator*)ctx)
-#define STRPOOL_FREE(ctx, ptr) memFree(ptr, (Allocator*)ctx)
-#define STRPOOL_ASSERT(expr, message) ASSERT_MSG(expr, message)
-#define STRPOOL_STRNICMP(s1, s2, len) (strIsEqualNoCaseCount(s1, s2, (uint32)len) ? 0 : 1)
-#define STRPOOL_IMPLEMENTATION
-#include "strpool.h"
-
 #define SJSON_IMPLEMENT
 #define sjson_malloc(user, size) memAlloc(size, (Allocator*)user)
 #define sjson_free(user, ptr) memFree(ptr, (Allocator*)user)
@@ -40,7 +36,9 @@ struct MainSettingsCallbacks : SettingsCustomCallbacks
     inline static const char* kCats[] = {
         "Build",
         "Tools",
-        "Layout"
+        "Layout",
+        "Output",
+        "Tasks"
     };
 
     enum Category 
@@ -48,6 +46,8 @@ struct MainSettingsCallbacks : SettingsCustomCallbacks
         Build = 0,
         Tool,
         Layout,
+        Output,
+        Tasks,
         Count
     };
 
@@ -113,14 +113,70 @@ struct ShortcutItem
     void* user;
 };
 
+// String interning (StringId): Strings are spread over shards by hash, each one with its own open-addressing table and storage
+// Entries are never moved or freed before shutdown, so StringId is the entry pointer itself and GetString doesn't need any locks
+// Looking up existing strings is lock-free as well, only adding new strings takes the shard lock
+static inline constexpr uint32 kStringNumShardsLog2 = 5;
+static inline constexpr uint32 kStringNumShards = 1u << kStringNumShardsLog2;
+static inline constexpr uint32 kStringInitTableSize = 256;
+static inline constexpr size_t kStringShardReserveSize = 32*kMB;
+
+struct StringEntry
+{
+    atomicUint32 refCount;      // Entries that get down to zero stay interned, the next CreateString revives them
+    uint32 hash;
+    uint32 len;
+    char str[1];
+};
+
+struct StringTable
+{
+    atomicPtr* slots;           // StringEntry*. Load factor is kept under 0.5
+    uint32 capacity;
+    StringTable* prev;          // Replaced tables stay alive until shutdown, readers might still be probing them
+};
+
+struct alignas(CACHE_LINE_SIZE) StringShard
+{
+    AtomicLock lock;
+    atomicPtr table;            // StringTable*
+    uint32 count;
+    MemBumpAllocatorVM alloc;
+};
+
+struct StringPool
+{
+    StringShard shards[kStringNumShards];
+    AtomicLock initLock;
+    atomicUint32 initialized;
+};
+
+static inline constexpr uint32 kRedrawInputFrames = 3;
+static inline constexpr uint64 kRedrawStatsInterval = 60000000000ull;    // nanosecs
+static inline constexpr uint32 kRedrawCaretInterval = 250;   // msecs
+
+struct RedrawState
+{
+    atomicUint32 backgroundPending; // Set by RequestBackgroundRedraw, cleared by the next frame
+    uint32 numFrames;               // Frames to draw without waiting
+    uint64 deadlineTm;              // Set by RequestRedrawTimeout, zero if there is none
+    uint64 lastBackgroundTm;        // Last frame that picked up the background changes
+
+    uint64 statsStartTm;
+    uint64 statsStartCpuTime;
+    uint32 statsNumFrames;
+    float cpuSecsPerMin;            // Process cpu time of the last stats period, scaled to a minute
+    float framesPerMin;
+    float frameTime;                // Milliseconds spent in Update, smoothed
+};
+
 struct MainContext
 {
     Settings settings;
     MainSettingsCallbacks settingsCallbacks;
-    strpool_t strPool;
-    AtomicLock strPoolLock;
-    bool strPoolInit;
+    StringPool strPool;
     bool showDemo;
+    bool showJobs;
 
     Array<GraphWindow> graphs;
     Array<ShortcutItem> shortcuts;
@@ -130,7 +186,9 @@ struct MainContext
     WorkspaceEvents workspaceEvents;
     FocusedWindow focused;
     GuiTaskView taskViewer;
+    GuiJobsView jobsViewer;
     IniContext workspaceSettings;
+    RedrawState redraw;
 };
 
 static MainContext gMain;
@@ -138,6 +196,7 @@ static MainContext gMain;
 static_assert(uint32(MainSettingsCallbacks::Category::Count) == CountOf(MainSettingsCallbacks::kCats));
 
 static void SaveGraph(GuiNodeGraph* uiGraph);
+static void ReleaseStrings();
 
 static void LoadOrCreateWorkspaceSettings()
 {
@@ -359,14 +418,19 @@ void WaitForProcessAndReadOutputText(const SysProcess& proc, Blob* outputBlob, u
     outputBlob->Write<char>('\0');
 }
 
-static Path GetSettingsFilePath()
+static Path GetCacheDir()
 {
     // Create cache dir if it doesn't exist
     Path cacheDir;
     pathGetCacheDir(cacheDir.Ptr(), sizeof(cacheDir), CONFIG_APP_NAME);
     if (!cacheDir.IsDir())
         pathCreateDir(cacheDir.CStr());
-    return Path::Join(cacheDir, CONFIG_APP_NAME ".ini");
+    return cacheDir;
+}
+
+static Path GetSettingsFilePath()
+{
+    return Path::Join(GetCacheDir(), CONFIG_APP_NAME ".ini");
 }
 
 bool Initialize()
@@ -375,11 +439,18 @@ bool Initialize()
     settingsInitializeFromINI(GetSettingsFilePath().CStr());
 
     logSetSettings(LogLevel::Debug, false, false);
+    logInitializeAsync();
+    // Queued entries are usually the most interesting ones when we hit an assert 
+    assertSetFailCallback([](void*) { logFlush(); }, nullptr);
+    // Everything is also kept in a binary log with the previous runs, use logDecodeBinaryFile to read them
+    logOpenBinaryFile(Path::Join(GetCacheDir(), CONFIG_APP_NAME ".aplog").CStr());
     jobsInitialize({});
+    saveInitialize();
     
     ngInitialize();
     tskInitialize();
     gMain.taskViewer.Initialize();
+    gMain.jobsViewer.Initialize();
 
     logRegisterCallback(_private::guiLog, nullptr);
 
@@ -459,15 +530,21 @@ void Release()
 
     gMain.graphs.Free();
 
+    // Layouts and graphs are saved in the background, everything should be on disk before we quit
+    saveRelease();
+
     gMain.taskViewer.Release();
+    gMain.jobsViewer.Release();
     ngRelease();
     tskRelease();
+    textArenaRelease();
 
     jobsRelease();
+    logCloseBinaryFile();
+    logReleaseAsync();
     settingsRelease();
 
-    if (gMain.strPoolInit)
-        strpool_term(&gMain.strPool);
+    ReleaseStrings();
 }
 
 void ShowOpenWorkspace()
@@ -510,9 +587,84 @@ static void SaveGraph(GuiNodeGraph* uiGraph)
     }
 }
 
+void RequestRedraw()
+{
+    gMain.redraw.numFrames = kRedrawInputFrames;
+}
+
+void RequestRedrawTimeout(uint32 msecs)
+{
+    uint64 deadlineTm = timerGetTicks() + uint64(msecs)*1000000;
+    if (gMain.redraw.deadlineTm == 0 || deadlineTm < gMain.redraw.deadlineTm)
+        gMain.redraw.deadlineTm = deadlineTm;
+}
+
+void RequestBackgroundRedraw()
+{
+    // Only the first change after a frame wakes up the main loop, the rest are picked up by the same frame
+    if (atomicExchange32(&gMain.redraw.backgroundPending, 1) == 0)
+        WakeMainLoop();
+}
+
+uint32 GetRedrawWaitTime()
+{
+    RedrawState& redraw = gMain.redraw;
+    if (redraw.numFrames)
+        return 0;
+
+    uint64 deadlineTm = redraw.deadlineTm;
+    if (atomicLoad32(&redraw.backgroundPending)) {
+        uint64 backgroundTm = redraw.lastBackgroundTm + uint64(kMainBackgroundRefreshInterval)*1000000;
+        if (deadlineTm == 0 || backgroundTm < deadlineTm)
+            deadlineTm = backgroundTm;
+    }
+
+    if (deadlineTm == 0)
+        return UINT32_MAX;
+
+    uint64 now = timerGetTicks();
+    return deadlineTm > now ? uint32((deadlineTm - now + 999999)/1000000) : 0;
+}
+
+static void BeginRedrawFrame()
+{
+    RedrawState& redraw = gMain.redraw;
+    uint64 now = timerGetTicks();
+
+    if (redraw.numFrames)
+        --redraw.numFrames;
+    if (redraw.deadlineTm && now >= redraw.deadlineTm)
+        redraw.deadlineTm = 0;
+    // Every frame draws the latest data, so it resets the throttle, whatever woke us up
+    if (atomicExchange32(&redraw.backgroundPending, 0))
+        redraw.lastBackgroundTm = now;
+
+    ++redraw.statsNumFrames;
+    if (redraw.statsStartTm == 0) {
+        redraw.statsStartTm = now;
+        redraw.statsStartCpuTime = sysGetProcessCpuTime();
+    }
+    else if (now - redraw.statsStartTm >= kRedrawStatsInterval) {
+        // Idle frames can be far apart, so the period is usually a bit longer than a minute
+        uint64 cpuTime = sysGetProcessCpuTime();
+        double scale = 60.0 / timerToSec(now - redraw.statsStartTm);
+        redraw.cpuSecsPerMin = float(timerToSec(cpuTime - redraw.statsStartCpuTime)*scale);
+        redraw.framesPerMin = float(double(redraw.statsNumFrames)*scale);
+        // Not for the status bar: it would flash it and redraw for the fade-out, which skews the next period
+        logVerboseCh(kGuiLogChannelNoStatus, "CPU time: %.2fs/min, Frames: %.0f/min", redraw.cpuSecsPerMin, redraw.framesPerMin);
+
+        redraw.statsStartTm = now;
+        redraw.statsStartCpuTime = cpuTime;
+        redraw.statsNumFrames = 0;
+    }
+}
+
 void Update()
 {
     ImGuiIO& io = ImGui::GetIO();
+    uint64 startTm = timerGetTicks();
+
+    BeginRedrawFrame();
 
     if (ImGui::BeginMainMenuBar()) {
         if (ImGui::BeginMenu(CONFIG_APP_NAME)) {
@@ -529,6 +681,7 @@ void Update()
 
             ImGui::Separator();
             ImGui::MenuItem("Show Demo", nullptr, &gMain.showDemo);
+            ImGui::MenuItem("Show Jobs", nullptr, &gMain.showJobs);
             if (ImGui::MenuItem("About")) {
                 guiMessageBox(GuiMessageBoxButtons::Ok|GuiMessageBoxButtons::Cancel, GuiMessageBoxFlags::InfoIcon, nullptr, nullptr, 
                               "AutoPilot version 0.001\nBoop Bip Beep");
@@ -547,10 +700,23 @@ void Update()
         }
 
          // Right status bar
-        imguiAlignRight([io] {
-            char fps[32];
-            strPrintFmt(fps, sizeof(fps), "Fps: %.1f", io.Framerate);
-            ImGui::TextColored(ImGui::GetStyle().Colors[ImGuiCol_TextDisabled], fps);
+        imguiAlignRight([] {
+            char stats[256];
+            uint32 len = 0;
+            if (gMain.focusedGraphIndex != INVALID_INDEX) {
+                const GuiNodeGraph* uiGraph = gMain.graphs[gMain.focusedGraphIndex].uiGraph;
+                const GuiNodeGraphStats& gs = uiGraph->mStats;
+                len = strPrintFmt(stats, sizeof(stats), "Nodes: %u/%u  Links: %u/%u%s  Graph: %.2fms  ", 
+                                  gs.numVisibleNodes, uiGraph->mNodes.Count(), gs.numVisibleLinks, uiGraph->mLinks.Count(),
+                                  uiGraph->mLod ? " (LOD)" : "", gs.renderTime);
+            }
+            TextArenaStats ts;
+            textArenaGetStats(&ts);
+            len += strPrintFmt(stats + len, sizeof(stats) - len, "Output: %.1fMB (%.1fMB resident)  ", 
+                               double(ts.bytesCaptured)/double(kMB), double(ts.bytesResident + ts.bytesPooled)/double(kMB));
+            strPrintFmt(stats + len, sizeof(stats) - len, "Frame: %.2fms  CPU: %.1fs/min  Frames: %.0f/min", 
+                        gMain.redraw.frameTime, gMain.redraw.cpuSecsPerMin, gMain.redraw.framesPerMin);
+            ImGui::TextColored(ImGui::GetStyle().Colors[ImGuiCol_TextDisabled], stats);
         });
 
         ImGui::EndMainMenuBar();
@@ -607,6 +773,10 @@ void Update()
     if (gMain.showDemo)
         ImGui::ShowDemoWindow(&gMain.showDemo);
 
+    gMain.jobsViewer.Update();
+    if (gMain.showJobs)
+        gMain.jobsViewer.Render("Jobs", &gMain.showJobs);
+
     gMain.taskViewer.Render("Tasks");
     gMain.workspace.Render();
 
@@ -627,6 +797,17 @@ void Update()
     guiUpdate();
 
     ProcessShortcuts();
+
+    // Things that change without any events
+    if (gMain.showDemo)
+        RequestRedraw();
+    if (HasRunningSessions())
+        RequestRedrawTimeout(kMainBackgroundRefreshInterval);   // Running times, spinners and finished sessions
+    if (io.WantTextInput)
+        RequestRedrawTimeout(kRedrawCaretInterval);
+
+    float frameTime = float(timerToMS(timerDiff(timerGetTicks(), startTm)));
+    gMain.redraw.frameTime = gMain.redraw.frameTime > 0 ? mathLerp(gMain.redraw.frameTime, frameTime, 0.1f) : frameTime;
 }
 
 uint32 MainSettingsCallbacks::GetCategoryCount() const
@@ -680,6 +861,27 @@ bool MainSettingsCallbacks::ParseSetting(uint32 categoryId, const char* key, con
         else if (strIsEqualNoCase(key, "LastWorkspacePath")) {
             gMain.settings.layout.lastWorkspacePath = value;
         }
+        break;
+    case MainSettingsCallbacks::Category::Output:
+        if (strIsEqualNoCase(key, "SpillToDisk")) {
+            gMain.settings.output.spillToDisk = strToBool(value);
+            return true;
+        }
+        else if (strIsEqualNoCase(key, "SpillHeadSizeMB")) {
+            gMain.settings.output.spillHeadSizeMB = uint32(Max(strToInt(value), 1));
+            return true;
+        }
+        else if (strIsEqualNoCase(key, "SpillTailSizeMB")) {
+            gMain.settings.output.spillTailSizeMB = uint32(Max(strToInt(value), 1));
+            return true;
+        }
+        break;
+    case MainSettingsCallbacks::Category::Tasks:
+        if (strIsEqualNoCase(key, "RetainedRuns")) {
+            gMain.settings.tasks.retainedRuns = uint32(Max(strToInt(value), 1));
+            return true;
+        }
+        break;
     default:
         break;
     }
@@ -708,6 +910,14 @@ void MainSettingsCallbacks::SaveCategory(uint32 categoryId, Array<SettingsKeyVal
         items.Push(SettingsKeyValue { "WindowY", ToStr(gMain.settings.layout.windowY) });
         items.Push(SettingsKeyValue { "LastWorkspacePath", gMain.settings.layout.lastWorkspacePath.CStr() });
         break;
+    case MainSettingsCallbacks::Category::Output:
+        items.Push(SettingsKeyValue { "SpillToDisk", gMain.settings.output.spillToDisk ? "1" : "0" });
+        items.Push(SettingsKeyValue { "SpillHeadSizeMB", ToStr(int(gMain.settings.output.spillHeadSizeMB)) });
+        items.Push(SettingsKeyValue { "SpillTailSizeMB", ToStr(int(gMain.settings.output.spillTailSizeMB)) });
+        break;
+    case MainSettingsCallbacks::Category::Tasks:
+        items.Push(SettingsKeyValue { "RetainedRuns", ToStr(int(gMain.settings.tasks.retainedRuns)) });
+        break;
     default:
         break;
     }
@@ -718,32 +928,123 @@ Settings& GetSettings()
     return gMain.settings;
 }
 
+static StringTable* CreateStringTable(uint32 capacity)
+{
+    MemSingleShotMalloc<StringTable> mallocator;
+    mallocator.AddMemberField<atomicPtr>(offsetof(StringTable, slots), capacity);
+    StringTable* table = mallocator.Calloc();
+    table->capacity = capacity;
+    return table;
+}
+
+static StringEntry* FindStringEntry(StringTable* table, uint32 hash, const char* str, uint32 len)
+{
+    uint32 mask = table->capacity - 1;
+    for (uint32 i = hash & mask; ; i = (i + 1) & mask) {
+        StringEntry* entry = (StringEntry*)atomicLoadPtrExplicit(&table->slots[i], AtomicMemoryOrder::Acquire);
+        if (!entry)
+            return nullptr;
+        if (entry->hash == hash && entry->len == len && memcmp(entry->str, str, len) == 0)
+            return entry;
+    }
+}
+
+// Only called with the shard lock held, there are no other writers
+static void InsertStringEntry(StringTable* table, StringEntry* entry)
+{
+    uint32 mask = table->capacity - 1;
+    uint32 i = entry->hash & mask;
+    while (atomicLoadPtrExplicit(&table->slots[i], AtomicMemoryOrder::Relaxed))
+        i = (i + 1) & mask;
+    atomicStorePtrExplicit(&table->slots[i], atomicPtr((uintptr_t)entry), AtomicMemoryOrder::Release);
+}
+
+static void InitializeStrings()
+{
+    StringPool& pool = gMain.strPool;
+    if (atomicLoad32Explicit(&pool.initialized, AtomicMemoryOrder::Acquire))
+        return;
+
+    AtomicLockScope lock(pool.initLock);
+    if (pool.initialized)
+        return;
+
+    for (StringShard& shard : pool.shards) {
+        shard.alloc.Initialize(kStringShardReserveSize, 64*kKB);
+        shard.table = atomicPtr((uintptr_t)CreateStringTable(kStringInitTableSize));
+    }
+    atomicStore32Explicit(&pool.initialized, 1, AtomicMemoryOrder::Release);
+}
+
+static void ReleaseStrings()
+{
+    StringPool& pool = gMain.strPool;
+    if (!pool.initialized)
+        return;
+
+    for (StringShard& shard : pool.shards) {
+        StringTable* table = (StringTable*)shard.table;
+        while (table) {
+            StringTable* prev = table->prev;
+            MemSingleShotMalloc<StringTable>::Free(table);
+            table = prev;
+        }
+        shard.table = 0;
+        shard.count = 0;
+        shard.alloc.Release();
+    }
+    pool.initialized = 0;
+}
+
 StringId CreateString(const char* str)
 {
     ASSERT(str);
+    InitializeStrings();
+
+    uint32 len = strLen(str);
+    uint32 hash = hashFnv32(str, len);
+    StringShard& shard = gMain.strPool.shards[hash >> (32 - kStringNumShardsLog2)];    // Tables use the low bits
+
+    StringEntry* entry = FindStringEntry((StringTable*)atomicLoadPtrExplicit(&shard.table, AtomicMemoryOrder::Acquire), hash, str, len);
+    if (!entry) {
+        AtomicLockScope lock(shard.lock);
+
+        // The table might have grown, or another thread added the same string since the lock-free lookup
+        StringTable* table = (StringTable*)shard.table;
+        entry = FindStringEntry(table, hash, str, len);
+        if (!entry) {
+            if ((shard.count + 1)*2 > table->capacity) {
+                StringTable* newTable = CreateStringTable(table->capacity*2);
+                for (uint32 i = 0; i < table->capacity; i++) {
+                    if (table->slots[i])
+                        InsertStringEntry(newTable, (StringEntry*)table->slots[i]);
+                }
+                newTable->prev = table;
+                atomicStorePtrExplicit(&shard.table, atomicPtr((uintptr_t)newTable), AtomicMemoryOrder::Release);
+                table = newTable;
+            }
 
-    AtomicLockScope lock(gMain.strPoolLock);
-    if (!gMain.strPoolInit) {
-        strpool_config_t conf = strpool_default_config;
-        conf.memctx = memDefaultAlloc();
-        strpool_init(&gMain.strPool, &conf);
-        gMain.strPoolInit = true;
+            entry = (StringEntry*)shard.alloc.Malloc(sizeof(StringEntry) + len, alignof(StringEntry));
+            entry->refCount = 0;
+            entry->hash = hash;
+            entry->len = len;
+            memcpy(entry->str, str, len + 1);
+            InsertStringEntry(table, entry);
+            shard.count++;
+        }
     }
 
-    StringId handle = strpool_inject(&gMain.strPool, str, strLen(str));
-    strpool_incref(&gMain.strPool, handle);
-    return handle;
+    atomicFetchAdd32Explicit(&entry->refCount, 1, AtomicMemoryOrder::Relaxed);
+    return StringId((uintptr_t)entry);
 }
 
 void DestroyString(StringId handle)
 {
-    ASSERT(gMain.strPoolInit);
-
     if (handle) {
-        AtomicLockScope lock(gMain.strPoolLock);
-        int refCount = strpool_getref(&gMain.strPool, handle);
-        if (refCount == 0)
-            strpool_discard(&gMain.strPool, handle);
+        ASSERT(gMain.strPool.initialized);
+        StringEntry* entry = (StringEntry*)(uintptr_t)handle;
+        [[maybe_unused]] uint32 prevCount = atomicFetchSub32Explicit(&entry->refCount, 1, AtomicMemoryOrder::Relaxed);
+        ASSERT_MSG(prevCount, "String '%s' is destroyed more than it's created", entry->str);
     }
 }
 
@@ -751,17 +1052,15 @@ StringId DuplicateString(StringId handle)
 {
     if (handle == 0)
         return 0;
-    ASSERT(gMain.strPoolInit);
+    ASSERT(gMain.strPool.initialized);
 
-    AtomicLockScope lock(gMain.strPoolLock);
-    strpool_incref(&gMain.strPool, handle);
+    atomicFetchAdd32Explicit(&((StringEntry*)(uintptr_t)handle)->refCount, 1, AtomicMemoryOrder::Relaxed);
     return handle;
 }
 
 const char* GetString(StringId handle)
 {
-    AtomicLockScope lock(gMain.strPoolLock);
-    return handle ? strpool_cstr(&gMain.strPool, handle) : "";
+    return handle ? ((const StringEntry*)(uintptr_t)handle)->str : "";
 }
 
 bool HasUnsavedChanges()
@@ -856,7 +1155,7 @@ bool WorkspaceEvents::OnCreateGraph(WksWorkspace* wks, WksFileHandle fileHandle)
     uiGraph->mEvents = &gMain.graphEvents;
 
     NodeGraph* graph = ngCreate(memDefaultAlloc(), uiGraph);
-    if (!ngSave(graph, fileHandle)) {
+    if (!ngSave(graph, fileHandle, true)) {
         DestroyNodeGraphUI(uiGraph);
         return false;
     }